@@ -0,0 +1,81 @@
+#include <cstring>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <audio_mixer.h>
+
+using AudioMixer::Kernel;
+using Format = AudioDecoderBase::Format;
+
+// One audio callback of 4096 frames with 8 BGM and 16 SE channels
+constexpr int frames = 4096;
+constexpr int bgm_channels = 8;
+constexpr int se_channels = 16;
+
+struct Channel {
+	Format format;
+	int channels;
+	std::vector<uint8_t> data;
+};
+
+static std::vector<Channel> MakeChannels() {
+	std::vector<Channel> out;
+	// BGM is decoded to stereo S16 or F32
+	for (int i = 0; i < bgm_channels; ++i) {
+		out.push_back({ i % 2 ? Format::F32 : Format::S16, 2, {} });
+	}
+	// SE are mono or stereo S16 and U8 wave files
+	for (int i = 0; i < se_channels; ++i) {
+		out.push_back({ i % 4 == 3 ? Format::U8 : Format::S16, i % 2 ? 1 : 2, {} });
+	}
+
+	for (auto& ch : out) {
+		const int samples = frames * ch.channels;
+		if (ch.format == Format::F32) {
+			std::vector<float> f(samples);
+			for (int i = 0; i < samples; ++i) {
+				f[i] = ((i * 7919) % 2001 - 1000) / 1000.0f;
+			}
+			ch.data.resize(samples * sizeof(float));
+			std::memcpy(ch.data.data(), f.data(), ch.data.size());
+		} else if (ch.format == Format::S16) {
+			std::vector<int16_t> s(samples);
+			for (int i = 0; i < samples; ++i) {
+				s[i] = static_cast<int16_t>(i * 7919);
+			}
+			ch.data.resize(samples * sizeof(int16_t));
+			std::memcpy(ch.data.data(), s.data(), ch.data.size());
+		} else {
+			ch.data.resize(samples);
+			for (int i = 0; i < samples; ++i) {
+				ch.data[i] = static_cast<uint8_t>(i * 31);
+			}
+		}
+	}
+	return out;
+}
+
+static void BM_AudioMix(benchmark::State& state) {
+	const auto kernel = static_cast<Kernel>(state.range(0));
+	if (!AudioMixer::IsSupported(kernel)) {
+		state.SkipWithError("Kernel not supported");
+		return;
+	}
+	state.SetLabel(AudioMixer::GetKernelName(kernel));
+
+	auto channels = MakeChannels();
+	std::vector<float> mixer(frames * 2);
+
+	for (auto _: state) {
+		bool active = false;
+		for (auto& ch : channels) {
+			AudioMixer::Mix(kernel, mixer.data(), ch.data.data(), ch.format, ch.channels, frames, 0.8f, 0.6f, active);
+			active = true;
+		}
+		benchmark::DoNotOptimize(mixer.data());
+	}
+	state.SetItemsProcessed(state.iterations() * frames * (bgm_channels + se_channels));
+}
+
+BENCHMARK(BM_AudioMix)->Arg(static_cast<int>(Kernel::Scalar))->Arg(static_cast<int>(Kernel::SSE2))->Arg(static_cast<int>(Kernel::NEON));
+
+BENCHMARK_MAIN();
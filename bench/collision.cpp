@@ -0,0 +1,92 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <spatial_hash.h>
+
+// Pixel movement of many events on a 100x100 map, collision radius 0.5
+constexpr int map_size = 100;
+constexpr float contact = 1.0f;
+
+struct Crowd {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> vx;
+	std::vector<float> vy;
+
+	explicit Crowd(int n) {
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> pos(0.0f, map_size);
+		std::uniform_real_distribution<float> vel(-0.1f, 0.1f);
+		for (int i = 0; i < n; ++i) {
+			x.push_back(pos(rng));
+			y.push_back(pos(rng));
+			vx.push_back(vel(rng));
+			vy.push_back(vel(rng));
+		}
+	}
+
+	void Step(int i) {
+		x[i] += vx[i];
+		y[i] += vy[i];
+		if (x[i] < 0.0f || x[i] >= map_size) {
+			vx[i] = -vx[i];
+		}
+		if (y[i] < 0.0f || y[i] >= map_size) {
+			vy[i] = -vy[i];
+		}
+	}
+
+	bool Touches(int i, int j) const {
+		return i != j && std::hypot(x[i] - x[j], y[i] - y[j]) < contact;
+	}
+};
+
+static void BM_CollisionBruteForce(benchmark::State& state) {
+	const int n = state.range(0);
+	Crowd crowd(n);
+
+	for (auto _: state) {
+		int contacts = 0;
+		for (int i = 0; i < n; ++i) {
+			crowd.Step(i);
+			for (int j = 0; j < n; ++j) {
+				contacts += crowd.Touches(i, j);
+			}
+		}
+		benchmark::DoNotOptimize(contacts);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_CollisionBruteForce)->RangeMultiplier(4)->Range(16, 4096);
+
+static void BM_CollisionSpatialHash(benchmark::State& state) {
+	const int n = state.range(0);
+	Crowd crowd(n);
+	SpatialHash grid;
+	grid.Reset(map_size, map_size);
+	for (int i = 0; i < n; ++i) {
+		grid.Update(i, crowd.x[i], crowd.y[i]);
+	}
+	std::vector<int> near;
+
+	for (auto _: state) {
+		int contacts = 0;
+		for (int i = 0; i < n; ++i) {
+			crowd.Step(i);
+			grid.Update(i, crowd.x[i], crowd.y[i]);
+			near.clear();
+			grid.Query(crowd.x[i], crowd.y[i], contact, near);
+			for (int j : near) {
+				contacts += crowd.Touches(i, j);
+			}
+		}
+		benchmark::DoNotOptimize(contacts);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_CollisionSpatialHash)->RangeMultiplier(4)->Range(16, 4096);
+
+BENCHMARK_MAIN();
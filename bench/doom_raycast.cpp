@@ -0,0 +1,101 @@
+#include <cmath>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <bitmap.h>
+#include <doom_raycaster.h>
+#include <options.h>
+#include <pixel_format.h>
+#include <rect.h>
+
+constexpr int map_size = 100;
+constexpr int screen_width = 320;
+constexpr int screen_height = 240;
+constexpr float fov = 110.0f * M_PI / 180.0f;
+
+// Border walls, scattered pillars and some wall events
+static DoomRaycaster MakeMap() {
+	DoomRaycaster raycaster;
+	raycaster.Resize(map_size, map_size);
+
+	for (int y = 0; y < map_size; ++y) {
+		for (int x = 0; x < map_size; ++x) {
+			bool border = x == 0 || y == 0 || x == map_size - 1 || y == map_size - 1;
+			bool pillar = (x % 7 == 3 && y % 5 == 2);
+			uint8_t flags = (border || pillar) ? DoomRaycaster::Tile_Wall : 0;
+			if (x % 11 == 5 && y % 13 == 6) {
+				flags |= DoomRaycaster::Tile_Upper;
+			}
+			raycaster.SetTile(x, y, flags);
+		}
+	}
+
+	int id = 1;
+	for (int y = 4; y < map_size - 1; y += 9) {
+		for (int x = 6; x < map_size - 1; x += 8) {
+			raycaster.AddWallEvent({ x, y, id++, DoomRaycaster::WallEvent::Type_Door, 0 });
+		}
+	}
+
+	return raycaster;
+}
+
+static float RayAngle(int x, float angle) {
+	return angle + (x - screen_width / 2) * (fov / screen_width);
+}
+
+static void BM_DoomCastFrame(benchmark::State& state) {
+	auto raycaster = MakeMap();
+	std::vector<DoomRaycaster::Hit> hits;
+	float px = map_size / 2 * TILE_SIZE + TILE_SIZE / 2;
+	float py = px;
+	float angle = 0.0f;
+
+	for (auto _: state) {
+		for (int x = 0; x < screen_width; ++x) {
+			hits.clear();
+			raycaster.Cast(px, py, RayAngle(x, angle), hits);
+			benchmark::DoNotOptimize(hits.data());
+		}
+		angle += 0.01f;
+	}
+	state.SetItemsProcessed(state.iterations() * screen_width);
+}
+
+BENCHMARK(BM_DoomCastFrame);
+
+static void BM_DoomRenderFrame(benchmark::State& state) {
+	auto raycaster = MakeMap();
+	std::vector<DoomRaycaster::Hit> hits;
+	float px = map_size / 2 * TILE_SIZE + TILE_SIZE / 2;
+	float py = px;
+	float angle = 0.0f;
+
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto frame = Bitmap::Create(screen_width, screen_height);
+	auto wall = Bitmap::Create(TILE_SIZE, TILE_SIZE, Color(128, 96, 64, 255));
+
+	for (auto _: state) {
+		frame->Clear();
+		for (int x = 0; x < screen_width; ++x) {
+			hits.clear();
+			if (!raycaster.Cast(px, py, RayAngle(x, angle), hits)) {
+				continue;
+			}
+			const auto& hit = hits.back();
+			if (hit.distance <= 0) {
+				continue;
+			}
+			int line_height = static_cast<int>(TILE_SIZE * screen_height * 1.1 / hit.distance);
+			int draw_start = (screen_height - line_height) / 2;
+			Rect dst = { x, draw_start, 1, line_height };
+			Rect src = { hit.texture_x, 0, 1, TILE_SIZE };
+			frame->StretchBlit(dst, *wall, src, 255);
+		}
+		angle += 0.01f;
+	}
+	state.SetItemsProcessed(state.iterations() * screen_width);
+}
+
+BENCHMARK(BM_DoomRenderFrame);
+
+BENCHMARK_MAIN();
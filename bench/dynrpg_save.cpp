@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <dynrpg_rpgss.h>
+#include <filefinder.h>
+#include <game_dynrpg.h>
+#include <output.h>
+
+constexpr int num_sprites = 1000;
+
+// Sprites are imported from the legacy JSON format, without image files
+static std::vector<uint8_t> MakeJsonSave() {
+	std::string s = "{";
+	for (int i = 0; i < num_sprites; ++i) {
+		if (i > 0) {
+			s += ",";
+		}
+		s += "\"sprite" + std::to_string(i) + "\":{"
+			"\"version\":1,\"filename\":\"\",\"blendmode\":0,\"fixed_to\":1,"
+			"\"current_angle\":" + std::to_string(i % 360) + ",\"finish_angle\":0,\"rotation_time_left\":0,"
+			"\"z\":" + std::to_string(i) + ",\"visible\":true,\"rotate_cw\":true,\"rotate_forever_degree\":0,"
+			"\"time_left\":0,\"current_opacity\":255,\"finish_opacity\":0,\"opacity_time_left\":0,"
+			"\"current_red\":100,\"current_green\":100,\"current_blue\":100,\"current_sat\":100,"
+			"\"finish_red\":100,\"finish_green\":100,\"finish_blue\":100,\"finish_sat\":100,"
+			"\"tone_time_left\":0}";
+	}
+	s += "}";
+	return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+struct RpgssFixture {
+	Game_DynRpg dynrpg;
+	DynRpg::Rpgss rpgss;
+	std::vector<uint8_t> json;
+
+	RpgssFixture() : rpgss(dynrpg), json(MakeJsonSave()) {
+		Output::SetLogLevel(LogLevel::Error);
+		FileFinder::SetGameFilesystem(FileFinder::Root().Create("."));
+		rpgss.Load(json);
+	}
+};
+
+static void BM_RpgssSave(benchmark::State& state) {
+	RpgssFixture f;
+
+	for (auto _: state) {
+		auto data = f.rpgss.Save();
+		benchmark::DoNotOptimize(data);
+	}
+	state.SetItemsProcessed(state.iterations() * num_sprites);
+}
+
+BENCHMARK(BM_RpgssSave);
+
+static void BM_RpgssLoad(benchmark::State& state) {
+	RpgssFixture f;
+	auto data = f.rpgss.Save();
+
+	for (auto _: state) {
+		f.rpgss.Load(data);
+	}
+	state.SetItemsProcessed(state.iterations() * num_sprites);
+}
+
+BENCHMARK(BM_RpgssLoad);
+
+static void BM_RpgssLoadJson(benchmark::State& state) {
+	RpgssFixture f;
+
+	for (auto _: state) {
+		f.rpgss.Load(f.json);
+	}
+	state.SetItemsProcessed(state.iterations() * num_sprites);
+}
+
+BENCHMARK(BM_RpgssLoadJson);
+
+BENCHMARK_MAIN();
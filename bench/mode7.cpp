@@ -0,0 +1,70 @@
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <bitmap.h>
+#include <drawable_list.h>
+#include <drawable_mgr.h>
+#include <map_data.h>
+#include <pixel_format.h>
+#include <tilemap_layer.h>
+
+constexpr int map_size = 200;
+
+struct Mode7Fixture {
+	DrawableList list;
+	std::unique_ptr<TilemapLayer> layer;
+	TilemapLayer::Mode7View view;
+
+	Mode7Fixture() {
+		Bitmap::SetFormat(format_R8G8B8A8_a().format());
+		DrawableMgr::SetLocalList(&list);
+
+		layer = std::make_unique<TilemapLayer>(0);
+		layer->SetWidth(map_size);
+		layer->SetHeight(map_size);
+
+		auto chipset = Bitmap::Create(480, 256, true);
+		chipset->Fill(Color(80, 160, 40, 255));
+		layer->SetChipset(chipset);
+
+		// Block C tiles only, no autotiles are generated
+		std::vector<short> tiles(map_size * map_size);
+		for (size_t i = 0; i < tiles.size(); ++i) {
+			tiles[i] = static_cast<short>(BLOCK_C + (i % 3) * BLOCK_C_STRIDE);
+		}
+		layer->SetMapData(tiles);
+
+		view.slant = 60;
+		view.horizon = 30;
+		view.baseline = 4;
+		view.scale = 200;
+	}
+};
+
+static void BM_Mode7YawSweep(benchmark::State& state) {
+	Mode7Fixture f;
+	int yaw = 0;
+
+	for (auto _: state) {
+		f.view.yaw = static_cast<float>(yaw);
+		yaw = (yaw + 7) % 360;
+		f.layer->ProjectMode7(f.view, 0, 0, false, false);
+	}
+}
+
+BENCHMARK(BM_Mode7YawSweep);
+
+static void BM_Mode7SlantSweep(benchmark::State& state) {
+	Mode7Fixture f;
+	int slant = 0;
+
+	for (auto _: state) {
+		f.view.slant = slant;
+		slant = (slant + 3) % 90;
+		f.layer->ProjectMode7(f.view, 0, 0, false, false);
+	}
+}
+
+BENCHMARK(BM_Mode7SlantSweep);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,122 @@
+#include <cstdlib>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <bitmap.h>
+#include <pixel_format.h>
+#include <dynrpg_particle_integrator.h>
+#include <dynrpg_particle_renderer.h>
+
+constexpr int screen_w = 320;
+constexpr int screen_h = 240;
+constexpr int num_particles = 500;
+
+struct Particles {
+	std::vector<float> x, y, s;
+
+	Particles(int n, float size) : x(n), y(n), s(n, size) {
+		srand(1);
+		for (int i = 0; i < n; ++i) {
+			x[i] = rand() % screen_w;
+			y[i] = rand() % screen_h;
+		}
+	}
+};
+
+static void BM_ParticleSolidStretchBlit(benchmark::State& state) {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto dst = Bitmap::Create(screen_w, screen_h);
+	auto image = Bitmap::Create(1, 1, true);
+	image->Fill(Color(255, 128, 0, 255));
+	Particles p(num_particles, state.range(0));
+
+	for (auto _: state) {
+		for (int i = 0; i < num_particles; ++i) {
+			Rect dst_rect(p.x[i] - p.s[i] / 2, p.y[i] - p.s[i] / 2, p.s[i], p.s[i]);
+			dst->StretchBlit(dst_rect, *image, image->GetRect(), Opacity::Opaque());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * num_particles);
+}
+
+BENCHMARK(BM_ParticleSolidStretchBlit)->Arg(1)->Arg(4);
+
+static void BM_ParticleSolidBatched(benchmark::State& state) {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto dst = Bitmap::Create(screen_w, screen_h);
+	Particles p(num_particles, state.range(0));
+
+	for (auto _: state) {
+		ParticleRenderer::DrawSolid(*dst, p.x.data(), p.y.data(), p.s.data(), num_particles, 0, 0, Color(255, 128, 0, 255));
+	}
+	state.SetItemsProcessed(state.iterations() * num_particles);
+}
+
+BENCHMARK(BM_ParticleSolidBatched)->Arg(1)->Arg(4);
+
+static void BM_ParticleTextureStretchBlit(benchmark::State& state) {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto dst = Bitmap::Create(screen_w, screen_h);
+	auto tex = Bitmap::Create(8, 8, Color(255, 255, 255, 128));
+	Particles p(num_particles, 1.0f);
+
+	for (auto _: state) {
+		for (int i = 0; i < num_particles; ++i) {
+			Rect dst_rect(p.x[i] - p.s[i] / 2, p.y[i] - p.s[i] / 2, 8 * p.s[i], 8 * p.s[i]);
+			dst->StretchBlit(dst_rect, *tex, tex->GetRect(), 200);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * num_particles);
+}
+
+BENCHMARK(BM_ParticleTextureStretchBlit);
+
+static void BM_ParticleTextureBatched(benchmark::State& state) {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto dst = Bitmap::Create(screen_w, screen_h);
+	auto tex = Bitmap::Create(8, 8, Color(255, 255, 255, 128));
+	Particles p(num_particles, 1.0f);
+
+	for (auto _: state) {
+		ParticleRenderer::DrawTexture(*dst, p.x.data(), p.y.data(), p.s.data(), num_particles, 0, 0, *tex, tex->GetRect(), 200);
+	}
+	state.SetItemsProcessed(state.iterations() * num_particles);
+}
+
+BENCHMARK(BM_ParticleTextureBatched);
+
+static void BM_ParticleIntegrate(benchmark::State& state) {
+	auto kernel = static_cast<ParticleIntegrator::Kernel>(state.range(0));
+	if (!ParticleIntegrator::IsSupported(kernel)) {
+		state.SkipWithError("Kernel not supported");
+		return;
+	}
+	state.SetLabel(ParticleIntegrator::GetKernelName(kernel));
+
+	const int n = state.range(1);
+	Particles p(n, 1.0f);
+	std::vector<float> dx(n, 0.5f);
+	std::vector<float> dy(n, -0.25f);
+
+	ParticleIntegrator::Params params;
+	params.ax0 = screen_w / 2;
+	params.ay0 = screen_h / 2;
+	params.afc = 5.0f / 600.0f;
+	params.gy = 1.0f / 600.0f;
+	params.ds = 0.01f;
+
+	for (auto _: state) {
+		ParticleIntegrator::Integrate(kernel, params, p.x.data(), p.y.data(), p.s.data(), dx.data(), dy.data(), n);
+		benchmark::ClobberMemory();
+	}
+	state.counters["particles/s"] = benchmark::Counter(state.iterations() * n, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_ParticleIntegrate)->ArgsProduct({
+	{ static_cast<int>(ParticleIntegrator::Kernel::Scalar),
+	  static_cast<int>(ParticleIntegrator::Kernel::SSE2),
+	  static_cast<int>(ParticleIntegrator::Kernel::AVX2),
+	  static_cast<int>(ParticleIntegrator::Kernel::NEON) },
+	{ 500, 15000 }
+});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,123 @@
+#include <memory>
+#include <random>
+#include <benchmark/benchmark.h>
+#include <game_actors.h>
+#include <game_map.h>
+#include <game_party.h>
+#include <game_pictures.h>
+#include <game_player.h>
+#include <game_screen.h>
+#include <game_switches.h>
+#include <game_system.h>
+#include <game_variables.h>
+#include <main_data.h>
+#include <map_data.h>
+#include <output.h>
+#include <lcf/data.h>
+
+// Pathfinding across a 100x100 map crowded with stationary events
+constexpr int map_size = 100;
+
+static std::unique_ptr<lcf::rpg::Map> MakeCrowdedMap(int num_events) {
+	auto map = std::make_unique<lcf::rpg::Map>();
+	map->width = map_size;
+	map->height = map_size;
+	map->upper_layer.resize(map_size * map_size, BLOCK_F);
+	map->lower_layer.resize(map_size * map_size, BLOCK_E);
+
+	// The walker starts in the top left corner
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> pos(2, map_size - 3);
+	for (int id = 1; id <= num_events + 1; ++id) {
+		map->events.push_back({});
+		auto& ev = map->events.back();
+		ev.ID = id;
+		ev.x = id == 1 ? 0 : pos(rng);
+		ev.y = id == 1 ? 0 : pos(rng);
+		ev.pages.push_back({});
+		ev.pages.back().ID = 1;
+		ev.pages.back().move_type = lcf::rpg::EventPage::MoveType_stationary;
+		ev.pages.back().character_name = "Hero";
+	}
+	return map;
+}
+
+struct CrowdedMap {
+	explicit CrowdedMap(int num_events) {
+		Output::SetLogLevel(LogLevel::Error);
+
+		lcf::rpg::Chipset chipset;
+		chipset.passable_data_lower.resize(162, 0xF);
+		chipset.passable_data_upper.resize(162, 0xF);
+		chipset.terrain_data.resize(144, 1);
+		lcf::Data::terrains.push_back({});
+		lcf::Data::chipsets.push_back(chipset);
+
+		lcf::Data::treemap.maps.push_back(lcf::rpg::MapInfo());
+		lcf::Data::treemap.maps.back().type = lcf::rpg::TreeMap::MapType_root;
+		lcf::Data::treemap.maps.push_back(lcf::rpg::MapInfo());
+		lcf::Data::treemap.maps.back().ID = 1;
+		lcf::Data::treemap.maps.back().type = lcf::rpg::TreeMap::MapType_map;
+
+		Main_Data::game_actors = std::make_unique<Game_Actors>();
+		Main_Data::game_party = std::make_unique<Game_Party>();
+		Game_Map::Init();
+		Main_Data::game_system = std::make_unique<Game_System>();
+		Main_Data::game_switches = std::make_unique<Game_Switches>();
+		Main_Data::game_variables = std::make_unique<Game_Variables>(Game_Variables::min_2k3, Game_Variables::max_2k3);
+		Main_Data::game_pictures = std::make_unique<Game_Pictures>();
+		Main_Data::game_screen = std::make_unique<Game_Screen>();
+		Main_Data::game_player = std::make_unique<Game_Player>();
+		Main_Data::game_player->SetMapId(1);
+		Main_Data::game_player->SetX(map_size - 1);
+		Main_Data::game_player->SetY(0);
+
+		Game_Map::Setup(MakeCrowdedMap(num_events));
+	}
+
+	~CrowdedMap() {
+		Main_Data::game_switches = {};
+		Main_Data::game_variables = {};
+		Main_Data::game_player = {};
+		Main_Data::game_screen = {};
+		Main_Data::game_pictures = {};
+		Game_Map::Quit();
+		lcf::Data::data = {};
+		Main_Data::game_party.reset();
+	}
+};
+
+static void BM_PathfindingCrowded(benchmark::State& state) {
+	CrowdedMap crowd(state.range(0));
+	auto* walker = Game_Map::GetEvent(1);
+
+	Game_Character::CalculateMoveRouteArgs args;
+	args.dest_x = map_size - 1;
+	args.dest_y = map_size - 1;
+	args.allow_diagonal = true;
+
+	for (auto _: state) {
+		benchmark::DoNotOptimize(walker->CalculateMoveRoute(args));
+	}
+}
+
+BENCHMARK(BM_PathfindingCrowded)->RangeMultiplier(4)->Range(16, 4096);
+
+static void BM_GetEventAtCrowded(benchmark::State& state) {
+	CrowdedMap crowd(state.range(0));
+
+	for (auto _: state) {
+		int found = 0;
+		for (int y = 0; y < map_size; ++y) {
+			for (int x = 0; x < map_size; ++x) {
+				found += Game_Map::GetEventAt(x, y, true) != nullptr;
+			}
+		}
+		benchmark::DoNotOptimize(found);
+	}
+	state.SetItemsProcessed(state.iterations() * map_size * map_size);
+}
+
+BENCHMARK(BM_GetEventAtCrowded)->RangeMultiplier(4)->Range(16, 4096);
+
+BENCHMARK_MAIN();
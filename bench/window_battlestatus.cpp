@@ -0,0 +1,103 @@
+#include <memory>
+#include <string>
+#include <benchmark/benchmark.h>
+#include <bitmap.h>
+#include <drawable_list.h>
+#include <drawable_mgr.h>
+#include <game_actors.h>
+#include <game_enemyparty.h>
+#include <game_party.h>
+#include <game_system.h>
+#include <main_data.h>
+#include <output.h>
+#include <pixel_format.h>
+#include <player.h>
+#include <window_battlestatus.h>
+#include <lcf/data.h>
+
+// 4-actor RPG Maker 2003 ATB battle status window refreshed every frame
+constexpr int num_actors = 4;
+
+struct AtbBattle {
+	AtbBattle() {
+		Output::SetLogLevel(LogLevel::Error);
+		Bitmap::SetFormat(format_R8G8B8A8_a().format());
+		DrawableMgr::SetLocalList(&drawable_list);
+
+		Player::game_config.engine = Player::EngineRpg2k3 | Player::EngineEnglish;
+		lcf::Data::battlecommands.battle_type = lcf::rpg::BattleCommands::BattleType_alternative;
+
+		lcf::Data::states.resize(1);
+		lcf::Data::states[0].ID = 1;
+		lcf::Data::states[0].name = lcf::DBString("Dead");
+
+		lcf::Data::actors.resize(num_actors);
+		for (int i = 0; i < num_actors; ++i) {
+			auto& actor = lcf::Data::actors[i];
+			actor.ID = i + 1;
+			actor.name = lcf::DBString("Actor " + std::to_string(i + 1));
+			actor.initial_level = 1;
+			actor.final_level = 99;
+			actor.parameters.Setup(actor.final_level);
+			actor.parameters.maxhp[0] = 999;
+			actor.parameters.maxsp[0] = 99;
+			actor.state_ranks.resize(lcf::Data::states.size(), 2);
+		}
+
+		Main_Data::game_system = std::make_unique<Game_System>();
+		Main_Data::game_actors = std::make_unique<Game_Actors>();
+		Main_Data::game_enemyparty = std::make_unique<Game_EnemyParty>();
+		Main_Data::game_party = std::make_unique<Game_Party>();
+		for (int i = 0; i < num_actors; ++i) {
+			Main_Data::game_party->AddActor(i + 1);
+		}
+
+		window = std::make_unique<Window_BattleStatus>(0, 160, 320, 80);
+	}
+
+	~AtbBattle() {
+		window.reset();
+		Main_Data::Cleanup();
+		lcf::Data::data = {};
+		DrawableMgr::SetLocalList(nullptr);
+	}
+
+	// Advances the ATB gauges, every frame one actor takes damage or heals
+	void Tick(int frame) {
+		for (int i = 0; i < num_actors; ++i) {
+			auto& actor = (*Main_Data::game_party)[i];
+			actor.IncrementAtbGauge(actor.GetMaxAtbGauge() / 100);
+			if (actor.IsAtbGaugeFull()) {
+				actor.SetAtbGauge(0);
+			}
+		}
+
+		auto& actor = (*Main_Data::game_party)[frame % num_actors];
+		actor.ChangeHp(frame % 2 ? 7 : -7, false);
+	}
+
+	DrawableList drawable_list;
+	std::unique_ptr<Window_BattleStatus> window;
+};
+
+static void BM_BattleStatusRefresh(benchmark::State& state) {
+	AtbBattle battle;
+	int frame = 0;
+	for (auto _: state) {
+		battle.Tick(frame++);
+		battle.window->Refresh();
+	}
+}
+
+BENCHMARK(BM_BattleStatusRefresh);
+
+static void BM_BattleStatusRefreshUnchanged(benchmark::State& state) {
+	AtbBattle battle;
+	for (auto _: state) {
+		battle.window->Refresh();
+	}
+}
+
+BENCHMARK(BM_BattleStatusRefreshUnchanged);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,337 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <lcf/data.h>
+#include <lcf/lmu/reader.h>
+#include <lcf/reader_util.h>
+#include "asset_prefetch.h"
+#include "async_handler.h"
+#include "audio_secache.h"
+#include "filefinder.h"
+#include "game_clock.h"
+#include "game_map.h"
+#include "game_system.h"
+#include "main_data.h"
+#include "output.h"
+#include "player.h"
+#include "worker_pool.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+	using Cmd = lcf::rpg::EventCommand::Code;
+
+	/** Reachable maps scanned per map, the others are only looked up */
+	constexpr int max_scanned_maps = 8;
+
+	/** Time spent per frame on prefetching */
+	constexpr auto time_slice = 1ms;
+
+	struct Item {
+		enum Type {
+			Image,
+			Sound,
+			Music,
+			Map
+		};
+		Type type;
+		std::string folder;
+		std::string name;
+		int map_id;
+		/** Parse the map file and prefetch its images */
+		bool scan;
+	};
+
+	std::deque<Item> queue;
+	AssetPrefetch::Stats stats;
+
+	/** Reachable map parsed by the scan pool */
+	struct Scan {
+		Filesystem_Stream::InputStream stream;
+		std::string encoding;
+		/** Images of the map, valid when done */
+		std::vector<std::pair<std::string, std::string>> images;
+		bool parsed = false;
+		std::atomic<bool> done { false };
+	};
+
+	/** Parses reachable maps, large maps take longer than a frame */
+	std::unique_ptr<WorkerPool> scan_pool;
+	/** Scans of the current map, checked by Update */
+	std::vector<std::shared_ptr<Scan>> scans;
+
+	/** Whether the name of a command is a constant, Maniac Patch can read it from a variable */
+	bool IsConstantName(const lcf::rpg::EventCommand& com, int mode_idx, int shift) {
+		if (!Player::IsPatchManiac() || static_cast<int>(com.parameters.size()) <= mode_idx) {
+			return true;
+		}
+		return ((com.parameters[mode_idx] >> (shift * 4)) & 0xF) == 0;
+	}
+
+	void AddImage(std::vector<std::pair<std::string, std::string>>& images, std::string folder, std::string_view name) {
+		if (!name.empty()) {
+			images.emplace_back(std::move(folder), ToString(name));
+		}
+	}
+
+	template <typename T>
+	void SortUnique(std::vector<T>& v) {
+		std::sort(v.begin(), v.end());
+		v.erase(std::unique(v.begin(), v.end()), v.end());
+	}
+
+	void CollectCommands(const std::vector<lcf::rpg::EventCommand>& commands, AssetPrefetch::MapAssets& assets) {
+		for (const auto& com : commands) {
+			switch (static_cast<Cmd>(com.code)) {
+				case Cmd::ShowPicture:
+					// Pictures without transparency use a different cache entry than the prefetched one
+					if (com.parameters.size() > 7 && com.parameters[7] > 0 &&
+							!(com.parameters.size() > 19 && com.parameters[19] != 0) && IsConstantName(com, 17, 2)) {
+						AddImage(assets.event_images, "Picture", com.string);
+					}
+					break;
+				case Cmd::ChangeFaceGraphic:
+					if (IsConstantName(com, 3, 0)) {
+						AddImage(assets.event_images, "FaceSet", com.string);
+					}
+					break;
+				case Cmd::ChangeSpriteAssociation:
+					if (IsConstantName(com, 3, 1)) {
+						AddImage(assets.event_images, "CharSet", com.string);
+					}
+					break;
+				case Cmd::ChangeActorFace:
+					if (IsConstantName(com, 2, 1)) {
+						AddImage(assets.event_images, "FaceSet", com.string);
+					}
+					break;
+				case Cmd::ChangePBG:
+					AddImage(assets.event_images, "Panorama", com.string);
+					break;
+				case Cmd::PlayBGM:
+					if (IsConstantName(com, 4, 0) && !com.string.empty()) {
+						assets.music.push_back(ToString(com.string));
+					}
+					break;
+				case Cmd::Teleport:
+					if (!com.parameters.empty() && com.parameters[0] > 0) {
+						assets.maps.push_back(com.parameters[0]);
+					}
+					break;
+				default:
+					break;
+			}
+		}
+
+		Game_System::CollectSeNames(commands, assets.sounds);
+	}
+
+	void PushImages(const std::vector<std::pair<std::string, std::string>>& images) {
+		for (const auto& image : images) {
+			queue.push_back({ Item::Image, image.first, image.second, 0, false });
+		}
+	}
+
+	void ScanMap(int map_id) {
+		// EasyRPG XML maps are rare, only RPG Maker maps are scanned
+		auto map_file = FileFinder::Game().FindFile(Game_Map::ConstructMapName(map_id, false));
+		if (map_file.empty()) {
+			return;
+		}
+
+		// The lookup is not thread safe, only the parsing happens in the worker
+		auto map_stream = FileFinder::Game().OpenInputStream(map_file);
+		if (!map_stream) {
+			return;
+		}
+
+		if (!scan_pool) {
+			scan_pool = std::make_unique<WorkerPool>(WorkerPool::GetDefaultThreadCount(1));
+		}
+
+		auto scan = std::make_shared<Scan>();
+		scan->stream = std::move(map_stream);
+		scan->encoding = Player::encoding;
+		scans.push_back(scan);
+
+		scan_pool->Push([scan]() {
+			auto map = lcf::LMU_Reader::Load(scan->stream, scan->encoding);
+			if (map) {
+				scan->images = AssetPrefetch::Collect(*map).images;
+				scan->parsed = true;
+			}
+			scan->done = true;
+		});
+	}
+
+	/** Queues the images of the finished scans */
+	void TakeScans() {
+		for (auto it = scans.begin(); it != scans.end();) {
+			auto& scan = **it;
+			if (!scan.done) {
+				++it;
+				continue;
+			}
+
+			if (scan.parsed) {
+				++stats.maps;
+				PushImages(scan.images);
+			}
+			it = scans.erase(it);
+		}
+	}
+
+	void Process(const Item& item) {
+		switch (item.type) {
+			case Item::Image:
+				// Decoded in the background or downloaded, depending on the platform
+				if (AsyncHandler::RequestFile(item.folder, item.name)->StartPrefetch()) {
+					++stats.images;
+				}
+				break;
+			case Item::Sound:
+				if (!AudioSeCache::IsFull()) {
+					Main_Data::game_system->SePredecode({ item.name });
+					++stats.sounds;
+				}
+				break;
+			case Item::Music:
+				FileFinder::FindMusic(item.name);
+				++stats.lookups;
+				break;
+			case Item::Map: {
+				const auto& map_info = Game_Map::GetMapInfo(item.map_id);
+				if (map_info.ID != item.map_id) {
+					// Teleport to a deleted map
+					break;
+				}
+
+				// Downloads the map on Emscripten
+				AsyncHandler::RequestFile(Game_Map::ConstructMapName(item.map_id, false))->StartPrefetch();
+				++stats.lookups;
+
+				// Specified BGM
+				if (map_info.music_type == 2 && !map_info.music.name.empty()) {
+					queue.push_back({ Item::Music, "Music", ToString(map_info.music.name), 0, false });
+				}
+
+				if (item.scan) {
+					ScanMap(item.map_id);
+				}
+				break;
+			}
+		}
+	}
+}
+
+AssetPrefetch::MapAssets AssetPrefetch::Collect(const lcf::rpg::Map& map) {
+	MapAssets assets;
+
+	// Drawn first when the map is entered
+	auto* chipset = lcf::ReaderUtil::GetElement(lcf::Data::chipsets, map.chipset_id);
+	if (chipset) {
+		AddImage(assets.images, "ChipSet", chipset->chipset_name);
+	}
+
+	if (map.parallax_flag) {
+		AddImage(assets.images, "Panorama", map.parallax_name);
+	}
+
+	std::vector<std::pair<std::string, std::string>> charsets;
+	for (const auto& ev : map.events) {
+		for (const auto& page : ev.pages) {
+			AddImage(charsets, "CharSet", page.character_name);
+			CollectCommands(page.event_commands, assets);
+		}
+	}
+
+	SortUnique(charsets);
+	assets.images.insert(assets.images.end(), charsets.begin(), charsets.end());
+	SortUnique(assets.event_images);
+	SortUnique(assets.sounds);
+	SortUnique(assets.music);
+	SortUnique(assets.maps);
+
+	return assets;
+}
+
+void AssetPrefetch::PrefetchMap(const lcf::rpg::Map& map, int map_id) {
+	queue.clear();
+	// Running scans finish in the background, their results are dropped
+	scans.clear();
+
+	auto assets = Collect(map);
+
+	auto s = GetStats();
+	Output::Debug("Prefetch Map {}: {} images, {} SE, {} BGM, {} reachable maps (total images {}, used {}, unused {}, dropped {}; SE {}, used {})",
+		map_id, assets.images.size() + assets.event_images.size(), assets.sounds.size(), assets.music.size(), assets.maps.size(),
+		s.images, s.image_cache.hits, s.image_cache.unused, s.image_cache.dropped, s.sounds, s.sound_hits);
+
+	// Most likely needed first
+	PushImages(assets.images);
+	PushImages(assets.event_images);
+	for (auto& name : assets.sounds) {
+		queue.push_back({ Item::Sound, "Sound", std::move(name), 0, false });
+	}
+	for (auto& name : assets.music) {
+		queue.push_back({ Item::Music, "Music", std::move(name), 0, false });
+	}
+
+	int scanned = 0;
+	for (int id : assets.maps) {
+		if (id != map_id) {
+			queue.push_back({ Item::Map, "", "", id, scanned++ < max_scanned_maps });
+		}
+	}
+}
+
+void AssetPrefetch::Update() {
+	if (!scans.empty()) {
+		TakeScans();
+	}
+
+	if (queue.empty()) {
+		return;
+	}
+
+	auto deadline = Game_Clock::now() + time_slice;
+	do {
+		auto item = std::move(queue.front());
+		queue.pop_front();
+		Process(item);
+	} while (!queue.empty() && Game_Clock::now() < deadline);
+}
+
+AssetPrefetch::Stats AssetPrefetch::GetStats() {
+	auto s = stats;
+	s.image_cache = Cache::GetPrefetchStats();
+	s.sound_hits = AudioSeCache::GetStats().predecode_hits;
+	return s;
+}
+
+void AssetPrefetch::Quit() {
+	queue.clear();
+	scans.clear();
+	// Waits for the running scans
+	scan_pool.reset();
+}
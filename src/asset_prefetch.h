@@ -0,0 +1,106 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_ASSET_PREFETCH_H
+#define EP_ASSET_PREFETCH_H
+
+// Headers
+#include <string>
+#include <utility>
+#include <vector>
+#include <lcf/rpg/map.h>
+#include "cache.h"
+
+/**
+ * Loads the assets of a map and of the maps reachable through teleports
+ * ahead of time to avoid stalls when they are used for the first time.
+ *
+ * Images are decoded into the Cache as prefetched, sounds are predecoded
+ * into the AudioSeCache and music and map files are looked up to fill the
+ * directory caches. The work is spread over several frames.
+ */
+namespace AssetPrefetch {
+	/** Assets referenced by a map, without duplicates */
+	struct MapAssets {
+		/**
+		 * Images shown when the map is entered, as folder and name.
+		 * Chipset and panorama come first, followed by the sorted event graphics.
+		 */
+		std::vector<std::pair<std::string, std::string>> images;
+		/** Images used by event commands, sorted, as folder and name */
+		std::vector<std::pair<std::string, std::string>> event_images;
+		/** Sound effects played by event commands */
+		std::vector<std::string> sounds;
+		/** Music played by event commands */
+		std::vector<std::string> music;
+		/** Maps reachable through Teleport commands */
+		std::vector<int> maps;
+	};
+
+	/**
+	 * Collects the assets of a map.
+	 * File names read from variables (Maniac Patch) are skipped.
+	 *
+	 * @param map map to scan
+	 * @return assets of the map
+	 */
+	MapAssets Collect(const lcf::rpg::Map& map);
+
+	/**
+	 * Replaces the pending prefetches with the assets of a map and of the
+	 * maps reachable from it.
+	 *
+	 * @param map current map
+	 * @param map_id ID of the current map
+	 */
+	void PrefetchMap(const lcf::rpg::Map& map, int map_id);
+
+	/**
+	 * Processes pending prefetches for a short time.
+	 * Reachable maps are parsed in the background, their images are queued
+	 * once the parsing finished.
+	 * Called once per frame by Scene_Map.
+	 */
+	void Update();
+
+	/**
+	 * Drops the pending prefetches and waits for running map scans.
+	 * Called by Player::Exit.
+	 */
+	void Quit();
+
+	/** Counters of the prefetcher */
+	struct Stats {
+		/** Images requested ahead of time */
+		int images = 0;
+		/** Sound effects requested ahead of time */
+		int sounds = 0;
+		/** Music and map files looked up ahead of time */
+		int lookups = 0;
+		/** Reachable maps that were scanned */
+		int maps = 0;
+		/** Usage of the prefetched images */
+		Cache::PrefetchStats image_cache;
+		/** Predecoded sound effects that were played */
+		int sound_hits = 0;
+	};
+
+	/** @return prefetch counters */
+	Stats GetStats();
+}
+
+#endif
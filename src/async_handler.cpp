@@ -27,6 +27,7 @@
 #endif
 
 #include "async_handler.h"
+#include "bitmap.h"
 #include "cache.h"
 #include "filefinder.h"
 #include "memory_management.h"
@@ -37,6 +38,13 @@
 #include "transition.h"
 #include "rand.h"
 
+#ifdef SUPPORT_ASYNC_DECODE
+#  include <atomic>
+#  include <memory>
+#  include <mutex>
+#  include "worker_pool.h"
+#endif
+
 // When this option is enabled async requests are randomly delayed.
 // This allows testing some aspects of async file fetching locally.
 //#define EP_DEBUG_SIMULATE_ASYNC
@@ -137,6 +145,80 @@ namespace {
 	}
 
 #endif
+
+#ifdef SUPPORT_ASYNC_DECODE
+	/** Increased by ClearRequests to discard decode results of cleared requests */
+	int request_generation = 0;
+
+	struct DecodeJob {
+		std::string path;
+		std::string directory;
+		std::string file;
+		int generation;
+		Filesystem_Stream::InputStream stream;
+		bool transparent;
+		uint32_t flags;
+		BitmapRef bitmap;
+	};
+
+	/**
+	 * Decodes images of file requests in worker threads.
+	 * The results are collected by the main thread in AsyncHandler::Update.
+	 */
+	std::unique_ptr<WorkerPool> decode_pool;
+	std::mutex decode_mutex;
+	std::vector<DecodeJob> decode_finished;
+	/** Set by AsyncHandler::Quit, queued jobs are skipped */
+	std::atomic<bool> decode_quit { false };
+
+	WorkerPool* GetDecodePool() {
+		if (!decode_pool && !decode_quit) {
+			decode_pool = std::make_unique<WorkerPool>(WorkerPool::GetDefaultThreadCount(4));
+		}
+		return decode_pool.get();
+	}
+
+	/**
+	 * Starts decoding the image of a request in the background.
+	 *
+	 * @return false when the request is not an image handled by the Cache
+	 */
+	bool StartDecode(const std::string& path, const std::string& directory, const std::string& file) {
+		auto* pool = GetDecodePool();
+		if (!pool || pool->GetThreadCount() == 0) {
+			// Decoding inline has no benefit over the synchronous load
+			return false;
+		}
+
+		bool transparent;
+		uint32_t flags;
+		if (!Cache::GetDecodeParams(directory, transparent, flags)) {
+			return false;
+		}
+
+		// The lookup is not thread safe, only the decoding happens in the worker
+		auto is = FileFinder::OpenImage(directory, file);
+		if (!is) {
+			// Cache reports the missing file
+			return false;
+		}
+
+		// std::function must be copyable, the stream is not
+		auto job = std::make_shared<DecodeJob>(DecodeJob{path, directory, file, request_generation, std::move(is), transparent, flags, nullptr});
+		pool->Push([job]() {
+			if (decode_quit) {
+				return;
+			}
+
+			Output::SetWorkerThread();
+			job->bitmap = Bitmap::Create(std::move(job->stream), job->transparent, job->flags);
+
+			std::lock_guard<std::mutex> lock(decode_mutex);
+			decode_finished.push_back(std::move(*job));
+		});
+		return true;
+	}
+#endif
 }
 
 void AsyncHandler::CreateRequestMapping(const std::string& file) {
@@ -223,6 +305,20 @@ void AsyncHandler::ClearRequests() {
 		}
 	}
 	async_requests.clear();
+
+#ifdef SUPPORT_ASYNC_DECODE
+	++request_generation;
+#endif
+}
+
+void AsyncHandler::Quit() {
+#ifdef SUPPORT_ASYNC_DECODE
+	// Stop the workers before the statics used by them are destroyed
+	decode_quit = true;
+	decode_pool.reset();
+	decode_finished.clear();
+	Output::FlushWorkerMessages();
+#endif
 }
 
 FileRequestAsync* AsyncHandler::RequestFile(std::string_view folder_name, std::string_view file_name) {
@@ -243,6 +339,33 @@ FileRequestAsync* AsyncHandler::RequestFile(std::string_view file_name) {
 	return RequestFile(".", file_name);
 }
 
+void AsyncHandler::Update() {
+#ifdef SUPPORT_ASYNC_DECODE
+	std::vector<DecodeJob> jobs;
+	{
+		std::lock_guard<std::mutex> lock(decode_mutex);
+		jobs.swap(decode_finished);
+	}
+
+	// Write the decoder messages before the results are used
+	Output::FlushWorkerMessages();
+
+	for (auto& job : jobs) {
+		if (job.generation != request_generation) {
+			continue;
+		}
+
+		auto* request = GetRequest(job.path);
+		if (!request || request->IsReady()) {
+			continue;
+		}
+
+		Cache::AddDecoded(job.directory, job.file, std::move(job.bitmap), request->IsPrefetch());
+		request->DownloadDone(true);
+	}
+#endif
+}
+
 bool AsyncHandler::IsFilePending(bool important, bool graphic) {
 	for (auto& ap: async_requests) {
 		FileRequestAsync& request = ap.second;
@@ -382,11 +505,28 @@ void FileRequestAsync::Start() {
 #  endif
 
 #  ifndef EP_DEBUG_SIMULATE_ASYNC
+#    ifdef SUPPORT_ASYNC_DECODE
+	if (StartDecode(path, directory, file)) {
+		// Finished by AsyncHandler::Update
+		return;
+	}
+#    endif
 	DownloadDone(true);
 #  endif
 #endif
 }
 
+bool FileRequestAsync::StartPrefetch() {
+	if (state != State_WaitForStart) {
+		// Already requested by someone else
+		return false;
+	}
+
+	prefetch = true;
+	Start();
+	return true;
+}
+
 void FileRequestAsync::UpdateProgress() {
 #ifndef EMSCRIPTEN
 	// Fake download for testing event handlers
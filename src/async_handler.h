@@ -30,6 +30,8 @@ struct FileRequestResult;
 /**
  * AsyncHandler supports asynchronous file requests for platforms that don't
  * support synchronous IO (e.g. Emscripten).
+ * On desktop platforms images requested through it are decoded by background
+ * threads instead (SUPPORT_ASYNC_DECODE).
  */
 namespace AsyncHandler {
 	/**
@@ -44,6 +46,12 @@ namespace AsyncHandler {
 	 */
 	void ClearRequests();
 
+	/**
+	 * Stops the background decoders, pending decodes are discarded.
+	 * Called by Player::Exit.
+	 */
+	void Quit();
+
 	/**
 	 * Creates a request to a file.
 	 * When the same file was already requested this will return an already
@@ -69,6 +77,13 @@ namespace AsyncHandler {
 	 */
 	FileRequestAsync* RequestFile(std::string_view file_name);
 
+	/**
+	 * Finishes requests whose images were decoded in the background and
+	 * calls their event handlers.
+	 * Called once per frame by the Player.
+	 */
+	void Update();
+
 	/**
 	 * Checks if any file with important-flag hasn't finished downloading yet.
 	 *
@@ -167,6 +182,20 @@ public:
 	 */
 	void Start();
 
+	/**
+	 * Starts the request ahead of time because the file is likely needed soon.
+	 * Decoded images are added to the Cache as prefetched.
+	 * Does nothing when the request was already started.
+	 *
+	 * @return Whether the request was started.
+	 */
+	bool StartPrefetch();
+
+	/**
+	 * @return If the request was started by StartPrefetch.
+	 */
+	bool IsPrefetch() const;
+
 	/**
 	 * @return Path to the requested file.
 	 */
@@ -221,6 +250,7 @@ private:
 	int state = State_DoneFailure;
 	bool important = false;
 	bool graphic = false;
+	bool prefetch = false;
 };
 
 /**
@@ -259,6 +289,10 @@ inline bool FileRequestAsync::IsGraphicFile() const {
 	return graphic;
 }
 
+inline bool FileRequestAsync::IsPrefetch() const {
+	return prefetch;
+}
+
 inline const std::string& FileRequestAsync::GetPath() const {
 	return path;
 }
@@ -65,7 +65,7 @@ EmptyAudio::EmptyAudio(const Game_ConfigAudio& cfg) : AudioInterface(cfg) {
 }
 
 AudioInterface::AudioInterface(const Game_ConfigAudio& cfg) : cfg(cfg) {
-
+	AudioSeCache::SetCacheLimit(static_cast<size_t>(cfg.se_cache_size.Get()) * 1024 * 1024);
 }
 
 Game_ConfigAudio AudioInterface::GetConfig() const {
@@ -111,6 +111,15 @@ void AudioInterface::SE_SetGlobalVolume(int volume) {
 	cfg.sound_volume.Set(volume);
 }
 
+int AudioInterface::SE_GetCacheSize() const {
+	return cfg.se_cache_size.Get();
+}
+
+void AudioInterface::SE_SetCacheSize(int size) {
+	cfg.se_cache_size.Set(size);
+	AudioSeCache::SetCacheLimit(static_cast<size_t>(cfg.se_cache_size.Get()) * 1024 * 1024);
+}
+
 bool AudioInterface::GetFluidsynthEnabled() const {
 	return cfg.fluidsynth_midi.Get();
 }
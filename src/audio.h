@@ -150,6 +150,16 @@ struct AudioInterface {
 	int SE_GetGlobalVolume() const;
 	void SE_SetGlobalVolume(int volume);
 
+	/** @return memory limit of the SE cache in MB */
+	int SE_GetCacheSize() const;
+
+	/**
+	 * Sets the memory limit of the SE cache.
+	 *
+	 * @param size memory limit in MB
+	 */
+	void SE_SetCacheSize(int size);
+
 	bool GetFluidsynthEnabled() const;
 	void SetFluidsynthEnabled(bool enable);
 
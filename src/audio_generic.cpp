@@ -21,6 +21,7 @@
 #include <cassert>
 #include <memory>
 #include "audio_generic.h"
+#include "audio_mixer.h"
 #include "output.h"
 
 GenericAudio::GenericAudio(const Game_ConfigAudio& cfg) : AudioInterface(cfg) {
@@ -412,61 +413,10 @@ void GenericAudio::Decode(uint8_t* output_buffer, int buffer_length) {
 		//--------------------------------------------------------------------------------------------------------------------//
 
 		if (channel_used) {
-			for (unsigned ii = 0; ii < (unsigned)(read_bytes / (samplesize * channels)); ii++) {
-
-				float vall = vleft;
-				float valr = vright;
-
-				// Convert to floating point
-				switch (sampleformat) {
-					case AudioDecoder::Format::S8:
-						vall *= (((int8_t *) scrap_buffer.data())[ii * channels] / 128.0);
-						valr *= (((int8_t *) scrap_buffer.data())[ii * channels + 1] / 128.0);
-						break;
-					case AudioDecoder::Format::U8:
-						vall *= (((uint8_t *) scrap_buffer.data())[ii * channels] / 128.0 - 1.0);
-						valr *= (((uint8_t *) scrap_buffer.data())[ii * channels + 1] / 128.0 - 1.0);
-						break;
-					case AudioDecoder::Format::S16:
-						vall *= (((int16_t *) scrap_buffer.data())[ii * channels] / 32768.0);
-						valr *= (((int16_t *) scrap_buffer.data())[ii * channels + 1] / 32768.0);
-						break;
-					case AudioDecoder::Format::U16:
-						vall *= (((uint16_t *) scrap_buffer.data())[ii * channels] / 32768.0 - 1.0);
-						valr *= (((uint16_t *) scrap_buffer.data())[ii * channels + 1] / 32768.0 - 1.0);
-						break;
-					case AudioDecoder::Format::S32:
-						vall *= (((int32_t *) scrap_buffer.data())[ii * channels] / 2147483648.0);
-						valr *= (((int32_t *) scrap_buffer.data())[ii * channels + 1] / 2147483648.0);
-						break;
-					case AudioDecoder::Format::U32:
-						vall *= (((uint32_t *) scrap_buffer.data())[ii * channels] / 2147483648.0 - 1.0);
-						valr *= (((uint32_t *) scrap_buffer.data())[ii * channels + 1] / 2147483648.0 - 1.0);
-						break;
-					case AudioDecoder::Format::F32:
-						vall *= (((float *) scrap_buffer.data())[ii * channels]);
-						valr *= (((float *) scrap_buffer.data())[ii * channels + 1]);
-						break;
-				}
-
-				if (!channel_active) {
-					// first channel
-					mixer_buffer[ii * output_format.channels] = vall;
-					if (channels > 1) {
-						mixer_buffer[ii * output_format.channels + 1] = valr;
-					} else {
-						mixer_buffer[ii * output_format.channels + 1] = mixer_buffer[ii * output_format.channels];
-					}
-				} else {
-					mixer_buffer[ii * output_format.channels] += vall;
-					if (channels > 1) {
-						mixer_buffer[ii * output_format.channels + 1] += valr;
-					} else {
-						mixer_buffer[ii * output_format.channels + 1] = mixer_buffer[ii * output_format.channels];
-					}
-				}
-
-			}
+			// The first mixed channel overwrites the buffer, the others are added
+			const int frames = read_bytes / (samplesize * channels);
+			AudioMixer::Mix(mixer_buffer.data(), scrap_buffer.data(), sampleformat, channels, frames,
+				vleft, vright, channel_active);
 			channel_active = true;
 		}
 	}
@@ -0,0 +1,395 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <cstring>
+#include "audio_mixer.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define EP_AUDIO_MIXER_SSE2
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define EP_AUDIO_MIXER_NEON
+#  include <arm_neon.h>
+#endif
+
+// The volume product is rounded before it is accumulated, fused multiply-add
+// would break the bit exactness between the kernels
+#if defined(__clang__)
+#  pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#  pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace {
+	using AudioMixer::Kernel;
+	using Format = AudioDecoderBase::Format;
+
+	using MixFn = void (*)(float* out, const uint8_t* in, int frames, float vleft, float vright);
+
+	// Sample formats, Apply returns the volume scaled sample.
+	// The unsigned formats are biased by half of their range.
+	// Integers up to 16 bit and their scaling are exact in float.
+	struct S8 {
+		using type = int8_t;
+		static constexpr bool simd = true;
+		static constexpr float scale = 1.0f / 128.0f;
+		static float Apply(float v, type s) { return v * (s * scale); }
+	};
+
+	struct U8 {
+		using type = uint8_t;
+		static constexpr bool simd = true;
+		static constexpr float scale = 1.0f / 128.0f;
+		static float Apply(float v, type s) { return v * ((s - 128) * scale); }
+	};
+
+	struct S16 {
+		using type = int16_t;
+		static constexpr bool simd = true;
+		static constexpr float scale = 1.0f / 32768.0f;
+		static float Apply(float v, type s) { return v * (s * scale); }
+	};
+
+	struct U16 {
+		using type = uint16_t;
+		static constexpr bool simd = true;
+		static constexpr float scale = 1.0f / 32768.0f;
+		static float Apply(float v, type s) { return v * ((s - 32768) * scale); }
+	};
+
+	// 32 bit integers do not fit into float, the product is rounded once from double
+	struct S32 {
+		using type = int32_t;
+		static constexpr bool simd = false;
+		static float Apply(float v, type s) { return static_cast<float>(v * (s / 2147483648.0)); }
+	};
+
+	struct U32 {
+		using type = uint32_t;
+		static constexpr bool simd = false;
+		static float Apply(float v, type s) { return static_cast<float>(v * ((s - 2147483648.0) / 2147483648.0)); }
+	};
+
+	struct F32 {
+		using type = float;
+		static constexpr bool simd = true;
+		static constexpr float scale = 1.0f;
+		static float Apply(float v, type s) { return v * s; }
+	};
+
+	template <typename S, int Channels, bool Accumulate>
+	inline void mix_scalar(float* out, const typename S::type* in, int i, int frames, float vleft, float vright) {
+		for (; i < frames; ++i) {
+			const float l = S::Apply(vleft, in[i * Channels]);
+			const float r = (Channels == 2) ? S::Apply(vright, in[i * Channels + 1]) : l;
+			if (Accumulate) {
+				out[i * 2] += l;
+				out[i * 2 + 1] += r;
+			} else {
+				out[i * 2] = l;
+				out[i * 2 + 1] = r;
+			}
+		}
+	}
+
+	template <typename S, int Channels, bool Accumulate>
+	struct MixScalar {
+		static void Run(float* out, const uint8_t* in, int frames, float vleft, float vright) {
+			mix_scalar<S, Channels, Accumulate>(out, reinterpret_cast<const typename S::type*>(in), 0, frames, vleft, vright);
+		}
+	};
+
+	// More than two channels, only the first two are mixed
+	template <typename S>
+	void mix_strided(float* out, const uint8_t* in_bytes, int channels, int frames, float vleft, float vright, bool accumulate) {
+		const auto* in = reinterpret_cast<const typename S::type*>(in_bytes);
+		for (int i = 0; i < frames; ++i) {
+			const float l = S::Apply(vleft, in[i * channels]);
+			const float r = S::Apply(vright, in[i * channels + 1]);
+			if (accumulate) {
+				out[i * 2] += l;
+				out[i * 2 + 1] += r;
+			} else {
+				out[i * 2] = l;
+				out[i * 2 + 1] = r;
+			}
+		}
+	}
+
+#ifdef EP_AUDIO_MIXER_SSE2
+	// Loads 4 samples as float, not yet scaled
+	inline __m128 load4_sse2(const int8_t* in) {
+		int32_t bytes;
+		std::memcpy(&bytes, in, sizeof(bytes));
+		__m128i x = _mm_cvtsi32_si128(bytes);
+		x = _mm_unpacklo_epi8(x, x);
+		x = _mm_unpacklo_epi16(x, x);
+		return _mm_cvtepi32_ps(_mm_srai_epi32(x, 24));
+	}
+
+	inline __m128 load4_sse2(const uint8_t* in) {
+		int32_t bytes;
+		std::memcpy(&bytes, in, sizeof(bytes));
+		__m128i x = _mm_xor_si128(_mm_cvtsi32_si128(bytes), _mm_set1_epi8(static_cast<char>(0x80)));
+		x = _mm_unpacklo_epi8(x, x);
+		x = _mm_unpacklo_epi16(x, x);
+		return _mm_cvtepi32_ps(_mm_srai_epi32(x, 24));
+	}
+
+	inline __m128 load4_sse2(const int16_t* in) {
+		__m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+		return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+	}
+
+	inline __m128 load4_sse2(const uint16_t* in) {
+		__m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+		x = _mm_xor_si128(x, _mm_set1_epi16(static_cast<short>(0x8000)));
+		return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+	}
+
+	inline __m128 load4_sse2(const float* in) {
+		return _mm_loadu_ps(in);
+	}
+
+	template <bool Accumulate>
+	inline void store4_sse2(float* out, __m128 v) {
+		if (Accumulate) {
+			v = _mm_add_ps(_mm_loadu_ps(out), v);
+		}
+		_mm_storeu_ps(out, v);
+	}
+
+	template <typename S, int Channels, bool Accumulate>
+	struct MixSse2 {
+		static void Run(float* out, const uint8_t* in_bytes, int frames, float vleft, float vright) {
+			const auto* in = reinterpret_cast<const typename S::type*>(in_bytes);
+			int i = 0;
+			if constexpr (S::simd) {
+				const __m128 scale = _mm_set1_ps(S::scale);
+				if constexpr (Channels == 2) {
+					const __m128 vol = _mm_setr_ps(vleft, vright, vleft, vright);
+					for (; i + 2 <= frames; i += 2) {
+						store4_sse2<Accumulate>(out + i * 2, _mm_mul_ps(vol, _mm_mul_ps(load4_sse2(in + i * 2), scale)));
+					}
+				} else {
+					const __m128 vol = _mm_set1_ps(vleft);
+					for (; i + 4 <= frames; i += 4) {
+						const __m128 v = _mm_mul_ps(vol, _mm_mul_ps(load4_sse2(in + i), scale));
+						store4_sse2<Accumulate>(out + i * 2, _mm_unpacklo_ps(v, v));
+						store4_sse2<Accumulate>(out + i * 2 + 4, _mm_unpackhi_ps(v, v));
+					}
+				}
+			}
+			mix_scalar<S, Channels, Accumulate>(out, in, i, frames, vleft, vright);
+		}
+	};
+#endif
+
+#ifdef EP_AUDIO_MIXER_NEON
+	// Loads 4 samples as float, not yet scaled
+	inline float32x4_t load4_neon(const int8_t* in) {
+		const int32_t v[4] = { in[0], in[1], in[2], in[3] };
+		return vcvtq_f32_s32(vld1q_s32(v));
+	}
+
+	inline float32x4_t load4_neon(const uint8_t* in) {
+		const int32_t v[4] = { in[0] - 128, in[1] - 128, in[2] - 128, in[3] - 128 };
+		return vcvtq_f32_s32(vld1q_s32(v));
+	}
+
+	inline float32x4_t load4_neon(const int16_t* in) {
+		return vcvtq_f32_s32(vmovl_s16(vld1_s16(in)));
+	}
+
+	inline float32x4_t load4_neon(const uint16_t* in) {
+		const int32x4_t v = vreinterpretq_s32_u32(vmovl_u16(vld1_u16(in)));
+		return vcvtq_f32_s32(vsubq_s32(v, vdupq_n_s32(32768)));
+	}
+
+	inline float32x4_t load4_neon(const float* in) {
+		return vld1q_f32(in);
+	}
+
+	template <bool Accumulate>
+	inline void store4_neon(float* out, float32x4_t v) {
+		if (Accumulate) {
+			v = vaddq_f32(vld1q_f32(out), v);
+		}
+		vst1q_f32(out, v);
+	}
+
+	template <typename S, int Channels, bool Accumulate>
+	struct MixNeon {
+		static void Run(float* out, const uint8_t* in_bytes, int frames, float vleft, float vright) {
+			const auto* in = reinterpret_cast<const typename S::type*>(in_bytes);
+			int i = 0;
+			if constexpr (S::simd) {
+				const float32x4_t scale = vdupq_n_f32(S::scale);
+				if constexpr (Channels == 2) {
+					const float vols[4] = { vleft, vright, vleft, vright };
+					const float32x4_t vol = vld1q_f32(vols);
+					for (; i + 2 <= frames; i += 2) {
+						store4_neon<Accumulate>(out + i * 2, vmulq_f32(vol, vmulq_f32(load4_neon(in + i * 2), scale)));
+					}
+				} else {
+					const float32x4_t vol = vdupq_n_f32(vleft);
+					for (; i + 4 <= frames; i += 4) {
+						const float32x4_t v = vmulq_f32(vol, vmulq_f32(load4_neon(in + i), scale));
+						const float32x4x2_t wide = vzipq_f32(v, v);
+						store4_neon<Accumulate>(out + i * 2, wide.val[0]);
+						store4_neon<Accumulate>(out + i * 2 + 4, wide.val[1]);
+					}
+				}
+			}
+			mix_scalar<S, Channels, Accumulate>(out, in, i, frames, vleft, vright);
+		}
+	};
+#endif
+
+	template <template <typename, int, bool> class K, typename S>
+	MixFn select_layout(int channels, bool accumulate) {
+		if (channels == 1) {
+			return accumulate ? &K<S, 1, true>::Run : &K<S, 1, false>::Run;
+		}
+		return accumulate ? &K<S, 2, true>::Run : &K<S, 2, false>::Run;
+	}
+
+	template <template <typename, int, bool> class K>
+	MixFn select_format(Format format, int channels, bool accumulate) {
+		switch (format) {
+			case Format::S8:
+				return select_layout<K, S8>(channels, accumulate);
+			case Format::U8:
+				return select_layout<K, U8>(channels, accumulate);
+			case Format::S16:
+				return select_layout<K, S16>(channels, accumulate);
+			case Format::U16:
+				return select_layout<K, U16>(channels, accumulate);
+			case Format::S32:
+				return select_layout<K, S32>(channels, accumulate);
+			case Format::U32:
+				return select_layout<K, U32>(channels, accumulate);
+			case Format::F32:
+				return select_layout<K, F32>(channels, accumulate);
+		}
+		return nullptr;
+	}
+
+	void mix_strided(Format format, float* out, const uint8_t* in, int channels, int frames, float vleft, float vright, bool accumulate) {
+		switch (format) {
+			case Format::S8:
+				return mix_strided<S8>(out, in, channels, frames, vleft, vright, accumulate);
+			case Format::U8:
+				return mix_strided<U8>(out, in, channels, frames, vleft, vright, accumulate);
+			case Format::S16:
+				return mix_strided<S16>(out, in, channels, frames, vleft, vright, accumulate);
+			case Format::U16:
+				return mix_strided<U16>(out, in, channels, frames, vleft, vright, accumulate);
+			case Format::S32:
+				return mix_strided<S32>(out, in, channels, frames, vleft, vright, accumulate);
+			case Format::U32:
+				return mix_strided<U32>(out, in, channels, frames, vleft, vright, accumulate);
+			case Format::F32:
+				return mix_strided<F32>(out, in, channels, frames, vleft, vright, accumulate);
+		}
+	}
+
+	constexpr Kernel detect_kernel() {
+#ifdef EP_AUDIO_MIXER_SSE2
+		return Kernel::SSE2;
+#elif defined(EP_AUDIO_MIXER_NEON)
+		return Kernel::NEON;
+#else
+		return Kernel::Scalar;
+#endif
+	}
+}
+
+bool AudioMixer::IsSupported(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::Scalar:
+			return true;
+		case Kernel::SSE2:
+#ifdef EP_AUDIO_MIXER_SSE2
+			return true;
+#else
+			return false;
+#endif
+		case Kernel::NEON:
+#ifdef EP_AUDIO_MIXER_NEON
+			return true;
+#else
+			return false;
+#endif
+	}
+	return false;
+}
+
+const char* AudioMixer::GetKernelName(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::Scalar:
+			return "Scalar";
+		case Kernel::SSE2:
+			return "SSE2";
+		case Kernel::NEON:
+			return "NEON";
+	}
+	return "Unknown";
+}
+
+AudioMixer::Kernel AudioMixer::GetKernel() {
+	return detect_kernel();
+}
+
+void AudioMixer::Mix(float* out, const uint8_t* in, AudioDecoderBase::Format format, int channels, int frames,
+		float vleft, float vright, bool accumulate) {
+	Mix(detect_kernel(), out, in, format, channels, frames, vleft, vright, accumulate);
+}
+
+void AudioMixer::Mix(Kernel kernel, float* out, const uint8_t* in, AudioDecoderBase::Format format, int channels, int frames,
+		float vleft, float vright, bool accumulate) {
+	if (frames <= 0 || channels <= 0) {
+		return;
+	}
+
+	if (channels > 2) {
+		mix_strided(format, out, in, channels, frames, vleft, vright, accumulate);
+		return;
+	}
+
+	MixFn fn = nullptr;
+	switch (kernel) {
+#ifdef EP_AUDIO_MIXER_SSE2
+		case Kernel::SSE2:
+			fn = select_format<MixSse2>(format, channels, accumulate);
+			break;
+#endif
+#ifdef EP_AUDIO_MIXER_NEON
+		case Kernel::NEON:
+			fn = select_format<MixNeon>(format, channels, accumulate);
+			break;
+#endif
+		default:
+			fn = select_format<MixScalar>(format, channels, accumulate);
+			break;
+	}
+
+	if (fn) {
+		fn(out, in, frames, vleft, vright);
+	}
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_AUDIO_MIXER_H
+#define EP_AUDIO_MIXER_H
+
+// Headers
+#include <cstdint>
+#include "audio_decoder_base.h"
+
+/**
+ * Convert and accumulate kernels of the GenericAudio mixer.
+ *
+ * Decoded samples of one channel are converted to float, scaled by the
+ * channel volume and written or added to an interleaved stereo buffer.
+ * Mono channels are widened to both output channels with the left volume.
+ * A kernel is specialised for every sample format and channel layout and
+ * picked once per call. The results are bit exact to the scalar kernel,
+ * 32 bit integer samples are converted with double precision.
+ */
+namespace AudioMixer {
+
+enum class Kernel {
+	Scalar,
+	SSE2,
+	NEON
+};
+
+/**
+ * Mixes one channel with the fastest kernel supported by the CPU.
+ *
+ * @param out interleaved stereo buffer, holds 2 * frames floats
+ * @param in interleaved samples
+ * @param format sample format of in
+ * @param channels channel count of in, the first two channels are mixed
+ * @param frames number of frames
+ * @param vleft left volume
+ * @param vright right volume
+ * @param accumulate false to overwrite out, true to add to it
+ */
+void Mix(float* out, const uint8_t* in, AudioDecoderBase::Format format, int channels, int frames,
+		float vleft, float vright, bool accumulate);
+
+/**
+ * Mixes one channel with a specific kernel.
+ * Falls back to the scalar kernel when the kernel is not supported.
+ *
+ * @see Mix
+ */
+void Mix(Kernel kernel, float* out, const uint8_t* in, AudioDecoderBase::Format format, int channels, int frames,
+		float vleft, float vright, bool accumulate);
+
+/** @return kernel used by Mix */
+Kernel GetKernel();
+
+/**
+ * @param kernel kernel to check
+ * @return Whether the kernel was compiled in
+ */
+bool IsSupported(Kernel kernel);
+
+/** @return name of the kernel, for logging */
+const char* GetKernelName(Kernel kernel);
+
+} // namespace AudioMixer
+
+#endif
@@ -18,48 +18,83 @@
 // Headers
 #include <cassert>
 #include <cstring>
-#include <map>
+#include <list>
 #include <memory>
-#include <set>
+#include <unordered_map>
 #include "audio_resampler.h"
 #include "audio_secache.h"
 #include "game_clock.h"
 #include "filefinder.h"
 #include "output.h"
 
-using namespace std::chrono_literals;
-
 namespace {
-	typedef std::map<std::string, AudioSeRef> cache_type;
+	struct CacheEntry {
+		/** Interned name, the lookup table keys point into it */
+		std::string name;
+		AudioSeRef se;
+		/** Inserted by Predecode and not looked up since */
+		bool predecoded;
+	};
 
-	cache_type cache;
+	/** Cached samples, most recently used first */
+	typedef std::list<CacheEntry> lru_type;
 
-	constexpr int cache_limit = 3 * 1024 * 1024;
-	int cache_size = 0;
+	lru_type lru;
+	std::unordered_map<std::string_view, lru_type::iterator> cache;
 
-	void FreeCacheMemory() {
-		auto cur_time = Game_Clock::GetFrameTime();
+	size_t cache_limit = 3 * 1024 * 1024;
+	size_t cache_size = 0;
 
-		for (auto it = cache.begin(); it != cache.end(); ) {
-			if (it->second.use_count() > 1) {
-				// SE is currently playing
-				++it;
-				continue;
+	AudioSeCache::Stats stats;
+
+	AudioSeRef Find(std::string_view name) {
+		auto it = cache.find(name);
+		if (it == cache.end()) {
+			return {};
+		}
+
+		// Mark as most recently used
+		lru.splice(lru.begin(), lru, it->second);
+		return it->second->se;
+	}
+
+	/** @return the cached samples, the already cached ones when the name is in the cache */
+	AudioSeRef Insert(std::string_view name, AudioSeRef se, bool recently_used) {
+		auto found = cache.find(name);
+		if (found != cache.end()) {
+			// Decoded twice, keep the cached samples so the entry stays unique
+			auto it = found->second;
+			if (recently_used) {
+				it->predecoded = false;
+				lru.splice(lru.begin(), lru, it);
 			}
+			return it->se;
+		}
+
+		auto it = lru.insert(recently_used ? lru.begin() : lru.end(), CacheEntry{ ToString(name), std::move(se), !recently_used });
+		cache.emplace(it->name, it);
+		cache_size += it->se->buffer.size();
+		return it->se;
+	}
 
-			if (cache_size <= cache_limit && cur_time - it->second->last_access < 3s) {
-				// Below memory limit and last access < 3s
-				++it;
+	void FreeCacheMemory() {
+		// Free the least recently used samples first
+		for (auto it = lru.end(); cache_size > cache_limit && it != lru.begin(); ) {
+			--it;
+
+			if (it->se.use_count() > 1) {
+				// SE is currently playing
 				continue;
 			}
 
 #ifdef CACHE_DEBUG
-			Output::Debug("SE: Freeing memory of {}", it->first);
+			Output::Debug("SE: Freeing memory of {}", it->name);
 #endif
 
-			cache_size -= it->second->buffer.size();
-
-			it = cache.erase(it);
+			cache_size -= it->se->buffer.size();
+			cache.erase(it->name);
+			it = lru.erase(it);
+			++stats.evictions;
 		}
 
 #ifdef CACHE_DEBUG
@@ -72,8 +107,8 @@ std::unique_ptr<AudioSeCache> AudioSeCache::Create(Filesystem_Stream::InputStrea
 	auto se = std::make_unique<AudioSeCache>();
 	se->name = ToString(name);
 
-	auto const it = cache.find(ToString(name));
-	if (it == cache.end()) {
+	se->se_data = Find(name);
+	if (!se->se_data) {
 		// Not in cache
 		if (!stream) {
 			return {};
@@ -108,88 +143,144 @@ void AudioSeCache::GetFormat(int& frequency, AudioDecoder::Format& format, int&
 }
 
 std::unique_ptr<AudioSeCache> AudioSeCache::GetCachedSe(std::string_view name) {
-	auto se = std::make_unique<AudioSeCache>();
-	se->name = ToString(name);
-
-	auto const it = cache.find(se->name);
-	if (it == cache.end()) {
+	auto se_data = Find(name);
+	if (!se_data) {
+		++stats.misses;
 		return {};
 	}
 
+	++stats.hits;
+
+	// Find moved the entry to the front
+	if (lru.front().predecoded) {
+		lru.front().predecoded = false;
+		++stats.predecode_hits;
+	}
+
+	auto se = std::make_unique<AudioSeCache>();
+	se->name = ToString(name);
+	se->se_data = std::move(se_data);
+
 	return se;
 }
 
 bool AudioSeCache::GetCachedFormat(int& frequency, AudioDecoder::Format& format, int& channels) const {
-	cache_type::const_iterator it = cache.find(name);
-
-	if (it != cache.end()) {
-		frequency = (*it).second->frequency;
-		format = (*it).second->format;
-		channels = (*it).second->channels;
+	if (se_data) {
+		frequency = se_data->frequency;
+		format = se_data->format;
+		channels = se_data->channels;
 
 		return true;
 	}
 
-	return false;
-}
-
-std::unique_ptr<AudioDecoderBase> AudioSeCache::CreateSeDecoder() {
-	AudioSeRef se;
-
 	auto it = cache.find(name);
+
 	if (it != cache.end()) {
-		se = it->second;
-		se->last_access = Game_Clock::GetFrameTime();
+		const auto& se = it->second->se;
+		frequency = se->frequency;
+		format = se->format;
+		channels = se->channels;
 
-		std::unique_ptr<AudioDecoderBase> dec = std::make_unique<AudioSeDecoder>(se);
-#ifdef USE_AUDIO_RESAMPLER
-		dec = std::make_unique<AudioResampler>(std::move(dec));
-#endif
-		Filesystem_Stream::InputStream is;
-		dec->Open(std::move(is));
-		return dec;
+		return true;
 	}
 
-	// Not cached yet: Decode the sample without any resampling
+	return false;
+}
 
-	if (!se) {
-		se.reset(new AudioSeData());
-	}
+AudioSeRef AudioSeCache::Decode() {
+	// Decode the sample without any resampling
+	AudioSeRef se = std::make_shared<AudioSeData>();
 
 	assert(audio_decoder);
 
 	audio_decoder->GetFormat(se->frequency, se->format, se->channels);
 	se->buffer = audio_decoder->DecodeAll();
+	audio_decoder.reset();
 
-	cache.insert(std::make_pair(name, se));
+	return se;
+}
 
-	cache_size += se->buffer.size();
+std::unique_ptr<AudioDecoderBase> AudioSeCache::CreateSeDecoder() {
+	if (!se_data) {
+		se_data = Find(name);
+	}
+
+	if (se_data) {
+		se_data->last_access = Game_Clock::GetFrameTime();
+	} else {
+		se_data = Insert(name, Decode(), true);
 
 #ifdef CACHE_DEBUG
-	Output::Debug("SE cache size (Add): {}", cache_size / 1024.0 / 1024.0);
+		Output::Debug("SE cache size (Add): {}", cache_size / 1024.0 / 1024.0);
 #endif
 
-	FreeCacheMemory();
+		FreeCacheMemory();
+	}
 
-	std::unique_ptr<AudioDecoderBase> dec = std::unique_ptr<AudioDecoderBase>(new AudioSeDecoder(se));
+	std::unique_ptr<AudioDecoderBase> dec = std::make_unique<AudioSeDecoder>(se_data);
 #ifdef USE_AUDIO_RESAMPLER
-	dec = std::unique_ptr<AudioDecoderBase>(new AudioResampler(std::move(dec)));
+	dec = std::make_unique<AudioResampler>(std::move(dec));
 #endif
 	Filesystem_Stream::InputStream is;
 	dec->Open(std::move(is));
 	return dec;
 }
 
+bool AudioSeCache::Predecode() {
+	if (se_data || IsCached(name)) {
+		return true;
+	}
+
+	if (IsFull() || !audio_decoder) {
+		return false;
+	}
+
+	// Not played yet, freed before any played sample
+	se_data = Decode();
+	se_data->last_access = Game_Clock::GetFrameTime();
+	se_data = Insert(name, se_data, false);
+	++stats.predecoded;
+
+	return true;
+}
+
 AudioSeRef AudioSeCache::GetSeData() const {
+	if (se_data) {
+		return se_data;
+	}
+
 	auto it = cache.find(name);
 	assert(it != cache.end());
 
-	return it->second;
+	return it->second->se;
 };
 
+bool AudioSeCache::IsCached(std::string_view name) {
+	return cache.find(name) != cache.end();
+}
+
+bool AudioSeCache::IsFull() {
+	return cache_size >= cache_limit;
+}
+
+void AudioSeCache::SetCacheLimit(size_t bytes) {
+	cache_limit = bytes;
+	FreeCacheMemory();
+}
+
+AudioSeCache::Stats AudioSeCache::GetStats() {
+	Stats result = stats;
+	result.entries = static_cast<int>(cache.size());
+	result.size = cache_size;
+	result.limit = cache_limit;
+	return result;
+}
+
 void AudioSeCache::Clear() {
 	cache_size = 0;
 	cache.clear();
+	lru.clear();
+	stats = {};
 }
 
 std::string_view AudioSeCache::GetName() const {
@@ -23,7 +23,6 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <map>
 
 #include "audio_decoder.h"
 #include "game_clock.h"
@@ -70,12 +69,32 @@ private:
  * AudioSeCache provides an interface for accessing sound effects.
  * It also provides an automatic cache management, any SE is only decoded
  * once, otherwise returned from the cache.
- * The cache is flushed from recently (>10 seconds by default) unused
- * samples when it reaches the memory limit (5 MB by default).
+ * When the decoded samples exceed the memory limit (3 MB by default) the
+ * least recently used samples that are not playing are freed.
  * Uses an internal AudioDecoder for handling the decoding.
  */
 class AudioSeCache {
 public:
+	/** Counters of the cache, reset by Clear */
+	struct Stats {
+		/** Lookups of SEs that were already decoded */
+		int hits = 0;
+		/** Lookups of SEs that were not decoded yet */
+		int misses = 0;
+		/** SEs freed because the memory limit was reached */
+		int evictions = 0;
+		/** SEs decoded ahead of time by Predecode */
+		int predecoded = 0;
+		/** Hits on predecoded SEs that were not used before */
+		int predecode_hits = 0;
+		/** Amount of cached SEs */
+		int entries = 0;
+		/** Bytes used by the decoded samples */
+		size_t size = 0;
+		/** Memory limit in bytes */
+		size_t limit = 0;
+	};
+
 	/**
 	 * Opens the passed filename with the internal audio decoder.
 	 *
@@ -125,6 +144,15 @@ public:
 	 */
 	std::unique_ptr<AudioDecoderBase> CreateSeDecoder();
 
+	/**
+	 * Decodes the whole sample into the cache without creating a decoder.
+	 * Does nothing when the SE is already cached or the memory limit is
+	 * reached, predecoding never evicts other samples.
+	 *
+	 * @return Whether the SE is cached afterwards
+	 */
+	bool Predecode();
+
 	/**
 	 * Returns the SE sample data handled by this SeCache.
 	 *
@@ -137,10 +165,37 @@ public:
 	 */
 	std::string_view GetName() const;
 
+	/**
+	 * Checks whether an SE is cached without counting a cache hit or miss.
+	 *
+	 * @param name Cache entry name
+	 * @return Whether the SE is cached
+	 */
+	static bool IsCached(std::string_view name);
+
+	/** @return Whether the decoded samples reached the memory limit */
+	static bool IsFull();
+
+	/**
+	 * Sets the memory limit of the decoded samples.
+	 * Unused samples are freed until the cache fits into the new limit.
+	 *
+	 * @param bytes Memory limit in bytes
+	 */
+	static void SetCacheLimit(size_t bytes);
+
+	/** @return cache counters and memory usage */
+	static Stats GetStats();
+
 	static void Clear();
 private:
+	AudioSeRef Decode();
+
 	std::unique_ptr<AudioDecoderBase> audio_decoder;
 
+	/** Keeps a cached sample alive until the decoder is created */
+	AudioSeRef se_data;
+
 	std::string name;
 };
 
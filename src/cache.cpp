@@ -20,7 +20,9 @@
 #  pragma warning(disable: 4003)
 #endif
 
-#include <map>
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
 #include <tuple>
 #include <chrono>
 #include <cassert>
@@ -73,6 +75,8 @@ namespace {
 	struct CacheItem {
 		BitmapRef bitmap;
 		Game_Clock::time_point last_access;
+		/** Added by a prefetch and not used since */
+		bool prefetched;
 	};
 
 	using key_type = std::string;
@@ -81,9 +85,74 @@ namespace {
 	using tile_key_type = std::string;
 	std::unordered_map<tile_key_type, std::weak_ptr<Bitmap>> cache_tiles;
 
-	// rect, flip_x, flip_y, tone, blend
-	using effect_key_type = std::tuple<std::string, bool, Rect, bool, bool, Tone, Color>;
-	std::map<effect_key_type, std::weak_ptr<Bitmap>> cache_effects;
+	struct EffectKey {
+		/** Interned bitmap ID, 0 when the bitmap has no ID */
+		int id;
+		/** Source bitmap, only set when the bitmap has no ID */
+		const Bitmap* bitmap;
+		bool transparent;
+		Rect rect;
+		bool flip_x;
+		bool flip_y;
+		Tone tone;
+		Color blend;
+	};
+
+	bool operator==(const EffectKey& l, const EffectKey& r) {
+		return std::tie(l.id, l.bitmap, l.transparent, l.rect, l.flip_x, l.flip_y, l.tone, l.blend) ==
+			std::tie(r.id, r.bitmap, r.transparent, r.rect, r.flip_x, r.flip_y, r.tone, r.blend);
+	}
+
+	struct EffectKeyHash {
+		size_t operator()(const EffectKey& k) const {
+			size_t h = std::hash<const Bitmap*>()(k.bitmap);
+			auto combine = [&h](size_t v) {
+				h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+			};
+			combine(k.id);
+			combine((k.transparent << 2) | (k.flip_x << 1) | k.flip_y);
+			combine((static_cast<size_t>(k.rect.x) << 16) ^ k.rect.y);
+			combine((static_cast<size_t>(k.rect.width) << 16) ^ k.rect.height);
+			combine((static_cast<size_t>(k.tone.red) << 24) ^ (k.tone.green << 16) ^ (k.tone.blue << 8) ^ k.tone.gray);
+			combine((static_cast<size_t>(k.blend.red) << 24) | (k.blend.green << 16) | (k.blend.blue << 8) | k.blend.alpha);
+			return h;
+		}
+	};
+
+	std::unordered_map<EffectKey, std::weak_ptr<Bitmap>, EffectKeyHash> cache_effects;
+
+	/** Bitmap IDs of effect keys, the lookup table keys point into the storage */
+	std::deque<std::string> effect_id_storage;
+	std::unordered_map<std::string_view, int> effect_ids;
+
+	/** Size of cache_effects that triggers the next removal of expired entries */
+	constexpr size_t effect_purge_min = 256;
+	size_t effect_purge_size = effect_purge_min;
+
+	int InternEffectId(std::string_view id) {
+		auto it = effect_ids.find(id);
+		if (it != effect_ids.end()) {
+			return it->second;
+		}
+
+		effect_id_storage.emplace_back(id);
+		int value = static_cast<int>(effect_id_storage.size());
+		effect_ids.emplace(effect_id_storage.back(), value);
+		return value;
+	}
+
+	void PurgeExpiredEffects() {
+		for (auto it = cache_effects.begin(); it != cache_effects.end();) {
+			if (it->second.expired()) {
+				it = cache_effects.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		// Amortized over the insertions until the next purge
+		effect_purge_size = std::max(effect_purge_min, cache_effects.size() * 2);
+	}
 
 	std::string system_name;
 
@@ -92,6 +161,11 @@ namespace {
 	constexpr int cache_limit = 10 * 1024 * 1024;
 	size_t cache_size = 0;
 
+	/** Memory used by prefetched images that were not used yet */
+	size_t prefetch_limit = 8 * 1024 * 1024;
+	size_t prefetch_size = 0;
+	Cache::PrefetchStats prefetch_stats;
+
 	void FreeBitmapMemory() {
 		auto cur_ticks = Game_Clock::GetFrameTime();
 
@@ -103,8 +177,15 @@ namespace {
 			}
 
 			auto last_access = cur_ticks - it->second.last_access;
-			bool cache_exhausted = cache_size > cache_limit;
-			if (cache_exhausted) {
+			// Prefetched images have their own budget
+			bool cache_exhausted = cache_size - prefetch_size > cache_limit;
+			if (it->second.prefetched) {
+				// Not needed yet, the player didn't reach the event that uses it
+				if (last_access <= 30s) {
+					++it;
+					continue;
+				}
+			} else if (cache_exhausted) {
 				if (last_access <= 50ms) {
 					// Used during the last 3 frames, must be important, keep it.
 					++it;
@@ -120,6 +201,10 @@ namespace {
 #endif
 
 			cache_size -= it->second.bitmap->GetSize();
+			if (it->second.prefetched) {
+				prefetch_size -= it->second.bitmap->GetSize();
+				++prefetch_stats.unused;
+			}
 
 			it = cache.erase(it);
 		}
@@ -137,7 +222,17 @@ namespace {
 #endif
 		}
 
-		return (cache[key] = {bmp, Game_Clock::GetFrameTime()}).bitmap;
+		return (cache[key] = {bmp, Game_Clock::GetFrameTime(), false}).bitmap;
+	}
+
+	BitmapRef UseCacheItem(CacheItem& item) {
+		item.last_access = Game_Clock::GetFrameTime();
+		if (item.prefetched) {
+			item.prefetched = false;
+			prefetch_size -= item.bitmap->GetSize();
+			++prefetch_stats.hits;
+		}
+		return item.bitmap;
 	}
 
 	struct Material {
@@ -235,6 +330,29 @@ namespace {
 		return s.dummy_renderer();
 	}
 
+	uint32_t GetMaterialFlags(Material::Type type) {
+		return Bitmap::Flag_ReadOnly | (
+				type == Material::Chipset ? Bitmap::Flag_Chipset :
+				type == Material::System ? Bitmap::Flag_System : 0);
+	}
+
+	/** Rejects decoded images that are not supported by the current engine, nullptr when invalid */
+	BitmapRef ValidateBitmap(const Spec& s, std::string_view filename, BitmapRef bmp) {
+		if (!bmp) {
+			Output::Warning("Invalid image: {}/{}", s.directory, filename);
+		} else {
+			if (bmp->GetOriginalBpp() > 8) {
+				// FIXME: This HasActiveTranslation check will also load 32 bit images in the game directory when
+				// a translation is active and our API does not expose whether the asset was redirected or not.
+				if (!Player::HasEasyRpgExtensions() && !Player::IsPatchManiac() && !Tr::HasActiveTranslation()) {
+					Output::Warning("Image {}/{} has a bit depth of {} that is not supported by RPG_RT. Enable EasyRPG Extensions or Maniac Patch to load such images.", s.directory, filename, bmp->GetOriginalBpp());
+					bmp.reset();
+				}
+			}
+		}
+		return bmp;
+	}
+
 	template<Material::Type T>
 	BitmapRef LoadBitmap(std::string_view filename, bool transparent, uint32_t extra_flags = 0) {
 		static_assert(Material::REND < T && T < Material::END, "Invalid material.");
@@ -267,24 +385,8 @@ namespace {
 						bmp = CreateEmpty<T>();
 					}
 				} else {
-					auto flags = Bitmap::Flag_ReadOnly | (
-							T == Material::Chipset ? Bitmap::Flag_Chipset :
-							T == Material::System ? Bitmap::Flag_System : 0);
-					flags |= extra_flags;
-
-					bmp = Bitmap::Create(std::move(is), transparent, flags);
-					if (!bmp) {
-						Output::Warning("Invalid image: {}/{}", s.directory, filename);
-					} else {
-						if (bmp->GetOriginalBpp() > 8) {
-							// FIXME: This HasActiveTranslation check will also load 32 bit images in the game directory when
-							// a translation is active and our API does not expose whether the asset was redirected or not.
-							if (!Player::HasEasyRpgExtensions() && !Player::IsPatchManiac() && !Tr::HasActiveTranslation()) {
-								Output::Warning("Image {}/{} has a bit depth of {} that is not supported by RPG_RT. Enable EasyRPG Extensions or Maniac Patch to load such images.", s.directory, filename, bmp->GetOriginalBpp());
-								bmp.reset();
-							}
-						}
-					}
+					auto flags = GetMaterialFlags(T) | extra_flags;
+					bmp = ValidateBitmap(s, filename, Bitmap::Create(std::move(is), transparent, flags));
 				}
 			}
 
@@ -295,8 +397,7 @@ namespace {
 
 			bmp = AddToCache(key, bmp);
 		} else {
-			it->second.last_access = Game_Clock::GetFrameTime();
-			bmp = it->second.bitmap;
+			bmp = UseCacheItem(it->second);
 		}
 
 		assert(bmp);
@@ -408,6 +509,73 @@ BitmapRef Cache::System(std::string_view file, bool bg_preserve_transparent_colo
 	return LoadBitmap<Material::System>(file, flags);
 }
 
+bool Cache::GetDecodeParams(std::string_view folder_name, bool& transparent, uint32_t& flags) {
+	for (int i = 0; i < Material::END; ++i) {
+		const Spec& s = spec[i];
+		if (folder_name == s.directory) {
+			transparent = s.transparent;
+			flags = GetMaterialFlags(static_cast<Material::Type>(i));
+			if (i == Material::System && Player::IsRPG2k()) {
+				// Same as Cache::System
+				flags |= Bitmap::Flag_SystemBgPreserveColor;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void Cache::AddDecoded(std::string_view folder_name, std::string_view filename, BitmapRef bmp, bool prefetch) {
+	for (int i = 0; i < Material::END; ++i) {
+		const Spec& s = spec[i];
+		if (folder_name != s.directory) {
+			continue;
+		}
+
+		bool transparent;
+		uint32_t flags;
+		GetDecodeParams(folder_name, transparent, flags);
+
+		const auto key = MakeHashKey(s.directory, filename, transparent, flags & ~GetMaterialFlags(static_cast<Material::Type>(i)));
+		if (cache.find(key) != cache.end()) {
+			// Was loaded in the meantime
+			return;
+		}
+
+		FreeBitmapMemory();
+
+		bmp = ValidateBitmap(s, filename, std::move(bmp));
+		if (!bmp) {
+			bmp = s.dummy_renderer();
+		}
+
+		if (prefetch) {
+			if (prefetch_size + bmp->GetSize() > prefetch_limit) {
+				// Loaded again when it is used
+				++prefetch_stats.dropped;
+				return;
+			}
+			prefetch_size += bmp->GetSize();
+			++prefetch_stats.prefetched;
+		}
+
+		AddToCache(key, std::move(bmp));
+		cache[key].prefetched = prefetch;
+		return;
+	}
+}
+
+Cache::PrefetchStats Cache::GetPrefetchStats() {
+	auto stats = prefetch_stats;
+	stats.size = prefetch_size;
+	stats.limit = prefetch_limit;
+	return stats;
+}
+
+void Cache::SetPrefetchLimit(size_t limit) {
+	prefetch_limit = limit;
+}
+
 BitmapRef Cache::Exfont() {
 	const auto key = MakeHashKey("ExFont", "ExFont", false);
 
@@ -470,17 +638,15 @@ BitmapRef Cache::Tile(std::string_view filename, int tile_id) {
 }
 
 BitmapRef Cache::SpriteEffect(const BitmapRef& src_bitmap, const Rect& rect, bool flip_x, bool flip_y, const Tone& tone, const Color& blend) {
-	std::string id = ToString(src_bitmap->GetId());
+	auto id = src_bitmap->GetId();
 
-	if (id.empty()) {
-		// Log causes false positives when empty bitmaps or placeholder (checkerboard)
-		// bitmaps are used.
-		//Output::Debug("Bitmap has no ID. Please report a bug!");
-		id = fmt::format("{}", (void*)(src_bitmap.get()));
-	}
+	// Log causes false positives when empty bitmaps or placeholder (checkerboard)
+	// bitmaps are used.
+	//if (id.empty()) Output::Debug("Bitmap has no ID. Please report a bug!");
 
-	const effect_key_type key {
-		id,
+	const EffectKey key {
+		id.empty() ? 0 : InternEffectId(id),
+		id.empty() ? src_bitmap.get() : nullptr,
 		src_bitmap->GetTransparent(),
 		rect,
 		flip_x,
@@ -525,14 +691,28 @@ BitmapRef Cache::SpriteEffect(const BitmapRef& src_bitmap, const Rect& rect, boo
 
 		assert(bitmap_effects && "Effect cache used but no effect applied!");
 
-		return(cache_effects[key] = bitmap_effects).lock();
+		if (it != cache_effects.end()) {
+			it->second = bitmap_effects;
+		} else {
+			if (cache_effects.size() >= effect_purge_size) {
+				PurgeExpiredEffects();
+			}
+			cache_effects.emplace(key, bitmap_effects);
+		}
+
+		return bitmap_effects;
 	} else { return it->second.lock(); }
 }
 
 void Cache::Clear() {
 	cache_effects.clear();
+	effect_ids.clear();
+	effect_id_storage.clear();
+	effect_purge_size = effect_purge_min;
 	cache.clear();
 	cache_size = 0;
+	prefetch_size = 0;
+	prefetch_stats = {};
 
 	for (auto& kv : cache_tiles) {
 		auto& key = kv.first;
@@ -61,6 +61,56 @@ namespace Cache {
 	void Clear();
 	void ClearAll();
 
+	/**
+	 * Determines how images of a folder are decoded by the default loader
+	 * of the folder, e.g. Cache::Charset for "CharSet".
+	 *
+	 * @param folder_name folder name
+	 * @param transparent receives the transparency flag
+	 * @param flags receives the Bitmap flags
+	 * @return false when the folder contains no images
+	 */
+	bool GetDecodeParams(std::string_view folder_name, bool& transparent, uint32_t& flags);
+
+	/**
+	 * Adds an image that was decoded outside of the cache with the
+	 * parameters of GetDecodeParams, e.g. by a background thread.
+	 * Invalid images are replaced by a placeholder like on a normal load.
+	 *
+	 * @param folder_name folder name
+	 * @param filename image name
+	 * @param bmp decoded image, nullptr when decoding failed
+	 * @param prefetch image is not needed yet, it is kept until it is used
+	 *                 as long as the prefetch budget allows it
+	 */
+	void AddDecoded(std::string_view folder_name, std::string_view filename, BitmapRef bmp, bool prefetch = false);
+
+	/** Counters of prefetched images, reset by Clear */
+	struct PrefetchStats {
+		/** Images added by a prefetch */
+		int prefetched = 0;
+		/** Prefetched images that were used */
+		int hits = 0;
+		/** Prefetched images freed before they were used */
+		int unused = 0;
+		/** Prefetched images discarded because the budget was exhausted */
+		int dropped = 0;
+		/** Bytes used by prefetched images that were not used yet */
+		size_t size = 0;
+		/** Prefetch budget in bytes */
+		size_t limit = 0;
+	};
+
+	/** @return prefetch counters */
+	PrefetchStats GetPrefetchStats();
+
+	/**
+	 * Sets the memory budget of prefetched images that were not used yet.
+	 *
+	 * @param limit budget in bytes
+	 */
+	void SetPrefetchLimit(size_t limit);
+
 	/** @return the configured system bitmap, or nullptr if there is no system */
 	BitmapRef System(bool bg_preserve_transparent_color = false);
 
@@ -0,0 +1,149 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "doom_rasterizer.h"
+#include "bitmap.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	const Color upper_color = Color(255, 0, 0, 255);
+
+	inline float Edge(const DoomRasterizer::Vertex& a, const DoomRasterizer::Vertex& b, float x, float y) {
+		return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+	}
+
+	inline uint32_t ToPixel(const Color& color) {
+		return Bitmap::pixel_format.rgba_to_uint32_t(color.red, color.green, color.blue, 255);
+	}
+}
+
+void DoomRasterizer::Begin(Bitmap& dst, Bitmap* upper) {
+	this->dst = &dst;
+	this->upper = upper;
+	width = dst.width();
+	height = dst.height();
+
+	direct = dst.bpp() == 4 && dst.pixels() != nullptr;
+	if (upper && (upper->width() != width || upper->height() != height || upper->bpp() != 4)) {
+		direct = false;
+	}
+
+	depth.assign(width * height, std::numeric_limits<float>::infinity());
+}
+
+void DoomRasterizer::Plot(int x, int y, float z, const Color& color) {
+	dst->FillRect(Rect(x, y, 1, 1), color);
+	if (upper) {
+		if (z < 0) {
+			upper->FillRect(Rect(x, y, 1, 1), upper_color);
+		} else {
+			upper->ClearRect(Rect(x, y, 1, 1));
+		}
+	}
+}
+
+bool DoomRasterizer::DrawTriangle(const Vertex& a, const Vertex& b_in, const Vertex& c_in) {
+	if (!dst) {
+		return false;
+	}
+
+	const Vertex* b = &b_in;
+	const Vertex* c = &c_in;
+
+	float area = Edge(a, *b, c->x, c->y);
+	if (area == 0.0f || (culling && area < 0.0f)) {
+		return false;
+	}
+	if (area < 0.0f) {
+		std::swap(b, c);
+		area = -area;
+	}
+
+	// Bounding box of the pixel centers inside the triangle, clipped to the target
+	const int min_x = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b->x, c->x }))));
+	const int max_x = std::min(width - 1, static_cast<int>(std::ceil(std::max({ a.x, b->x, c->x }))));
+	const int min_y = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b->y, c->y }))));
+	const int max_y = std::min(height - 1, static_cast<int>(std::ceil(std::max({ a.y, b->y, c->y }))));
+	if (min_x > max_x || min_y > max_y) {
+		return true;
+	}
+
+	// Edge functions step by a constant per pixel, w0 weights a, w1 b and w2 c
+	const float inv_area = 1.0f / area;
+	const float w0_dx = b->y - c->y;
+	const float w1_dx = c->y - a.y;
+	const float w2_dx = a.y - b->y;
+
+	const bool flat = a.color == b->color && a.color == c->color;
+	const uint32_t flat_pixel = ToPixel(a.color);
+	const uint32_t upper_pixel = ToPixel(upper_color);
+
+	auto* dst_pixels = direct ? reinterpret_cast<uint32_t*>(dst->pixels()) : nullptr;
+	const int dst_stride = dst->pitch() / 4;
+	auto* upper_pixels = (direct && upper) ? reinterpret_cast<uint32_t*>(upper->pixels()) : nullptr;
+	const int upper_stride = upper ? upper->pitch() / 4 : 0;
+
+	const float start_x = min_x + 0.5f;
+	for (int y = min_y; y <= max_y; ++y) {
+		const float py = y + 0.5f;
+		float w0 = Edge(*b, *c, start_x, py);
+		float w1 = Edge(*c, a, start_x, py);
+		float w2 = Edge(a, *b, start_x, py);
+
+		float* depth_row = &depth[y * width];
+		uint32_t* dst_row = dst_pixels ? dst_pixels + y * dst_stride : nullptr;
+		uint32_t* upper_row = upper_pixels ? upper_pixels + y * upper_stride : nullptr;
+
+		for (int x = min_x; x <= max_x; ++x, w0 += w0_dx, w1 += w1_dx, w2 += w2_dx) {
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+				continue;
+			}
+
+			const float l0 = w0 * inv_area;
+			const float l1 = w1 * inv_area;
+			const float l2 = w2 * inv_area;
+
+			const float z = l0 * a.z + l1 * b->z + l2 * c->z;
+			if (z >= depth_row[x]) {
+				continue;
+			}
+			depth_row[x] = z;
+
+			Color color = a.color;
+			if (!flat) {
+				color.red = static_cast<uint8_t>(l0 * a.color.red + l1 * b->color.red + l2 * c->color.red + 0.5f);
+				color.green = static_cast<uint8_t>(l0 * a.color.green + l1 * b->color.green + l2 * c->color.green + 0.5f);
+				color.blue = static_cast<uint8_t>(l0 * a.color.blue + l1 * b->color.blue + l2 * c->color.blue + 0.5f);
+			}
+
+			if (!dst_row) {
+				Plot(x, y, z, color);
+				continue;
+			}
+
+			dst_row[x] = flat ? flat_pixel : ToPixel(color);
+			if (upper_row) {
+				upper_row[x] = z < 0 ? upper_pixel : 0;
+			}
+		}
+	}
+
+	return true;
+}
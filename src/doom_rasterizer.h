@@ -0,0 +1,88 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_DOOM_RASTERIZER_H
+#define EP_DOOM_RASTERIZER_H
+
+// Headers
+#include <vector>
+#include "color.h"
+
+class Bitmap;
+
+/**
+ * Depth buffered triangle rasterizer for the 3D models of Spriteset_MapDoom.
+ *
+ * Vertices are in screen coordinates, a smaller depth is nearer to the
+ * viewer. Triangles are filled with the interpolated vertex colors, pass
+ * the same color to every vertex for flat shading. Rows are written
+ * directly into the 32 bit target buffer.
+ */
+class DoomRasterizer {
+public:
+	struct Vertex {
+		float x;
+		float y;
+		float z;
+		Color color;
+	};
+
+	/**
+	 * Starts a frame and clears the depth buffer.
+	 * The targets are not cleared.
+	 *
+	 * @param dst target bitmap
+	 * @param upper optional mask, visible pixels with a negative depth are
+	 *        marked red, other drawn pixels are made transparent
+	 */
+	void Begin(Bitmap& dst, Bitmap* upper = nullptr);
+
+	/**
+	 * Enables back-face culling. Front faces are clockwise on screen,
+	 * which are counter-clockwise faces of a model seen from negative z.
+	 *
+	 * @param enable Whether back faces are skipped
+	 */
+	void SetCulling(bool enable);
+
+	/**
+	 * Draws a triangle into the target of the current frame.
+	 *
+	 * @param a first vertex
+	 * @param b second vertex
+	 * @param c third vertex
+	 * @return Whether the triangle was rasterized and not culled
+	 */
+	bool DrawTriangle(const Vertex& a, const Vertex& b, const Vertex& c);
+
+private:
+	void Plot(int x, int y, float z, const Color& color);
+
+	Bitmap* dst = nullptr;
+	Bitmap* upper = nullptr;
+	bool direct = false;
+	bool culling = true;
+	int width = 0;
+	int height = 0;
+	std::vector<float> depth;
+};
+
+inline void DoomRasterizer::SetCulling(bool enable) {
+	culling = enable;
+}
+
+#endif
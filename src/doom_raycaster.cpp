@@ -0,0 +1,176 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "doom_raycaster.h"
+#include "options.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Step length of an axis parallel to the ray direction, never crossed
+	constexpr float no_crossing = 1e30f;
+
+	int TextureColumn(float pos) {
+		float frac = pos - std::floor(pos);
+		return std::min(static_cast<int>(frac * TILE_SIZE), TILE_SIZE - 1);
+	}
+}
+
+void DoomRaycaster::Resize(int width, int height) {
+	this->width = std::max(width, 0);
+	this->height = std::max(height, 0);
+
+	tiles.assign(this->width * this->height, 0);
+	event_head.assign(this->width * this->height, -1);
+	event_next.clear();
+	events.clear();
+}
+
+void DoomRaycaster::SetTile(int x, int y, uint8_t flags) {
+	if (x < 0 || y < 0 || x >= width || y >= height) {
+		return;
+	}
+	tiles[y * width + x] = flags;
+}
+
+void DoomRaycaster::AddWallEvent(const WallEvent& ev) {
+	if (ev.x < 0 || ev.y < 0 || ev.x >= width || ev.y >= height) {
+		return;
+	}
+
+	// Append to the end of the tile list to keep the event order
+	int index = static_cast<int>(events.size());
+	events.push_back(ev);
+	event_next.push_back(-1);
+
+	int* link = &event_head[ev.y * width + ev.x];
+	while (*link >= 0) {
+		link = &event_next[*link];
+	}
+	*link = index;
+}
+
+bool DoomRaycaster::Cast(float x, float y, float angle, std::vector<Hit>& hits) const {
+	// Traversal in tile units, t is the ray length in tiles
+	const float px = x / TILE_SIZE;
+	const float py = y / TILE_SIZE;
+	const float dir_x = std::cos(angle);
+	const float dir_y = std::sin(angle);
+
+	int map_x = static_cast<int>(std::floor(px));
+	int map_y = static_cast<int>(std::floor(py));
+
+	if (map_x < 0 || map_y < 0 || map_x >= width || map_y >= height) {
+		return false;
+	}
+
+	const float delta_x = dir_x != 0.0f ? std::abs(1.0f / dir_x) : no_crossing;
+	const float delta_y = dir_y != 0.0f ? std::abs(1.0f / dir_y) : no_crossing;
+	const int step_x = dir_x < 0.0f ? -1 : 1;
+	const int step_y = dir_y < 0.0f ? -1 : 1;
+
+	float side_x = dir_x < 0.0f ? (px - map_x) * delta_x : (map_x + 1 - px) * delta_x;
+	float side_y = dir_y < 0.0f ? (py - map_y) * delta_y : (map_y + 1 - py) * delta_y;
+
+	float t = 0.0f;
+	bool vertical_edge = false;
+	bool start = true;
+
+	for (;;) {
+		const int index = map_y * width + map_x;
+		const uint8_t flags = tiles[index];
+
+		if (flags & Tile_Upper) {
+			// Closest approach of the ray to the tile center
+			float cx = map_x + 0.5f - px;
+			float cy = map_y + 0.5f - py;
+			Hit hit;
+			hit.kind = Hit::Kind_Upper;
+			hit.distance = (cx * dir_x + cy * dir_y) * TILE_SIZE;
+			hit.texture_x = 0;
+			hit.tile_x = map_x;
+			hit.tile_y = map_y;
+			hit.event = -1;
+			hit.offset = std::abs(cx * dir_y - cy * dir_x) * TILE_SIZE;
+			hits.push_back(hit);
+		}
+
+		if (!start) {
+			// Texture column from the position on the crossed edge
+			const int texture_x = vertical_edge ? TextureColumn(py + t * dir_y) : TextureColumn(px + t * dir_x);
+			const float distance = t * TILE_SIZE;
+
+			bool stop = false;
+			for (int ev = event_head[index]; ev >= 0; ev = event_next[ev]) {
+				Hit hit;
+				hit.kind = Hit::Kind_Event;
+				hit.distance = distance;
+				hit.texture_x = texture_x;
+				hit.tile_x = map_x;
+				hit.tile_y = map_y;
+				hit.event = ev;
+				hit.offset = 0.0f;
+				hits.push_back(hit);
+
+				if (events[ev].type != WallEvent::Type_Door) {
+					stop = true;
+				}
+			}
+			if (stop) {
+				return true;
+			}
+
+			if (flags & (Tile_Wall | Tile_Hidden)) {
+				Hit hit;
+				hit.kind = Hit::Kind_Wall;
+				hit.distance = distance;
+				hit.texture_x = texture_x;
+				hit.tile_x = map_x;
+				hit.tile_y = map_y;
+				hit.event = -1;
+				hit.offset = 0.0f;
+				hits.push_back(hit);
+				return true;
+			}
+		}
+		start = false;
+
+		// Jump to the next tile edge
+		if (side_x < side_y) {
+			t = side_x;
+			side_x += delta_x;
+			map_x += step_x;
+			vertical_edge = true;
+		} else {
+			t = side_y;
+			side_y += delta_y;
+			map_y += step_y;
+			vertical_edge = false;
+		}
+
+		if (map_x < 0 || map_y < 0 || map_x >= width || map_y >= height) {
+			return false;
+		}
+	}
+}
+
+size_t DoomRaycaster::GetMemoryUsage() const {
+	return tiles.capacity() * sizeof(uint8_t)
+		+ (event_head.capacity() + event_next.capacity()) * sizeof(int)
+		+ events.capacity() * sizeof(WallEvent);
+}
@@ -0,0 +1,169 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_DOOM_RAYCASTER_H
+#define EP_DOOM_RAYCASTER_H
+
+// Headers
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Grid raycaster of the Doom map renderer.
+ *
+ * Rays are traversed with a DDA (Digital Differential Analyzer): every
+ * step jumps to the next tile edge crossed by the ray, so the cost of a
+ * ray only depends on the amount of tiles it passes. Wall events are
+ * looked up through a per-tile index.
+ *
+ * Positions and distances are in pixels, one tile is TILE_SIZE pixels.
+ */
+class DoomRaycaster {
+public:
+	enum TileFlags : uint8_t {
+		/** Stops rays and is drawn */
+		Tile_Wall = 1,
+		/** Stops rays but is not drawn */
+		Tile_Hidden = 2,
+		/** Has an upper layer tile drawn as billboard */
+		Tile_Upper = 4
+	};
+
+	/** Event drawn as wall, named [WALL], [WALL_D] or [WALL_S] */
+	struct WallEvent {
+		enum Type : int {
+			/** [WALL], stops rays */
+			Type_Wall = 0,
+			/** [WALL_D], rays pass through */
+			Type_Door = 1,
+			/** [WALL_S], stops rays, the sprite covers the whole tile */
+			Type_Stretch = 3
+		};
+		int x;
+		int y;
+		int id;
+		int type;
+		int tile_sprite;
+	};
+
+	struct Hit {
+		enum Kind : uint8_t {
+			/** Wall tile, always the last hit of a ray */
+			Kind_Wall,
+			/** Wall event, the last hit when it stops the ray */
+			Kind_Event,
+			/** Tile with Tile_Upper passed by the ray */
+			Kind_Upper
+		};
+		Kind kind;
+		/** Distance from the ray origin */
+		float distance;
+		/** Texture column inside the tile, 0 to TILE_SIZE - 1 */
+		int texture_x;
+		int tile_x;
+		int tile_y;
+		/** Index of the wall event for Kind_Event */
+		int event;
+		/** Distance between the ray and the tile center for Kind_Upper */
+		float offset;
+	};
+
+	/**
+	 * Resizes the grid, all tiles are cleared and all wall events removed.
+	 *
+	 * @param width map width in tiles
+	 * @param height map height in tiles
+	 */
+	void Resize(int width, int height);
+
+	int GetWidth() const;
+	int GetHeight() const;
+
+	/**
+	 * @param x tile x
+	 * @param y tile y
+	 * @param flags combination of TileFlags
+	 */
+	void SetTile(int x, int y, uint8_t flags);
+
+	/**
+	 * @param x tile x
+	 * @param y tile y
+	 * @return TileFlags of the tile, 0 outside of the map
+	 */
+	uint8_t GetTile(int x, int y) const;
+
+	/**
+	 * Adds a wall event to the index of its tile.
+	 * Events outside of the map are ignored.
+	 *
+	 * @param ev wall event
+	 */
+	void AddWallEvent(const WallEvent& ev);
+
+	/** @return all wall events, indexed by Hit::event */
+	const std::vector<WallEvent>& GetWallEvents() const;
+
+	/**
+	 * Casts a ray through the grid.
+	 *
+	 * The start tile never stops the ray. Hits are appended in ray order.
+	 * A wall hit or a stopping wall event ends the traversal.
+	 *
+	 * @param x ray origin x
+	 * @param y ray origin y
+	 * @param angle ray angle in radians
+	 * @param hits receives the hits
+	 * @return Whether the ray was stopped before leaving the map
+	 */
+	bool Cast(float x, float y, float angle, std::vector<Hit>& hits) const;
+
+	/** @return bytes used by the grid and the wall events */
+	size_t GetMemoryUsage() const;
+
+private:
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> tiles;
+	/** first wall event of every tile, -1 when none */
+	std::vector<int> event_head;
+	/** next wall event on the same tile, -1 when none */
+	std::vector<int> event_next;
+	std::vector<WallEvent> events;
+};
+
+inline int DoomRaycaster::GetWidth() const {
+	return width;
+}
+
+inline int DoomRaycaster::GetHeight() const {
+	return height;
+}
+
+inline uint8_t DoomRaycaster::GetTile(int x, int y) const {
+	if (x < 0 || y < 0 || x >= width || y >= height) {
+		return 0;
+	}
+	return tiles[y * width + x];
+}
+
+inline const std::vector<DoomRaycaster::WallEvent>& DoomRaycaster::GetWallEvents() const {
+	return events;
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "dynrpg_chunk.h"
+#include <cstring>
+
+namespace {
+	// The legacy formats are text, they never start with a NUL byte
+	constexpr uint8_t magic[] = { 0, 'D', 'Y', 'N' };
+	constexpr size_t header_size = sizeof(magic) + 2;
+}
+
+DynRpg::ChunkWriter::ChunkWriter(uint16_t version) {
+	data.insert(data.end(), std::begin(magic), std::end(magic));
+	WriteU16(version);
+}
+
+void DynRpg::ChunkWriter::Reserve(size_t bytes) {
+	data.reserve(data.size() + bytes);
+}
+
+void DynRpg::ChunkWriter::WriteBool(bool value) {
+	data.push_back(value ? 1 : 0);
+}
+
+void DynRpg::ChunkWriter::WriteU8(uint8_t value) {
+	data.push_back(value);
+}
+
+void DynRpg::ChunkWriter::WriteU16(uint16_t value) {
+	data.push_back(value & 0xFF);
+	data.push_back(value >> 8);
+}
+
+void DynRpg::ChunkWriter::WriteU32(uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		data.push_back((value >> (i * 8)) & 0xFF);
+	}
+}
+
+void DynRpg::ChunkWriter::WriteU64(uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		data.push_back((value >> (i * 8)) & 0xFF);
+	}
+}
+
+void DynRpg::ChunkWriter::WriteI32(int32_t value) {
+	WriteU32(static_cast<uint32_t>(value));
+}
+
+void DynRpg::ChunkWriter::WriteFloat(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	WriteU32(bits);
+}
+
+void DynRpg::ChunkWriter::WriteDouble(double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	WriteU64(bits);
+}
+
+void DynRpg::ChunkWriter::WriteString(std::string_view value) {
+	WriteU32(static_cast<uint32_t>(value.size()));
+	data.insert(data.end(), value.begin(), value.end());
+}
+
+std::vector<uint8_t> DynRpg::ChunkWriter::Finish() {
+	return std::move(data);
+}
+
+DynRpg::ChunkReader::ChunkReader(const std::vector<uint8_t>& data) {
+	if (!IsBinaryChunk(data)) {
+		ok = false;
+		return;
+	}
+
+	this->data = data.data();
+	size = data.size();
+	pos = sizeof(magic);
+	version = ReadU16();
+}
+
+bool DynRpg::ChunkReader::IsBinaryChunk(const std::vector<uint8_t>& data) {
+	return data.size() >= header_size && memcmp(data.data(), magic, sizeof(magic)) == 0;
+}
+
+const uint8_t* DynRpg::ChunkReader::Take(size_t n) {
+	if (!ok || size - pos < n) {
+		ok = false;
+		return nullptr;
+	}
+	const uint8_t* p = data + pos;
+	pos += n;
+	return p;
+}
+
+bool DynRpg::ChunkReader::CanHold(uint32_t count, size_t min_size) {
+	if (!ok || count > (size - pos) / min_size) {
+		ok = false;
+	}
+	return ok;
+}
+
+bool DynRpg::ChunkReader::ReadBool() {
+	return ReadU8() != 0;
+}
+
+uint8_t DynRpg::ChunkReader::ReadU8() {
+	const uint8_t* p = Take(1);
+	return p ? p[0] : 0;
+}
+
+uint16_t DynRpg::ChunkReader::ReadU16() {
+	const uint8_t* p = Take(2);
+	return p ? static_cast<uint16_t>(p[0] | (p[1] << 8)) : 0;
+}
+
+uint32_t DynRpg::ChunkReader::ReadU32() {
+	const uint8_t* p = Take(4);
+	if (!p) {
+		return 0;
+	}
+	uint32_t value = 0;
+	for (int i = 0; i < 4; ++i) {
+		value |= static_cast<uint32_t>(p[i]) << (i * 8);
+	}
+	return value;
+}
+
+uint64_t DynRpg::ChunkReader::ReadU64() {
+	const uint8_t* p = Take(8);
+	if (!p) {
+		return 0;
+	}
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i) {
+		value |= static_cast<uint64_t>(p[i]) << (i * 8);
+	}
+	return value;
+}
+
+int32_t DynRpg::ChunkReader::ReadI32() {
+	return static_cast<int32_t>(ReadU32());
+}
+
+float DynRpg::ChunkReader::ReadFloat() {
+	uint32_t bits = ReadU32();
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+double DynRpg::ChunkReader::ReadDouble() {
+	uint64_t bits = ReadU64();
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+std::string DynRpg::ChunkReader::ReadString() {
+	uint32_t len = ReadU32();
+	const uint8_t* p = Take(len);
+	if (!p) {
+		return {};
+	}
+	return std::string(reinterpret_cast<const char*>(p), len);
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_DYNRPG_CHUNK_H
+#define EP_DYNRPG_CHUNK_H
+
+// Headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Binary save data of the DynRPG plugins.
+ *
+ * A chunk starts with a magic that never starts the legacy text formats
+ * (JSON, CSV), followed by the format version of the plugin.
+ * All values are stored little endian, strings are length prefixed.
+ */
+namespace DynRpg {
+
+class ChunkWriter {
+public:
+	/**
+	 * @param version format version of the plugin data
+	 */
+	explicit ChunkWriter(uint16_t version);
+
+	/**
+	 * Reserves space for the expected size of the chunk.
+	 *
+	 * @param bytes expected size
+	 */
+	void Reserve(size_t bytes);
+
+	void WriteBool(bool value);
+	void WriteU8(uint8_t value);
+	void WriteU16(uint16_t value);
+	void WriteU32(uint32_t value);
+	void WriteU64(uint64_t value);
+	void WriteI32(int32_t value);
+	void WriteFloat(float value);
+	void WriteDouble(double value);
+	void WriteString(std::string_view value);
+
+	/** @return bytes written so far, including the header */
+	size_t GetSize() const { return data.size(); }
+
+	/** @return the chunk, the writer is empty afterwards */
+	std::vector<uint8_t> Finish();
+
+private:
+	std::vector<uint8_t> data;
+};
+
+class ChunkReader {
+public:
+	/**
+	 * @param data chunk data, must outlive the reader
+	 */
+	explicit ChunkReader(const std::vector<uint8_t>& data);
+
+	/**
+	 * @param data plugin save data
+	 * @return Whether the data is a binary chunk and not a legacy format
+	 */
+	static bool IsBinaryChunk(const std::vector<uint8_t>& data);
+
+	/** @return format version of the plugin data, 0 when not a binary chunk */
+	uint16_t GetVersion() const;
+
+	bool ReadBool();
+	uint8_t ReadU8();
+	uint16_t ReadU16();
+	uint32_t ReadU32();
+	uint64_t ReadU64();
+	int32_t ReadI32();
+	float ReadFloat();
+	double ReadDouble();
+	std::string ReadString();
+
+	/**
+	 * Reading past the end returns 0 or empty strings and marks the
+	 * reader as failed.
+	 *
+	 * @return Whether all reads were in bounds
+	 */
+	bool IsOk() const;
+
+	/** @return Whether the whole chunk was read */
+	bool AtEnd() const;
+
+	/**
+	 * Checks that a count read from the chunk is plausible.
+	 * Every element uses at least min_size bytes.
+	 *
+	 * @param count element count
+	 * @param min_size minimum size of one element
+	 * @return Whether the remaining data can hold count elements
+	 */
+	bool CanHold(uint32_t count, size_t min_size);
+
+private:
+	const uint8_t* Take(size_t n);
+
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+	uint16_t version = 0;
+	bool ok = true;
+};
+
+inline bool ChunkReader::IsOk() const {
+	return ok;
+}
+
+inline bool ChunkReader::AtEnd() const {
+	return pos >= size;
+}
+
+inline uint16_t ChunkReader::GetVersion() const {
+	return version;
+}
+
+} // namespace DynRpg
+
+#endif
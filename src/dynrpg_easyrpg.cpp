@@ -58,13 +58,7 @@ bool DynRpg::EasyRpgPlugin::EasyCall(dyn_arg_list args, bool& do_yield, Game_Int
 		return true;
 	}
 
-	for (auto& plugin: instance.plugins) {
-		if (plugin->Invoke(func_name, args.subspan(1), do_yield, interpreter)) {
-			return true;
-		}
-	}
-
-	return false;
+	return instance.CallFunction(instance.GetFunctionId(func_name), args.subspan(1), do_yield, interpreter);
 }
 
 static bool EasyAdd(dyn_arg_list args) {
@@ -88,15 +82,12 @@ static bool EasyAdd(dyn_arg_list args) {
 	return true;
 }
 
-bool DynRpg::EasyRpgPlugin::Invoke(std::string_view func, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter) {
-	if (func == "call") {
+void DynRpg::EasyRpgPlugin::RegisterFunctions() {
+	instance.RegisterFunction("call", [this](dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter) {
 		return EasyCall(args, do_yield, interpreter);
-	} else if (func == "easyrpg_output") {
-		return EasyOput(args);
-	} else if (func == "easyrpg_add") {
-		return EasyAdd(args);
-	}
-	return false;
+	});
+	instance.RegisterFunction("easyrpg_output", EasyOput);
+	instance.RegisterFunction("easyrpg_add", EasyAdd);
 }
 
 void DynRpg::EasyRpgPlugin::Load(const std::vector<uint8_t>& buffer) {
@@ -18,14 +18,22 @@
  */
 
 // Headers
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <cmath>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "async_handler.h"
 #include "drawable.h"
 #include "drawable_mgr.h"
+#include "dynrpg_chunk.h"
 #include "dynrpg_particle.h"
+#include "dynrpg_particle_integrator.h"
+#include "dynrpg_particle_pool.h"
+#include "dynrpg_particle_renderer.h"
 #include "baseui.h"
 #include "bitmap.h"
 #include "cache.h"
@@ -35,6 +43,7 @@
 #include "game_switches.h"
 #include "main_data.h"
 #include "graphics.h"
+#include "worker_pool.h"
 
 //	static void load() = 0;
 
@@ -48,9 +57,26 @@ class ParticleEffect;
 namespace {
 	typedef std::map<std::string, ParticleEffect*> ptag_t;
 
+	// Version of the binary save chunk
+	constexpr uint16_t save_version = 1;
+	// Size of the settings shared by all effects with an empty texture name
+	constexpr size_t effect_settings_size =
+		8 + 1 + 1 + 2 + // z, fade, delay, amount
+		4 * 4 + // r0, rand_r, rand_x, rand_y
+		12 * 4 + // spd, rand_spd, s0, s1, gx, gy, ax0, ay0, afc, beta, alpha, theta
+		3 * 4 + // color0, color1, interval
+		2 + // isScreenRelative, radial
+		4; // texture name length
+	// Empty tag, type, shared settings and the smallest effect data (Burst)
+	constexpr size_t min_effect_size = 4 + 1 + effect_settings_size + 2;
+
 	ptag_t pfx_list;
+
+	// Simulates the effects in the background while the frame is drawn
+	std::unique_ptr<WorkerPool> pfx_pool;
 }
 
+static void wait_for_simulation();
 void linear_fade(ParticleEffect* effect, uint32_t color0, uint32_t color1, int fade, int delay);
 void linear_fade_texture(uint32_t color0, uint32_t color1, int fade, int delay, uint8_t* dst_r, uint8_t* dst_g, uint8_t* dst_b);
 
@@ -59,7 +85,17 @@ void linear_fade_texture(uint32_t color0, uint32_t color1, int fade, int delay,
 class ParticleEffect : public Drawable {
 public:
 	ParticleEffect();
-	void Draw(Bitmap& dst) override {};
+	void Draw(Bitmap& dst) override;
+
+	/**
+	 * Advances the simulation by one game step.
+	 * Runs on a worker thread and only writes the back draw state.
+	 */
+	virtual void Update() {}
+
+	/** Makes the state of the last Update visible to Draw. */
+	void Publish();
+
 	virtual void clear() {};
 	virtual void setSimul(int newSimul) {};
 	virtual void setAmount(int newAmount);
@@ -82,6 +118,27 @@ public:
 	void setColor0(uint8_t r, uint8_t g, uint8_t b);
 	void setColor1(uint8_t r, uint8_t g, uint8_t b);
 
+	enum class Type : uint8_t {
+		Burst,
+		Stream
+	};
+	virtual Type GetType() const = 0;
+
+	/**
+	 * Writes the settings of the effect to a save chunk.
+	 * Particles in flight are not saved.
+	 *
+	 * @param w chunk writer
+	 */
+	virtual void Save(DynRpg::ChunkWriter& w) const;
+
+	/**
+	 * Restores the settings written by Save.
+	 *
+	 * @param r chunk reader
+	 */
+	virtual void Load(DynRpg::ChunkReader& r);
+
 	static void create_trig_lut();
 
 	std::array<Color, 256> palette;
@@ -119,7 +176,39 @@ protected:
 	uint8_t* g;
 	uint8_t* b;
 	BitmapRef image;
-	BitmapRef tone_image;
+	/** image tinted with the color of every age, one frame per age stacked vertically */
+	BitmapRef texture_atlas;
+	/** textures fade out with age, baked into the atlas */
+	bool fade_texture = false;
+	/** name of the loaded texture, empty when drawing solid particles */
+	std::string texture_name;
+	/** pending load of the texture */
+	FileRequestBinding texture_request;
+	/** particles are generated by init_radial */
+	bool radial = false;
+
+	/** Particles of the same age, drawn with the same color */
+	struct DrawBatch {
+		int offset;
+		int count;
+		uint8_t age;
+	};
+
+	/** Snapshot of the particles produced by one simulation step */
+	struct DrawState {
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> s;
+		std::vector<DrawBatch> batches;
+
+		void Clear();
+	};
+
+	// Draw reads front, Update writes back, Publish swaps them
+	DrawState front;
+	DrawState back;
+
+	uint32_t rng_state;
 
 	float beta;
 	float alpha;
@@ -135,7 +224,17 @@ protected:
 	void free_rgb();
 	void alloc_rgb();
 	void update_color();
+	void build_texture_atlas();
+	void OnTextureReady(FileRequestResult* result);
+	void integrate(float* x, float* y, float* s, float* dx, float* dy, int n) const;
+	void push_batch(const float* x, const float* y, const float* s, int n, uint8_t age);
+	void reset_draw_state();
+	float randf();
 	static float sin_lut[32];
+
+private:
+	void draw_solid(Bitmap& dst, int cam_x, int cam_y);
+	void draw_texture(Bitmap& dst, int cam_x, int cam_y);
 };
 
 void linear_fade(ParticleEffect* effect, uint32_t color0, uint32_t color1, int fade, int delay) {
@@ -218,28 +317,233 @@ alpha(0), theta(0), fade(30), delay(0), amount(50) {
 	isScreenRelative = false;
 
 	image = Bitmap::Create(1, 1, true);
-     tone_image = Bitmap::Create(image->GetWidth(), image->GetHeight(), true);
 
+	rng_state = static_cast<uint32_t>(rand()) | 1;
 
 	DrawableMgr::Register(this);
 }
 
+void ParticleEffect::DrawState::Clear() {
+	x.clear();
+	y.clear();
+	s.clear();
+	batches.clear();
+}
+
+void ParticleEffect::Publish() {
+	std::swap(front, back);
+}
+
+void ParticleEffect::reset_draw_state() {
+	front.Clear();
+	back.Clear();
+}
+
+void ParticleEffect::push_batch(const float* x, const float* y, const float* s, int n, uint8_t age) {
+	back.batches.push_back({ static_cast<int>(back.x.size()), n, age });
+	back.x.insert(back.x.end(), x, x + n);
+	back.y.insert(back.y.end(), y, y + n);
+	back.s.insert(back.s.end(), s, s + n);
+}
+
+float ParticleEffect::randf() {
+	// xorshift32, rand() is not safe to call from the simulation workers
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return (rng_state >> 8) * (1.0f / 16777215.0f);
+}
+
+void ParticleEffect::Draw(Bitmap& dst) {
+	if (front.batches.empty() || !image) {
+		return;
+	}
+
+	int cam_x = (isScreenRelative) ? 0 : Game_Map::GetDisplayX() / 16;
+	int cam_y = (isScreenRelative) ? 0 : Game_Map::GetDisplayY() / 16;
+
+	if (col_mode == LINEAR_TEXTURE) {
+		draw_texture(dst, cam_x, cam_y);
+	} else {
+		draw_solid(dst, cam_x, cam_y);
+	}
+}
+
+void ParticleEffect::draw_solid(Bitmap& dst, int cam_x, int cam_y) {
+	const bool batched = ParticleRenderer::IsSupported(dst);
+
+	for (const auto& batch: front.batches) {
+		const float* x = front.x.data() + batch.offset;
+		const float* y = front.y.data() + batch.offset;
+		const float* s = front.s.data() + batch.offset;
+
+		if (batched) {
+			ParticleRenderer::DrawSolid(dst, x, y, s, batch.count, cam_x, cam_y, palette[batch.age]);
+		} else {
+			image->Fill(palette[batch.age]);
+			for (int j = 0; j < batch.count; j++) {
+				Rect dst_rect(x[j] - cam_x - s[j] / 2, y[j] - cam_y - s[j] / 2, s[j], s[j]);
+				dst.StretchBlit(dst_rect, *image, image->GetRect(), Opacity::Opaque());
+			}
+		}
+	}
+}
+
+void ParticleEffect::draw_texture(Bitmap& dst, int cam_x, int cam_y) {
+	if (!texture_atlas) {
+		return;
+	}
+
+	const bool batched = ParticleRenderer::IsSupported(dst) && ParticleRenderer::IsSupported(*texture_atlas);
+
+	int w = image->width();
+	int h = image->height();
+	int last_age = texture_atlas->height() / h - 1;
+	for (const auto& batch: front.batches) {
+		Rect src_rect(0, std::min<int>(batch.age, last_age) * h, w, h);
+
+		const float* x = front.x.data() + batch.offset;
+		const float* y = front.y.data() + batch.offset;
+		const float* s = front.s.data() + batch.offset;
+
+		if (batched) {
+			ParticleRenderer::DrawTexture(dst, x, y, s, batch.count, cam_x, cam_y, *texture_atlas, src_rect, 255);
+		} else {
+			for (int j = 0; j < batch.count; j++) {
+				Rect dst_rect(x[j] - cam_x - s[j] / 2, y[j] - cam_y - s[j] / 2, w*s[j], h*s[j]);
+				dst.StretchBlit(dst_rect, *texture_atlas, src_rect, Opacity::Opaque());
+			}
+		}
+	}
+}
+
+void ParticleEffect::build_texture_atlas() {
+	if (!r || !image) {
+		texture_atlas.reset();
+		return;
+	}
+
+	int w = image->width();
+	int h = image->height();
+	texture_atlas = Bitmap::Create(w, h * fade, true);
+	auto tone_image = Bitmap::Create(w, h, true);
+
+	for (int age = 0; age < fade; ++age) {
+		// FIXME: Order is bgr instead of rgb
+		Tone tone(b[age], g[age], r[age], 128);
+		tone_image->Clear();
+		tone_image->ToneBlit(0, 0, *image, image->GetRect(), tone, Opacity::Opaque());
+
+		int opacity = fade_texture ? static_cast<int>(255 - da * age) : 255;
+		texture_atlas->Blit(0, age * h, *tone_image, tone_image->GetRect(), opacity);
+	}
+}
+
 void ParticleEffect::setTexture(std::string filename) {
 	// When the name ends with .png, remove it
 //	if (std::string_view(filename).ends_with(".png")) {
 //		filename = filename.substr(0, filename.length() - 4);
 //	}
+	texture_name = filename;
+
+	// Nothing is drawn until the picture is loaded
+	texture_atlas.reset();
 	FileRequestAsync* req = AsyncHandler::RequestFile("Picture", filename);
+	texture_request = req->Bind(&ParticleEffect::OnTextureReady, this);
 	req->Start();
-	image = Cache::Picture(filename, true);
-	tone_image = Bitmap::Create(image->GetWidth(), image->GetHeight(), true);
-	linear_fade_texture(color0, color1, fade, delay, r, g, b);
+}
+
+void ParticleEffect::OnTextureReady(FileRequestResult* result) {
+	wait_for_simulation();
+
+	image = Cache::Picture(result->file, true);
+	update_color();
 }
 
 void ParticleEffect::unloadTexture() {
+	texture_name.clear();
+	texture_request.reset();
 	linear_fade(this, color0, color1, fade, delay);
 }
 
+void ParticleEffect::Save(DynRpg::ChunkWriter& w) const {
+	const size_t start = w.GetSize();
+	(void)start;
+
+	w.WriteU64(GetZ());
+	w.WriteU8(fade);
+	w.WriteU8(delay);
+	w.WriteU16(amount);
+	w.WriteI32(r0);
+	w.WriteI32(rand_r);
+	w.WriteI32(rand_x);
+	w.WriteI32(rand_y);
+	w.WriteFloat(spd);
+	w.WriteFloat(rand_spd);
+	w.WriteFloat(s0);
+	w.WriteFloat(s1);
+	w.WriteFloat(gx);
+	w.WriteFloat(gy);
+	w.WriteFloat(ax0);
+	w.WriteFloat(ay0);
+	w.WriteFloat(afc);
+	w.WriteFloat(beta);
+	w.WriteFloat(alpha);
+	w.WriteFloat(theta);
+	w.WriteU32(color0);
+	w.WriteU32(color1);
+	w.WriteU32(interval);
+	w.WriteBool(isScreenRelative);
+	w.WriteBool(radial);
+	w.WriteString(texture_name);
+
+	// min_effect_size must follow the fields written here
+	assert(w.GetSize() - start == effect_settings_size + texture_name.size());
+}
+
+void ParticleEffect::Load(DynRpg::ChunkReader& r) {
+	Drawable::Z_t z = r.ReadU64();
+	int new_fade = r.ReadU8();
+	int new_delay = r.ReadU8();
+	int new_amount = r.ReadU16();
+	r0 = r.ReadI32();
+	rand_r = r.ReadI32();
+	rand_x = r.ReadI32();
+	rand_y = r.ReadI32();
+	spd = r.ReadFloat();
+	rand_spd = r.ReadFloat();
+	s0 = r.ReadFloat();
+	s1 = r.ReadFloat();
+	gx = r.ReadFloat();
+	gy = r.ReadFloat();
+	ax0 = r.ReadFloat();
+	ay0 = r.ReadFloat();
+	afc = r.ReadFloat();
+	beta = r.ReadFloat();
+	alpha = r.ReadFloat();
+	theta = r.ReadFloat();
+	color0 = r.ReadU32();
+	color1 = r.ReadU32();
+	uint32_t new_interval = r.ReadU32();
+	isScreenRelative = r.ReadBool();
+	bool new_radial = r.ReadBool();
+	std::string texture = r.ReadString();
+
+	if (!r.IsOk()) {
+		return;
+	}
+
+	// The setters derive the growth, fade and color tables from the fields
+	SetZ(z);
+	setInterval(new_interval);
+	setGeneratingFunction(new_radial ? "radial" : "standard");
+	setAmount(std::max(new_amount, 1));
+	setTimeout(std::max(new_fade, 1), new_delay);
+	if (!texture.empty()) {
+		setTexture(texture);
+	}
+}
+
 void ParticleEffect::setGravityDirection(float angle, float factor) {
 	angle *= 0.0174532925;
 	gx = factor * cosf(angle) / 600.0;
@@ -339,6 +643,7 @@ void ParticleEffect::update_color() {
 		break;
 	case LINEAR_TEXTURE:
 		linear_fade_texture(color0, color1, fade, delay, r, g, b);
+		build_texture_atlas();
 		break;
 	}
 }
@@ -359,6 +664,17 @@ void ParticleEffect::alloc_rgb() {
 	}
 }
 
+void ParticleEffect::integrate(float* x, float* y, float* s, float* dx, float* dy, int n) const {
+	ParticleIntegrator::Params params;
+	params.ax0 = ax0;
+	params.ay0 = ay0;
+	params.afc = afc;
+	params.gx = gx;
+	params.gy = gy;
+	params.ds = ds;
+	ParticleIntegrator::Integrate(params, x, y, s, dx, dy, n);
+}
+
 void ParticleEffect::create_trig_lut() {
 	double dr = 3.141592653589793 / 16.0;
 	for (int i = 0; i < 32; i++)
@@ -370,7 +686,7 @@ class Stream : public ParticleEffect {
 public:
 	Stream();
 	~Stream();
-	void Draw(Bitmap& dst) override;
+	void Update() override;
 	void clear() override;
 	void stopAll();
 	void stop(std::string tag);
@@ -384,127 +700,82 @@ public:
 	void setGeneratingFunction(std::string type) override;
 	void setPosition(std::string tag, int x, int y);
 
+	Type GetType() const override { return Type::Stream; }
+	void Save(DynRpg::ChunkWriter& w) const override;
+	void Load(DynRpg::ChunkReader& r) override;
+
 
 private:
-	// Drawing Counters
-	uint8_t simulBeg;
-	uint8_t simulRun;
-	uint8_t simulCnt;
-	uint16_t simulMax;
+	using Handle = ParticlePool::Handle;
 
-	// SOA Style
-	float* x;
-	float* y;
-	float* s;
-	float* dx;
-	float* dy;
-	uint8_t* itr;
-	int16_t* str_x;
-	int16_t* str_y;
-	uint8_t* pfx_ref;
-	uint8_t* end_cnt;
+	// Emitters and their particles, one ring buffer of fade blocks each
+	ParticlePool pool;
 
-	// Stream tags ( for different stream of same type )
-	std::map<std::string, int> pfx_tag;
+	void (Stream::*init)(Handle, int, int);
 
-	void resize();
-	void sort_pfx();
-	void free_mem();
-	void alloc_mem();
-	void stream_to_end(uint8_t idx);
-	void start_to_stream(uint8_t idx);
-
-	void (Stream::*init)(int, int, int);
-	void (Stream::*draw_block)(Bitmap& dst, int, uint8_t, uint8_t, uint8_t, int16_t, int16_t);
-
-	void init_basic(int a, int b, int idx);
-	void init_radial(int a, int b, int idx);
-	void draw_block_basic(Bitmap& dst, int ref, uint8_t n, uint8_t z, uint8_t c0, int16_t cam_x, int16_t cam_y);
-	void draw_block_texture(Bitmap& dst, int ref, uint8_t n, uint8_t z, uint8_t c0, int16_t cam_x, int16_t cam_y);
+	void init_basic(Handle h, int a, int b);
+	void init_radial(Handle h, int a, int b);
+	void step_block(Handle h, uint8_t n, uint8_t z, uint8_t c0);
 };
 
 
-Stream::Stream() : ParticleEffect(), simulBeg(0), simulRun(0), simulCnt(0), simulMax(1) {
+Stream::Stream() : ParticleEffect() {
 	amount = 10;
-	alloc_mem();
+	pool.SetParticlesPerSlot(amount * fade);
 	init = &Stream::init_basic;
-	draw_block = &Stream::draw_block_basic;
 	update_color();
 }
 
 Stream::~Stream() {
-	free_mem();
 	free_rgb();
 }
 
 void Stream::start(int x0, int y0, std::string tag) {
-	std::map<std::string, int>::iterator pfx_itr = pfx_tag.find(tag);
-	if (pfx_itr != pfx_tag.end()) return;
-	if (simulCnt >= simulMax) resize();
-	uint8_t idx = pfx_ref[simulCnt];
-	uint8_t tmp;
-
-	tmp = pfx_ref[simulCnt];
-	pfx_ref[simulCnt] = pfx_ref[simulRun];
-	pfx_ref[simulRun] = tmp;
-
-	tmp = pfx_ref[simulRun];
-	pfx_ref[simulRun] = pfx_ref[simulBeg];
-	pfx_ref[simulBeg] = tmp;
-
-	std::pair<std::string, int> newItem(tag, idx);
-	pfx_tag.insert(newItem);
-
-	end_cnt[idx] = fade - 1;
-	str_x[idx] = x0;
-	str_y[idx] = y0;
-	itr[idx] = 0;
-	simulBeg++;
-	simulRun++;
-	simulCnt++;
+	Handle h = pool.Start(tag);
+	if (h == ParticlePool::null_handle) return;
+
+	auto& emitter = pool.GetEmitter(h);
+	emitter.end_cnt = fade - 1;
+	emitter.x = x0;
+	emitter.y = y0;
+	emitter.itr = 0;
 }
 
 void Stream::stop(std::string tag) {
-	std::map<std::string, int>::iterator pfx_itr = pfx_tag.find(tag);
-	if (pfx_itr == pfx_tag.end()) return;
-	uint8_t i, probe = pfx_itr->second;
-	for (i = 0; i < simulCnt; i++) if (pfx_ref[i] == probe) break;
-	simulRun--;
-	uint8_t tmp = pfx_ref[i];
-	pfx_ref[i] = pfx_ref[simulRun];
-	pfx_ref[simulRun] = tmp;
-	pfx_tag.erase(pfx_itr);
+	pool.Stop(tag);
 }
 
 void Stream::stopAll() {
-	simulBeg = 0;
-	simulRun = 0;
-	pfx_tag.clear();
+	pool.StopAll();
 }
 
 void Stream::clear() {
-	simulBeg = 0;
-	simulRun = 0;
-	simulCnt = 0;
-	pfx_tag.clear();
+	pool.Clear();
+	reset_draw_state();
 }
 
 void Stream::setGeneratingFunction(std::string type) {
 	std::transform(type.begin(), type.end(), type.begin(), ::tolower);
-	if (!type.substr(0, 8).compare("standard")) { init = &Stream::init_basic; return; }
-	if (!type.substr(0, 6).compare("radial")) { init = &Stream::init_radial; return; }
-}
-
-void Stream::init_basic(int a, int b, int idx) {
-	float x0 = str_x[idx];
-	float y0 = str_y[idx];
+	if (!type.substr(0, 8).compare("standard")) { init = &Stream::init_basic; radial = false; return; }
+	if (!type.substr(0, 6).compare("radial")) { init = &Stream::init_radial; radial = true; return; }
+}
+
+void Stream::init_basic(Handle h, int a, int b) {
+	const auto& emitter = pool.GetEmitter(h);
+	float x0 = emitter.x;
+	float y0 = emitter.y;
+	float* x = pool.X(h);
+	float* y = pool.Y(h);
+	float* s = pool.S(h);
+	float* dx = pool.DX(h);
+	float* dy = pool.DY(h);
 	for (int i = a; i < b; i++) {
-		x[i] = x0 + 2 * rand_x * (float)rand() / RAND_MAX - rand_x;
-		y[i] = y0 + 2 * rand_y * (float)rand() / RAND_MAX - rand_y;
+		x[i] = x0 + 2 * rand_x * randf() - rand_x;
+		y[i] = y0 + 2 * rand_y * randf() - rand_y;
 		s[i] = s0;
 
-		float tmp_angle = (float)rand() / RAND_MAX * beta + alpha;
-		float tmp_spd = spd + rand_spd * (float)rand() / RAND_MAX;
+		float tmp_angle = randf() * beta + alpha;
+		float tmp_spd = spd + rand_spd * randf();
 		int v = tmp_angle / 0.1963495408;
 		tmp_angle = (tmp_angle - v * 0.1963495408) / 0.1963495408;
 		dx[i] = tmp_spd * (sin_lut[(v + 9) & 31] * tmp_angle + sin_lut[(v + 8) & 31] * (1 - tmp_angle));
@@ -512,13 +783,19 @@ void Stream::init_basic(int a, int b, int idx) {
 	}
 }
 
-void Stream::init_radial(int a, int b, int idx) {
-	float x0 = str_x[idx];
-	float y0 = str_y[idx];
+void Stream::init_radial(Handle h, int a, int b) {
+	const auto& emitter = pool.GetEmitter(h);
+	float x0 = emitter.x;
+	float y0 = emitter.y;
+	float* x = pool.X(h);
+	float* y = pool.Y(h);
+	float* s = pool.S(h);
+	float* dx = pool.DX(h);
+	float* dy = pool.DY(h);
 	for (int i = a; i < b; i++) {
-		float tmp_rnd = rand_r * (float)rand() / RAND_MAX;
-		float tmp_angle = (float)rand() / RAND_MAX * beta + alpha;
-		float tmp_spd = spd + rand_spd * (float)rand() / RAND_MAX;
+		float tmp_rnd = rand_r * randf();
+		float tmp_angle = randf() * beta + alpha;
+		float tmp_spd = spd + rand_spd * randf();
 		int   v = tmp_angle / 0.1963495408;
 		float p = (tmp_angle - v * 0.1963495408) / 0.1963495408;
 
@@ -533,129 +810,87 @@ void Stream::init_radial(int a, int b, int idx) {
 	}
 }
 
-void Stream::draw_block_basic(Bitmap& dst, int ref, uint8_t n, uint8_t z, uint8_t c0, int16_t cam_x, int16_t cam_y) {
-	if (!image.get()) {
-		return;
-	}
-
-	for (uint8_t i = 0; i < n; i++) {
-		image->Fill(palette[i + c0]);
-		int idx = ref + z * amount;
-		float tx, ty, tsqr;
-		for (int j = 0; j < amount; j++) {
-			x[idx] += dx[idx];
-			y[idx] += dy[idx];
-			tx = ax0 - x[idx];
-			ty = ay0 - y[idx];
-			tsqr = sqrtf(tx*tx + ty*ty + 0.001);
-			dx[idx] += gx + afc * tx / tsqr;
-			dy[idx] += gy + afc * ty / tsqr;
-			s[idx] += ds;
-			Rect dst_rect(x[idx] - cam_x - s[idx] / 2, y[idx] - cam_y - s[idx] / 2, s[idx], s[idx]);
-			dst.StretchBlit(dst_rect, *image, image->GetRect(), Opacity::Opaque());
-			idx++;
-		}
-		z = (z + 1) % fade;
-	}
-
-}
-
-void Stream::draw_block_texture(Bitmap& dst, int ref, uint8_t n, uint8_t z, uint8_t c0, int16_t cam_x, int16_t cam_y) {
-	if (!image.get()) {
-		return;
-	}
+void Stream::step_block(Handle h, uint8_t n, uint8_t z, uint8_t c0) {
+	float* x = pool.X(h);
+	float* y = pool.Y(h);
+	float* s = pool.S(h);
+	float* dx = pool.DX(h);
+	float* dy = pool.DY(h);
 
-	float w = image->width();
-	float h = image->height();
 	for (uint8_t i = 0; i < n; i++) {
-		// FIXME: Order is bgr instead of rgb
-		Tone tone(b[i + c0], g[i + c0], r[i + c0], 128);
-		int alpha = ( 255 - da * ( i + c0 ) );
-		tone_image->ToneBlit(0, 0, *image, image->GetRect(), tone, Opacity::Opaque());
-
-		int idx = ref + z * amount;
-		float tx, ty, tsqr;
-		for (int j = 0; j < amount; j++) {
-			x[idx] += dx[idx];
-			y[idx] += dy[idx];
-			tx = ax0 - x[idx];
-			ty = ay0 - y[idx];
-			tsqr = sqrtf(tx*tx + ty*ty + 0.001);
-			dx[idx] += gx + afc * tx / tsqr;
-			dy[idx] += gy + afc * ty / tsqr;
-			s[idx] += ds;
-			Rect dst_rect(x[idx] - cam_x - s[idx] / 2, y[idx] - cam_y - s[idx] / 2, w*s[idx], h*s[idx]);
-			dst.StretchBlit(dst_rect, *tone_image, tone_image->GetRect(), Opacity::Opaque());
-			idx++;
-		}
+		int idx = z * amount;
+		integrate(x + idx, y + idx, s + idx, dx + idx, dy + idx, amount);
+		push_batch(x + idx, y + idx, s + idx, amount, i + c0);
 		z = (z + 1) % fade;
 	}
 }
 
 void Stream::setPosition(std::string tag, int x, int y) {
-	std::map<std::string, int>::iterator pfx_itr = pfx_tag.find(tag);
-	if (pfx_itr == pfx_tag.end()) return;
-	uint8_t i, probe = pfx_itr->second;
-	for (i = 0; i < simulCnt; i++) if (pfx_ref[i] == probe) break;
-	str_x[i] = x;
-	str_y[i] = y;
+	Handle h = pool.Find(tag);
+	if (h == ParticlePool::null_handle) return;
+	auto& emitter = pool.GetEmitter(h);
+	emitter.x = x;
+	emitter.y = y;
 }
 
 void Stream::setTexture(std::string filename) {
-	FileRequestAsync* req = AsyncHandler::RequestFile("Picture", filename);
-	req->Start();
 	alloc_rgb();
-	image = Cache::Picture(filename, true);
-	tone_image = Bitmap::Create(image->GetWidth(), image->GetHeight(), true);
-	draw_block = &Stream::draw_block_texture;
 	col_mode = LINEAR_TEXTURE;
-	update_color();
+	ParticleEffect::setTexture(std::move(filename));
 }
 
 void Stream::unloadTexture() {
+	texture_name.clear();
+	texture_request.reset();
 	free_rgb();
-	draw_block = &Stream::draw_block_basic;
+	texture_atlas.reset();
 	col_mode = LINEAR;
 	update_color();
 }
 
-void Stream::Draw(Bitmap& dst) {
-	if (simulCnt <= 0) return;
-	int cam_x = (isScreenRelative) ? 0 : Game_Map::GetDisplayX() / 16;
-	int cam_y = (isScreenRelative) ? 0 : Game_Map::GetDisplayY() / 16;
-	int block_size = amount * fade;
+void Stream::Update() {
+	back.Clear();
+	if (pool.GetActiveCount() <= 0) return;
 	int i = 0;
 
 	--cur_interval;
 
 	/// Starting
-	for (; i < simulBeg; i++) {
-		uint8_t idx = pfx_ref[i];
-		if (itr[idx] < fade) {
-			uint8_t z = fade - itr[idx]++ - 1;
+	for (; i < pool.GetStartingCount(); i++) {
+		Handle h = pool.GetActive(i);
+		auto& emitter = pool.GetEmitter(h);
+		if (emitter.itr < fade) {
+			uint8_t z = fade - emitter.itr++ - 1;
 			if (cur_interval == 0) {
-				(this->*init)(z * amount + idx * block_size, (z + 1) * amount + idx * block_size, idx);
+				(this->*init)(h, z * amount, (z + 1) * amount);
 			}
-			(this->*draw_block)(dst, idx * block_size, itr[idx], z, 0, cam_x, cam_y);
-		} else start_to_stream(i--);
+			step_block(h, emitter.itr, z, 0);
+		} else {
+			emitter.itr = 0;
+			pool.StartToStream(i--);
+		}
 	}
 	/// Streaming
-	for (; i < simulRun; i++) {
-		uint8_t idx = pfx_ref[i];
-		uint8_t z = fade - itr[idx] - 1;
-		itr[idx] = (itr[idx] + 1) % fade;
+	for (; i < pool.GetRunningCount(); i++) {
+		Handle h = pool.GetActive(i);
+		auto& emitter = pool.GetEmitter(h);
+		uint8_t z = fade - emitter.itr - 1;
+		emitter.itr = (emitter.itr + 1) % fade;
 		if (cur_interval == 0) {
-			(this->*init)(z * amount + idx * block_size, (z + 1) * amount + idx * block_size, idx);
+			(this->*init)(h, z * amount, (z + 1) * amount);
 		}
-		(this->*draw_block)(dst, idx * block_size, fade, z, 0, cam_x, cam_y);
+		step_block(h, fade, z, 0);
 	}
 	/// Stopping
-	for (; i < simulCnt; i++) {
-		uint8_t idx = pfx_ref[i];
-		uint8_t z = (fade - itr[idx]) % fade;
-		(this->*draw_block)(dst, idx * block_size, end_cnt[idx]--, z, fade - end_cnt[idx], cam_x, cam_y);
-		if (end_cnt[idx] <= 0)
-			stream_to_end(i);
+	for (; i < pool.GetActiveCount(); i++) {
+		Handle h = pool.GetActive(i);
+		auto& emitter = pool.GetEmitter(h);
+		uint8_t z = (fade - emitter.itr) % fade;
+		// Colors of the last blocks, fade - 1 at most
+		int n = emitter.end_cnt--;
+		step_block(h, n, z, fade - n);
+		if (emitter.end_cnt <= 0)
+			pool.Release(i--);
 	}
 
 	if (cur_interval == 0) {
@@ -663,74 +898,17 @@ void Stream::Draw(Bitmap& dst) {
 	}
 }
 
-void Stream::resize() {
-	float* tmp_x = (float*)malloc(sizeof(float) * amount * fade * 2 * simulMax);
-	float* tmp_y = (float*)malloc(sizeof(float) * amount * fade * 2 * simulMax);
-	float* tmp_s = (float*)malloc(sizeof(float) * amount * fade * 2 * simulMax);
-	float* tmp_dx = (float*)malloc(sizeof(float) * amount * fade * 2 * simulMax);
-	float* tmp_dy = (float*)malloc(sizeof(float) * amount * fade * 2 * simulMax);
-	uint8_t* tmp_itr = (uint8_t*)malloc(sizeof(uint8_t) * 2 * simulMax);
-	int16_t* tmp_srx = (int16_t*)malloc(sizeof(int16_t) * 2 * simulMax);
-	int16_t* tmp_sry = (int16_t*)malloc(sizeof(int16_t) * 2 * simulMax);
-	uint8_t* tmp_ref = (uint8_t*)malloc(sizeof(uint8_t) * 2 * simulMax);
-	uint8_t* tmp_cnt = (uint8_t*)malloc(sizeof(uint8_t) * 2 * simulMax);
-
-	memcpy(tmp_x, x, sizeof(float) * simulMax * amount * fade);
-	memcpy(tmp_y, y, sizeof(float) * simulMax * amount * fade);
-	memcpy(tmp_s, s, sizeof(float) * simulMax * amount * fade);
-	memcpy(tmp_dx, dx, sizeof(float) * simulMax * amount * fade);
-	memcpy(tmp_dy, dy, sizeof(float) * simulMax * amount * fade);
-	memcpy(tmp_itr, itr, sizeof(uint8_t) * simulMax);
-	memcpy(tmp_srx, str_x, sizeof(int16_t) * simulMax);
-	memcpy(tmp_sry, str_y, sizeof(int16_t) * simulMax);
-	memcpy(tmp_ref, pfx_ref, sizeof(uint8_t) * simulMax);
-	memcpy(tmp_cnt, end_cnt, sizeof(uint8_t) * simulMax);
-	for (int i = simulMax; i < 2 * simulMax; i++) {
-		tmp_itr[i] = 0;
-		tmp_srx[i] = -(s1 + 1);
-		tmp_sry[i] = -(s1 + 1);
-		tmp_cnt[i] = 0;
-		tmp_ref[i] = i;
-	}
-	for (int i = simulMax * amount * fade; i < 2 * simulMax * amount * fade; i++) {
-		tmp_x[i] = 0;
-		tmp_y[i] = 0;
-		tmp_s[i] = 0;
-		tmp_dx[i] = 0;
-		tmp_dy[i] = 0;
-	}
-	free_mem();
-
-	x = tmp_x;
-	y = tmp_y;
-	s = tmp_s;
-	dx = tmp_dx;
-	dy = tmp_dy;
-	itr = tmp_itr;
-	str_x = tmp_srx;
-	str_y = tmp_sry;
-	pfx_ref = tmp_ref;
-	end_cnt = tmp_cnt;
-	simulMax *= 2;
-}
-
 void Stream::setAmount(int newAmount) {
-	free_mem();
 	amount = newAmount;
-	alloc_mem();
+	pool.SetParticlesPerSlot(amount * fade);
 }
 
 void Stream::setSimul(int newSimul) {
-	free_mem();
-	simulMax = newSimul;
-	alloc_mem();
-	simulBeg = 0;
-	simulRun = 0;
-	simulCnt = 0;
+	pool.Clear();
+	pool.Reserve(newSimul);
 }
 
 void Stream::setTimeout(int _fade, int _delay) {
-	free_mem();
 	if (_fade > 255) _fade = 255;
 	else if (_fade < 0) _fade = 1;
 	if (_delay >= _fade) _delay = _fade - 1;
@@ -740,69 +918,46 @@ void Stream::setTimeout(int _fade, int _delay) {
 	//da = 255 / ( fade - delay );
 	da = 255 / _fade;
 	ds = (s1 - s0) / _fade;
-	alloc_mem();
+	pool.SetParticlesPerSlot(amount * fade);
+	// The rings of running emitters must fit the new timeout
+	pool.RestartEmitters(fade);
 	if (r) { free_rgb(); alloc_rgb(); }
 	update_color();
 }
 
-void Stream::free_mem() {
-	free(x);
-	free(y);
-	free(s);
-	free(dx);
-	free(dy);
-	free(itr);
-	free(str_x);
-	free(str_y);
-	free(pfx_ref);
-	free(end_cnt);
-}
-
-void Stream::alloc_mem() {
-	x = (float*)malloc(sizeof(float) * amount * fade * simulMax);
-	y = (float*)malloc(sizeof(float) * amount * fade * simulMax);
-	s = (float*)malloc(sizeof(float) * amount * fade * simulMax);
-	dx = (float*)malloc(sizeof(float) * amount * fade * simulMax);
-	dy = (float*)malloc(sizeof(float) * amount * fade * simulMax);
-	itr = (uint8_t*)malloc(sizeof(uint8_t) * simulMax);
-	str_x = (int16_t*)malloc(sizeof(int16_t) * simulMax);
-	str_y = (int16_t*)malloc(sizeof(int16_t) * simulMax);
-	pfx_ref = (uint8_t*)malloc(sizeof(uint8_t) * simulMax);
-	end_cnt = (uint8_t*)malloc(sizeof(uint8_t) * simulMax);
-	for (int i = 0; i < simulMax; i++) {
-		itr[i] = 0;
-		str_x[i] = -(s1 + 1);
-		str_y[i] = -(s1 + 1);
-		pfx_ref[i] = i;
-		end_cnt[i] = 0;
-	}
-	for (int i = 0; i < amount * fade * simulMax; i++) {
-		x[i] = 0;
-		y[i] = 0;
-		s[i] = 0;
-		dx[i] = 0;
-		dy[i] = 0;
+void Stream::Save(DynRpg::ChunkWriter& w) const {
+	ParticleEffect::Save(w);
+
+	// Only the running emitters, they refill their particles after loading
+	const auto& tags = pool.GetTags();
+	w.WriteU32(static_cast<uint32_t>(tags.size()));
+	for (const auto& [tag, h] : tags) {
+		const auto& emitter = pool.GetEmitter(h);
+		w.WriteString(tag);
+		w.WriteI32(emitter.x);
+		w.WriteI32(emitter.y);
 	}
 }
 
-void Stream::start_to_stream(uint8_t idx) {
-	itr[pfx_ref[idx]] = 0;
-	int tmp = pfx_ref[--simulBeg];
-	pfx_ref[simulBeg] = pfx_ref[idx];
-	pfx_ref[idx] = tmp;
-	sort_pfx();
-}
+void Stream::Load(DynRpg::ChunkReader& r) {
+	ParticleEffect::Load(r);
 
-void Stream::stream_to_end(uint8_t idx) {
-	--simulCnt;
-	uint8_t temp = pfx_ref[simulCnt];
-	pfx_ref[simulCnt] = pfx_ref[idx];
-	pfx_ref[idx] = temp;
-}
+	uint32_t count = r.ReadU32();
+	if (!r.CanHold(count, 12)) {
+		return;
+	}
 
-void Stream::sort_pfx() {
-	/// General Idea: improve cache efficiency
-	/// Not implemented yet
+	pool.Clear();
+	pool.Reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		std::string tag = r.ReadString();
+		int x0 = r.ReadI32();
+		int y0 = r.ReadI32();
+		if (!r.IsOk()) {
+			return;
+		}
+		start(x0, y0, tag);
+	}
 }
 
 
@@ -810,7 +965,7 @@ class Burst : public ParticleEffect {
 public:
 	Burst();
 	~Burst();
-	void Draw(Bitmap& dst) override;
+	void Update() override;
 	void clear() override;
 	void newBurst(int x, int y);
 
@@ -820,6 +975,10 @@ public:
 	void setTexture(std::string filename) override;
 	void setGeneratingFunction(std::string type) override;
 
+	Type GetType() const override { return Type::Burst; }
+	void Save(DynRpg::ChunkWriter& w) const override;
+	void Load(DynRpg::ChunkReader& r) override;
+
 private:
 
 	uint8_t simulCnt;
@@ -838,19 +997,16 @@ private:
 	void alloc_mem();
 
 	void (Burst::*init)(int, int, int, int);
-	void (Burst::*draw_function)(Bitmap& dst, int, int);
 
 	void init_basic(int x0, int y0, int a, int b);
 	void init_radial(int x0, int y0, int a, int b);
-	void draw_texture(Bitmap& dst, int cam_x, int cam_y);
-	void draw_standard(Bitmap& dst, int cam_x, int cam_y);
 };
 
 
 Burst::Burst() : ParticleEffect(), simulCnt(0), simulMax(1) {
+	fade_texture = true;
 	alloc_mem();
 	init = &Burst::init_basic;
-	draw_function = &Burst::draw_standard;
 	update_color();
 }
 
@@ -862,12 +1018,13 @@ Burst::~Burst() {
 
 void Burst::setGeneratingFunction(std::string type) {
 	std::transform(type.begin(), type.end(), type.begin(), ::tolower);
-	if (!type.substr(0, 8).compare("standard")) { init = &Burst::init_basic; return; }
-	if (!type.substr(0, 6).compare("radial")) { init = &Burst::init_radial; return; }
+	if (!type.substr(0, 8).compare("standard")) { init = &Burst::init_basic; radial = false; return; }
+	if (!type.substr(0, 6).compare("radial")) { init = &Burst::init_radial; radial = true; return; }
 }
 
 void Burst::clear() {
 	simulCnt = 0;
+	reset_draw_state();
 }
 
 void Burst::newBurst(int x0, int y0) {
@@ -879,12 +1036,12 @@ void Burst::newBurst(int x0, int y0) {
 
 void Burst::init_basic(int x0, int y0, int a, int b) {
 	for (int i = a; i < b; i++) {
-		x[i] = x0 + 2 * rand_x * (float)rand() / RAND_MAX - rand_x;
-		y[i] = y0 + 2 * rand_y * (float)rand() / RAND_MAX - rand_y;
+		x[i] = x0 + 2 * rand_x * randf() - rand_x;
+		y[i] = y0 + 2 * rand_y * randf() - rand_y;
 		s[i] = s0;
 
-		float tmp_angle = (float)rand() / RAND_MAX * beta + alpha;
-		float tmp_spd = spd + rand_spd * (float)rand() / RAND_MAX;
+		float tmp_angle = randf() * beta + alpha;
+		float tmp_spd = spd + rand_spd * randf();
 		int v = tmp_angle / 0.1963495408;
 		tmp_angle = (tmp_angle - v * 0.1963495408) / 0.1963495408;
 		dx[i] = tmp_spd * (sin_lut[(v + 9) & 31] * tmp_angle + sin_lut[(v + 8) & 31] * (1 - tmp_angle));
@@ -894,9 +1051,9 @@ void Burst::init_basic(int x0, int y0, int a, int b) {
 
 void Burst::init_radial(int x0, int y0, int a, int b) {
 	for (int i = a; i < b; i++) {
-		float tmp_rnd = rand_r * (float)rand() / RAND_MAX;
-		float tmp_angle = (float)rand() / RAND_MAX * beta + alpha;
-		float tmp_spd = spd + rand_spd * (float)rand() / RAND_MAX;
+		float tmp_rnd = rand_r * randf();
+		float tmp_angle = randf() * beta + alpha;
+		float tmp_spd = spd + rand_spd * randf();
 		int   v = tmp_angle / 0.1963495408;
 		float p = (tmp_angle - v * 0.1963495408) / 0.1963495408;
 
@@ -911,7 +1068,8 @@ void Burst::init_radial(int x0, int y0, int a, int b) {
 	}
 }
 
-void Burst::Draw(Bitmap& dst) {
+void Burst::Update() {
+	back.Clear();
 	if (simulCnt <= 0) return;
 	if (simulCnt > 1) {
 		for (int i = 0; i < simulCnt - 1; i++) {
@@ -930,87 +1088,27 @@ void Burst::Draw(Bitmap& dst) {
 		if (itr[simulCnt - 1] >= fade) simulCnt--;
 	} else if (itr[0] >= fade) --simulCnt;
 
-	int cam_x = (isScreenRelative) ? 0 : Game_Map::GetDisplayX() / 16;
-	int cam_y = (isScreenRelative) ? 0 : Game_Map::GetDisplayY() / 16;
-	(this->*draw_function)(dst, cam_x, cam_y);
-}
-
-void Burst::draw_standard(Bitmap& dst, int cam_x, int cam_y) {
-	if (!image.get()) {
-		return;
-	}
-
 	for (int i = 0; i < simulCnt; i++) {
-		image->Fill(palette[itr[i]]);
+		uint8_t age = itr[i];
 		itr[i]++;
-		float tx, ty, tsqr;
-		for (int j = i * amount; j < (i + 1) * amount; j++) {
-			x[j] += dx[j];
-			y[j] += dy[j];
-			tx = ax0 - x[j];
-			ty = ay0 - y[j];
-			tsqr = sqrtf(tx*tx + ty*ty + 0.001);
-			dx[j] += gx + afc * tx / tsqr;
-			dy[j] += gy + afc * ty / tsqr;
-			s[j] += ds;
-			Rect dst_rect(x[j] - cam_x - s[j] / 2, y[j] - cam_y - s[j] / 2, s[j], s[j]);
-			dst.StretchBlit(dst_rect, *image, image->GetRect(), Opacity::Opaque());
-		}
-	}
-}
 
-void Burst::draw_texture(Bitmap& dst, int cam_x, int cam_y) {
-	if (!image.get()) {
-		return;
-	}
-
-	float w = image->width();
-	float h = image->height();
-	for (int i = 0; i < simulCnt; i++) {
-		uint8_t idx = itr[i];
-
-		// FIXME: Order is bgr instead of rgb
-		Tone tone(b[idx], g[idx], r[idx], 128);
-		int alpha = ( 255 - da * idx );
-		tone_image->Clear();
-		tone_image->ToneBlit(0, 0, *image, image->GetRect(), tone, Opacity::Opaque());
-
-		itr[i]++;
-		float tx, ty, tsqr;
-		for (int j = i * amount; j < (i + 1) * amount; j++) {
-			x[j] += dx[j];
-			y[j] += dy[j];
-			tx = ax0 - x[j];
-			ty = ay0 - y[j];
-			tsqr = sqrtf(tx*tx + ty*ty + 0.001);
-			dx[j] += gx + afc * tx / tsqr;
-			dy[j] += gy + afc * ty / tsqr;
-			s[j] += ds;
-			Rect dst_rect(x[j] - cam_x - s[j] / 2, y[j] - cam_y - s[j] / 2, w*s[j], h*s[j]);
-			dst.StretchBlit(dst_rect, *tone_image, tone_image->GetRect(), alpha);
-		}
+		int idx = i * amount;
+		integrate(x + idx, y + idx, s + idx, dx + idx, dy + idx, amount);
+		push_batch(x + idx, y + idx, s + idx, amount, age);
 	}
 }
 
 void Burst::setTexture(std::string filename) {
-	// When the name ends with .png, remove it
-//	if (std::string_view(filename).ends_with(".png")) {
-//		filename = filename.substr(0, filename.length() - 4);
-//	}
-	FileRequestAsync* req = AsyncHandler::RequestFile("Picture", filename);
-	req->Start();
-
 	alloc_rgb();
-	image = Cache::Picture(filename, true);
-	tone_image = Bitmap::Create(image->GetWidth(), image->GetHeight(), true);
-	draw_function = &Burst::draw_texture;
 	col_mode = LINEAR_TEXTURE;
-	update_color();
+	ParticleEffect::setTexture(std::move(filename));
 }
 
 void Burst::unloadTexture() {
+	texture_name.clear();
+	texture_request.reset();
 	free_rgb();
-	draw_function = &Burst::draw_standard;
+	texture_atlas.reset();
 	col_mode = LINEAR;
 	update_color();
 }
@@ -1053,6 +1151,22 @@ void Burst::setSimul(int newSimul) {
 	simulCnt = 0;
 }
 
+void Burst::Save(DynRpg::ChunkWriter& w) const {
+	ParticleEffect::Save(w);
+
+	// Bursts in flight are short lived and not saved
+	w.WriteU16(simulMax);
+}
+
+void Burst::Load(DynRpg::ChunkReader& r) {
+	ParticleEffect::Load(r);
+
+	int simul = r.ReadU16();
+	if (r.IsOk()) {
+		setSimul(std::max(simul, 1));
+	}
+}
+
 void Burst::free_mem() {
 	free(x);
 	free(y);
@@ -1071,6 +1185,12 @@ void Burst::alloc_mem() {
 	itr = (uint8_t*)malloc(sizeof(uint8_t) * simulMax);
 }
 
+static void wait_for_simulation() {
+	if (pfx_pool) {
+		pfx_pool->Wait();
+	}
+}
+
 static bool create_effect(dyn_arg_list args) {
 	auto func = "pfx_create_effect";
 	bool okay;
@@ -1107,14 +1227,17 @@ static bool destroy_effect(dyn_arg_list args) {
 	return true;
 }
 
-static bool destroy_all(dyn_arg_list args) {
-    	auto func = "pfx_destroy_all";
+static void destroy_all_effects() {
 	ptag_t::iterator itr = pfx_list.begin();
 	while (itr != pfx_list.end()) {
 		delete itr->second;
 		itr++;
 	}
 	pfx_list.clear();
+}
+
+static bool destroy_all(dyn_arg_list args) {
+	destroy_all_effects();
 	return true;
 }
 
@@ -1671,147 +1794,139 @@ static bool SetLayer(dyn_arg_list args) {
 // }
 
 
-bool DynRpg::Particle::Invoke(std::string_view func, dyn_arg_list args, bool&, Game_Interpreter*)
-{
-    if (func == "pfx_destroy_all") {
-                return destroy_all(args);
-                }
-    else
-    if (func == "pfx_create_effect") {
-                return create_effect(args);
-                }
-    else
-      if (func == "pfx_destroy_effect") {
-                return destroy_effect(args);
-                }
-    else
-    if (func == "pfx_does_effect_exist") {
-                return does_effect_exist(args);
-                }
-    else
-    if (func == "pfx_burst") {
-                return burst(args);
-                }
-    else
-    if (func == "pfx_start") {
-                return start(args);
-                }
-    else
-      if (func == "pfx_stop") {
-                return stop(args);
-                }
-    else
-    if (func == "pfx_stopall") {
-                return stopall(args);
-                }
-    else
-    if (func == "pfx_set_simul_effects") {
-                return set_simul(args);
-                }
-    else
-    if (func == "pfx_set_amount") {
-                return set_amount(args);
-                }
-    else
-      if (func == "pfx_set_timeout") {
-                return set_timeout(args);
-                }
-    else
-    if (func == "pfx_set_initial_color") {
-                return set_initial_color(args);
-                }
-    else
-    if (func == "pfx_set_final_color") {
-                return set_final_color(args);
-                }
-    else
-    if (func == "pfx_set_growth") {
-                return set_growth(args);
-                }
-    else
-      if (func == "pfx_set_position") {
-                return set_position(args);
-                }
-    else
-    if (func == "pfx_set_random_position") {
-                return set_random_position(args);
-                }
-    else
-        if (func == "pfx_set_random_radius") {
-                return set_random_radius(args);
-                }
-    else
-    if (func == "pfx_set_radius") {
-                return set_radius(args);
-                }
-    else
-    if (func == "pfx_set_texture") {
-                return set_texture(args);
-                }
-    else
-      if (func == "pfx_set_acceleration_point") {
-                return set_acceleration_point(args);
-                }
-    else
-    if (func == "pfx_set_gravity_direction") {
-                return set_gravity_direction(args);
-                }
-    else
-    if (func == "pfx_set_velocity") {
-                return set_velocity(args);
-                }
-    else
-    if (func == "pfx_set_angle") {
-                return set_angle(args);
-                }
-    else
-      if (func == "pfx_set_interval") {
-                return set_interval(args);
-                }
-    else
-    if (func == "pfx_set_secondary_angle") {
-                return set_secondary_angle(args);
-                }
-    else
-    if (func == "pfx_set_generating_function") {
-                return set_generating_function(args);
-                }
-    else
-    if (func == "pfx_use_screen_relative") {
-                return use_screen_relative(args);
-                }
-    else
-      if (func == "pfx_unload_texture") {
-                return unload_texture(args);
-                }
-    else
-    if (func == "pfx_load_effect") {
-                return load_effect(args);
-                }
-    else
-    if (func == "pfx_set_z") {
-                return SetZ(args);
-                }
-    else
-    if (func == "pfx_set_layer") {
-                return SetLayer(args);
-                }
+void DynRpg::Particle::RegisterFunctions() {
+	ParticleEffect::create_trig_lut();
 
+	auto reg = [this](std::string_view name, dynfunc func) {
+		instance.RegisterFunction(name, [func](dyn_arg_list args, bool&, Game_Interpreter*) {
+			// Commands modify the effects, the running simulation step must finish first
+			wait_for_simulation();
+			return func(args);
+		});
+	};
+
+	reg("pfx_destroy_all", destroy_all);
+	reg("pfx_create_effect", create_effect);
+	reg("pfx_destroy_effect", destroy_effect);
+	reg("pfx_does_effect_exist", does_effect_exist);
+	reg("pfx_burst", burst);
+	reg("pfx_start", start);
+	reg("pfx_stop", stop);
+	reg("pfx_stopall", stopall);
+	reg("pfx_set_simul_effects", set_simul);
+	reg("pfx_set_amount", set_amount);
+	reg("pfx_set_timeout", set_timeout);
+	reg("pfx_set_initial_color", set_initial_color);
+	reg("pfx_set_final_color", set_final_color);
+	reg("pfx_set_growth", set_growth);
+	reg("pfx_set_position", set_position);
+	reg("pfx_set_random_position", set_random_position);
+	reg("pfx_set_random_radius", set_random_radius);
+	reg("pfx_set_radius", set_radius);
+	reg("pfx_set_texture", set_texture);
+	reg("pfx_set_acceleration_point", set_acceleration_point);
+	reg("pfx_set_gravity_direction", set_gravity_direction);
+	reg("pfx_set_velocity", set_velocity);
+	reg("pfx_set_angle", set_angle);
+	reg("pfx_set_interval", set_interval);
+	reg("pfx_set_secondary_angle", set_secondary_angle);
+	reg("pfx_set_generating_function", set_generating_function);
+	reg("pfx_use_screen_relative", use_screen_relative);
+	reg("pfx_unload_texture", unload_texture);
+	reg("pfx_load_effect", load_effect);
+	reg("pfx_set_z", SetZ);
+	reg("pfx_set_layer", SetLayer);
 }
 
 void DynRpg::Particle::Update() {
+	// Called once per game step: publish the finished step and start the next
+	// one in the background. Drawing only reads the published state.
+	wait_for_simulation();
+
+	if (!pfx_pool) {
+		pfx_pool = std::make_unique<WorkerPool>(WorkerPool::GetDefaultThreadCount(4));
+	}
+
 	ptag_t::iterator itr = pfx_list.begin();
 	while (itr != pfx_list.end()) {
-		//itr->second->draw();
+		ParticleEffect* effect = itr->second;
+		effect->Publish();
+		pfx_pool->Push([effect]() { effect->Update(); });
 		itr++;
 	}
 }
 
+void DynRpg::Particle::Load(const std::vector<uint8_t>& in) {
+	wait_for_simulation();
+	destroy_all_effects();
+
+	// Older savegames never stored the effects
+	if (!DynRpg::ChunkReader::IsBinaryChunk(in)) {
+		return;
+	}
+
+	DynRpg::ChunkReader r(in);
+	if (r.GetVersion() > save_version) {
+		Output::Warning("KazeParticles: Unsupported save version {}", r.GetVersion());
+		return;
+	}
+
+	uint32_t count = r.ReadU32();
+	if (!r.CanHold(count, min_effect_size)) {
+		Output::Warning("KazeParticles: Corrupted save data");
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		std::string tag = r.ReadString();
+		auto type = static_cast<ParticleEffect::Type>(r.ReadU8());
+
+		std::unique_ptr<ParticleEffect> effect;
+		if (type == ParticleEffect::Type::Burst) {
+			effect = std::make_unique<Burst>();
+		} else if (type == ParticleEffect::Type::Stream) {
+			effect = std::make_unique<Stream>();
+		}
+		if (!effect || !r.IsOk()) {
+			break;
+		}
+
+		effect->Load(r);
+		if (!r.IsOk() || pfx_list.find(tag) != pfx_list.end()) {
+			break;
+		}
+		pfx_list[tag] = effect.release();
+	}
+
+	if (!r.IsOk()) {
+		Output::Warning("KazeParticles: Corrupted save data");
+	}
+}
+
+std::vector<uint8_t> DynRpg::Particle::Save() {
+	wait_for_simulation();
+
+	DynRpg::ChunkWriter w(save_version);
+	w.WriteU32(static_cast<uint32_t>(pfx_list.size()));
+	for (const auto& [tag, effect] : pfx_list) {
+		w.WriteString(tag);
+		w.WriteU8(static_cast<uint8_t>(effect->GetType()));
+		effect->Save(w);
+	}
+
+	return w.Finish();
+}
+
 DynRpg::Particle::~Particle() {
 	OnMapChange();
+
+	// Joined with the plugin instead of during static destruction
+	pfx_pool.reset();
 }
 
 void DynRpg::Particle::OnMapChange() {
+	wait_for_simulation();
+
 	ptag_t::iterator itr = pfx_list.begin();
 	while (itr != pfx_list.end()) {
 		itr->second->clear();
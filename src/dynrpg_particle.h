@@ -37,13 +37,10 @@ namespace DynRpg {
 //		void Update();
 
 
-//		void RegisterFunctions() override;
-
-//      bool Invoke(std::string_view, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter) override;
-        bool Invoke(std::string_view, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter);
+		void RegisterFunctions() override;
 		void Update() override;
-//		void Load(const std::vector<uint8_t>&) override;
-//		std::vector<uint8_t> Save() override;
+		void Load(const std::vector<uint8_t>&) override;
+		std::vector<uint8_t> Save() override;
 
 
 		void OnMapChange();
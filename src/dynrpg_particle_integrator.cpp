@@ -0,0 +1,301 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <cmath>
+#include "dynrpg_particle_integrator.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define EP_PARTICLE_X86
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#  endif
+#  if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define EP_PARTICLE_SSE2
+#  endif
+#  if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#    define EP_PARTICLE_AVX2
+#  endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define EP_PARTICLE_NEON
+#  include <arm_neon.h>
+#endif
+
+#if defined(EP_PARTICLE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#  define EP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#  define EP_TARGET_AVX2
+#endif
+
+namespace {
+	using ParticleIntegrator::Params;
+	using ParticleIntegrator::Kernel;
+
+	constexpr float attractor_eps = 0.001f;
+
+	inline void integrate_scalar(const Params& p, float* x, float* y, float* s, float* dx, float* dy, int i, int n) {
+		float tx, ty, tsqr;
+		for (; i < n; i++) {
+			x[i] += dx[i];
+			y[i] += dy[i];
+			tx = p.ax0 - x[i];
+			ty = p.ay0 - y[i];
+			tsqr = sqrtf(tx*tx + ty*ty + attractor_eps);
+			dx[i] += p.gx + p.afc * tx / tsqr;
+			dy[i] += p.gy + p.afc * ty / tsqr;
+			s[i] += p.ds;
+		}
+	}
+
+#ifdef EP_PARTICLE_SSE2
+	void integrate_sse2(const Params& p, float* x, float* y, float* s, float* dx, float* dy, int n) {
+		const __m128 ax0 = _mm_set1_ps(p.ax0);
+		const __m128 ay0 = _mm_set1_ps(p.ay0);
+		const __m128 afc = _mm_set1_ps(p.afc);
+		const __m128 gx = _mm_set1_ps(p.gx);
+		const __m128 gy = _mm_set1_ps(p.gy);
+		const __m128 ds = _mm_set1_ps(p.ds);
+		const __m128 eps = _mm_set1_ps(attractor_eps);
+
+		int i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 vdx = _mm_loadu_ps(dx + i);
+			__m128 vdy = _mm_loadu_ps(dy + i);
+			__m128 vx = _mm_add_ps(_mm_loadu_ps(x + i), vdx);
+			__m128 vy = _mm_add_ps(_mm_loadu_ps(y + i), vdy);
+			_mm_storeu_ps(x + i, vx);
+			_mm_storeu_ps(y + i, vy);
+
+			__m128 tx = _mm_sub_ps(ax0, vx);
+			__m128 ty = _mm_sub_ps(ay0, vy);
+			__m128 tsqr = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), eps));
+			vdx = _mm_add_ps(vdx, _mm_add_ps(gx, _mm_div_ps(_mm_mul_ps(afc, tx), tsqr)));
+			vdy = _mm_add_ps(vdy, _mm_add_ps(gy, _mm_div_ps(_mm_mul_ps(afc, ty), tsqr)));
+			_mm_storeu_ps(dx + i, vdx);
+			_mm_storeu_ps(dy + i, vdy);
+
+			_mm_storeu_ps(s + i, _mm_add_ps(_mm_loadu_ps(s + i), ds));
+		}
+		integrate_scalar(p, x, y, s, dx, dy, i, n);
+	}
+#endif
+
+#ifdef EP_PARTICLE_AVX2
+	EP_TARGET_AVX2
+	void integrate_avx2(const Params& p, float* x, float* y, float* s, float* dx, float* dy, int n) {
+		const __m256 ax0 = _mm256_set1_ps(p.ax0);
+		const __m256 ay0 = _mm256_set1_ps(p.ay0);
+		const __m256 afc = _mm256_set1_ps(p.afc);
+		const __m256 gx = _mm256_set1_ps(p.gx);
+		const __m256 gy = _mm256_set1_ps(p.gy);
+		const __m256 ds = _mm256_set1_ps(p.ds);
+		const __m256 eps = _mm256_set1_ps(attractor_eps);
+
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 vdx = _mm256_loadu_ps(dx + i);
+			__m256 vdy = _mm256_loadu_ps(dy + i);
+			__m256 vx = _mm256_add_ps(_mm256_loadu_ps(x + i), vdx);
+			__m256 vy = _mm256_add_ps(_mm256_loadu_ps(y + i), vdy);
+			_mm256_storeu_ps(x + i, vx);
+			_mm256_storeu_ps(y + i, vy);
+
+			__m256 tx = _mm256_sub_ps(ax0, vx);
+			__m256 ty = _mm256_sub_ps(ay0, vy);
+			__m256 tsqr = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty)), eps));
+			vdx = _mm256_add_ps(vdx, _mm256_add_ps(gx, _mm256_div_ps(_mm256_mul_ps(afc, tx), tsqr)));
+			vdy = _mm256_add_ps(vdy, _mm256_add_ps(gy, _mm256_div_ps(_mm256_mul_ps(afc, ty), tsqr)));
+			_mm256_storeu_ps(dx + i, vdx);
+			_mm256_storeu_ps(dy + i, vdy);
+
+			_mm256_storeu_ps(s + i, _mm256_add_ps(_mm256_loadu_ps(s + i), ds));
+		}
+		integrate_scalar(p, x, y, s, dx, dy, i, n);
+	}
+
+	bool detect_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuid(info, 1);
+		// OSXSAVE and AVX, the OS must save the YMM registers
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) {
+			return false;
+		}
+		if ((_xgetbv(0) & 6) != 6) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	bool cpu_has_avx2() {
+		static const bool avx2 = detect_avx2();
+		return avx2;
+	}
+#endif
+
+#ifdef EP_PARTICLE_NEON
+	void integrate_neon(const Params& p, float* x, float* y, float* s, float* dx, float* dy, int n) {
+		const float32x4_t ax0 = vdupq_n_f32(p.ax0);
+		const float32x4_t ay0 = vdupq_n_f32(p.ay0);
+		const float32x4_t afc = vdupq_n_f32(p.afc);
+		const float32x4_t gx = vdupq_n_f32(p.gx);
+		const float32x4_t gy = vdupq_n_f32(p.gy);
+		const float32x4_t ds = vdupq_n_f32(p.ds);
+		const float32x4_t eps = vdupq_n_f32(attractor_eps);
+
+		int i = 0;
+		for (; i + 4 <= n; i += 4) {
+			float32x4_t vdx = vld1q_f32(dx + i);
+			float32x4_t vdy = vld1q_f32(dy + i);
+			float32x4_t vx = vaddq_f32(vld1q_f32(x + i), vdx);
+			float32x4_t vy = vaddq_f32(vld1q_f32(y + i), vdy);
+			vst1q_f32(x + i, vx);
+			vst1q_f32(y + i, vy);
+
+			float32x4_t tx = vsubq_f32(ax0, vx);
+			float32x4_t ty = vsubq_f32(ay0, vy);
+			float32x4_t sq = vaddq_f32(vaddq_f32(vmulq_f32(tx, tx), vmulq_f32(ty, ty)), eps);
+#if defined(__aarch64__) || defined(_M_ARM64)
+			float32x4_t inv = vdivq_f32(afc, vsqrtq_f32(sq));
+#else
+			// ARMv7 has no vector divide, refine the reciprocal square root estimate twice
+			float32x4_t rs = vrsqrteq_f32(sq);
+			rs = vmulq_f32(rs, vrsqrtsq_f32(vmulq_f32(sq, rs), rs));
+			rs = vmulq_f32(rs, vrsqrtsq_f32(vmulq_f32(sq, rs), rs));
+			float32x4_t inv = vmulq_f32(afc, rs);
+#endif
+			vdx = vaddq_f32(vdx, vaddq_f32(gx, vmulq_f32(tx, inv)));
+			vdy = vaddq_f32(vdy, vaddq_f32(gy, vmulq_f32(ty, inv)));
+			vst1q_f32(dx + i, vdx);
+			vst1q_f32(dy + i, vdy);
+
+			vst1q_f32(s + i, vaddq_f32(vld1q_f32(s + i), ds));
+		}
+		integrate_scalar(p, x, y, s, dx, dy, i, n);
+	}
+#endif
+
+	Kernel detect_kernel() {
+#ifdef EP_PARTICLE_AVX2
+		if (cpu_has_avx2()) {
+			return Kernel::AVX2;
+		}
+#endif
+#ifdef EP_PARTICLE_SSE2
+		return Kernel::SSE2;
+#elif defined(EP_PARTICLE_NEON)
+		return Kernel::NEON;
+#else
+		return Kernel::Scalar;
+#endif
+	}
+
+	Kernel& active_kernel() {
+		static Kernel kernel = detect_kernel();
+		return kernel;
+	}
+}
+
+bool ParticleIntegrator::IsSupported(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::Scalar:
+			return true;
+		case Kernel::SSE2:
+#ifdef EP_PARTICLE_SSE2
+			return true;
+#else
+			return false;
+#endif
+		case Kernel::AVX2:
+#ifdef EP_PARTICLE_AVX2
+			return cpu_has_avx2();
+#else
+			return false;
+#endif
+		case Kernel::NEON:
+#ifdef EP_PARTICLE_NEON
+			return true;
+#else
+			return false;
+#endif
+	}
+	return false;
+}
+
+const char* ParticleIntegrator::GetKernelName(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::Scalar:
+			return "Scalar";
+		case Kernel::SSE2:
+			return "SSE2";
+		case Kernel::AVX2:
+			return "AVX2";
+		case Kernel::NEON:
+			return "NEON";
+	}
+	return "Unknown";
+}
+
+ParticleIntegrator::Kernel ParticleIntegrator::GetKernel() {
+	return active_kernel();
+}
+
+void ParticleIntegrator::SetKernel(Kernel kernel) {
+	if (IsSupported(kernel)) {
+		active_kernel() = kernel;
+	}
+}
+
+void ParticleIntegrator::Integrate(const Params& p, float* x, float* y, float* s, float* dx, float* dy, int n) {
+	Integrate(active_kernel(), p, x, y, s, dx, dy, n);
+}
+
+void ParticleIntegrator::Integrate(Kernel kernel, const Params& p, float* x, float* y, float* s, float* dx, float* dy, int n) {
+	switch (kernel) {
+#ifdef EP_PARTICLE_AVX2
+		case Kernel::AVX2:
+			if (cpu_has_avx2()) {
+				integrate_avx2(p, x, y, s, dx, dy, n);
+				return;
+			}
+			break;
+#endif
+#ifdef EP_PARTICLE_SSE2
+		case Kernel::SSE2:
+			integrate_sse2(p, x, y, s, dx, dy, n);
+			return;
+#endif
+#ifdef EP_PARTICLE_NEON
+		case Kernel::NEON:
+			integrate_neon(p, x, y, s, dx, dy, n);
+			return;
+#endif
+		default:
+			break;
+	}
+	integrate_scalar(p, x, y, s, dx, dy, 0, n);
+}
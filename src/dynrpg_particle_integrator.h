@@ -0,0 +1,98 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_DYNRPG_PARTICLE_INTEGRATOR_H
+#define EP_DYNRPG_PARTICLE_INTEGRATOR_H
+
+// Headers
+#include <cstdint>
+
+/**
+ * Integration step of the DynRPG particle plugin.
+ *
+ * Moves every particle by its velocity, accelerates it towards the
+ * acceleration point and by gravity and applies the growth.
+ * A scalar reference implementation and SIMD kernels (SSE2, AVX2, NEON)
+ * are provided, the fastest supported kernel is picked at runtime.
+ */
+namespace ParticleIntegrator {
+
+/** Per effect constants used by the integration */
+struct Params {
+	/** acceleration point */
+	float ax0 = 0.0f;
+	float ay0 = 0.0f;
+	/** acceleration factor towards the acceleration point */
+	float afc = 0.0f;
+	/** gravity */
+	float gx = 0.0f;
+	float gy = 0.0f;
+	/** growth per step */
+	float ds = 0.0f;
+};
+
+enum class Kernel {
+	Scalar,
+	SSE2,
+	AVX2,
+	NEON
+};
+
+/**
+ * Integrates n particles with the fastest kernel supported by the CPU.
+ *
+ * @param p effect constants
+ * @param x particle x coordinates
+ * @param y particle y coordinates
+ * @param s particle sizes
+ * @param dx particle x velocities
+ * @param dy particle y velocities
+ * @param n number of particles
+ */
+void Integrate(const Params& p, float* x, float* y, float* s, float* dx, float* dy, int n);
+
+/**
+ * Integrates n particles with a specific kernel.
+ * Falls back to the scalar kernel when the kernel is not supported.
+ *
+ * @see Integrate
+ */
+void Integrate(Kernel kernel, const Params& p, float* x, float* y, float* s, float* dx, float* dy, int n);
+
+/** @return kernel used by Integrate */
+Kernel GetKernel();
+
+/**
+ * Overrides the kernel picked at startup.
+ * Unsupported kernels are ignored.
+ *
+ * @param kernel kernel to use
+ */
+void SetKernel(Kernel kernel);
+
+/**
+ * @param kernel kernel to check
+ * @return Whether the kernel was compiled in and the CPU supports it
+ */
+bool IsSupported(Kernel kernel);
+
+/** @return name of the kernel, for logging */
+const char* GetKernelName(Kernel kernel);
+
+} // namespace ParticleIntegrator
+
+#endif
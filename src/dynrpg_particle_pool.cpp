@@ -0,0 +1,188 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "dynrpg_particle_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace {
+	constexpr int alignment = 64;
+	constexpr int floats_per_line = alignment / sizeof(float);
+	// Target size of one chunk, large emitters get one slot per chunk
+	constexpr int chunk_bytes = 64 * 1024;
+	constexpr int max_chunk_slots = 16;
+	// x, y, s, dx, dy
+	constexpr int num_arrays = 5;
+}
+
+void ParticlePool::Chunk::Deleter::operator()(void* p) const {
+	std::free(p);
+}
+
+ParticlePool::ParticlePool(int particles_per_slot) {
+	SetParticlesPerSlot(particles_per_slot);
+}
+
+ParticlePool::~ParticlePool() = default;
+
+void ParticlePool::SetParticlesPerSlot(int particles_per_slot) {
+	this->particles_per_slot = std::max(particles_per_slot, 1);
+	slot_stride = (this->particles_per_slot + floats_per_line - 1) / floats_per_line * floats_per_line;
+
+	int slot_bytes = slot_stride * num_arrays * sizeof(float);
+	chunk_slots = std::clamp(chunk_bytes / slot_bytes, 1, max_chunk_slots);
+
+	// Running emitters are kept, only their particles are reset
+	int capacity = GetCapacity();
+	chunks.clear();
+	while (GetChunkCount() * chunk_slots < capacity) {
+		AllocChunk();
+	}
+	AddSlots();
+}
+
+void ParticlePool::RestartEmitters(int blocks) {
+	for (int i = 0; i < active; ++i) {
+		auto& emitter = GetEmitter(GetActive(i));
+		emitter.itr = 0;
+		emitter.end_cnt = std::min(emitter.end_cnt, blocks - 1);
+	}
+}
+
+void ParticlePool::Reserve(int num) {
+	while (GetCapacity() < num) {
+		Grow();
+	}
+}
+
+void ParticlePool::Grow() {
+	AllocChunk();
+	AddSlots();
+}
+
+void ParticlePool::AllocChunk() {
+	size_t array_size = static_cast<size_t>(chunk_slots) * slot_stride;
+	size_t bytes = array_size * num_arrays * sizeof(float);
+
+	// Zeroed, so that never started slots are harmless when drawn
+	void* memory = std::calloc(bytes + alignment - 1, 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+
+	uintptr_t aligned = (reinterpret_cast<uintptr_t>(memory) + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	float* base = reinterpret_cast<float*>(aligned);
+
+	Chunk chunk;
+	chunk.memory.reset(memory);
+	chunk.x = base;
+	chunk.y = base + array_size;
+	chunk.s = base + array_size * 2;
+	chunk.dx = base + array_size * 3;
+	chunk.dy = base + array_size * 4;
+	chunks.push_back(std::move(chunk));
+}
+
+void ParticlePool::AddSlots() {
+	// New slots are appended to the free region of the order list
+	Handle h = static_cast<Handle>(emitters.size());
+	for (; h < static_cast<Handle>(GetChunkCount() * chunk_slots); ++h) {
+		emitters.emplace_back();
+		order_pos.push_back(static_cast<int>(order.size()));
+		order.push_back(h);
+	}
+}
+
+void ParticlePool::Swap(int a, int b) {
+	std::swap(order[a], order[b]);
+	order_pos[order[a]] = a;
+	order_pos[order[b]] = b;
+}
+
+ParticlePool::Handle ParticlePool::Start(const std::string& tag) {
+	if (tags.find(tag) != tags.end()) {
+		return null_handle;
+	}
+
+	if (active == GetCapacity()) {
+		Grow();
+	}
+
+	// Take the first free slot and move it to the end of the starting phase
+	Handle h = order[active];
+	Swap(active, running);
+	Swap(running, starting);
+	++starting;
+	++running;
+	++active;
+
+	emitters[h] = Emitter();
+	tags.emplace(tag, h);
+	return h;
+}
+
+ParticlePool::Handle ParticlePool::Stop(const std::string& tag) {
+	auto it = tags.find(tag);
+	if (it == tags.end()) {
+		return null_handle;
+	}
+
+	Handle h = it->second;
+	tags.erase(it);
+
+	int pos = order_pos[h];
+	if (pos < starting) {
+		--starting;
+		Swap(pos, starting);
+		pos = starting;
+	}
+	--running;
+	Swap(pos, running);
+
+	return h;
+}
+
+void ParticlePool::StopAll() {
+	starting = 0;
+	running = 0;
+	tags.clear();
+}
+
+void ParticlePool::Clear() {
+	starting = 0;
+	running = 0;
+	active = 0;
+	tags.clear();
+}
+
+ParticlePool::Handle ParticlePool::Find(const std::string& tag) const {
+	auto it = tags.find(tag);
+	return it == tags.end() ? null_handle : it->second;
+}
+
+void ParticlePool::StartToStream(int i) {
+	--starting;
+	Swap(i, starting);
+}
+
+void ParticlePool::Release(int i) {
+	--active;
+	Swap(i, active);
+}
@@ -0,0 +1,291 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_DYNRPG_PARTICLE_POOL_H
+#define EP_DYNRPG_PARTICLE_POOL_H
+
+// Headers
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Storage of the emitters of a particle stream effect.
+ *
+ * Every emitter owns a slot of a fixed amount of particles, stored as
+ * 64 byte aligned structure-of-arrays (x, y, s, dx, dy). Slots live in
+ * chunks that are never moved, growing the pool only appends a chunk, so
+ * handles and particle pointers stay valid until the slot size changes.
+ *
+ * Active emitters are kept in one ordered list partitioned by phase:
+ * [0, starting) emitters filling their ring buffer,
+ * [starting, running) emitters streaming,
+ * [running, active) emitters that were stopped and fade out,
+ * [active, capacity) free slots.
+ * All phase changes and slot reuse are O(1) swaps inside this list.
+ */
+class ParticlePool {
+public:
+	using Handle = uint32_t;
+	static constexpr Handle null_handle = UINT32_MAX;
+
+	/** Per emitter state */
+	struct Emitter {
+		/** emitter position */
+		int x = 0;
+		int y = 0;
+		/** steps since the emitter started, ring buffer position */
+		int itr = 0;
+		/** remaining steps of a stopped emitter */
+		int end_cnt = 0;
+	};
+
+	/**
+	 * @param particles_per_slot particles owned by each emitter
+	 */
+	explicit ParticlePool(int particles_per_slot = 1);
+
+	~ParticlePool();
+
+	ParticlePool(const ParticlePool&) = delete;
+	ParticlePool& operator=(const ParticlePool&) = delete;
+
+	/**
+	 * Changes the amount of particles per emitter.
+	 * The storage is reallocated and all particles are reset, the emitters
+	 * and their handles are kept. The ring positions of the emitters are not
+	 * changed, see RestartEmitters.
+	 *
+	 * @param particles_per_slot particles owned by each emitter
+	 */
+	void SetParticlesPerSlot(int particles_per_slot);
+
+	/**
+	 * Restarts the ring buffers of all active emitters, used after their
+	 * particles were reset. The ring position starts over and stopping
+	 * emitters run for at most blocks - 1 further steps.
+	 *
+	 * @param blocks new length of the ring buffers
+	 */
+	void RestartEmitters(int blocks);
+
+	/** @return particles owned by each emitter */
+	int GetParticlesPerSlot() const;
+
+	/**
+	 * Makes sure that slots for at least num emitters are allocated.
+	 *
+	 * @param num amount of emitters
+	 */
+	void Reserve(int num);
+
+	/**
+	 * Starts a new emitter.
+	 *
+	 * @param tag unique name of the emitter
+	 * @return handle of the new emitter or null_handle when the tag is in use
+	 */
+	Handle Start(const std::string& tag);
+
+	/**
+	 * Moves a starting or streaming emitter to the stopping phase and
+	 * frees the tag.
+	 *
+	 * @param tag name of the emitter
+	 * @return handle of the emitter or null_handle when not found
+	 */
+	Handle Stop(const std::string& tag);
+
+	/** Moves all emitters to the stopping phase and frees all tags. */
+	void StopAll();
+
+	/** Releases all emitters, the storage is kept. */
+	void Clear();
+
+	/**
+	 * @param tag name of the emitter
+	 * @return handle of the starting or streaming emitter, null_handle when not found
+	 */
+	Handle Find(const std::string& tag) const;
+
+	/** @return tags of all starting and streaming emitters */
+	const std::unordered_map<std::string, Handle>& GetTags() const;
+
+	/**
+	 * Moves the starting emitter at position i of the active list to the
+	 * streaming phase. The emitter previously at the end of the starting
+	 * phase takes position i.
+	 *
+	 * @param i position in the active list
+	 */
+	void StartToStream(int i);
+
+	/**
+	 * Releases the stopping emitter at position i of the active list.
+	 * The last active emitter takes position i.
+	 *
+	 * @param i position in the active list
+	 */
+	void Release(int i);
+
+	/** @return number of emitters in the starting phase */
+	int GetStartingCount() const;
+
+	/** @return number of emitters in the starting or streaming phase */
+	int GetRunningCount() const;
+
+	/** @return number of emitters in any phase */
+	int GetActiveCount() const;
+
+	/** @return number of allocated slots */
+	int GetCapacity() const;
+
+	/** @return number of allocated chunks */
+	int GetChunkCount() const;
+
+	/**
+	 * @param i position in the active list
+	 * @return handle of the emitter
+	 */
+	Handle GetActive(int i) const;
+
+	/**
+	 * @param h emitter handle
+	 * @return emitter state, valid until the pool grows
+	 */
+	Emitter& GetEmitter(Handle h);
+	const Emitter& GetEmitter(Handle h) const;
+
+	/**
+	 * Particle arrays of a slot, GetParticlesPerSlot() elements each.
+	 * The pointers stay valid until SetParticlesPerSlot is called.
+	 */
+	float* X(Handle h);
+	float* Y(Handle h);
+	float* S(Handle h);
+	float* DX(Handle h);
+	float* DY(Handle h);
+
+private:
+	/** Particle arrays of chunk_slots consecutive slots */
+	struct Chunk {
+		struct Deleter {
+			void operator()(void* p) const;
+		};
+		/** single allocation holding all arrays */
+		std::unique_ptr<void, Deleter> memory;
+		float* x = nullptr;
+		float* y = nullptr;
+		float* s = nullptr;
+		float* dx = nullptr;
+		float* dy = nullptr;
+	};
+
+	void Grow();
+	void AllocChunk();
+	void AddSlots();
+	void Swap(int a, int b);
+	float* Slot(float* base, Handle h) const;
+	Chunk& GetChunk(Handle h);
+
+	int particles_per_slot = 1;
+	/** distance between two slots, padded to keep every slot 64 byte aligned */
+	int slot_stride = 1;
+	int chunk_slots = 1;
+	int starting = 0;
+	int running = 0;
+	int active = 0;
+
+	std::vector<Chunk> chunks;
+	std::vector<Emitter> emitters;
+	/** position of every slot in the order list */
+	std::vector<int> order_pos;
+	std::vector<Handle> order;
+	std::unordered_map<std::string, Handle> tags;
+};
+
+inline int ParticlePool::GetParticlesPerSlot() const {
+	return particles_per_slot;
+}
+
+inline int ParticlePool::GetStartingCount() const {
+	return starting;
+}
+
+inline int ParticlePool::GetRunningCount() const {
+	return running;
+}
+
+inline int ParticlePool::GetActiveCount() const {
+	return active;
+}
+
+inline int ParticlePool::GetCapacity() const {
+	return static_cast<int>(order.size());
+}
+
+inline int ParticlePool::GetChunkCount() const {
+	return static_cast<int>(chunks.size());
+}
+
+inline const std::unordered_map<std::string, ParticlePool::Handle>& ParticlePool::GetTags() const {
+	return tags;
+}
+
+inline ParticlePool::Handle ParticlePool::GetActive(int i) const {
+	return order[i];
+}
+
+inline ParticlePool::Chunk& ParticlePool::GetChunk(Handle h) {
+	return chunks[h / chunk_slots];
+}
+
+inline ParticlePool::Emitter& ParticlePool::GetEmitter(Handle h) {
+	return emitters[h];
+}
+
+inline const ParticlePool::Emitter& ParticlePool::GetEmitter(Handle h) const {
+	return emitters[h];
+}
+
+inline float* ParticlePool::Slot(float* base, Handle h) const {
+	return base + (h % chunk_slots) * slot_stride;
+}
+
+inline float* ParticlePool::X(Handle h) {
+	return Slot(GetChunk(h).x, h);
+}
+
+inline float* ParticlePool::Y(Handle h) {
+	return Slot(GetChunk(h).y, h);
+}
+
+inline float* ParticlePool::S(Handle h) {
+	return Slot(GetChunk(h).s, h);
+}
+
+inline float* ParticlePool::DX(Handle h) {
+	return Slot(GetChunk(h).dx, h);
+}
+
+inline float* ParticlePool::DY(Handle h) {
+	return Slot(GetChunk(h).dy, h);
+}
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "dynrpg_particle_renderer.h"
+#include "bitmap.h"
+
+namespace {
+	bool enabled = true;
+
+	/** Multiplies all four 8 bit channels of a pixel with a (0-255) */
+	inline uint32_t mul_un8x4(uint32_t p, uint32_t a) {
+		uint32_t t = (p & 0x00FF00FF) * a + 0x00800080;
+		t = ((t + ((t >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+		uint32_t u = ((p >> 8) & 0x00FF00FF) * a + 0x00800080;
+		u = (u + ((u >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+		return t | u;
+	}
+
+	/** Premultiplied source over destination */
+	inline uint32_t over(uint32_t src, uint32_t dst, int as) {
+		uint32_t sa = (src >> as) & 0xFF;
+		if (sa == 0xFF) {
+			return src;
+		}
+		return src + mul_un8x4(dst, 0xFF - sa);
+	}
+
+	/** Clips the span [v, v + len) against [0, limit) */
+	inline bool clip(int& v, int& len, int limit) {
+		if (v < 0) {
+			len += v;
+			v = 0;
+		}
+		if (v + len > limit) {
+			len = limit - v;
+		}
+		return len > 0;
+	}
+}
+
+bool ParticleRenderer::IsSupported(const Bitmap& dst) {
+	return enabled && dst.bpp() == 4 && dst.pixels() != nullptr;
+}
+
+void ParticleRenderer::SetEnabled(bool enable) {
+	enabled = enable;
+}
+
+bool ParticleRenderer::IsEnabled() {
+	return enabled;
+}
+
+void ParticleRenderer::DrawSolid(Bitmap& dst, const float* x, const float* y, const float* s, int count,
+		int cam_x, int cam_y, const Color& color) {
+	if (color.alpha == 0) {
+		return;
+	}
+
+	const auto& pf = Bitmap::pixel_format;
+	const int as = pf.a.shift;
+	const uint32_t pix = pf.rgba_to_uint32_t(
+			color.red * color.alpha / 255,
+			color.green * color.alpha / 255,
+			color.blue * color.alpha / 255,
+			color.alpha);
+	const bool opaque = (color.alpha == 255);
+
+	const int dst_w = dst.width();
+	const int dst_h = dst.height();
+	const int stride = dst.pitch() / sizeof(uint32_t);
+	auto* pixels = reinterpret_cast<uint32_t*>(dst.pixels());
+
+	for (int i = 0; i < count; ++i) {
+		// Same truncation as Rect(float, float, float, float) in the StretchBlit path
+		int px = static_cast<int>(x[i] - cam_x - s[i] / 2);
+		int py = static_cast<int>(y[i] - cam_y - s[i] / 2);
+		int size = static_cast<int>(s[i]);
+
+		if (size == 1) {
+			if (static_cast<unsigned>(px) < static_cast<unsigned>(dst_w) &&
+				static_cast<unsigned>(py) < static_cast<unsigned>(dst_h)) {
+				uint32_t& d = pixels[py * stride + px];
+				d = opaque ? pix : over(pix, d, as);
+			}
+			continue;
+		}
+
+		int w = size;
+		int h = size;
+		if (!clip(px, w, dst_w) || !clip(py, h, dst_h)) {
+			continue;
+		}
+
+		uint32_t* row = pixels + py * stride + px;
+		for (int yy = 0; yy < h; ++yy, row += stride) {
+			if (opaque) {
+				std::fill(row, row + w, pix);
+			} else {
+				for (int xx = 0; xx < w; ++xx) {
+					row[xx] = over(pix, row[xx], as);
+				}
+			}
+		}
+	}
+}
+
+void ParticleRenderer::DrawTexture(Bitmap& dst, const float* x, const float* y, const float* s, int count,
+		int cam_x, int cam_y, const Bitmap& tex, const Rect& src_rect, int opacity) {
+	if (opacity <= 0 || src_rect.width <= 0 || src_rect.height <= 0) {
+		return;
+	}
+	opacity = std::min(opacity, 255);
+
+	const int as = Bitmap::pixel_format.a.shift;
+	const int dst_w = dst.width();
+	const int dst_h = dst.height();
+	const int stride = dst.pitch() / sizeof(uint32_t);
+	auto* pixels = reinterpret_cast<uint32_t*>(dst.pixels());
+
+	const int src_stride = tex.pitch() / sizeof(uint32_t);
+	const auto* src_pixels = reinterpret_cast<const uint32_t*>(tex.pixels()) + src_rect.y * src_stride + src_rect.x;
+	const float tw = src_rect.width;
+	const float th = src_rect.height;
+
+	for (int i = 0; i < count; ++i) {
+		int px = static_cast<int>(x[i] - cam_x - s[i] / 2);
+		int py = static_cast<int>(y[i] - cam_y - s[i] / 2);
+		int w = static_cast<int>(tw * s[i]);
+		int h = static_cast<int>(th * s[i]);
+		if (w <= 0 || h <= 0) {
+			continue;
+		}
+
+		// 16.16 fixed point source step, sampled at the pixel centre (nearest filter)
+		const int32_t step_x = (src_rect.width << 16) / w;
+		const int32_t step_y = (src_rect.height << 16) / h;
+
+		int cx = px, cw = w;
+		int cy = py, ch = h;
+		if (!clip(cx, cw, dst_w) || !clip(cy, ch, dst_h)) {
+			continue;
+		}
+
+		const int32_t sx0 = (cx - px) * step_x + step_x / 2;
+		int32_t sy = (cy - py) * step_y + step_y / 2;
+
+		uint32_t* row = pixels + cy * stride + cx;
+		for (int yy = 0; yy < ch; ++yy, row += stride, sy += step_y) {
+			const uint32_t* src_row = src_pixels + (sy >> 16) * src_stride;
+			int32_t sx = sx0;
+			for (int xx = 0; xx < cw; ++xx, sx += step_x) {
+				uint32_t sp = src_row[sx >> 16];
+				if (sp == 0) {
+					continue;
+				}
+				if (opacity != 255) {
+					sp = mul_un8x4(sp, opacity);
+				}
+				row[xx] = over(sp, row[xx], as);
+			}
+		}
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_DYNRPG_PARTICLE_RENDERER_H
+#define EP_DYNRPG_PARTICLE_RENDERER_H
+
+// Headers
+#include <cstdint>
+#include "color.h"
+#include "rect.h"
+#include "memory_management.h"
+
+class Bitmap;
+
+/**
+ * Batched rasterizer for the DynRPG particle plugin.
+ *
+ * Particles are passed as structure-of-arrays (centre x, centre y, size)
+ * and are written directly into the pixels of the destination bitmap
+ * instead of issuing one pixman composite per particle.
+ * The rectangle of every particle is computed exactly like the old
+ * StretchBlit based code did, so both paths cover the same pixels.
+ */
+namespace ParticleRenderer {
+
+/**
+ * Checks if the batched rasterizer can write into the bitmap.
+ * Only 32 bit surfaces are supported, everything else must use
+ * the StretchBlit fallback.
+ *
+ * @param dst destination bitmap
+ * @return whether the fast path is usable
+ */
+bool IsSupported(const Bitmap& dst);
+
+/**
+ * Enables or disables the batched rasterizer globally.
+ * When disabled IsSupported always returns false.
+ *
+ * @param enabled whether to use the fast path
+ */
+void SetEnabled(bool enabled);
+
+/** @return whether the batched rasterizer is enabled */
+bool IsEnabled();
+
+/**
+ * Draws count solid squares of the same color.
+ * 1x1 particles are plotted as single pixels, larger ones are filled
+ * row by row.
+ *
+ * @param dst destination bitmap
+ * @param x particle centre x coordinates
+ * @param y particle centre y coordinates
+ * @param s particle sizes
+ * @param count number of particles
+ * @param cam_x camera x offset subtracted from every particle
+ * @param cam_y camera y offset subtracted from every particle
+ * @param color fill color
+ */
+void DrawSolid(Bitmap& dst, const float* x, const float* y, const float* s, int count,
+		int cam_x, int cam_y, const Color& color);
+
+/**
+ * Draws count scaled copies of an already tinted texture.
+ * The texture is sampled with nearest neighbour filtering and blended
+ * with the destination (premultiplied source over).
+ *
+ * @param dst destination bitmap
+ * @param x particle top-left anchor x coordinates (centre of a 1x1 particle)
+ * @param y particle top-left anchor y coordinates (centre of a 1x1 particle)
+ * @param s particle scale factors
+ * @param count number of particles
+ * @param cam_x camera x offset subtracted from every particle
+ * @param cam_y camera y offset subtracted from every particle
+ * @param tex texture to draw
+ * @param src_rect part of the texture to draw
+ * @param opacity global opacity (0-255)
+ */
+void DrawTexture(Bitmap& dst, const float* x, const float* y, const float* s, int count,
+		int cam_x, int cam_y, const Bitmap& tex, const Rect& src_rect, int opacity);
+
+} // namespace ParticleRenderer
+
+#endif
@@ -20,6 +20,7 @@
 #define _USE_MATH_DEFINES
 #endif
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <map>
@@ -27,6 +28,7 @@
 
 #include "cache.h"
 #include "dynrpg_rpgss.h"
+#include "dynrpg_chunk.h"
 #include "baseui.h"
 #include "bitmap.h"
 #include "filefinder.h"
@@ -45,8 +47,35 @@ constexpr Drawable::Z_t layer_mask = (5 << 16);
 constexpr Drawable::Z_t default_priority = Priority_Timer + layer_mask;
 
 namespace {
-	std::map<std::string, std::unique_ptr<RpgssSprite>> graphics;
-	std::map<std::string, std::function<double(double, double, double, double)>> easing_funcs;
+	// Version of the binary save chunk
+	constexpr uint16_t save_version = 1;
+	// Two empty strings (id, file) and four effects with empty easing
+	constexpr size_t min_sprite_size = 8 + 4 * 36 + 138;
+	constexpr size_t approx_sprite_size = 384;
+
+	enum class Easing : uint8_t {
+		Linear,
+		QuadraticIn,
+		QuadraticOut,
+		QuadraticInOut,
+		CubicIn,
+		CubicOut,
+		CubicInOut,
+		SinusoidalIn,
+		SinusoidalOut,
+		SinusoidalInOut,
+		ExponentialIn,
+		ExponentialOut,
+		ExponentialInOut,
+		CircularIn,
+		CircularOut,
+		CircularInOut
+	};
+	constexpr int easing_count = 16;
+
+	// Every curve sampled on [0, 1], interpolated linearly between samples
+	constexpr int easing_lut_size = 256;
+	std::array<std::array<double, easing_lut_size + 1>, easing_count> easing_lut;
 
 	// via http://www.gizma.com/easing/
 	// via https://gist.github.com/Metallix/628de265d0a24e0c4acb
@@ -149,112 +178,173 @@ namespace {
 	}
 }
 
-class Effect {
-public:
-	Effect() {
-
-	}
-
-	Effect(double start) :
-		start(0.0), current(start), finish(0.0), finish_frame(0), easing("linear")
-	{
-		// static effect
-	}
-
-	Effect(double start, double finish, int frames, const std::string& easing) :
-		start(start), current(start), finish(finish), finish_frame(frames), easing(easing)
-	{
-		if (easing.empty()) {
-			this->easing = "linear";
-			return;
-		}
-
-		if (easing_funcs.find(easing) == easing_funcs.end()) {
-			Output::Warning("RPGSS: Unsupported easing mode {}}", easing);
-			this->easing = "linear";
+namespace {
+	using EasingFunc = double (*)(double, double, double, double);
+
+	constexpr std::array<std::pair<std::string_view, EasingFunc>, easing_count> easing_table = {{
+		{ "linear", linear_easing },
+		{ "quadratic in", quadratic_in_easing },
+		{ "quadratic out", quadratic_out_easing },
+		{ "quadratic in/out", quadratic_in_out_easing },
+		{ "cubic in", cubic_in_easing },
+		{ "cubic out", cubic_out_easing },
+		{ "cubic in/out", cubic_in_out_easing },
+		{ "sinusoidal in", sinusoidal_in_easing },
+		{ "sinusoidal out", sinusoidal_out_easing },
+		{ "sinusoidal in/out", sinusoidal_in_out_easing },
+		{ "exponential in", exponential_in_easing },
+		{ "exponential out", exponential_out_easing },
+		{ "exponential in/out", exponential_in_out_easing },
+		{ "circular in", circular_in_easing },
+		{ "circular out", circular_out_easing },
+		{ "circular in/out", circular_in_out_easing }
+	}};
+
+	void build_easing_lut() {
+		for (int e = 0; e < easing_count; ++e) {
+			auto& lut = easing_lut[e];
+			for (int i = 0; i <= easing_lut_size; ++i) {
+				lut[i] = easing_table[e].second(i, 0.0, 1.0, easing_lut_size);
+			}
+			// Tweens start and end exactly at their values
+			lut[0] = 0.0;
+			lut[easing_lut_size] = 1.0;
 		}
 	}
 
-	double NextFrame() {
-		if (finish_frame == 0) {
-			return current;
-		}
-
-		bool ok = current_frame <= finish_frame;
-
-		if (!ok) {
-			return current;
+	Easing parse_easing(std::string_view name) {
+		if (name.empty()) {
+			return Easing::Linear;
 		}
 
-		if (easing_precalc.empty()) {
-			PrecalculateEasing();
+		for (int e = 0; e < easing_count; ++e) {
+			if (easing_table[e].first == name) {
+				return static_cast<Easing>(e);
+			}
 		}
 
-		current += easing_precalc[current_frame];
-
-		++current_frame;
-		return current;
+		Output::Warning("RPGSS: Unsupported easing mode {}", name);
+		return Easing::Linear;
 	}
 
-	bool IsFinished() {
-		return !(finish_frame > 0 && current_frame <= finish_frame);
+	std::string_view easing_name(Easing easing) {
+		return easing_table[static_cast<int>(easing)].first;
 	}
 
-	picojson::object ToJson() {
-		picojson::object o;
-		o["start"] = picojson::value(start);
-		o["finish"] = picojson::value(finish);
-		o["current"] = picojson::value(current);
-		o["current_frame"] = picojson::value((double)current_frame);
-		o["finish_frame"] = picojson::value((double)finish_frame);
-		o["easing"] = picojson::value(easing);
-
-		return o;
+	/**
+	 * @param easing easing curve
+	 * @param p progress in [0, 1]
+	 * @return eased progress
+	 */
+	double ease(Easing easing, double p) {
+		const auto& lut = easing_lut[static_cast<int>(easing)];
+		double f = p * easing_lut_size;
+		int i = std::min(static_cast<int>(f), easing_lut_size - 1);
+		return lut[i] + (lut[i + 1] - lut[i]) * (f - i);
 	}
+}
 
-	static Effect FromJson(picojson::object& o) {
-		Effect e;
-		e.start = o["start"].get<double>();
-		e.finish = o["finish"].get<double>();
-		e.current = o["current"].get<double>();
-		e.current_frame = (int)(o["current_frame"].get<double>());
-		e.finish_frame = (int)(o["finish_frame"].get<double>());
-		e.easing = o["easing"].get<std::string>();
+/** Sprite properties animated by the TweenEngine */
+enum Channel : uint8_t {
+	Channel_X,
+	Channel_Y,
+	Channel_ZoomX,
+	Channel_ZoomY,
+	Channel_Angle,
+	Channel_Opacity,
+	Channel_Red,
+	Channel_Green,
+	Channel_Blue,
+	Channel_Sat,
+	Channel_Count
+};
 
-		return e;
-	}
+/**
+ * Active tweens of all sprites, stored as structure-of-arrays and advanced
+ * in one pass per frame. A sprite has at most one tween per channel, idle
+ * sprites own no tween and are not touched.
+ */
+class TweenEngine {
+public:
+	static constexpr int32_t no_tween = -1;
+
+	/**
+	 * Starts a tween and replaces the running tween of the channel.
+	 * Frame 0 yields from, frame frames yields to.
+	 *
+	 * @param owner animated sprite
+	 * @param channel animated property
+	 * @param from value at frame 0
+	 * @param to value at the last frame
+	 * @param frames duration, no tween is started when 0
+	 * @param first_frame frame yielded by the next Advance
+	 * @param easing easing curve
+	 */
+	void Start(RpgssSprite* owner, Channel channel, double from, double to, int frames, int first_frame, Easing easing);
+
+	/**
+	 * Starts an endless tween adding speed every frame.
+	 *
+	 * @param owner animated sprite
+	 * @param channel animated property
+	 * @param speed change per frame
+	 */
+	void StartSpin(RpgssSprite* owner, Channel channel, double speed);
+
+	/**
+	 * Stops the tween of a channel, the property keeps its current value.
+	 *
+	 * @param owner animated sprite
+	 * @param channel animated property
+	 */
+	void Stop(RpgssSprite* owner, Channel channel);
+
+	/** Advances all tweens by one frame and marks their sprites dirty. */
+	void Advance();
+
+	/** State of a running tween, used by the savegame */
+	struct State {
+		double from = 0.0;
+		double to = 0.0;
+		int frame = 0;
+		int frames = 0;
+		Easing easing = Easing::Linear;
+		bool spin = false;
+	};
 
-	double start = 0.0;
-	double finish = 0.0;
-	double current = 0.0;
-	int current_frame = 0;
-	int finish_frame = 0;
-	std::vector<double> easing_precalc;
-	std::string easing = "linear";
+	/**
+	 * @param owner animated sprite
+	 * @param channel animated property
+	 * @param state filled with the tween state
+	 * @return Whether the channel has a running tween
+	 */
+	bool GetState(const RpgssSprite* owner, Channel channel, State& state) const;
 
 private:
-	void PrecalculateEasing() {
-		easing_precalc.clear();
-		easing_precalc.resize((size_t)finish_frame + 1);
-
-		double prev = start;
-
-		if (easing.empty()) {
-			easing = "linear";
-		}
-
-		auto interpolate_easing = easing_funcs[easing];
-
-		for (size_t i = 1; i < (size_t)finish_frame; ++i) {
-			double e = interpolate_easing(i, start, finish - start, finish_frame);
-			easing_precalc[i] = e - prev;
-			prev = e;
-		}
-
-		easing_precalc[finish_frame] = finish - prev;
-	}
+	void Remove(int32_t i);
+
+	// Spinning tweens have frames == spin_frames
+	static constexpr int32_t spin_frames = -1;
+
+	std::vector<double> from;
+	std::vector<double> delta;
+	std::vector<int32_t> frame;
+	std::vector<int32_t> frames;
+	std::vector<Easing> easing;
+	std::vector<RpgssSprite*> owner;
+	std::vector<Channel> channel;
 };
 
+namespace {
+	TweenEngine tweens;
+	// Sprites whose properties changed since the last frame
+	std::vector<RpgssSprite*> dirty_sprites;
+	// Declared after tweens and dirty_sprites, the sprites unregister from both on destruction
+	std::map<std::string, std::unique_ptr<RpgssSprite>> graphics;
+	int last_display_x = 0;
+	int last_display_y = 0;
+}
+
 class RpgssSprite {
 public:
 	enum FixedTo {
@@ -263,17 +353,43 @@ public:
 		FixedTo_Mouse
 	};
 
+	enum Dirty : uint32_t {
+		Dirty_Position = (1 << Channel_X) | (1 << Channel_Y),
+		Dirty_Zoom = (1 << Channel_ZoomX) | (1 << Channel_ZoomY),
+		Dirty_Angle = 1 << Channel_Angle,
+		Dirty_Opacity = 1 << Channel_Opacity,
+		Dirty_Tone = (1 << Channel_Red) | (1 << Channel_Green) | (1 << Channel_Blue) | (1 << Channel_Sat),
+		Dirty_Z = 1 << Channel_Count,
+		Dirty_Blend = 1 << (Channel_Count + 1),
+		Dirty_Visible = 1 << (Channel_Count + 2),
+		Dirty_All = (1 << (Channel_Count + 3)) - 1
+	};
+
 	RpgssSprite() {
+		tween.fill(TweenEngine::no_tween);
 	}
 
-	RpgssSprite(const std::string& filename) {
+	RpgssSprite(const std::string& filename) : RpgssSprite() {
 		SetSpriteImage(filename);
 		SetSpriteDefaults();
 	}
 
 	~RpgssSprite() {
+		for (int c = 0; c < Channel_Count; ++c) {
+			tweens.Stop(this, static_cast<Channel>(c));
+		}
+		if (dirty) {
+			// The last dirty sprite takes the place of this one
+			RpgssSprite* last = dirty_sprites.back();
+			dirty_sprites[dirty_index] = last;
+			last->dirty_index = dirty_index;
+			dirty_sprites.pop_back();
+		}
 	};
 
+	RpgssSprite(const RpgssSprite&) = delete;
+	RpgssSprite& operator=(const RpgssSprite&) = delete;
+
 	bool SetSprite(const std::string& filename) {
 		return SetSpriteImage(filename);
 	}
@@ -282,59 +398,34 @@ public:
 		return sprite.get();
 	}
 
-	static double interpolate(double d, double x0, double x1) {
-		return (x0 * (d - 1) + x1) / d;
-	}
-
 	static int frames(int ms) {
 		return (int)(DEFAULT_FPS * ms / 1000.0f);
 	}
 
-	void Update() {
-		if (file.empty()) {
-			return;
-		}
-
-		double x = movement_x.NextFrame();
-		double y = movement_y.NextFrame();
-
-		if (fixed_to == FixedTo_Map) {
-			x -= (double)(Game_Map::GetDisplayX() / TILE_SIZE);
-			y -= (double)(Game_Map::GetDisplayY() / TILE_SIZE);
-		}
-
-		if (rotation_time_left > 0) {
-			// TODO: Rotate ccw
-			current_angle = interpolate(rotation_time_left, current_angle, finish_angle);
-			--rotation_time_left;
-		}
-
-		if (opacity_time_left > 0) {
-			current_opacity = interpolate(opacity_time_left, current_opacity, finish_opacity);
-			--opacity_time_left;
+	void MarkDirty(uint32_t flags) {
+		if (!dirty) {
+			dirty_index = dirty_sprites.size();
+			dirty_sprites.push_back(this);
 		}
+		dirty |= flags;
+	}
 
-		if (tone_time_left > 0)	{
-			current_red = interpolate(tone_time_left, current_red, finish_red);
-			current_green = interpolate(tone_time_left, current_green, finish_green);
-			current_blue = interpolate(tone_time_left, current_blue, finish_blue);
-			current_sat = interpolate(tone_time_left, current_sat, finish_sat);
-			--tone_time_left;
-		}
+	/** Pushes the properties that changed since the last call to the Sprite. */
+	void Apply() {
+		uint32_t flags = dirty;
+		dirty = 0;
 
-		if (rotate_forever_degree) {
-			current_angle += (rotate_cw ? 1 : -1) * rotate_forever_degree;
+		if (file.empty()) {
+			return;
 		}
 
-		double zx = zoom_x.NextFrame() / 100.0;
-		double zy = zoom_y.NextFrame() / 100.0;
+		bool load = !((value[Channel_ZoomX] == 0.0 && value[Channel_ZoomY] == 0.0) || value[Channel_Opacity] == 0 || visible == false);
 
-		bool loaded_this_frame = !(zx == 0.0 && zy == 0.0 || current_opacity == 0 || visible == false);
-
-		if (loaded_this_frame != image_loaded) {
+		if (load != image_loaded) {
 			if (!image_loaded) {
 				// Load image now
 				LoadSprite();
+				flags = Dirty_All;
 			} else {
 				UnloadSprite();
 			}
@@ -344,71 +435,95 @@ public:
 			return;
 		}
 
-		sprite->SetX(x);
-		sprite->SetY(y);
-		sprite->SetZ(z);
-		sprite->SetOx((int)(sprite->GetWidth() / 2));
-		sprite->SetOy((int)(sprite->GetHeight() / 2));
-		sprite->SetAngle(current_angle * (2 * M_PI) / 360);
-		sprite->SetZoomX(zx);
-		sprite->SetZoomY(zy);
-		sprite->SetOpacity((int)(current_opacity));
-		sprite->SetTone(Tone(current_red, current_green, current_blue, current_sat));
-		sprite->SetBlendType(static_cast<int>(blendmode));
-		sprite->SetVisible(visible);
+		if (flags & Dirty_Position) {
+			double x = value[Channel_X];
+			double y = value[Channel_Y];
+			if (fixed_to == FixedTo_Map) {
+				x -= (double)(Game_Map::GetDisplayX() / TILE_SIZE);
+				y -= (double)(Game_Map::GetDisplayY() / TILE_SIZE);
+			}
+			sprite->SetX(x);
+			sprite->SetY(y);
+		}
+		if (flags & Dirty_Z) {
+			sprite->SetZ(z);
+		}
+		if (flags == Dirty_All) {
+			sprite->SetOx((int)(sprite->GetWidth() / 2));
+			sprite->SetOy((int)(sprite->GetHeight() / 2));
+		}
+		if (flags & Dirty_Angle) {
+			sprite->SetAngle(value[Channel_Angle] * (2 * M_PI) / 360);
+		}
+		if (flags & Dirty_Zoom) {
+			sprite->SetZoomX(value[Channel_ZoomX] / 100.0);
+			sprite->SetZoomY(value[Channel_ZoomY] / 100.0);
+		}
+		if (flags & Dirty_Opacity) {
+			sprite->SetOpacity((int)(value[Channel_Opacity]));
+		}
+		if (flags & Dirty_Tone) {
+			sprite->SetTone(Tone(value[Channel_Red], value[Channel_Green], value[Channel_Blue], value[Channel_Sat]));
+		}
+		if (flags & Dirty_Blend) {
+			sprite->SetBlendType(static_cast<int>(blendmode));
+		}
+		if (flags & Dirty_Visible) {
+			sprite->SetVisible(visible);
+		}
+	}
+
+	bool IsFixedToMap() const {
+		return fixed_to == FixedTo_Map;
 	}
 
 	void SetRelativeMovementXEffect(int ox, int ms, const std::string& easing) {
-		movement_x = Effect(movement_x.current,(double)ox + movement_x.current, frames(ms), easing);
+		SetEffect(Channel_X, (double)ox + value[Channel_X], frames(ms), parse_easing(easing));
 	}
 
 	void SetRelativeMovementYEffect(int oy, int ms, const std::string& easing) {
-		movement_y = Effect(movement_y.current,(double)oy + movement_y.current, frames(ms), easing);
+		SetEffect(Channel_Y, (double)oy + value[Channel_Y], frames(ms), parse_easing(easing));
 	}
 
 	void SetMovementXEffect(int x, int ms, const std::string& easing) {
-		movement_x = Effect(movement_x.current,(double)x, frames(ms), easing);
+		SetEffect(Channel_X, (double)x, frames(ms), parse_easing(easing));
 	}
 
 	void SetMovementYEffect(int y, int ms, const std::string& easing) {
-		movement_y = Effect(movement_y.current,(double)y, frames(ms), easing);
+		SetEffect(Channel_Y, (double)y, frames(ms), parse_easing(easing));
 	}
 
 	void SetRelativeRotationEffect(double angle, int ms) {
-		SetRotationEffect(angle >= 0.0, current_angle + angle, ms);
+		SetRotationEffect(angle >= 0.0, value[Channel_Angle] + angle, ms);
 	}
 
 	void SetRotationEffect(bool forward, double angle, int ms) {
-		finish_angle = angle;
-		rotation_time_left = frames(ms);
-		rotate_forever_degree = 0.0;
-		rotate_cw = forward;
+		// TODO: Rotate ccw
+		SetInterpolation(Channel_Angle, angle, frames(ms));
 	}
 
 	void SetRotationForever(bool forward, int ms_per_full_rotation) {
-		rotate_forever_degree = 360.0 / frames(ms_per_full_rotation);
-		rotate_cw = forward;
+		tweens.StartSpin(this, Channel_Angle, (forward ? 1 : -1) * 360.0 / frames(ms_per_full_rotation));
 	}
 
 	void SetZoomXEffect(int new_zoom, int ms, const std::string& easing_) {
-		zoom_x = Effect(zoom_x.current,(double)new_zoom, frames(ms), easing_);
+		SetEffect(Channel_ZoomX, (double)new_zoom, frames(ms), parse_easing(easing_));
 	}
 
 	void SetZoomYEffect(int new_zoom, int ms, const std::string& easing_) {
-		zoom_y = Effect(zoom_y.current,(double)new_zoom, frames(ms), easing_);
+		SetEffect(Channel_ZoomY, (double)new_zoom, frames(ms), parse_easing(easing_));
 	}
 
 	void SetOpacityEffect(int new_opacity, int ms) {
-		finish_opacity = new_opacity;
-		opacity_time_left = frames(ms);
+		SetInterpolation(Channel_Opacity, new_opacity, frames(ms));
 	}
 
 	void SetToneEffect(Tone new_tone, int ms) {
-		finish_red = new_tone.red;
-		finish_green = new_tone.green;
-		finish_blue = new_tone.blue;
-		finish_sat = new_tone.gray;
-		tone_time_left = frames(ms);
+		int f = frames(ms);
+		SetInterpolation(Channel_Red, new_tone.red, f);
+		SetInterpolation(Channel_Green, new_tone.green, f);
+		SetInterpolation(Channel_Blue, new_tone.blue, f);
+		SetInterpolation(Channel_Sat, new_tone.gray, f);
 	}
 
 	void SetFixedTo(FixedTo to) {
@@ -416,106 +531,165 @@ public:
 			Output::Warning("Sprite: Fixed to mouse not supported");
 		} else {
 			fixed_to = to;
+			MarkDirty(Dirty_Position);
 		}
 	}
 
 	int GetX() const {
-		return movement_x.current;
+		return value[Channel_X];
 	}
 
 	void SetX(int x) {
-		movement_x = Effect((double)x);
+		SetValue(Channel_X, x);
 	}
 
 	int GetY() const {
-		return movement_y.current;
+		return value[Channel_Y];
 	}
 
 	void SetY(int y) {
-		movement_y = Effect((double)y);
+		SetValue(Channel_Y, y);
 	}
 
-	int GetZ() const{
+	Drawable::Z_t GetZ() const {
 		return z;
 	}
 
-	void SetZ(Drawable::Z_t) {
+	void SetZ(Drawable::Z_t z) {
 		this->z = z;
+		MarkDirty(Dirty_Z);
 	}
 
 	void SetTone(Tone new_tone) {
-		current_red = new_tone.red;
-		current_green = new_tone.green;
-		current_blue = new_tone.blue;
-		current_sat = new_tone.gray;
-		tone_time_left = 0;
+		SetValue(Channel_Red, new_tone.red);
+		SetValue(Channel_Green, new_tone.green);
+		SetValue(Channel_Blue, new_tone.blue);
+		SetValue(Channel_Sat, new_tone.gray);
 	}
 
 	void SetAngle(int degree) {
-		current_angle = degree;
-		rotation_time_left = 0;
-		rotate_forever_degree = 0.0;
+		SetValue(Channel_Angle, degree);
 	}
 
 	void SetZoomX(double zoom) {
-		zoom_x = Effect((double)zoom);
+		SetValue(Channel_ZoomX, zoom);
 	}
 
 	void SetZoomY(double zoom) {
-		zoom_y = Effect((double)zoom);
+		SetValue(Channel_ZoomY, zoom);
 	}
 
 	void SetVisible(bool v) {
 		visible = v;
+		MarkDirty(Dirty_Visible);
 	}
 
 	void SetOpacity(int opacity) {
-		current_opacity = opacity;
-		opacity_time_left = 0;
+		SetValue(Channel_Opacity, opacity);
 	}
 
 	void SetBlendMode(Bitmap::BlendMode mode) {
 		blendmode = mode;
+		MarkDirty(Dirty_Blend);
+	}
+
+	/** Value of a channel, written by the TweenEngine */
+	double& Value(Channel channel) {
+		return value[channel];
+	}
+
+	/** Tween of a channel, maintained by the TweenEngine */
+	int32_t& Tween(Channel channel) {
+		return tween[channel];
+	}
+
+	int32_t Tween(Channel channel) const {
+		return tween[channel];
 	}
 
-	picojson::object Save() {
-		picojson::object o;
-
-		o["version"] = picojson::value(1.0);
-
-		o["movement_x"] = picojson::value(movement_x.ToJson());
-		o["movement_y"] = picojson::value(movement_y.ToJson());
-		o["zoom_x"] = picojson::value(zoom_x.ToJson());
-		o["zoom_y"] = picojson::value(zoom_y.ToJson());
-
-		o["blendmode"] = picojson::value((double)blendmode);
-		o["fixed_to"] = picojson::value((double)fixed_to);
-		o["current_angle"] = picojson::value(current_angle);
-		o["finish_angle"] = picojson::value(finish_angle);
-		o["rotation_time_left"] = picojson::value((double)rotation_time_left);
-		o["z"] = picojson::value((double)z);
-		o["visible"] = picojson::value(visible);
-		o["rotate_cw"] = picojson::value(rotate_cw);
-		o["rotate_forever_degree"] = picojson::value(rotate_forever_degree);
-		o["time_left"] = picojson::value((double)time_left);
-		o["current_opacity"] = picojson::value(current_opacity);
-		o["finish_opacity"] = picojson::value(finish_opacity);
-		o["opacity_time_left"] = picojson::value((double)opacity_time_left);
-		o["filename"] = picojson::value(file);
-		o["current_red"] = picojson::value(current_red);
-		o["current_green"] = picojson::value(current_green);
-		o["current_blue"] = picojson::value(current_blue);
-		o["current_sat"] = picojson::value(current_sat);
-		o["finish_red"] = picojson::value(finish_red);
-		o["finish_green"] = picojson::value(finish_green);
-		o["finish_blue"] = picojson::value(finish_blue);
-		o["finish_sat"] = picojson::value(finish_sat);
-		o["tone_time_left"] = picojson::value((double)tone_time_left);
-
-		return o;
-	}
-
-	static std::unique_ptr<RpgssSprite> Load(picojson::object& o) {
+	void Save(DynRpg::ChunkWriter& w) const {
+		w.WriteString(file);
+
+		SaveEffect(w, Channel_X);
+		SaveEffect(w, Channel_Y);
+		SaveEffect(w, Channel_ZoomX);
+		SaveEffect(w, Channel_ZoomY);
+
+		TweenEngine::State angle;
+		bool rotating = tweens.GetState(this, Channel_Angle, angle);
+		double speed = rotating && angle.spin ? angle.to : 0.0;
+		if (!rotating || angle.spin) {
+			angle = TweenEngine::State();
+			angle.to = value[Channel_Angle];
+		}
+
+		w.WriteI32(static_cast<int32_t>(blendmode));
+		w.WriteI32(fixed_to);
+		w.WriteDouble(value[Channel_Angle]);
+		w.WriteDouble(angle.to);
+		w.WriteI32(TimeLeft(angle));
+		w.WriteU64(z);
+		w.WriteBool(visible);
+		w.WriteBool(speed >= 0.0);
+		w.WriteDouble(std::abs(speed));
+		// Unused time_left field of the JSON format
+		w.WriteI32(0);
+		w.WriteDouble(value[Channel_Opacity]);
+		w.WriteDouble(InterpolationTarget(Channel_Opacity));
+		w.WriteI32(InterpolationTimeLeft(Channel_Opacity));
+		w.WriteDouble(value[Channel_Red]);
+		w.WriteDouble(value[Channel_Green]);
+		w.WriteDouble(value[Channel_Blue]);
+		w.WriteDouble(value[Channel_Sat]);
+		w.WriteDouble(InterpolationTarget(Channel_Red));
+		w.WriteDouble(InterpolationTarget(Channel_Green));
+		w.WriteDouble(InterpolationTarget(Channel_Blue));
+		w.WriteDouble(InterpolationTarget(Channel_Sat));
+		w.WriteI32(InterpolationTimeLeft(Channel_Red));
+	}
+
+	static std::unique_ptr<RpgssSprite> Load(DynRpg::ChunkReader& r) {
+		auto sprite = std::make_unique<RpgssSprite>(r.ReadString());
+
+		sprite->LoadEffect(r, Channel_X);
+		sprite->LoadEffect(r, Channel_Y);
+		sprite->LoadEffect(r, Channel_ZoomX);
+		sprite->LoadEffect(r, Channel_ZoomY);
+
+		sprite->blendmode = static_cast<Bitmap::BlendMode>(r.ReadI32());
+		sprite->fixed_to = r.ReadI32();
+		double current_angle = r.ReadDouble();
+		double finish_angle = r.ReadDouble();
+		int rotation_time_left = r.ReadI32();
+		sprite->z = r.ReadU64();
+		sprite->visible = r.ReadBool();
+		bool rotate_cw = r.ReadBool();
+		double rotate_forever_degree = r.ReadDouble();
+		r.ReadI32();
+		double current_opacity = r.ReadDouble();
+		double finish_opacity = r.ReadDouble();
+		int opacity_time_left = r.ReadI32();
+		double current_tone[4], finish_tone[4];
+		for (auto& v : current_tone) {
+			v = r.ReadDouble();
+		}
+		for (auto& v : finish_tone) {
+			v = r.ReadDouble();
+		}
+		int tone_time_left = r.ReadI32();
+
+		sprite->RestoreRotation(current_angle, finish_angle, rotation_time_left, rotate_cw, rotate_forever_degree);
+		sprite->RestoreInterpolation(Channel_Opacity, current_opacity, finish_opacity, opacity_time_left);
+		for (int i = 0; i < 4; ++i) {
+			sprite->RestoreInterpolation(static_cast<Channel>(Channel_Red + i), current_tone[i], finish_tone[i], tone_time_left);
+		}
+		sprite->MarkDirty(Dirty_All);
+
+		return sprite;
+	}
+
+	/** Import of the JSON format used by older savegames */
+	static std::unique_ptr<RpgssSprite> FromJson(picojson::object& o) {
 		auto sprite = std::make_unique<RpgssSprite>(o["filename"].get<std::string>());
 
 		int version = 1;
@@ -524,49 +698,124 @@ public:
 		}
 
 		if (version > 1) {
-			sprite->movement_x = Effect::FromJson(o["movement_x"].get<picojson::object>());
-			sprite->movement_y = Effect::FromJson(o["movement_y"].get<picojson::object>());
-			sprite->zoom_x = Effect::FromJson(o["zoom_x"].get<picojson::object>());
-			sprite->zoom_y = Effect::FromJson(o["zoom_y"].get<picojson::object>());
+			sprite->EffectFromJson(o["movement_x"].get<picojson::object>(), Channel_X);
+			sprite->EffectFromJson(o["movement_y"].get<picojson::object>(), Channel_Y);
+			sprite->EffectFromJson(o["zoom_x"].get<picojson::object>(), Channel_ZoomX);
+			sprite->EffectFromJson(o["zoom_y"].get<picojson::object>(), Channel_ZoomY);
 		}
 
 		sprite->blendmode = static_cast<Bitmap::BlendMode>(o["blendmode"].get<double>());
 		sprite->fixed_to = (int)(o["fixed_to"].get<double>());
-		sprite->current_angle = o["current_angle"].get<double>();
-		sprite->finish_angle = o["finish_angle"].get<double>();
-		sprite->rotation_time_left = (int)o["rotation_time_left"].get<double>();
 		sprite->z = (int)o["z"].get<double>();
 		sprite->visible = o["visible"].get<bool>();
-		sprite->rotate_cw = o["rotate_cw"].get<bool>();
-		sprite->rotate_forever_degree = o["rotate_forever_degree"].get<double>();
-		sprite->time_left = (int)o["time_left"].get<double>();
-		sprite->current_opacity = o["current_opacity"].get<double>();
-		sprite->finish_opacity = o["finish_opacity"].get<double>();
-		sprite->opacity_time_left = (int)o["opacity_time_left"].get<double>();
-		sprite->current_red = o["current_red"].get<double>();
-		sprite->current_green = o["current_green"].get<double>();
-		sprite->current_blue = o["current_blue"].get<double>();
-		sprite->current_sat = o["current_sat"].get<double>();
-		sprite->finish_red = o["finish_red"].get<double>();
-		sprite->finish_green = o["finish_green"].get<double>();
-		sprite->finish_blue = o["finish_blue"].get<double>();
-		sprite->finish_sat = o["finish_sat"].get<double>();
-		sprite->tone_time_left = (int)o["tone_time_left"].get<double>();
+
+		sprite->RestoreRotation(o["current_angle"].get<double>(), o["finish_angle"].get<double>(),
+			(int)o["rotation_time_left"].get<double>(), o["rotate_cw"].get<bool>(), o["rotate_forever_degree"].get<double>());
+		sprite->RestoreInterpolation(Channel_Opacity, o["current_opacity"].get<double>(),
+			o["finish_opacity"].get<double>(), (int)o["opacity_time_left"].get<double>());
+
+		int tone_time_left = (int)o["tone_time_left"].get<double>();
+		sprite->RestoreInterpolation(Channel_Red, o["current_red"].get<double>(), o["finish_red"].get<double>(), tone_time_left);
+		sprite->RestoreInterpolation(Channel_Green, o["current_green"].get<double>(), o["finish_green"].get<double>(), tone_time_left);
+		sprite->RestoreInterpolation(Channel_Blue, o["current_blue"].get<double>(), o["finish_blue"].get<double>(), tone_time_left);
+		sprite->RestoreInterpolation(Channel_Sat, o["current_sat"].get<double>(), o["finish_sat"].get<double>(), tone_time_left);
+		sprite->MarkDirty(Dirty_All);
 
 		return sprite;
 	}
 
 private:
+	void SetValue(Channel channel, double v) {
+		tweens.Stop(this, channel);
+		value[channel] = v;
+		MarkDirty(1 << channel);
+	}
+
+	/** Eased tween, the first frame yields the current value */
+	void SetEffect(Channel channel, double to, int frames, Easing easing) {
+		tweens.Start(this, channel, value[channel], to, frames, 0, easing);
+	}
+
+	/** Linear tween, the first frame already moves towards the target */
+	void SetInterpolation(Channel channel, double to, int frames) {
+		tweens.Start(this, channel, value[channel], to, frames, 1, Easing::Linear);
+	}
+
+	static int TimeLeft(const TweenEngine::State& state) {
+		return state.frames > 0 ? state.frames - state.frame + 1 : 0;
+	}
+
+	double InterpolationTarget(Channel channel) const {
+		TweenEngine::State state;
+		return tweens.GetState(this, channel, state) ? state.to : value[channel];
+	}
+
+	int InterpolationTimeLeft(Channel channel) const {
+		TweenEngine::State state;
+		return tweens.GetState(this, channel, state) ? TimeLeft(state) : 0;
+	}
+
+	void SaveEffect(DynRpg::ChunkWriter& w, Channel channel) const {
+		TweenEngine::State state;
+		if (!tweens.GetState(this, channel, state)) {
+			state.from = value[channel];
+			state.to = value[channel];
+		}
+		w.WriteDouble(state.from);
+		w.WriteDouble(state.to);
+		w.WriteDouble(value[channel]);
+		w.WriteI32(state.frame);
+		w.WriteI32(state.frames);
+		w.WriteString(easing_name(state.easing));
+	}
+
+	void RestoreEffect(Channel channel, double start, double finish, double current, int current_frame, int finish_frame, std::string_view easing) {
+		value[channel] = current;
+		if (finish_frame > 0 && current_frame <= finish_frame) {
+			tweens.Start(this, channel, start, finish, finish_frame, current_frame, parse_easing(easing));
+		}
+	}
+
+	void LoadEffect(DynRpg::ChunkReader& r, Channel channel) {
+		double start = r.ReadDouble();
+		double finish = r.ReadDouble();
+		double current = r.ReadDouble();
+		int current_frame = r.ReadI32();
+		int finish_frame = r.ReadI32();
+		std::string easing = r.ReadString();
+		RestoreEffect(channel, start, finish, current, current_frame, finish_frame, easing);
+	}
+
+	void EffectFromJson(picojson::object& o, Channel channel) {
+		RestoreEffect(channel, o["start"].get<double>(), o["finish"].get<double>(), o["current"].get<double>(),
+			(int)o["current_frame"].get<double>(), (int)o["finish_frame"].get<double>(), o["easing"].get<std::string>());
+	}
+
+	void RestoreInterpolation(Channel channel, double current, double finish, int time_left) {
+		value[channel] = current;
+		SetInterpolation(channel, finish, time_left);
+	}
+
+	void RestoreRotation(double current, double finish, int time_left, bool cw, double forever_degree) {
+		value[Channel_Angle] = current;
+		if (forever_degree) {
+			tweens.StartSpin(this, Channel_Angle, (cw ? 1 : -1) * forever_degree);
+		} else {
+			SetInterpolation(Channel_Angle, finish, time_left);
+		}
+	}
+
 	void SetSpriteDefaults() {
 		if (!sprite) {
 			return;
 		}
 
-		movement_x.current = 160.0;
-		movement_y.current = 120.0;
+		value[Channel_X] = 160.0;
+		value[Channel_Y] = 120.0;
 		z = default_priority;
-		zoom_x.current = 100.0;
-		zoom_y.current = 100.0;
+		value[Channel_ZoomX] = 100.0;
+		value[Channel_ZoomY] = 100.0;
+		MarkDirty(Dirty_All);
 	}
 
 	bool SetSpriteImage(const std::string& filename) {
@@ -581,7 +830,11 @@ private:
 			return false;
 		}
 
-		return LoadSprite();
+		if (!LoadSprite()) {
+			return false;
+		}
+		MarkDirty(Dirty_All);
+		return true;
 	}
 
 	bool LoadSprite() {
@@ -608,41 +861,118 @@ private:
 	Bitmap::BlendMode blendmode = Bitmap::BlendMode::Default;
 	int fixed_to = FixedTo_Screen;
 
-	Effect movement_x;
-	Effect movement_y;
-	Effect zoom_x;
-	Effect zoom_y;
-
-	double current_angle = 0.0;
-	double finish_angle = 0.0;
-	int rotation_time_left = 0;
-	Drawable::Z_t z;
-//	int z = 0;
+	/** current value of every channel */
+	std::array<double, Channel_Count> value = {{
+		0.0, 0.0, // position
+		0.0, 0.0, // zoom
+		0.0, // angle
+		255.0, // opacity
+		128.0, 128.0, 128.0, 128.0 // tone
+	}};
+	/** running tween of every channel */
+	std::array<int32_t, Channel_Count> tween;
+	/** Dirty flags of the properties not yet pushed to the sprite */
+	uint32_t dirty = 0;
+	/** position in dirty_sprites while dirty */
+	size_t dirty_index = 0;
+
+	Drawable::Z_t z = default_priority;
 	bool visible = true;
 
-	bool rotate_cw = true;
-	double rotate_forever_degree = 0.0;
-	int time_left = 0;
+	std::string file;
 
-	double current_opacity = 255.0;
-	double finish_opacity = 0.0;
-	int opacity_time_left = 0;
+	bool image_loaded = false;
+};
 
-	double current_red = 128.0;
-	double current_green = 128.0;
-	double current_blue = 128.0;
-	double current_sat = 128.0;
+void TweenEngine::Start(RpgssSprite* sprite, Channel ch, double start, double finish, int num_frames, int first_frame, Easing ease_type) {
+	Stop(sprite, ch);
+	if (num_frames <= 0 || first_frame > num_frames) {
+		return;
+	}
 
-	double finish_red = 100;
-	double finish_green = 100;
-	double finish_blue = 100;
-	double finish_sat = 100;
-	int tone_time_left = 0;
+	sprite->Tween(ch) = static_cast<int32_t>(owner.size());
+	from.push_back(start);
+	delta.push_back(finish - start);
+	frame.push_back(first_frame);
+	frames.push_back(num_frames);
+	easing.push_back(ease_type);
+	owner.push_back(sprite);
+	channel.push_back(ch);
+}
 
-	std::string file;
+void TweenEngine::StartSpin(RpgssSprite* sprite, Channel ch, double speed) {
+	Start(sprite, ch, 0.0, speed, 1, 0, Easing::Linear);
+	frames.back() = spin_frames;
+}
 
-	bool image_loaded = false;
-};
+void TweenEngine::Stop(RpgssSprite* sprite, Channel ch) {
+	int32_t i = sprite->Tween(ch);
+	if (i != no_tween) {
+		Remove(i);
+	}
+}
+
+void TweenEngine::Remove(int32_t i) {
+	owner[i]->Tween(channel[i]) = no_tween;
+
+	// The last tween takes the place of the removed one
+	int32_t last = static_cast<int32_t>(owner.size()) - 1;
+	if (i != last) {
+		from[i] = from[last];
+		delta[i] = delta[last];
+		frame[i] = frame[last];
+		frames[i] = frames[last];
+		easing[i] = easing[last];
+		owner[i] = owner[last];
+		channel[i] = channel[last];
+		owner[i]->Tween(channel[i]) = i;
+	}
+
+	from.pop_back();
+	delta.pop_back();
+	frame.pop_back();
+	frames.pop_back();
+	easing.pop_back();
+	owner.pop_back();
+	channel.pop_back();
+}
+
+void TweenEngine::Advance() {
+	for (int32_t i = 0; i < static_cast<int32_t>(owner.size()); ++i) {
+		RpgssSprite* sprite = owner[i];
+		double& v = sprite->Value(channel[i]);
+		sprite->MarkDirty(1 << channel[i]);
+
+		if (frames[i] == spin_frames) {
+			v += delta[i];
+			continue;
+		}
+
+		int32_t f = frame[i]++;
+		if (f < frames[i]) {
+			v = from[i] + delta[i] * ease(easing[i], static_cast<double>(f) / frames[i]);
+		} else {
+			// Reached the target exactly
+			v = from[i] + delta[i];
+			Remove(i--);
+		}
+	}
+}
+
+bool TweenEngine::GetState(const RpgssSprite* sprite, Channel ch, State& state) const {
+	int32_t i = sprite->Tween(ch);
+	if (i == no_tween) {
+		return false;
+	}
+
+	state.spin = frames[i] == spin_frames;
+	state.from = from[i];
+	state.to = state.spin ? delta[i] : from[i] + delta[i];
+	state.frame = frame[i];
+	state.frames = state.spin ? 0 : frames[i];
+	state.easing = easing[i];
+	return true;
+}
 
 static bool AddSprite(dyn_arg_list args) {
 	auto func = "add_sprite";
@@ -1414,171 +1744,124 @@ static bool SetSpritePosition(dyn_arg_list args) {
 //      easing_funcs["circular in/out"] = circular_in_out_easing;
 //      }
 
-bool DynRpg::Rpgss::Invoke(std::string_view func, dyn_arg_list args, bool&, Game_Interpreter*)
-{
-    if (func == "add_sprite")         {
-                return AddSprite(args);
-                }
-    else
-    if (func == "set_sprite_blend_mode") {
-                return SetSpriteBlendMode(args);
-                }
-    else
-    if (func == "remove_sprite") {
-                return RemoveSprite(args);
-                }
-    else
-    if (func == "set_sprite_image") {
-                return SetSpriteImage(args);
-                }
-    else
-    if (func == "bind_sprite_to") {
-                return BindSpriteTo(args);
-                }
-    else
-    if (func == "move_x_sprite_by") {
-                return MoveXSpriteBy(args);
-                }
-    else
-    if (func == "move_y_sprite_by") {
-                return MoveYSpriteBy(args);
-                }
-    else
-    if (func == "move_sprite_by") {
-                return MoveSpriteBy(args);
-                }
-    else
-    if (func == "move_x_sprite_to") {
-                return MoveXSpriteTo(args);
-                }
-    else
-    if (func == "move_y_sprite_to") {
-                return MoveYSpriteTo(args);
-                }
-    else
-    if (func == "move_sprite_to") {
-                return MoveSpriteTo(args);
-                }
-    else
-    if (func == "scale_sprite_to") {
-                return ScaleSpriteTo(args);
-                }
-    else
-    if (func == "scale_x_sprite_to") {
-                return ScaleXSpriteTo(args);
-                }
-    else
-    if (func == "scale_y_sprite_to") {
-                return ScaleYSpriteTo(args);
-                }
-    else
-    if (func == "rotate_sprite_by") {
-                return RotateSpriteBy(args);
-                }
-    else
-    if (func == "rotate_sprite_to") {
-                return RotateSpriteTo(args);
-                }
-    else
-    if (func == "rotate_sprite_forever") {
-                return RotateSpriteForever(args);
-                }
-    else
-    if (func == "stop_sprite_rotation") {
-                return StopSpriteRotation(args);
-                }
-    else
-    if (func == "set_sprite_opacity") {
-                return SetSpriteOpacity(args);
-                }
-    else
-    if (func == "shift_sprite_opacity_to") {
-                return ShiftSpriteOpacityTo(args);
-                }
-    else
-    if (func == "set_sprite_z") {
-                return SetZ(args);
-                }
-    else
-    if (func == "set_sprite_layer") {
-                return SetLayer(args);
-                }
-    else
-    if (func == "set_sprite_color") {
-                return SetSpriteColor(args);
-                }
-    else
-    if (func == "shift_sprite_color_to") {
-                return ShiftSpriteColorTo(args);
-                }
-    else
-    if (func == "get_sprite_position") {
-                return GetSpritePosition(args);
-                }
-    else
-    if (func == "set_sprite_position") {
-                return SetSpritePosition(args);
-                }
-
-    easing_funcs["linear"] = linear_easing;
-	easing_funcs["quadratic in"] = quadratic_in_easing;
-	easing_funcs["quadratic out"] = quadratic_out_easing;
-	easing_funcs["quadratic in/out"] = quadratic_in_out_easing;
-	easing_funcs["cubic in"] = cubic_in_easing;
-	easing_funcs["cubic out"] = cubic_out_easing;
-	easing_funcs["cubic in/out"] = cubic_in_out_easing;
-	easing_funcs["sinusoidal in"] = sinusoidal_in_easing;
-	easing_funcs["sinusoidal out"] = sinusoidal_out_easing;
-	easing_funcs["sinusoidal in/out"] = sinusoidal_in_out_easing;
-	easing_funcs["exponential in"] = exponential_in_easing;
-	easing_funcs["exponential out"] = exponential_out_easing;
-	easing_funcs["exponential in/out"] = exponential_in_out_easing;
-	easing_funcs["circular in"] = circular_in_easing;
-	easing_funcs["circular out"] = circular_out_easing;
-	easing_funcs["circular in/out"] = circular_in_out_easing;
+DynRpg::Rpgss::Rpgss(Game_DynRpg& instance) : DynRpgPlugin("RpgssDeep8", instance) {
+	build_easing_lut();
+}
 
+void DynRpg::Rpgss::RegisterFunctions() {
+	instance.RegisterFunction("add_sprite", AddSprite);
+	instance.RegisterFunction("set_sprite_blend_mode", SetSpriteBlendMode);
+	instance.RegisterFunction("remove_sprite", RemoveSprite);
+	instance.RegisterFunction("set_sprite_image", SetSpriteImage);
+	instance.RegisterFunction("bind_sprite_to", BindSpriteTo);
+	instance.RegisterFunction("move_x_sprite_by", MoveXSpriteBy);
+	instance.RegisterFunction("move_y_sprite_by", MoveYSpriteBy);
+	instance.RegisterFunction("move_sprite_by", MoveSpriteBy);
+	instance.RegisterFunction("move_x_sprite_to", MoveXSpriteTo);
+	instance.RegisterFunction("move_y_sprite_to", MoveYSpriteTo);
+	instance.RegisterFunction("move_sprite_to", MoveSpriteTo);
+	instance.RegisterFunction("scale_sprite_to", ScaleSpriteTo);
+	instance.RegisterFunction("scale_x_sprite_to", ScaleXSpriteTo);
+	instance.RegisterFunction("scale_y_sprite_to", ScaleYSpriteTo);
+	instance.RegisterFunction("rotate_sprite_by", RotateSpriteBy);
+	instance.RegisterFunction("rotate_sprite_to", RotateSpriteTo);
+	instance.RegisterFunction("rotate_sprite_forever", RotateSpriteForever);
+	instance.RegisterFunction("stop_sprite_rotation", StopSpriteRotation);
+	instance.RegisterFunction("set_sprite_opacity", SetSpriteOpacity);
+	instance.RegisterFunction("shift_sprite_opacity_to", ShiftSpriteOpacityTo);
+	instance.RegisterFunction("set_sprite_z", SetZ);
+	instance.RegisterFunction("set_sprite_layer", SetLayer);
+	instance.RegisterFunction("set_sprite_color", SetSpriteColor);
+	instance.RegisterFunction("shift_sprite_color_to", ShiftSpriteColorTo);
+	instance.RegisterFunction("get_sprite_position", GetSpritePosition);
+	instance.RegisterFunction("set_sprite_position", SetSpritePosition);
 }
 
 void DynRpg::Rpgss::Update() {
-	for (auto& g : graphics) {
-		g.second->Update();
+	tweens.Advance();
+
+	// Sprites fixed to the map follow the camera
+	int display_x = Game_Map::GetDisplayX();
+	int display_y = Game_Map::GetDisplayY();
+	if (display_x != last_display_x || display_y != last_display_y) {
+		last_display_x = display_x;
+		last_display_y = display_y;
+		for (auto& g : graphics) {
+			if (g.second->IsFixedToMap()) {
+				g.second->MarkDirty(RpgssSprite::Dirty_Position);
+			}
+		}
 	}
+
+	// Only sprites that changed are pushed to their Sprite
+	for (RpgssSprite* sprite : dirty_sprites) {
+		sprite->Apply();
+	}
+	dirty_sprites.clear();
 }
 
 DynRpg::Rpgss::~Rpgss() {
 	graphics.clear();
-
-	easing_funcs.clear();
 }
 
 void DynRpg::Rpgss::Load(const std::vector<uint8_t> &in) {
+	graphics.clear();
+
+	if (!DynRpg::ChunkReader::IsBinaryChunk(in)) {
+		LoadJson(in);
+		return;
+	}
+
+	DynRpg::ChunkReader r(in);
+	if (r.GetVersion() > save_version) {
+		Output::Warning("RPGSS: Unsupported save version {}", r.GetVersion());
+		return;
+	}
+
+	uint32_t count = r.ReadU32();
+	if (!r.CanHold(count, min_sprite_size)) {
+		Output::Warning("RPGSS: Corrupted save data");
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		std::string id = r.ReadString();
+		auto sprite = RpgssSprite::Load(r);
+		if (!r.IsOk()) {
+			Output::Warning("RPGSS: Corrupted save data");
+			break;
+		}
+		graphics[std::move(id)] = std::move(sprite);
+	}
+}
+
+void DynRpg::Rpgss::LoadJson(const std::vector<uint8_t> &in) {
 	picojson::value v;
-	std::string s;
-	s.resize(in.size());
-	std::copy(in.begin(), in.end(), s.begin());
+	std::string s(in.begin(), in.end());
 
 	picojson::parse(v, s);
 
+	if (!v.is<picojson::object>()) {
+		Output::Warning("RPGSS: Invalid save data");
+		return;
+	}
+
 	for (auto& k : v.get<picojson::object>()) {
-		graphics[k.first] = RpgssSprite::Load(k.second.get<picojson::object>());
+		graphics[k.first] = RpgssSprite::FromJson(k.second.get<picojson::object>());
 	}
 }
 
 std::vector<uint8_t> DynRpg::Rpgss::Save() {
-	picojson::object o;
+	DynRpg::ChunkWriter w(save_version);
+	w.Reserve(graphics.size() * approx_sprite_size);
 
+	w.WriteU32(static_cast<uint32_t>(graphics.size()));
 	for (auto& g : graphics) {
-		o[g.first] = picojson::value(g.second->Save());
+		w.WriteString(g.first);
+		g.second->Save(w);
 	}
 
-	std::string s = picojson::value(o).serialize();
-
-	std::vector<uint8_t> v;
-	v.resize(s.size());
-
-	std::copy(s.begin(), s.end(), v.begin());
-
-	return v;
+	return w.Finish();
 }
 
 void DynRpg::Rpgss::OnMapChange() {
@@ -29,13 +29,12 @@ namespace DynRpg {
 //		Rpgss() : DynRpgPlugin("RpgssDeep8") {}
 //		~Rpgss();
 
-		Rpgss(Game_DynRpg& instance) : DynRpgPlugin("RpgssDeep8", instance) {}
+		Rpgss(Game_DynRpg& instance);
 		~Rpgss() override;
 
 
 //		void RegisterFunctions();
-//      bool Invoke(std::string_view func, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter) override;
-        bool Invoke(std::string_view func, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter);
+		void RegisterFunctions() override;
 
 		void Update();
 //		void Load(const std::vector<uint8_t>&) override;
@@ -44,6 +43,9 @@ namespace DynRpg {
 
 		void OnMapChange();
 
+	private:
+		void LoadJson(const std::vector<uint8_t>& in);
+
 //        private:
 //  		bool EasyCall(dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter);
 
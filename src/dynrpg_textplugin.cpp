@@ -21,6 +21,7 @@
 #include <lcf/reader_util.h>
 
 #include "dynrpg_textplugin.h"
+#include "dynrpg_chunk.h"
 #include "baseui.h"
 #include "bitmap.h"
 #include "drawable.h"
@@ -36,6 +37,11 @@
 class DynRpgText;
 
 namespace {
+	// Version of the binary save chunk
+	constexpr uint16_t save_version = 1;
+	// Empty id, position, no lines, color, fixed and picture
+	constexpr size_t min_text_size = 4 + 8 + 4 + 4 + 1 + 4;
+
 	std::map<std::string, std::unique_ptr<DynRpgText>> graphics;
 }
 
@@ -135,32 +141,16 @@ public:
 		}
 	}
 
-	std::vector<uint8_t> Save(const std::string& id) {
-		std::stringstream ss;
-		ss << x << "," << y << ",";
-		for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
-			std::string t = texts[i];
-			// Replace , with a sentinel 0x01 to not mess up the tokenizer
-			std::replace(t.begin(), t.end(), ',', '\1');
-			ss << t;
-			if (i < static_cast<int>(texts.size()) - 1) {
-				ss << "\n";
-			}
-
+	void Save(DynRpg::ChunkWriter& w) const {
+		w.WriteI32(x);
+		w.WriteI32(y);
+		w.WriteU32(static_cast<uint32_t>(texts.size()));
+		for (auto& t : texts) {
+			w.WriteString(t);
 		}
-		ss << "," << color << "," << id;
-
-		ss << "," << 255 << "," << (fixed ? "1" : "0") << "," << pic_id;
-
-		std::vector<uint8_t> data;
-
-		std::string s = ss.str();
-		size_t slen = s.size();
-
-		data.resize(slen);
-		data.insert(data.end(), s.begin(), s.end());
-
-		return data;
+		w.WriteI32(color);
+		w.WriteBool(fixed);
+		w.WriteI32(pic_id);
 	}
 
 	static DynRpgText* GetTextHandle(const std::string& id, bool silent = false) {
@@ -399,23 +389,14 @@ static bool RemoveAll(dyn_arg_list) {
 	return true;
 }
 
-bool DynRpg::TextPlugin::Invoke(std::string_view func, dyn_arg_list args, bool&, Game_Interpreter*) {
-	if (func == "write_text") {
-		return WriteText(args);
-	} else if (func == "append_line") {
-		return AppendLine(args);
-	} else if (func == "append_text") {
-		return AppendText(args);
-	} else if (func == "change_text") {
-		return ChangeText(args);
-	} else if (func == "change_position") {
-		return ChangePosition(args);
-	} else if (func == "remove_text") {
-		return RemoveText(args);
-	} else if (func == "remove_all") {
-		return RemoveAll(args);
-	}
-	return false;
+void DynRpg::TextPlugin::RegisterFunctions() {
+	instance.RegisterFunction("write_text", WriteText);
+	instance.RegisterFunction("append_line", AppendLine);
+	instance.RegisterFunction("append_text", AppendText);
+	instance.RegisterFunction("change_text", ChangeText);
+	instance.RegisterFunction("change_position", ChangePosition);
+	instance.RegisterFunction("remove_text", RemoveText);
+	instance.RegisterFunction("remove_all", RemoveAll);
 }
 
 void DynRpg::TextPlugin::Update() {
@@ -428,7 +409,8 @@ DynRpg::TextPlugin::~TextPlugin() {
 	graphics.clear();
 }
 
-void DynRpg::TextPlugin::Load(const std::vector<uint8_t>& in_buffer) {
+// Import of the text format used by older savegames
+static void LoadLegacy(const std::vector<uint8_t>& in_buffer) {
 	size_t counter = 0;
 
 	std::string str((char*)in_buffer.data(), in_buffer.size());
@@ -491,18 +473,67 @@ void DynRpg::TextPlugin::Load(const std::vector<uint8_t>& in_buffer) {
 	}
 }
 
+void DynRpg::TextPlugin::Load(const std::vector<uint8_t>& in_buffer) {
+	graphics.clear();
+
+	if (!DynRpg::ChunkReader::IsBinaryChunk(in_buffer)) {
+		LoadLegacy(in_buffer);
+		return;
+	}
+
+	DynRpg::ChunkReader r(in_buffer);
+	if (r.GetVersion() > save_version) {
+		Output::Warning("DynTextPlugin: Unsupported save version {}", r.GetVersion());
+		return;
+	}
+
+	uint32_t count = r.ReadU32();
+	if (!r.CanHold(count, min_text_size)) {
+		Output::Warning("DynTextPlugin: Corrupted save data");
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		std::string id = r.ReadString();
+		int x = r.ReadI32();
+		int y = r.ReadI32();
+
+		uint32_t num_lines = r.ReadU32();
+		if (!r.CanHold(num_lines, 4)) {
+			break;
+		}
+		std::vector<std::string> texts;
+		texts.reserve(num_lines);
+		for (uint32_t j = 0; j < num_lines; ++j) {
+			texts.push_back(r.ReadString());
+		}
+
+		int color = r.ReadI32();
+		bool fixed = r.ReadBool();
+		int pic_id = r.ReadI32();
+		if (!r.IsOk()) {
+			break;
+		}
+
+		auto text = std::make_unique<DynRpgText>(pic_id, x, y, texts);
+		text->SetColor(color);
+		text->SetFixed(fixed);
+		graphics[std::move(id)] = std::move(text);
+	}
+
+	if (!r.IsOk()) {
+		Output::Warning("DynTextPlugin: Corrupted save data");
+	}
+}
+
 std::vector<uint8_t> DynRpg::TextPlugin::Save() {
-	std::vector<uint8_t> save_data;
-	std::stringstream ss;
+	DynRpg::ChunkWriter w(save_version);
 
+	w.WriteU32(static_cast<uint32_t>(graphics.size()));
 	for (auto& g : graphics) {
-		std::vector<uint8_t> res = g.second->Save(g.first);
-		save_data.reserve(save_data.size() + res.size() + 1);
-		save_data.insert(save_data.end(), res.begin(), res.end());
-
-		save_data.push_back(',');
+		w.WriteString(g.first);
+		g.second->Save(w);
 	}
-	save_data.pop_back();
 
-	return DynRpgPlugin::Save();
+	return w.Finish();
 }
@@ -74,6 +74,69 @@ static LHAInputStreamType vio = {
 	nullptr // close not supported by istream interface
 };
 
+namespace {
+	/**
+	 * Decompresses an entry chunk by chunk.
+	 * The decoder state cannot be restored, seeking backwards decompresses from the beginning.
+	 */
+	class LzhStreamBuf : public Filesystem_Stream::InputDecoderStreamBuf {
+	public:
+		LzhStreamBuf(Filesystem_Stream::InputStream is, std::string name, LHADecoderType* decoder_type, std::streamoff offset, size_t uncompressed_size) :
+			InputDecoderStreamBuf(uncompressed_size), is(std::move(is)), name(std::move(name)), decoder_type(decoder_type), offset(offset), uncompressed_size(uncompressed_size) {
+			Restart();
+		}
+
+		bool IsOk() const {
+			return decoder != nullptr;
+		}
+
+	protected:
+		size_t Decode(char* buf, size_t len) override {
+			if (!decoder) {
+				return 0;
+			}
+			size_t res = lha_decoder_read(decoder.get(), reinterpret_cast<uint8_t*>(buf), len);
+
+			// Never asked for more than the entry size, a short read ends the data early
+			if (res < len && !warned) {
+				Output::Warning("LzhFS: Less data compressed than expected ({})", name);
+				warned = true;
+			}
+			return res;
+		}
+
+		std::streamoff Seek(std::streamoff pos, std::streamoff current) override {
+			if (pos >= current) {
+				return current;
+			}
+			return Restart() ? 0 : -1;
+		}
+
+	private:
+		bool Restart() {
+			is.clear();
+			is.seekg(offset, std::ios_base::beg);
+			decoder.reset(lha_decoder_new(decoder_type, vio_read_dec_func, &is, uncompressed_size));
+			return decoder != nullptr;
+		}
+
+		struct DecoderDeleter {
+			void operator()(LHADecoder* o) const {
+				lha_decoder_free(o);
+			}
+		};
+
+		Filesystem_Stream::InputStream is;
+		std::string name;
+		LHADecoderType* decoder_type;
+		std::streamoff offset;
+		size_t uncompressed_size;
+		std::unique_ptr<LHADecoder, DecoderDeleter> decoder;
+		/** Corrupted entries are only reported once, also when decoded again after seeking */
+		bool warned = false;
+	};
+}
+
 LzhFilesystem::LzhFilesystem(std::string base_path, FilesystemView parent_fs, std::string_view enc) :
 	Filesystem(base_path, parent_fs) {
 	is = parent_fs.OpenInputStream(GetPath());
@@ -282,24 +345,19 @@ std::streambuf* LzhFilesystem::CreateInputStreambuffer(std::string_view path, st
 			return nullptr;
 		}
 
-		// Seek to the compressed data
-		is.clear();
-		is.seekg(entry->fileoffset, std::ios_base::beg);
-
-		// Create a suitable decoder for the compression method
-		std::unique_ptr<LHADecoder, LhasaDeleter> decoder;
-		decoder.reset(lha_decoder_new(decoder_type, vio_read_dec_func, &is, entry->uncompressed_size));
-
-		// Decompress
-		auto dec_buf = std::vector<uint8_t>(entry->uncompressed_size);
-		size_t res = lha_decoder_read(decoder.get(), dec_buf.data(), dec_buf.size());
-
-		if (res != entry->uncompressed_size) {
-			Output::Warning("LzhFS: Less data compressed than expected ({})", path_normalized);
+		// Every stream has an own handle on the archive: Files are read independently from each other
+		auto lzh_is = GetParent().OpenInputStream(GetPath());
+		if (!lzh_is) {
 			return nullptr;
 		}
 
-		return new Filesystem_Stream::InputMemoryStreamBuf(std::move(dec_buf));
+		auto* buf = new LzhStreamBuf(std::move(lzh_is), path_normalized, decoder_type, entry->fileoffset, entry->uncompressed_size);
+		if (!buf->IsOk()) {
+			Output::Warning("LzhFS: Decoder creation failed for {}", path_normalized);
+			delete buf;
+			return nullptr;
+		}
+		return buf;
 	}
 
 	return nullptr;
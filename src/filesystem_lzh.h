@@ -80,10 +80,6 @@ private:
 		void operator()(LHAReader* o) const {
 			lha_reader_free(o);
 		}
-
-		void operator()(LHADecoder* o) const {
-			lha_decoder_free(o);
-		}
 	};
 
 	void Rewind();
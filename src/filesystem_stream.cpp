@@ -17,6 +17,8 @@
 
 #include "filesystem_stream.h"
 
+#include <algorithm>
+#include <cstring>
 #include <utility>
 
 #ifdef USE_CUSTOM_FILEBUF
@@ -131,6 +133,123 @@ Filesystem_Stream::InputMemoryStreamBuf::InputMemoryStreamBuf(std::vector<uint8_
 
 }
 
+Filesystem_Stream::InputDecoderStreamBuf::InputDecoderStreamBuf(std::streamoff size)
+		: std::streambuf(), size(size) {
+	setg(buffer.data(), buffer.data(), buffer.data());
+}
+
+std::streamoff Filesystem_Stream::InputDecoderStreamBuf::Position() const {
+	return buffer_pos + (gptr() - eback());
+}
+
+bool Filesystem_Stream::InputDecoderStreamBuf::MoveDecoder(std::streamoff pos) {
+	if (decoder_pos != pos) {
+		decoder_pos = Seek(pos, decoder_pos);
+		if (decoder_pos < 0) {
+			return false;
+		}
+	}
+
+	// Decode and discard until the target is reached
+	while (decoder_pos < pos) {
+		auto len = static_cast<size_t>(std::min<std::streamoff>(buffer.size(), pos - decoder_pos));
+		size_t res = Decode(buffer.data(), len);
+		if (res == 0) {
+			return false;
+		}
+		decoder_pos += res;
+	}
+	return true;
+}
+
+Filesystem_Stream::InputDecoderStreamBuf::int_type Filesystem_Stream::InputDecoderStreamBuf::underflow() {
+	assert(gptr() == egptr());
+
+	auto pos = Position();
+	buffer_pos = pos;
+	setg(buffer.data(), buffer.data(), buffer.data());
+
+	if (pos >= size || !MoveDecoder(pos)) {
+		return traits_type::eof();
+	}
+
+	auto len = static_cast<size_t>(std::min<std::streamoff>(buffer.size(), size - pos));
+	size_t res = Decode(buffer.data(), len);
+	if (res == 0) {
+		return traits_type::eof();
+	}
+	decoder_pos += res;
+
+	setg(buffer.data(), buffer.data(), buffer.data() + res);
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize Filesystem_Stream::InputDecoderStreamBuf::xsgetn(char* s, std::streamsize n) {
+	std::streamsize done = 0;
+
+	while (done < n) {
+		auto avail = std::min<std::streamsize>(egptr() - gptr(), n - done);
+		if (avail > 0) {
+			memcpy(s + done, gptr(), avail);
+			gbump(static_cast<int>(avail));
+			done += avail;
+			continue;
+		}
+
+		auto pos = Position();
+		if (n - done < static_cast<std::streamsize>(buffer.size())) {
+			if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+				break;
+			}
+			continue;
+		}
+
+		// Large read: Decode directly into the destination
+		buffer_pos = pos;
+		setg(buffer.data(), buffer.data(), buffer.data());
+		if (pos >= size || !MoveDecoder(pos)) {
+			break;
+		}
+
+		auto len = static_cast<size_t>(std::min<std::streamoff>(n - done, size - pos));
+		size_t res = Decode(s + done, len);
+		if (res == 0) {
+			break;
+		}
+		decoder_pos += res;
+		buffer_pos += res;
+		done += res;
+	}
+
+	return done;
+}
+
+std::streambuf::pos_type Filesystem_Stream::InputDecoderStreamBuf::seekoff(std::streambuf::off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode mode) {
+	std::streambuf::pos_type off;
+	if (dir == std::ios_base::beg) {
+		off = offset;
+	} else if (dir == std::ios_base::cur) {
+		off = Position() + offset;
+	} else {
+		off = size + offset;
+	}
+	return seekpos(off, mode);
+}
+
+std::streambuf::pos_type Filesystem_Stream::InputDecoderStreamBuf::seekpos(std::streambuf::pos_type pos, std::ios_base::openmode) {
+	std::streamoff off = Utils::Clamp<std::streamoff>(pos, 0, size);
+
+	if (off >= buffer_pos && off <= buffer_pos + (egptr() - eback())) {
+		// Inside of the buffer
+		setg(eback(), eback() + (off - buffer_pos), egptr());
+	} else {
+		// Repositioned by the next read
+		buffer_pos = off;
+		setg(buffer.data(), buffer.data(), buffer.data());
+	}
+	return off;
+}
+
 #ifdef USE_CUSTOM_FILEBUF
 
 Filesystem_Stream::FdStreamBuf::FdStreamBuf(int fd, bool is_read) : fd(fd), is_read(is_read) {
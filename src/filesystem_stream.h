@@ -19,6 +19,7 @@
 #define EP_FILESYSTEM_STREAM_H
 
 // Headers
+#include <array>
 #include <cassert>
 #include <istream>
 #include <ostream>
@@ -98,6 +99,58 @@ namespace Filesystem_Stream {
 		std::vector<uint8_t> buffer;
 	};
 
+	/**
+	 * Streambuf interface for data of a known size that is decoded sequentially,
+	 * e.g. compressed archive entries. The data is decoded in chunks on demand.
+	 *
+	 * Seeking is deferred until the next read, so querying the size does not
+	 * decode anything. When the target is not reachable by decoding forward the
+	 * implementation repositions the decoder through Seek.
+	 */
+	class InputDecoderStreamBuf : public std::streambuf {
+	public:
+		/** @param size size of the decoded data */
+		explicit InputDecoderStreamBuf(std::streamoff size);
+		InputDecoderStreamBuf(InputDecoderStreamBuf const& other) = delete;
+		InputDecoderStreamBuf const& operator=(InputDecoderStreamBuf const& other) = delete;
+
+	protected:
+		int_type underflow() override;
+		std::streamsize xsgetn(char* s, std::streamsize n) override;
+		std::streambuf::pos_type seekoff(std::streambuf::off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode mode) override;
+		std::streambuf::pos_type seekpos(std::streambuf::pos_type pos, std::ios_base::openmode mode) override;
+
+		/**
+		 * Decodes the data following the current decoder position.
+		 *
+		 * @param buf receives the decoded data
+		 * @param len maximum amount of bytes to decode
+		 * @return bytes decoded, 0 on error or at the end of the data
+		 */
+		virtual size_t Decode(char* buf, size_t len) = 0;
+
+		/**
+		 * Repositions the decoder as close as possible to pos without passing it.
+		 * The remaining bytes up to pos are decoded and discarded.
+		 *
+		 * @param pos target position
+		 * @param current current decoder position
+		 * @return new decoder position, -1 on error
+		 */
+		virtual std::streamoff Seek(std::streamoff pos, std::streamoff current) = 0;
+
+	private:
+		std::streamoff Position() const;
+		bool MoveDecoder(std::streamoff pos);
+
+		std::streamoff size;
+		/** Data position of eback() */
+		std::streamoff buffer_pos = 0;
+		/** Data position of the next byte returned by Decode */
+		std::streamoff decoder_pos = 0;
+		std::array<char, 32 * 1024> buffer;
+	};
+
 #ifdef USE_CUSTOM_FILEBUF
 	class FdStreamBuf : public std::streambuf {
 	public:
@@ -23,11 +23,12 @@
 #include <zlib.h>
 #include <lcf/encoder.h>
 #include <lcf/reader_util.h>
-#include <lcf/scope_guard.h>
 #include <iostream>
 #include <sstream>
 #include <cassert>
 #include <algorithm>
+#include <array>
+#include <iterator>
 #include <fmt/format.h>
 
 constexpr char end_of_central_directory[] = "\x50\x4b\x05\x06";
@@ -37,6 +38,262 @@ constexpr uint32_t central_directory_entry = 0x02014b50;
 constexpr uint32_t local_header = 0x04034b50;
 constexpr uint32_t local_header_size = 30;
 
+namespace {
+	/** Bounded view on the stored (uncompressed) data of an entry, read directly from the archive */
+	class StoredStreamBuf : public Filesystem_Stream::InputDecoderStreamBuf {
+	public:
+		StoredStreamBuf(Filesystem_Stream::InputStream is, std::streamoff offset, std::streamoff size) :
+			InputDecoderStreamBuf(size), is(std::move(is)), offset(offset) {}
+
+	protected:
+		size_t Decode(char* buf, size_t len) override {
+			is.read(buf, len);
+			return static_cast<size_t>(is.gcount());
+		}
+
+		std::streamoff Seek(std::streamoff pos, std::streamoff) override {
+			is.clear();
+			is.seekg(offset + pos);
+			return is ? pos : -1;
+		}
+
+	private:
+		Filesystem_Stream::InputStream is;
+		std::streamoff offset;
+	};
+
+	/**
+	 * Inflates a deflate compressed entry chunk by chunk.
+	 *
+	 * For large entries the inflate state is recorded at block boundaries
+	 * (access points) every access_point_span bytes, seeking backwards resumes
+	 * from the closest access point instead of inflating from the beginning.
+	 */
+	class InflateStreamBuf : public Filesystem_Stream::InputDecoderStreamBuf {
+	public:
+		InflateStreamBuf(Filesystem_Stream::InputStream is, std::string name, std::streamoff offset, uint32_t compressed_size, uint32_t uncompressed_size) :
+			InputDecoderStreamBuf(uncompressed_size), is(std::move(is)), name(std::move(name)), offset(offset), compressed_size(compressed_size),
+			uncompressed_size(uncompressed_size), track_window(uncompressed_size > access_point_span) {
+			ok = inflateInit2(&zlib_stream, -MAX_WBITS) == Z_OK;
+		}
+
+		~InflateStreamBuf() override {
+			if (ok) {
+				inflateEnd(&zlib_stream);
+			}
+		}
+
+		bool IsOk() const {
+			return ok;
+		}
+
+	protected:
+		size_t Decode(char* buf, size_t len) override {
+			if (!ok) {
+				return 0;
+			}
+
+			zlib_stream.next_out = reinterpret_cast<Bytef*>(buf);
+			zlib_stream.avail_out = static_cast<uInt>(len);
+
+			while (zlib_stream.avail_out > 0 && !stream_end) {
+				if (zlib_stream.avail_in == 0 && !FillInput()) {
+					Warn("Less data compressed than expected (Archive corrupted?)");
+					break;
+				}
+
+				Bytef* out = zlib_stream.next_out;
+				int zlib_error = inflate(&zlib_stream, track_window ? Z_BLOCK : Z_NO_FLUSH);
+				auto produced = static_cast<size_t>(zlib_stream.next_out - out);
+				out_pos += produced;
+
+				if (track_window) {
+					AppendWindow(out, produced);
+
+					// Bit 7: End of a block, Bit 6: Last block of the stream
+					if ((zlib_stream.data_type & 128) && !(zlib_stream.data_type & 64) &&
+							out_pos >= (points.empty() ? 0 : points.back().out_pos) + access_point_span) {
+						AddAccessPoint();
+					}
+				}
+
+				if (zlib_error == Z_STREAM_END) {
+					stream_end = true;
+					if (out_pos != uncompressed_size) {
+						Warn("Less data compressed than expected (Archive corrupted?)");
+					}
+				} else if (zlib_error != Z_OK) {
+					Output::Warning("ZipFS: zlib failed for {}: {} ({})", name, zlib_error, zlib_stream.msg ? zlib_stream.msg : "No error message");
+					ok = false;
+					break;
+				}
+			}
+
+			size_t res = len - zlib_stream.avail_out;
+			if (ok && !stream_end && out_pos == uncompressed_size) {
+				CheckStreamEnd();
+			}
+			return res;
+		}
+
+		std::streamoff Seek(std::streamoff pos, std::streamoff current) override {
+			if (!ok) {
+				return -1;
+			}
+
+			auto it = std::upper_bound(points.begin(), points.end(), pos, [](std::streamoff p, const AccessPoint& point) {
+				return p < point.out_pos;
+			});
+			std::streamoff point_pos = (it == points.begin()) ? 0 : std::prev(it)->out_pos;
+
+			if (pos >= current && point_pos <= current) {
+				// Inflating forward is faster than resuming
+				return current;
+			}
+
+			inflateReset(&zlib_stream);
+			zlib_stream.avail_in = 0;
+			stream_end = false;
+			is.clear();
+
+			if (it == points.begin()) {
+				in_pos = 0;
+				out_pos = 0;
+				window.fill(0);
+				window_pos = 0;
+				is.seekg(offset);
+			} else {
+				const auto& point = *std::prev(it);
+				in_pos = point.in_pos - (point.bits ? 1 : 0);
+				out_pos = point.out_pos;
+				is.seekg(offset + in_pos);
+				if (point.bits) {
+					int c = is.get();
+					if (c == EOF) {
+						ok = false;
+						return -1;
+					}
+					++in_pos;
+					inflatePrime(&zlib_stream, point.bits, c >> (8 - point.bits));
+				}
+				inflateSetDictionary(&zlib_stream, point.window.data(), static_cast<uInt>(point.window.size()));
+				std::copy(point.window.begin(), point.window.end(), window.begin());
+				window_pos = 0;
+			}
+
+			return is ? out_pos : -1;
+		}
+
+	private:
+		static constexpr std::streamoff access_point_span = 1024 * 1024;
+
+		/** @return Whether compressed data was read */
+		bool FillInput() {
+			auto remaining = std::min<std::streamoff>(in_buf.size(), compressed_size - in_pos);
+			if (remaining <= 0) {
+				return false;
+			}
+			is.read(reinterpret_cast<char*>(in_buf.data()), remaining);
+			auto read = is.gcount();
+			if (read <= 0) {
+				return false;
+			}
+			in_pos += read;
+			zlib_stream.next_in = in_buf.data();
+			zlib_stream.avail_in = static_cast<uInt>(read);
+			return true;
+		}
+
+		/** All data was decoded, the stream must end without producing more */
+		void CheckStreamEnd() {
+			Bytef extra;
+			for (;;) {
+				if (zlib_stream.avail_in == 0 && !FillInput()) {
+					// Only the end marker is missing, the data is complete
+					return;
+				}
+
+				zlib_stream.next_out = &extra;
+				zlib_stream.avail_out = 1;
+				int zlib_error = inflate(&zlib_stream, Z_NO_FLUSH);
+				if (zlib_stream.avail_out == 0) {
+					Warn("More data available (Archive corrupted?)");
+					return;
+				}
+				if (zlib_error == Z_STREAM_END) {
+					stream_end = true;
+					return;
+				}
+				if (zlib_error != Z_OK) {
+					return;
+				}
+			}
+		}
+
+		void Warn(std::string_view msg) {
+			// Decoding again after seeking backwards does not repeat it
+			if (!warned) {
+				Output::Warning("ZipFS: zlib failed for {}: {}", name, msg);
+				warned = true;
+			}
+		}
+
+		struct AccessPoint {
+			/** Decoded position */
+			std::streamoff out_pos;
+			/** Compressed position, the first byte is partially used when bits is not 0 */
+			std::streamoff in_pos;
+			int bits;
+			/** Last 32 KiB of decoded data (dictionary) */
+			std::vector<Bytef> window;
+		};
+
+		void AppendWindow(const Bytef* data, size_t len) {
+			if (len >= window.size()) {
+				std::copy(data + len - window.size(), data + len, window.begin());
+				window_pos = 0;
+				return;
+			}
+			size_t first = std::min(len, window.size() - window_pos);
+			std::copy(data, data + first, window.begin() + window_pos);
+			std::copy(data + first, data + len, window.begin());
+			window_pos = (window_pos + len) % window.size();
+		}
+
+		void AddAccessPoint() {
+			AccessPoint point;
+			point.out_pos = out_pos;
+			point.in_pos = in_pos - zlib_stream.avail_in;
+			point.bits = zlib_stream.data_type & 7;
+			point.window.reserve(window.size());
+			point.window.insert(point.window.end(), window.begin() + window_pos, window.end());
+			point.window.insert(point.window.end(), window.begin(), window.begin() + window_pos);
+			points.push_back(std::move(point));
+		}
+
+		Filesystem_Stream::InputStream is;
+		std::string name;
+		std::streamoff offset;
+		std::streamoff compressed_size;
+		std::streamoff uncompressed_size;
+		/** Compressed bytes read from the archive */
+		std::streamoff in_pos = 0;
+		/** Decoded bytes */
+		std::streamoff out_pos = 0;
+		z_stream zlib_stream = {};
+		bool ok = false;
+		/** The end of the deflate stream was reached */
+		bool stream_end = false;
+		bool warned = false;
+		bool track_window;
+		std::array<Bytef, 16 * 1024> in_buf;
+		/** Ring buffer of the last 32 KiB of decoded data */
+		std::array<Bytef, 32 * 1024> window = {};
+		size_t window_pos = 0;
+		std::vector<AccessPoint> points;
+	};
+}
+
 static std::string normalize_path(std::string_view path) {
 	if (path == "." || path == "/" || path.empty()) {
 		return "";
@@ -54,7 +311,8 @@ static std::string normalize_path(std::string_view path) {
 
 ZipFilesystem::ZipFilesystem(std::string base_path, FilesystemView parent_fs, std::string_view enc) :
 	Filesystem(base_path, parent_fs) {
-	zip_is = parent_fs.OpenInputStream(GetPath());
+	// Only used for reading the directory, every opened file uses an own handle
+	auto zip_is = parent_fs.OpenInputStream(GetPath());
 	if (!zip_is) {
 		return;
 	}
@@ -366,7 +624,12 @@ std::streambuf* ZipFilesystem::CreateInputStreambuffer(std::string_view path, st
 	std::string path_normalized = normalize_path(path);
 	auto central_entry = Find(path);
 	if (central_entry && !central_entry->is_directory) {
-		zip_is.clear();
+		// Every stream has an own handle on the archive: Files are read independently from each other
+		auto zip_is = GetParent().OpenInputStream(GetPath());
+		if (!zip_is) {
+			return nullptr;
+		}
+
 		zip_is.seekg(central_entry->fileoffset);
 		StorageMethod method;
 		ZipEntry local_entry = {};
@@ -394,36 +657,18 @@ std::streambuf* ZipFilesystem::CreateInputStreambuffer(std::string_view path, st
 				return nullptr;
 			}
 
-			zip_is.seekg(central_entry->fileoffset + local_entry.fileoffset);
+			std::streamoff data_offset = static_cast<std::streamoff>(central_entry->fileoffset) + local_entry.fileoffset;
+			zip_is.seekg(data_offset);
 			if (method == StorageMethod::Plain) {
-				auto data = std::vector<uint8_t>(local_entry.uncompressed_size);
-				zip_is.read(reinterpret_cast<char*>(data.data()), data.size());
-				return new Filesystem_Stream::InputMemoryStreamBuf(std::move(data));
+				return new StoredStreamBuf(std::move(zip_is), data_offset, local_entry.uncompressed_size);
 			} else if (method == StorageMethod::Deflate) {
-				std::vector<uint8_t> comp_buf;
-				comp_buf.resize(local_entry.compressed_size);
-				zip_is.read(reinterpret_cast<char*>(comp_buf.data()), comp_buf.size());
-				auto dec_buf = std::vector<uint8_t>(local_entry.uncompressed_size);
-				z_stream zlib_stream = {};
-				zlib_stream.next_in = reinterpret_cast<Bytef*>(comp_buf.data());
-				zlib_stream.avail_in = static_cast<uInt>(comp_buf.size());
-				zlib_stream.next_out = reinterpret_cast<Bytef*>(dec_buf.data());
-				zlib_stream.avail_out = static_cast<uInt>(dec_buf.size());
-				inflateInit2(&zlib_stream, -MAX_WBITS);
-				auto inflate_sg = lcf::makeScopeGuard([&]() {
-					inflateEnd(&zlib_stream);
-				});
-
-				int zlib_error = inflate(&zlib_stream, Z_NO_FLUSH);
-				if (zlib_error == Z_OK) {
-					Output::Warning("ZipFS: zlib failed for {}: More data available (Archive corrupted?)", path_normalized);
-					return nullptr;
-				}
-				else if (zlib_error != Z_STREAM_END) {
-					Output::Warning("ZipFS: zlib failed for {}: {} ({})", path_normalized, zlib_error, zlib_stream.msg ? zlib_stream.msg : "No error message");
+				auto* buf = new InflateStreamBuf(std::move(zip_is), path_normalized, data_offset, local_entry.compressed_size, local_entry.uncompressed_size);
+				if (!buf->IsOk()) {
+					Output::Warning("ZipFS: zlib failed for {}: Initialization failed", path_normalized);
+					delete buf;
 					return nullptr;
 				}
-				return new Filesystem_Stream::InputMemoryStreamBuf(std::move(dec_buf));
+				return buf;
 			} else {
 				Output::Warning("ZipFS: {} has unsupported compression format. Only Deflate is supported", path_normalized);
 				return nullptr;
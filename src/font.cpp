@@ -18,6 +18,7 @@
 // Headers
 #include <cstdint>
 #include <map>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 #include <iterator>
@@ -137,7 +138,6 @@ namespace {
 
 	private:
 		function_type func;
-		mutable BitmapRef glyph_bm;
 	}; // class BitmapFont
 
 #ifdef HAVE_FREETYPE
@@ -219,6 +219,47 @@ namespace {
 
 	using namespace std::chrono_literals;
 
+	/** Glyphs per font, the glyph cache is emptied when reached */
+	constexpr size_t glyph_cache_limit = 4096;
+
+	/** System graphic colors zoomed for glyphs taller than 16px */
+	struct SysMask {
+		/** ID of the system graphic, detects reuse of the address */
+		std::string sys_id;
+		BitmapRef bitmap;
+	};
+
+	// system graphic, color, size
+	using sys_mask_key_type = std::tuple<const Bitmap*, int, int>;
+	std::map<sys_mask_key_type, SysMask> sys_masks;
+
+	constexpr size_t sys_mask_limit = 64;
+
+	const Bitmap& GetSysMask(const Bitmap& sys, int color, int size) {
+		auto& mask = sys_masks[{&sys, color, size}];
+		if (mask.bitmap && mask.sys_id == sys.GetId()) {
+			return *mask.bitmap;
+		}
+
+		if (sys_masks.size() > sys_mask_limit) {
+			sys_masks.clear();
+			return GetSysMask(sys, color, size);
+		}
+
+		const Rect shadow_color_rect = { 16, 32, 16, 16 };
+		const Rect mask_color_rect = { color % 10 * 16, color / 10 * 16 + 48, 16, 16 };
+		mask.bitmap = Bitmap::Create(size * 2, size, false);
+		mask.sys_id = ToString(sys.GetId());
+		double zoom = size / 16.0;
+		// Left half of the image is the shadow, right half the mask
+		if (color != Font::ColorShadow) {
+			mask.bitmap->ZoomOpacityBlit(0, 0, 0, 0, sys, shadow_color_rect, zoom, zoom, Opacity::Opaque());
+		}
+		mask.bitmap->ZoomOpacityBlit(size, 0, 0, 0, sys, mask_color_rect, zoom, zoom, Opacity::Opaque());
+
+		return *mask.bitmap;
+	}
+
 	void FreeFontMemory() {
 		auto cur_ticks = Game_Clock::GetFrameTime();
 
@@ -250,7 +291,9 @@ namespace {
 
 BitmapFont::BitmapFont(std::string_view name, function_type func)
 	: Font(name, HEIGHT, false, false), func(func)
-{}
+{
+	cache_glyphs = true;
+}
 
 Rect BitmapFont::vGetSize(char32_t glyph) const {
 	auto bm_glyph = func(glyph);
@@ -259,11 +302,8 @@ Rect BitmapFont::vGetSize(char32_t glyph) const {
 }
 
 Font::GlyphRet BitmapFont::vRender(char32_t glyph) const {
-	std::vector<Font::GlyphRet> glyphs;
-
-	if (EP_UNLIKELY(!glyph_bm)) {
-		glyph_bm = Bitmap::Create(nullptr, FULL_WIDTH, HEIGHT, 0, DynamicFormat(8, 8, 0, 8, 0, 8, 0, 8, 0, PF::Alpha));
-	}
+	// Kept by the glyph cache
+	auto glyph_bm = Bitmap::Create(nullptr, FULL_WIDTH, HEIGHT, 0, DynamicFormat(8, 8, 0, 8, 0, 8, 0, 8, 0, PF::Alpha));
 	auto bm_glyph = func(glyph);
 	auto width = bm_glyph->is_full ? FULL_WIDTH : HALF_WIDTH;
 
@@ -280,6 +320,7 @@ Font::GlyphRet BitmapFont::vRender(char32_t glyph) const {
 #ifdef HAVE_FREETYPE
 FTFont::FTFont(Filesystem_Stream::InputStream is, int size, bool bold, bool italic)
 	: Font(is.GetName(), size, bold, italic) {
+	cache_glyphs = true;
 
 	if (!library) {
 		if (FT_Init_FreeType(&library) != FT_Err_Ok) {
@@ -462,7 +503,9 @@ Font::GlyphRet FTFont::vRenderShaped(char32_t glyph) const {
 	bool has_color = false;
 
 	if (ft_bitmap->pixel_mode == FT_PIXEL_MODE_BGRA) {
-		bm = Bitmap::Create(ft_bitmap->buffer, width, height, 0, format_B8G8R8A8_a().format());
+		// Copied, the buffer of the glyph slot is reused by the next glyph
+		auto slot_bm = Bitmap::Create(ft_bitmap->buffer, width, height, 0, format_B8G8R8A8_a().format());
+		bm = Bitmap::Create(*slot_bm, slot_bm->GetRect());
 		has_color = true;
 	} else {
 		bm = Bitmap::Create(width, height);
@@ -692,6 +735,7 @@ void Font::ResetDefault() {
 void Font::Dispose() {
 	SetDefault(nullptr, true);
 	SetDefault(nullptr, false);
+	ClearSystemMasks();
 
 #ifdef HAVE_FREETYPE
 	if (library) {
@@ -701,6 +745,10 @@ void Font::Dispose() {
 #endif
 }
 
+void Font::ClearSystemMasks() {
+	sys_masks.clear();
+}
+
 // Constructor.
 Font::Font(std::string_view name, int size, bool bold, bool italic)
 	: name(ToString(name))
@@ -742,7 +790,7 @@ Point Font::Render(Bitmap& dest, int const x, int const y, const Bitmap& sys, in
 		return {};
 	}
 
-	auto gret = vRender(glyph);
+	auto gret = GetGlyph(glyph, false);
 
 	if (EP_UNLIKELY(!RenderImpl(dest, x, y, sys, color, gret))) {
 		return {};
@@ -758,7 +806,7 @@ Point Font::Render(Bitmap& dest, int const x, int const y, const Bitmap& sys, in
 		return Render(dest, x, y, sys, color, shape.code);
 	}
 
-	auto gret = vRenderShaped(shape.code);
+	auto gret = GetGlyph(shape.code, true);
 
 	if (EP_UNLIKELY(!RenderImpl(dest, x, y, sys, color, gret))) {
 		return {};
@@ -792,26 +840,16 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 	// When <= 12: Will work fine
 	// When <= 16: Slightly adjusted (see ~20 lines below)
 	if (glyph_height > 16) {
-		// Too large for the existing mask: Resize the masks (slow)
+		// Too large for the existing mask: Use resized masks
 		// The mask is too small and the system graphic must be resized
 		// This is usually an exception and requires a custom font
-		const Rect shadow_color_rect = { 16, 32, 16, 16 };
-		const Rect mask_color_rect = { color % 10 * 16, color / 10 * 16 + 48, 16, 16 };
-		auto sys_large = Bitmap::Create(current_style.size * 2, current_style.size, false);
-		double zoom = current_style.size / 16.0;
-		// Left half of the image is the shadow, right half the mask
-		if (color != ColorShadow && current_style.draw_shadow) {
-			sys_large->ZoomOpacityBlit(0, 0, 0, 0, sys, shadow_color_rect, zoom, zoom, Opacity::Opaque());
-		}
-		if (!gret.has_color) {
-			sys_large->ZoomOpacityBlit(current_style.size, 0, 0, 0, sys, mask_color_rect, zoom, zoom, Opacity::Opaque());
-		}
+		const Bitmap& sys_large = GetSysMask(sys, color, current_style.size);
 
 		if (color != ColorShadow) {
 			// First draw the shadow, offset by one
 			if (!gret.has_color && current_style.draw_shadow) {
 				auto shadow_rect = Rect(rect.x + 1, rect.y + 1, rect.width, rect.height);
-				dest.MaskedBlit(shadow_rect, *gret.bitmap, 0, 0, *sys_large, 0, 0);
+				dest.MaskedBlit(shadow_rect, *gret.bitmap, 0, 0, sys_large, 0, 0);
 			}
 
 			src_x = current_style.size;
@@ -820,11 +858,10 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 
 		if (!gret.has_color) {
 			if (current_style.draw_gradient) {
-				dest.MaskedBlit(rect, *gret.bitmap, 0, 0, *sys_large, src_x, src_y);
+				dest.MaskedBlit(rect, *gret.bitmap, 0, 0, sys_large, src_x, src_y);
 			} else {
 				auto col = sys.GetColorAt(current_style.color_offset.x + src_x, current_style.color_offset.y + src_y);
-				auto col_bm = Bitmap::Create(gret.bitmap->width(), gret.bitmap->height(), col);
-				dest.MaskedBlit(rect, *gret.bitmap, 0, 0, *col_bm, 0, 0);
+				dest.MaskedBlit(rect, *gret.bitmap, 0, 0, col);
 			}
 		} else {
 			// Color glyphs, emojis etc.
@@ -862,8 +899,7 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 			dest.MaskedBlit(rect, *gret.bitmap, 0, 0, sys, src_x, src_y);
 		} else {
 			auto col = sys.GetColorAt(current_style.color_offset.x + src_x, current_style.color_offset.y + src_y);
-			auto col_bm = Bitmap::Create(gret.bitmap->width(), gret.bitmap->height(), col);
-			dest.MaskedBlit(rect, *gret.bitmap, 0, 0, *col_bm, 0, 0);
+			dest.MaskedBlit(rect, *gret.bitmap, 0, 0, col);
 		}
 	} else {
 		// Color glyphs, emojis etc.
@@ -873,12 +909,32 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 	return true;
 }
 
+Font::GlyphRet Font::GetGlyph(char32_t code, bool shaped) const {
+	if (!cache_glyphs) {
+		return shaped ? vRenderShaped(code) : vRender(code);
+	}
+
+	const uint64_t key = (static_cast<uint64_t>(shaped) << 63) |
+		(static_cast<uint64_t>(current_style.size & 0x7FFFFFFF) << 32) | static_cast<uint32_t>(code);
+
+	auto it = glyph_cache.find(key);
+	if (it != glyph_cache.end()) {
+		return it->second;
+	}
+
+	if (glyph_cache.size() >= glyph_cache_limit) {
+		glyph_cache.clear();
+	}
+
+	return glyph_cache.emplace(key, shaped ? vRenderShaped(code) : vRender(code)).first->second;
+}
+
 Point Font::Render(Bitmap& dest, int x, int y, Color const& color, char32_t glyph) const {
 	if (EP_UNLIKELY(Utils::IsControlCharacter(glyph))) {
 		return {};
 	}
 
-	auto gret = vRender(glyph);
+	auto gret = GetGlyph(glyph, false);
 	if (EP_UNLIKELY(gret.bitmap == nullptr)) {
 		return {};
 	}
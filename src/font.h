@@ -25,7 +25,9 @@
 #include "memory_management.h"
 #include "rect.h"
 #include "string_view.h"
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <lcf/scope_guard.h>
 
 class Color;
@@ -235,6 +237,8 @@ class Font {
 	static void SetDefault(FontRef new_default, bool use_mincho);
 	static void ResetDefault();
 	static void Dispose();
+	/** Drops the zoomed system graphic colors, call when the system graphic changes */
+	static void ClearSystemMasks();
 
 	static FontRef exfont;
 
@@ -262,9 +266,26 @@ class Font {
 	Style original_style;
 	Style current_style;
 	FontRef fallback_font;
+	/**
+	 * Keep rendered glyphs in the glyph cache.
+	 * Only allowed when vRender returns a new bitmap on every call.
+	 */
+	bool cache_glyphs = false;
 
 private:
 	bool RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys, int color, const GlyphRet& gret) const;
+
+	/**
+	 * Returns the glyph from the glyph cache, renders it on a miss.
+	 *
+	 * @param code codepoint, or glyph index when shaped
+	 * @param shaped whether code is a glyph index from shaping
+	 * @return rendered glyph
+	 */
+	GlyphRet GetGlyph(char32_t code, bool shaped) const;
+
+	/** Rendered glyphs by codepoint, shaping flag and style size */
+	mutable std::unordered_map<uint64_t, GlyphRet> glyph_cache;
 };
 
 #endif
@@ -69,8 +69,7 @@ void Game_Character::SanitizeMoveRoute(std::string_view name, const lcf::rpg::Mo
 void Game_Character::MoveTo(int map_id, int x, int y) {
     if (true) { // TODO - PIXELMOVE
 		is_moving_toward_target = false;
-		real_x = (float)x;
-		real_y = (float)y;
+		SetRealPosition((float)x, (float)y);
 		//Output::Warning("Char Pos = {}x{}", real_x, real_y);
 	}// END - PIXELMOVE
 
@@ -624,6 +623,28 @@ bool Game_Character::MoveVector(c2v vector) {
 	return MoveVector(vector.x, vector.y);
 }
 
+void Game_Character::SetX(int new_x) {
+	data()->position_x = new_x;
+	if (GetType() == Event) {
+		Game_Map::UpdateEventTile(static_cast<const Game_Event&>(*this));
+	}
+}
+
+void Game_Character::SetY(int new_y) {
+	data()->position_y = new_y;
+	if (GetType() == Event) {
+		Game_Map::UpdateEventTile(static_cast<const Game_Event&>(*this));
+	}
+}
+
+void Game_Character::SetRealPosition(float x, float y) {
+	real_x = x;
+	real_y = y;
+	if (GetType() == Event) {
+		Game_Map::UpdateEventGridPosition(static_cast<const Game_Event&>(*this));
+	}
+}
+
 bool Game_Character::MoveVector(float vx, float vy) {  // TODO - PIXELMOVE
 //	if (abs(vx) <= Epsilon && abs(vy) <= Epsilon) {
 //		return false;
@@ -657,8 +678,7 @@ bool Game_Character::MoveVector(float vx, float vy) {  // TODO - PIXELMOVE
 	SetRemainingStep(1); //little hack to make the character step anim
 	float last_x = real_x;
 	float last_y = real_y;
-	real_x += vx;
-	real_y += vy;
+	SetRealPosition(real_x + vx, real_y + vy);
 	if (GetThrough()) {
 		return true;
 	}
@@ -710,7 +730,11 @@ bool Game_Character::MoveVector(float vx, float vy) {  // TODO - PIXELMOVE
 	*/
 
 	//Test Collision With Events
-	for (auto& ev : Game_Map::GetEvents()) {
+	// Events are only pushed away when closer than 1 tile and every push is
+	// shorter than 1 tile, so events further than 2 tiles never collide
+	auto& events = Game_Map::GetEvents();
+	for (int idx : Game_Map::GetEventIndicesNear(self.p.x, self.p.y, 2.0f)) {
+		auto& ev = events[idx];
 		if (!Game_Map::WouldCollideWithCharacter(*this, ev, false)) {
 			continue;
 		}
@@ -978,8 +1002,7 @@ if (!Game_Map::LoopVertical()) {
 		}
           }
 		}
-            real_x = self.p.x - 0.5;
-            real_y = self.p.y - 0.5;
+            SetRealPosition(self.p.x - 0.5, self.p.y - 0.5);
 //      real_x = round((self.p.x - 0.5) * (float)SCREEN_TILE_SIZE) / SCREEN_TILE_SIZE;
 //      real_y = round((self.p.y - 0.5) * (float)SCREEN_TILE_SIZE) / SCREEN_TILE_SIZE;
 	SetX(round(real_x));
@@ -1200,8 +1223,7 @@ bool Game_Character::BeginMoveRouteJump(int32_t& current_index, const lcf::rpg::
 
 bool Game_Character::Jump(int x, int y) {
 
-   		real_x = (float)x;
-		real_y = (float)y;
+   		SetRealPosition((float)x, (float)y);
 
 	if (!IsStopping()) {
 		return true;
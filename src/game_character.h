@@ -42,6 +42,15 @@ public:
 	float real_x;
 	float real_y;
 
+	/**
+	 * Sets the pixel movement position and keeps the collision grid of the
+	 * map events up to date.
+	 *
+	 * @param x position x in tiles
+	 * @param y position y in tiles
+	 */
+	void SetRealPosition(float x, float y);
+
 	float target_x;
 	float target_y;
 	c2v move_direction;
@@ -1039,18 +1048,10 @@ inline int Game_Character::GetX() const {
 	return data()->position_x;
 }
 
-inline void Game_Character::SetX(int new_x) {
-	data()->position_x = new_x;
-}
-
 inline int Game_Character::GetY() const {
 	return data()->position_y;
 }
 
-inline void Game_Character::SetY(int new_y) {
-	data()->position_y = new_y;
-}
-
 inline int Game_Character::GetMapId() const {
 	return data()->map_id;
 }
@@ -611,6 +611,7 @@ void Game_Config::LoadFromStream(Filesystem_Stream::InputStream& is) {
 	/** AUDIO SECTION */
 	audio.music_volume.FromIni(ini);
 	audio.sound_volume.FromIni(ini);
+	audio.se_cache_size.FromIni(ini);
 	audio.fluidsynth_midi.FromIni(ini);
 	audio.wildmidi_midi.FromIni(ini);
 	audio.native_midi.FromIni(ini);
@@ -713,6 +714,7 @@ void Game_Config::WriteToStream(Filesystem_Stream::OutputStream& os) const {
 
 	audio.music_volume.ToIni(os);
 	audio.sound_volume.ToIni(os);
+	audio.se_cache_size.ToIni(os);
 	audio.fluidsynth_midi.ToIni(os);
 	audio.wildmidi_midi.ToIni(os);
 	audio.native_midi.ToIni(os);
@@ -176,6 +176,11 @@ static std::string ParseToken(std::string token, std::string_view function_name)
 	return token;
 }
 
+// Tokens that may resolve to a variable, string variable or actor name
+static bool IsTokenReference(std::string_view token) {
+	return !token.empty() && (token[0] == 'V' || token[0] == 'N' || token[0] == 'T');
+}
+
 void Game_DynRpg::InitPlugins() {
 	if (plugins_loaded) {
 		return;
@@ -197,17 +202,32 @@ void Game_DynRpg::InitPlugins() {
 		plugins.emplace_back(new DynRpg::Rpgss(*this));
 	}
 
+	for (auto& plugin: plugins) {
+		plugin->RegisterFunctions();
+	}
 
 	plugins_loaded = true;
 }
 
-std::string DynRpg::ParseCommand(std::string command, std::vector<std::string>& args) {
+using dyn_references = std::vector<std::pair<int, std::string>>;
+
+static void AddToken(const std::string& token, std::string_view function_name, std::vector<std::string>& args, dyn_references* references) {
+	if (references && IsTokenReference(token)) {
+		// Resolved on every call by ResolveArgs
+		references->emplace_back(static_cast<int>(args.size()), token);
+		args.emplace_back();
+	} else {
+		args.emplace_back(ParseToken(token, function_name));
+	}
+}
+
+static std::string ParseCommandImpl(std::string_view command, std::vector<std::string>& args, dyn_references* references) {
 	if (command.empty()) {
 		// Not a DynRPG function (empty comment)
 		return {};
 	}
 
-	std::string::iterator text_index, end;
+	std::string_view::iterator text_index, end;
 	text_index = command.begin();
 	end = command.end();
 
@@ -220,7 +240,6 @@ std::string DynRpg::ParseCommand(std::string command, std::vector<std::string>&
 
 	DynRpg_ParseMode mode = ParseMode_Function;
 	std::string function_name;
-	std::string tmp;
 	std::stringstream token;
 
 	++text_index;
@@ -230,8 +249,8 @@ std::string DynRpg::ParseCommand(std::string command, std::vector<std::string>&
 	// Number is a valid float number
 	// Tokens are Strings without "" and with Whitespace stripped o_O
 
-	// All arguments are passed as string to the DynRpg functions and are
-	// converted to int or float on demand.
+	// All arguments are passed as string to the DynRpg functions. Cached
+	// commands also carry the numbers converted once by ParseNumber.
 
 	for (;;) {
 		if (text_index != end) {
@@ -263,8 +282,7 @@ std::string DynRpg::ParseCommand(std::string command, std::vector<std::string>&
 					args.emplace_back(token.str());
 					break;
 				case ParseMode_Token:
-					tmp = ParseToken(token.str(), function_name);
-					args.emplace_back(tmp);
+					AddToken(token.str(), function_name, args, references);
 					break;
 			}
 
@@ -320,8 +338,7 @@ std::string DynRpg::ParseCommand(std::string command, std::vector<std::string>&
 					token << chr;
 					break;
 				case ParseMode_Token:
-					tmp = ParseToken(token.str(), function_name);
-					args.emplace_back(tmp);
+					AddToken(token.str(), function_name, args, references);
 					// already on a comma
 					mode = ParseMode_WaitForArg;
 					token.str("");
@@ -378,34 +395,134 @@ std::string DynRpg::ParseCommand(std::string command, std::vector<std::string>&
 	return function_name;
 }
 
+std::string DynRpg::ParseCommand(std::string command, std::vector<std::string>& args) {
+	return ParseCommandImpl(command, args, nullptr);
+}
+
+DynRpg::Number DynRpg::ParseNumber(std::string_view arg) {
+	Number number;
+	if (arg.empty()) {
+		return number;
+	}
+
+	if (detail::parse_int(arg, number.int_value)) {
+		number.is_int = true;
+		number.is_float = true;
+		number.float_value = static_cast<float>(number.int_value);
+		return number;
+	}
+
+	// Same conversion as ParseArgs, only accepted when the whole argument is used
+	std::istringstream iss{std::string(arg)};
+	iss.imbue(std::locale::classic());
+	iss >> number.float_value;
+	number.is_float = !iss.fail() && iss.peek() == std::char_traits<char>::eof();
+	if (!number.is_float) {
+		number.float_value = 0.0f;
+	}
+	return number;
+}
+
+DynRpg::ParsedCommand DynRpg::ParseCommandCached(std::string_view command) {
+	ParsedCommand cmd;
+	cmd.function_name = ParseCommandImpl(command, cmd.args, &cmd.references);
+	cmd.numbers.reserve(cmd.args.size());
+	for (const auto& arg: cmd.args) {
+		cmd.numbers.push_back(ParseNumber(arg));
+	}
+	return cmd;
+}
+
+void DynRpg::ResolveArgs(const ParsedCommand& cmd, std::vector<std::string>& args, std::vector<Number>& numbers) {
+	args = cmd.args;
+	numbers = cmd.numbers;
+	for (const auto& ref: cmd.references) {
+		args[ref.first] = ParseToken(ref.second, cmd.function_name);
+		numbers[ref.first] = ParseNumber(args[ref.first]);
+	}
+}
+
+void Game_DynRpg::RegisterFunction(std::string_view name, dyn_handler handler) {
+	auto it = dyn_rpg_function_ids.find(name);
+	if (it == dyn_rpg_function_ids.end()) {
+		const auto& key = function_names.emplace_back(ToString(name));
+		it = dyn_rpg_function_ids.emplace(key, static_cast<dyn_func_id>(dyn_rpg_functions.size())).first;
+		dyn_rpg_functions.emplace_back();
+	}
+	// Plugins registered first are tried first
+	dyn_rpg_functions[it->second].push_back(std::move(handler));
+}
+
+void Game_DynRpg::RegisterFunction(std::string_view name, dynfunc func) {
+	RegisterFunction(name, [func](dyn_arg_list args, bool&, Game_Interpreter*) {
+		return func(args);
+	});
+}
+
+dyn_func_id Game_DynRpg::GetFunctionId(std::string_view name) const {
+	auto it = dyn_rpg_function_ids.find(name);
+	return it == dyn_rpg_function_ids.end() ? -1 : it->second;
+}
+
 bool Game_DynRpg::Invoke(std::string_view command, Game_Interpreter* interpreter) {
 	InitPlugins();
 
-	std::vector<std::string> args;
-	std::string function_name = DynRpg::ParseCommand(ToString(command), args);
+	// Parse every distinct comment once, only references are resolved per call
+	auto it = command_cache.find(command);
+	if (it == command_cache.end()) {
+		auto cmd = DynRpg::ParseCommandCached(command);
+		cmd.id = GetFunctionId(cmd.function_name);
+		const auto& key = command_texts.emplace_back(ToString(command));
+		it = command_cache.emplace(key, std::move(cmd)).first;
+	}
+
+	auto& cmd = it->second;
 
-	if (function_name.empty()) {
+	if (cmd.function_name.empty()) {
 		return true;
 	}
 
-	return Invoke(function_name, args, interpreter);
+	if (cmd.references.empty()) {
+		return Invoke(cmd.id, cmd.function_name, DynRpg::ArgList(cmd.args, cmd.numbers), interpreter);
+	}
+
+	std::vector<std::string> args;
+	std::vector<DynRpg::Number> numbers;
+	DynRpg::ResolveArgs(cmd, args, numbers);
+	return Invoke(cmd.id, cmd.function_name, DynRpg::ArgList(args, numbers), interpreter);
 }
 
 bool Game_DynRpg::Invoke(std::string_view func, dyn_arg_list args, Game_Interpreter* interpreter) {
 	InitPlugins();
 
+	return Invoke(GetFunctionId(func), func, args, interpreter);
+}
+
+bool Game_DynRpg::Invoke(dyn_func_id id, std::string_view func, dyn_arg_list args, Game_Interpreter* interpreter) {
 	bool yield = false;
 
-	for (auto& plugin: plugins) {
-		if (plugin->Invoke(func, args, yield, interpreter)) {
-			return !yield;
-		}
+	if (CallFunction(id, args, yield, interpreter)) {
+		return !yield;
 	}
 
 	Output::Warning("Unsupported DynRPG function: {}", func);
 	return true;
 }
 
+bool Game_DynRpg::CallFunction(dyn_func_id id, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter) {
+	if (id < 0) {
+		return false;
+	}
+
+	// A plugin that does not handle the call leaves it to the next one
+	for (auto& handler: dyn_rpg_functions[id]) {
+		if (handler(args, do_yield, interpreter)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 std::string get_filename(int slot) {
 	auto fs = FileFinder::Save();
 
@@ -420,6 +537,24 @@ std::string get_filename(int slot) {
 	return found;
 }
 
+namespace {
+	constexpr char save_magic[] = "DYNSAVE1";
+	constexpr size_t save_magic_size = 8;
+
+	uint32_t read_u32(const std::vector<uint8_t>& buffer, size_t pos) {
+		uint32_t value;
+		memcpy(&value, buffer.data() + pos, 4);
+		Utils::SwapByteOrder(value);
+		return value;
+	}
+
+	void write_u32(std::vector<uint8_t>& buffer, uint32_t value) {
+		Utils::SwapByteOrder(value);
+		auto* p = reinterpret_cast<const uint8_t*>(&value);
+		buffer.insert(buffer.end(), p, p + 4);
+	}
+}
+
 void Game_DynRpg::Load(int slot) {
 	if (!Player::IsPatchDynRpg()) {
 		return;
@@ -433,57 +568,57 @@ void Game_DynRpg::Load(int slot) {
 
 	if (!in) {
 		Output::Warning("Couldn't read DynRPG save: {}", filename);
+		return;
 	}
 
-	std::vector<uint8_t> in_buffer;
-	in_buffer.resize(8);
-
-	in.read((char*)in_buffer.data(), 8);
+	// The whole file is read at once, chunks are parsed from memory
+	std::vector<uint8_t> buffer = Utils::ReadStream(in);
 
-	if (strncmp((char*)in_buffer.data(), "DYNSAVE1", 8) != 0) {
+	if (buffer.size() < save_magic_size || memcmp(buffer.data(), save_magic, save_magic_size) != 0) {
 		Output::Warning("Corrupted DynRPG save: {}", filename);
 		return;
 	}
 
-	while (!(in.eof() || in.fail())) {
-		// Read header length followed by header (Plugin Identifier)
-
-		uint32_t len;
-		in.read((char *) &len, 4);
-		Utils::SwapByteOrder(len);
+	size_t pos = save_magic_size;
+	std::vector<uint8_t> chunk;
 
-		in_buffer.resize(len);
-		in.read((char*)in_buffer.data(), len);
+	while (pos < buffer.size()) {
+		// Header length followed by header (Plugin Identifier) and the chunk
+		if (buffer.size() - pos < 4) {
+			break;
+		}
+		uint32_t len = read_u32(buffer, pos);
+		pos += 4;
+		if (buffer.size() - pos < len) {
+			break;
+		}
+		std::string_view identifier(reinterpret_cast<const char*>(buffer.data() + pos), len);
+		pos += len;
 
-		// Find a plugin that feels responsible
-		bool have_one = false;
+		if (buffer.size() - pos < 4) {
+			break;
+		}
+		len = read_u32(buffer, pos);
+		pos += 4;
+		if (buffer.size() - pos < len) {
+			break;
+		}
 
+		// Find a plugin that feels responsible, other chunks are skipped
 		for (auto &plugin : plugins) {
-			if (strncmp((char*)in_buffer.data(), plugin->GetIdentifier().data(), len) == 0) {
-				// Chunk length
-				in.read((char *) &len, 4);
-				Utils::SwapByteOrder(len);
-
+			if (plugin->GetIdentifier() == identifier) {
 				if (len > 0) {
-					// Read chunk
-					in_buffer.resize(len);
-					in.read((char*)in_buffer.data(), len);
-
-					plugin->Load(in_buffer);
+					chunk.assign(buffer.begin() + pos, buffer.begin() + pos + len);
+					plugin->Load(chunk);
 				}
-
-				have_one = true;
 				break;
 			}
 		}
+		pos += len;
+	}
 
-		if (!have_one) {
-			// Skip this chunk, no plugin found
-			in.read((char *) &len, 4);
-			Utils::SwapByteOrder(len);
-
-			in.seekg(len, std::ios::cur);
-		}
+	if (pos != buffer.size()) {
+		Output::Warning("Corrupted DynRPG save: {}", filename);
 	}
 }
 
@@ -494,6 +629,19 @@ void Game_DynRpg::Save(int slot) {
 
 	InitPlugins();
 
+	// Built in memory and written at once
+	std::vector<uint8_t> buffer(save_magic, save_magic + save_magic_size);
+
+	for (auto &plugin : plugins) {
+		std::string_view identifier = plugin->GetIdentifier();
+		write_u32(buffer, static_cast<uint32_t>(identifier.size()));
+		buffer.insert(buffer.end(), identifier.begin(), identifier.end());
+
+		std::vector<uint8_t> data = plugin->Save();
+		write_u32(buffer, static_cast<uint32_t>(data.size()));
+		buffer.insert(buffer.end(), data.begin(), data.end());
+	}
+
 	std::string filename = get_filename(slot);
 
 	auto out = FileFinder::Save().OpenOutputStream(filename);
@@ -503,24 +651,7 @@ void Game_DynRpg::Save(int slot) {
 		return;
 	}
 
-	std::string header = "DYNSAVE1";
-
-	out.write(header.c_str(), 8);
-
-	for (auto &plugin : plugins) {
-		uint32_t len = plugin->GetIdentifier().size();
-		Utils::SwapByteOrder(len);
-
-		out.write((char*)&len, 4);
-		out.write(plugin->GetIdentifier().data(), len);
-
-		std::vector<uint8_t> data = plugin->Save();
-		len = data.size();
-		Utils::SwapByteOrder(len);
-
-		out.write((char*)&len, 4);
-		out.write((char*)data.data(), data.size());
-	}
+	out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
 }
 
 void Game_DynRpg::Update() {
@@ -18,7 +18,10 @@
 #ifndef EP_GAME_DYNRPG_H
 #define EP_GAME_DYNRPG_H
 
+#include <charconv>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <locale>
 #include <vector>
 #include <sstream>
@@ -26,6 +29,7 @@
 #include <tuple>
 #include <unordered_map>
 #include "output.h"
+#include "span.h"
 #include "utils.h"
 
 // Headers
@@ -36,8 +40,53 @@ namespace lcf::rpg {
 class DynRpgPlugin;
 class Game_Interpreter;
 
-using dyn_arg_list = const Span<std::string>;
+namespace DynRpg {
+	/** Numeric value of an argument, converted once when the comment is parsed */
+	struct Number {
+		bool is_int = false;
+		bool is_float = false;
+		int int_value = 0;
+		float float_value = 0.0f;
+	};
+
+	/**
+	 * Converts an argument that is a plain integer or float.
+	 *
+	 * @param arg argument text
+	 * @return number, is_int and is_float are false for other text
+	 */
+	Number ParseNumber(std::string_view arg);
+
+	/** Arguments of a DynRPG function call */
+	class ArgList {
+	public:
+		ArgList(const std::vector<std::string>& args) : args(args) {}
+		ArgList(Span<const std::string> args, Span<const Number> numbers = {}) : args(args), numbers(numbers) {}
+
+		size_t size() const { return args.size(); }
+		bool empty() const { return args.empty(); }
+		const std::string& operator[](size_t i) const { return args[i]; }
+
+		ArgList subspan(size_t offset) const {
+			return { args.subspan(offset), numbers.empty() ? numbers : numbers.subspan(offset) };
+		}
+
+		/** @return converted value of argument i, nullptr when it was not converted */
+		const Number* GetNumber(size_t i) const {
+			return i < numbers.size() ? &numbers[i] : nullptr;
+		}
+
+	private:
+		Span<const std::string> args;
+		Span<const Number> numbers;
+	};
+}
+
+using dyn_arg_list = const DynRpg::ArgList;
 using dynfunc = bool(*)(dyn_arg_list);
+using dyn_handler = std::function<bool(dyn_arg_list, bool& do_yield, Game_Interpreter* interpreter)>;
+/** Interned DynRPG function name, index into the function table */
+using dyn_func_id = int;
 
 /** Contains helper functions for parsing */
 namespace DynRpg {
@@ -46,6 +95,35 @@ namespace DynRpg {
 	std::string ParseVarArg(std::string_view func_name, dyn_arg_list args, int index, bool& parse_okay);
 	std::string ParseCommand(std::string command, std::vector<std::string>& params);
 
+	/** A DynRPG comment parsed once and reused on every execution */
+	struct ParsedCommand {
+		dyn_func_id id = -1;
+		std::string function_name;
+		std::vector<std::string> args;
+		/** Numeric value of every argument */
+		std::vector<Number> numbers;
+		/** Arguments that reference variables or actors, resolved again on every call (index, token) */
+		std::vector<std::pair<int, std::string>> references;
+	};
+
+	/**
+	 * Parses a DynRPG comment and remembers which arguments depend on
+	 * the game state.
+	 *
+	 * @param command comment text
+	 * @return parsed command, function_name is empty when it is not a DynRPG command
+	 */
+	ParsedCommand ParseCommandCached(std::string_view command);
+
+	/**
+	 * Resolves the variable and actor references of a parsed command.
+	 *
+	 * @param cmd parsed command
+	 * @param args receives the arguments
+	 * @param numbers receives the numeric values of the arguments
+	 */
+	void ResolveArgs(const ParsedCommand& cmd, std::vector<std::string>& args, std::vector<Number>& numbers);
+
 	namespace detail {
 		template <typename T>
 		inline bool parse_arg(std::string_view, dyn_arg_list, const int, T&, bool&) {
@@ -55,6 +133,17 @@ namespace DynRpg {
 
 		// FIXME: Extracting floats that are followed by chars behaviour varies depending on the C++ library
 		// see https://bugs.llvm.org/show_bug.cgi?id=17782
+		/**
+		 * Fast path for the common case of a plain integer argument.
+		 *
+		 * @return Whether the whole argument is an integer
+		 */
+		inline bool parse_int(std::string_view arg, int& value) {
+			const char* end = arg.data() + arg.size();
+			auto res = std::from_chars(arg.data(), end, value);
+			return res.ec == std::errc() && res.ptr == end;
+		}
+
 		template <>
 		inline bool parse_arg(std::string_view func_name, dyn_arg_list args, const int i, float& value, bool& parse_okay) {
 			if (!parse_okay) return false;
@@ -63,6 +152,19 @@ namespace DynRpg {
 				parse_okay = true;
 				return parse_okay;
 			}
+			if (auto* number = args.GetNumber(i)) {
+				if (number->is_float) {
+					value = number->float_value;
+					parse_okay = true;
+					return parse_okay;
+				}
+			}
+			int int_value;
+			if (parse_int(args[i], int_value)) {
+				value = int_value;
+				parse_okay = true;
+				return parse_okay;
+			}
 			std::istringstream iss(args[i]);
 			iss.imbue(std::locale::classic());
 			iss >> value;
@@ -78,7 +180,14 @@ namespace DynRpg {
 		inline bool parse_arg(std::string_view func_name, dyn_arg_list args, const int i, int& value, bool& parse_okay) {
 			if (!parse_okay) return false;
 			value = 0;
-			if (args[i].empty()) {
+			if (auto* number = args.GetNumber(i)) {
+				if (number->is_int) {
+					value = number->int_value;
+					parse_okay = true;
+					return parse_okay;
+				}
+			}
+			if (args[i].empty() || parse_int(args[i], value)) {
 				parse_okay = true;
 				return parse_okay;
 			}
@@ -134,21 +243,47 @@ public:
 	void Load(int slot);
 	void Save(int slot);
 
+	/**
+	 * Registers a DynRPG function. A name can be registered by multiple
+	 * plugins, they are tried in registration order until one handles the
+	 * call.
+	 *
+	 * @param name function name (lower case)
+	 * @param handler function, returns false when the call was not handled
+	 */
+	void RegisterFunction(std::string_view name, dyn_handler handler);
+	void RegisterFunction(std::string_view name, dynfunc func);
+
+	/**
+	 * @param name function name (lower case)
+	 * @return id of the function, -1 when not registered
+	 */
+	dyn_func_id GetFunctionId(std::string_view name) const;
+
 private:
 	friend DynRpg::EasyRpgPlugin;
 
 	bool Invoke(std::string_view func, dyn_arg_list args, Game_Interpreter* interpreter = nullptr);
+	bool Invoke(dyn_func_id id, std::string_view func, dyn_arg_list args, Game_Interpreter* interpreter);
+	/** @return Whether a handler of the function handled the call */
+	bool CallFunction(dyn_func_id id, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter);
 	void InitPlugins();
 
-	using dyn_rpg_func = std::unordered_map<std::string, dynfunc>;
-
 	bool plugins_loaded = false;
 
 	// Registered DynRpg Plugins
 	std::vector<std::unique_ptr<DynRpgPlugin>> plugins;
 
-	// DynRpg Function table
-	dyn_rpg_func dyn_rpg_functions;
+	// DynRpg Function table, indexed by dyn_func_id, handlers in registration order
+	std::vector<std::vector<dyn_handler>> dyn_rpg_functions;
+	// The keys point into function_names, a lookup does not allocate
+	std::deque<std::string> function_names;
+	std::unordered_map<std::string_view, dyn_func_id> dyn_rpg_function_ids;
+
+	// Parsed commands by comment text, the amount is bounded by the comments of the game
+	// The keys point into command_texts, a lookup does not allocate
+	std::deque<std::string> command_texts;
+	std::unordered_map<std::string_view, DynRpg::ParsedCommand> command_cache;
 };
 
 /** Base class for implementing a DynRpg Plugins */
@@ -159,7 +294,8 @@ public:
 	virtual ~DynRpgPlugin() = default;
 
 	std::string_view GetIdentifier() const { return identifier; }
-	virtual bool Invoke(std::string_view func, dyn_arg_list args, bool& do_yield, Game_Interpreter* interpreter) = 0;
+	/** Registers the functions of the plugin in the function table of the instance */
+	virtual void RegisterFunctions() = 0;
 	virtual void Update() {}
 	virtual void Load(const std::vector<uint8_t>&) {}
 	virtual std::vector<uint8_t> Save() { return {}; }
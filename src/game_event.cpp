@@ -46,8 +46,7 @@ Game_Event::Game_Event(int map_id, const lcf::rpg::Event* event) :
 	SetY(event->y);
 
 	if (true) { //TODO - PIXELMOVE
-		real_x = (float)GetX();
-		real_y = (float)GetY();
+		SetRealPosition((float)GetX(), (float)GetY());
 		//Output::Warning("Event Pos = {}x{}", real_x, real_y);
 	}// END - PIXELMOVE
 
@@ -105,8 +104,7 @@ void Game_Event::SetSaveData(lcf::rpg::SaveMapEvent save)
 	}
 
     if (true) { // TODO - PIXELMOVE
-		real_x = (float)GetX();
-		real_y = (float)GetY();
+		SetRealPosition((float)GetX(), (float)GetY());
 	} // END - PIXELMOVE
 
 }
@@ -57,6 +57,7 @@
 #include <lcf/scope_guard.h>
 #include <lcf/rpg/save.h>
 #include "scene_gameover.h"
+#include "spatial_hash.h"
 #include "feature.h"
 
 namespace {
@@ -84,6 +85,13 @@ namespace {
 	std::vector<unsigned char> passages_down;
 	std::vector<unsigned char> passages_up;
 	std::vector<Game_Event> events;
+	// Pixel movement broadphase, items are indices into events
+	SpatialHash event_grid;
+	std::vector<int> event_grid_query;
+	// Events per tile in ascending order, the last list holds the events outside of the map
+	std::vector<int> tile_event_head;
+	std::vector<int> event_tile;
+	std::vector<int> event_tile_next;
 	std::vector<Game_CommonEvent> common_events;
 	std::unique_ptr<Game_Map::Caching::MapCache> map_cache;
 
@@ -148,6 +156,10 @@ void Game_Map::InitCommonEvents() {
 
 void Game_Map::Dispose() {
 	events.clear();
+	event_grid.Reset(0, 0);
+	tile_event_head.clear();
+	event_tile.clear();
+	event_tile_next.clear();
 	map.reset();
 	map_info = {};
 	panorama = {};
@@ -288,6 +300,9 @@ void Game_Map::SetupFromSave(
 		}
 		if (destroyed_event_ids.size() > 0) {
 			UpdateUnderlyingEventReferences();
+		} else {
+			// The positions were restored from the save
+			RebuildEventIndex();
 		}
 	}
 
@@ -421,6 +436,7 @@ void Game_Map::CreateMapEvents() {
 		events.emplace_back(GetMapId(), &ev);
 		AddEventToCache(ev);
 	}
+	RebuildEventIndex();
 }
 
 void Game_Map::AddEventToCache(const lcf::rpg::Event& ev) {
@@ -589,6 +605,100 @@ void Game_Map::UpdateUnderlyingEventReferences() {
 	}
 
 	Main_Data::game_screen->UpdateUnderlyingEventReferences();
+
+	RebuildEventIndex();
+}
+
+static int GetEventIndex(const Game_Event& ev) {
+	// Events under construction are not in the list yet
+	if (events.empty() || &ev < events.data() || &ev >= events.data() + events.size()) {
+		return -1;
+	}
+	return static_cast<int>(&ev - events.data());
+}
+
+static int GetEventTileIndex(int x, int y) {
+	if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+		return map->width * map->height;
+	}
+	return y * map->width + x;
+}
+
+static void LinkEventTile(int index, int tile) {
+	int* link = &tile_event_head[tile];
+	while (*link >= 0 && *link < index) {
+		link = &event_tile_next[*link];
+	}
+	event_tile_next[index] = *link;
+	*link = index;
+	event_tile[index] = tile;
+}
+
+static void UnlinkEventTile(int index) {
+	int* link = &tile_event_head[event_tile[index]];
+	while (*link != index) {
+		link = &event_tile_next[*link];
+	}
+	*link = event_tile_next[index];
+}
+
+void Game_Map::RebuildEventIndex() {
+	tile_event_head.clear();
+	event_tile.clear();
+	event_tile_next.clear();
+
+	if (!map) {
+		event_grid.Reset(0, 0);
+		return;
+	}
+
+	event_grid.Reset(GetTilesX(), GetTilesY());
+	tile_event_head.assign(GetTilesX() * GetTilesY() + 1, -1);
+	event_tile.resize(events.size());
+	event_tile_next.resize(events.size());
+	for (size_t i = 0; i < events.size(); ++i) {
+		event_grid.Update(static_cast<int>(i), events[i].real_x + 0.5f, events[i].real_y + 0.5f);
+		LinkEventTile(static_cast<int>(i), GetEventTileIndex(events[i].GetX(), events[i].GetY()));
+	}
+}
+
+void Game_Map::UpdateEventTile(const Game_Event& ev) {
+	const int index = GetEventIndex(ev);
+	if (index < 0 || index >= static_cast<int>(event_tile.size())) {
+		return;
+	}
+
+	const int tile = GetEventTileIndex(ev.GetX(), ev.GetY());
+	if (event_tile[index] != tile) {
+		UnlinkEventTile(index);
+		LinkEventTile(index, tile);
+	}
+}
+
+int Game_Map::GetFirstEventIndexAt(int x, int y) {
+	if (tile_event_head.empty()) {
+		return -1;
+	}
+	return tile_event_head[GetEventTileIndex(x, y)];
+}
+
+int Game_Map::GetNextEventIndexAt(int index) {
+	return event_tile_next[index];
+}
+
+void Game_Map::UpdateEventGridPosition(const Game_Event& ev) {
+	const int index = GetEventIndex(ev);
+	if (index >= 0) {
+		event_grid.Update(index, ev.real_x + 0.5f, ev.real_y + 0.5f);
+	}
+}
+
+const std::vector<int>& Game_Map::GetEventIndicesNear(float x, float y, float radius) {
+	event_grid_query.clear();
+	event_grid.Query(x, y, radius, event_grid_query);
+	// Keep the event order of a full scan
+	std::sort(event_grid_query.begin(), event_grid_query.end());
+	return event_grid_query;
 }
 
 const lcf::rpg::Event* Game_Map::FindEventById(const std::vector<lcf::rpg::Event>& events, int eventId) {
@@ -916,17 +1026,27 @@ bool Game_Map::CheckOrMakeWayEx(const Game_Character& self,
 	}
 	if (vehicle_type != Game_Vehicle::Airship && check_events_and_vehicles) {
 		// Check for collision with events on the target tile.
-		if (ignore_some_events_by_id.empty()) {
-			for (auto& other: GetEvents()) {
-				if (CheckOrMakeCollideEvent(other)) {
+		auto CheckOrMakeCollideMapEvent = [&](Game_Event& other) {
+			if (std::find(ignore_some_events_by_id.begin(), ignore_some_events_by_id.end(), other.GetId()) != ignore_some_events_by_id.end()) {
+				return false;
+			}
+			return CheckOrMakeCollideEvent(other);
+		};
+		if (make_way) {
+			// Making way updates the other events, which can move them
+			// between tiles, so the candidates are collected first.
+			std::vector<int> candidates;
+			for (int idx = GetFirstEventIndexAt(to_x, to_y); idx >= 0; idx = GetNextEventIndexAt(idx)) {
+				candidates.push_back(idx);
+			}
+			for (int idx: candidates) {
+				if (CheckOrMakeCollideMapEvent(events[idx])) {
 					return false;
 				}
 			}
 		} else {
-			for (auto& other: GetEvents()) {
-				if (std::find(ignore_some_events_by_id.begin(), ignore_some_events_by_id.end(), other.GetId()) != ignore_some_events_by_id.end())
-					continue;
-				if (CheckOrMakeCollideEvent(other)) {
+			for (int idx = GetFirstEventIndexAt(to_x, to_y); idx >= 0; idx = GetNextEventIndexAt(idx)) {
+				if (CheckOrMakeCollideMapEvent(events[idx])) {
 					return false;
 				}
 			}
@@ -986,7 +1106,8 @@ bool Game_Map::CanLandAirship(int x, int y) {
 		return false;
 	}
 
-	for (auto& ev: events) {
+	for (int idx = GetFirstEventIndexAt(x, y); idx >= 0; idx = GetNextEventIndexAt(idx)) {
+		auto& ev = events[idx];
 		if (ev.IsInPosition(x, y)
 				&& ev.IsActive()
 				&& ev.GetActivePage() != nullptr) {
@@ -1024,7 +1145,8 @@ bool Game_Map::CanDisembarkShip(Game_Player& player, int x, int y) {
 		return false;
 	}
 
-	for (auto& ev: GetEvents()) {
+	for (int idx = GetFirstEventIndexAt(x, y); idx >= 0; idx = GetNextEventIndexAt(idx)) {
+		auto& ev = events[idx];
 		if (ev.IsInPosition(x, y)
 			&& ev.GetLayer() == lcf::rpg::EventPage::Layers_same
 			&& ev.IsActive()
@@ -1102,7 +1224,8 @@ bool Game_Map::IsPassableTile(
 
 		// Highest ID event with layer=below, not through, and a tile graphic wins.
 		int event_tile_id = 0;
-		for (auto& ev: events) {
+		for (int idx = GetFirstEventIndexAt(x, y); idx >= 0; idx = GetNextEventIndexAt(idx)) {
+			auto& ev = events[idx];
 			if (self == &ev) {
 				continue;
 			}
@@ -1216,14 +1339,15 @@ int Game_Map::GetTerrainTag(int x, int y) {
 }
 
 Game_Event* Game_Map::GetEventAt(int x, int y, bool require_active) {
-	auto& events = GetEvents();
-	for (auto iter = events.rbegin(); iter != events.rend(); ++iter) {
-		auto& ev = *iter;
+	// The last match has the highest ID
+	Game_Event* found = nullptr;
+	for (int idx = GetFirstEventIndexAt(x, y); idx >= 0; idx = GetNextEventIndexAt(idx)) {
+		auto& ev = events[idx];
 		if (ev.IsInPosition(x, y) && (!require_active || ev.IsActive())) {
-			return &ev;
+			found = &ev;
 		}
 	}
-	return nullptr;
+	return found;
 }
 
 bool Game_Map::LoopHorizontal() {
@@ -1275,7 +1399,8 @@ int Game_Map::YwithDirection(int y, int direction) {
 }
 
 int Game_Map::CheckEvent(int x, int y) {
-	for (const Game_Event& ev : events) {
+	for (int idx = GetFirstEventIndexAt(x, y); idx >= 0; idx = GetNextEventIndexAt(idx)) {
+		const Game_Event& ev = events[idx];
 		if (ev.IsInPosition(x, y)) {
 			return ev.GetId();
 		}
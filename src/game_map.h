@@ -139,6 +139,54 @@ namespace Game_Map {
 	void TranslateMapMessages(int mapId, lcf::rpg::Map& map);
 	void CreateMapEvents();
 	void UpdateUnderlyingEventReferences();
+
+	/** Rebuilds the tile index and the collision grid of the map events from their positions. */
+	void RebuildEventIndex();
+
+	/**
+	 * Moves a map event in the tile index to its current tile.
+	 * Events which are not stored in the map event list are ignored.
+	 *
+	 * @param ev map event
+	 */
+	void UpdateEventTile(const Game_Event& ev);
+
+	/**
+	 * Gets the first map event on a tile, the others follow through
+	 * GetNextEventIndexAt in ascending order. All tiles outside of the map
+	 * share one list, so the position must still be checked.
+	 *
+	 * @param x tile x
+	 * @param y tile y
+	 * @return index into GetEvents(), -1 when none
+	 */
+	int GetFirstEventIndexAt(int x, int y);
+
+	/**
+	 * @param index index into GetEvents()
+	 * @return index of the next map event on the same tile, -1 when none
+	 */
+	int GetNextEventIndexAt(int index);
+
+	/**
+	 * Moves a map event in the collision grid to its current position.
+	 * Events which are not stored in the map event list are ignored.
+	 *
+	 * @param ev map event
+	 */
+	void UpdateEventGridPosition(const Game_Event& ev);
+
+	/**
+	 * Gets the map events near a pixel movement position.
+	 * Every event whose center is within the radius is returned, events
+	 * further away can be returned too.
+	 *
+	 * @param x center x in tiles
+	 * @param y center y in tiles
+	 * @param radius search radius in tiles
+	 * @return ascending indices into GetEvents(), valid until the next call
+	 */
+	const std::vector<int>& GetEventIndicesNear(float x, float y, float radius);
 	void AddEventToCache(const lcf::rpg::Event& ev);
 	void RemoveEventFromCache(const lcf::rpg::Event& ev);
 	const lcf::rpg::Event* FindEventById(const std::vector<lcf::rpg::Event>& events, int event_id);
@@ -63,8 +63,7 @@ void Game_Player::SetSaveData(lcf::rpg::SavePartyLocation save)
 
 
 	if (true) { // TODO - PIXELMOVE
-		real_x = (float)GetX();
-		real_y = (float)GetY();
+		SetRealPosition((float)GetX(), (float)GetY());
 	} // END - PIXELMOVE
 
 }
@@ -866,7 +865,9 @@ bool Game_Player::CheckEventTriggerHere(TriggerSet triggers, bool triggered_by_d
 		self.p = c2V(((float)GetX() / (float)SCREEN_TILE_SIZE) + 0.5, ((float)GetY() / (float)SCREEN_TILE_SIZE) + 0.5);
 		self.r = 0.25 - Epsilon;
 		other.r = 0.5;
-		for (auto& ev : Game_Map::GetEvents()) {
+		auto& events = Game_Map::GetEvents();
+		for (int idx : Game_Map::GetEventIndicesNear(self.p.x, self.p.y, self.r + other.r)) {
+			auto& ev = events[idx];
 			const auto trigger = ev.GetTrigger();
 			other.p = c2V(ev.real_x + 0.5, ev.real_y + 0.5);
 			if (ev.IsActive()
@@ -907,7 +908,9 @@ bool Game_Player::CheckEventTriggerThere(TriggerSet triggers, int x, int y, bool
 	}
 	bool result = false;
 
-	for (auto& ev : Game_Map::GetEvents()) {
+	auto& events = Game_Map::GetEvents();
+	for (int idx = Game_Map::GetFirstEventIndexAt(x, y); idx >= 0; idx = Game_Map::GetNextEventIndexAt(idx)) {
+		auto& ev = events[idx];
 		const auto trigger = ev.GetTrigger();
 		if (ev.IsActive()
 				&& ev.GetX() == x
@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include "game_system.h"
@@ -25,6 +26,8 @@
 #include "baseui.h"
 #include "bitmap.h"
 #include "cache.h"
+#include "filefinder.h"
+#include "font.h"
 #include "output.h"
 #include "game_ineluki.h"
 #include "transition.h"
@@ -217,6 +220,46 @@ void Game_System::SePlay(const lcf::rpg::Animation &animation) {
 	}
 }
 
+void Game_System::SePredecode(std::vector<std::string> names) {
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+
+	for (auto& name : names) {
+		if (AudioSeCache::IsFull()) {
+			return;
+		}
+
+		// Stop sounds and Ineluki files are not decoded
+		if (name.empty() || (StartsWith(name, '(') && EndsWith(name, ')')) ||
+			EndsWith(name, ".script") || EndsWith(name, ".link")) {
+			continue;
+		}
+
+		if (AudioSeCache::IsCached(name) || se_predecode_request_ids.find(name) != se_predecode_request_ids.end()) {
+			continue;
+		}
+
+		FileRequestAsync* request = AsyncHandler::RequestFile("Sound", name);
+		se_predecode_request_ids[name] = request->Bind(&Game_System::OnSePredecodeReady, this);
+		request->Start();
+	}
+}
+
+void Game_System::CollectSeNames(const std::vector<lcf::rpg::EventCommand>& commands, std::vector<std::string>& names) {
+	for (const auto& com : commands) {
+		if (com.code != static_cast<int>(lcf::rpg::EventCommand::Code::PlaySound)) {
+			continue;
+		}
+
+		// Maniac Patch: Name is read from a string variable
+		if (Player::IsPatchManiac() && com.parameters.size() >= 5 && (com.parameters[3] & 0xF) != 0) {
+			continue;
+		}
+
+		names.push_back(ToString(com.string));
+	}
+}
+
 std::string_view Game_System::GetSystemName() {
 	return !data.graphics_name.empty() ?
 		std::string_view(data.graphics_name) : std::string_view(lcf::Data::system.system_name);
@@ -224,6 +267,7 @@ std::string_view Game_System::GetSystemName() {
 
 void Game_System::OnChangeSystemGraphicReady(FileRequestResult* result) {
 	Cache::SetSystemName(result->file);
+	Font::ClearSystemMasks();
 	bg_color = Cache::SystemOrBlack()->GetBackgroundColor();
 
 	Scene_Map* scene = (Scene_Map*)Scene::Find(Scene::Map).get();
@@ -621,6 +665,27 @@ void Game_System::OnSeReady(FileRequestResult* result, lcf::rpg::Sound se, bool
 	Audio().SE_Play(std::move(se_cache), se.volume, se.tempo, se.balance);
 }
 
+void Game_System::OnSePredecodeReady(FileRequestResult* result) {
+	auto item = se_predecode_request_ids.find(result->file);
+	if (item != se_predecode_request_ids.end()) {
+		se_predecode_request_ids.erase(item);
+	}
+
+	if (AudioSeCache::IsCached(result->file)) {
+		return;
+	}
+
+	auto stream = FileFinder::OpenSound(result->file);
+	if (!stream) {
+		return;
+	}
+
+	auto se_cache = AudioSeCache::Create(std::move(stream), result->file);
+	if (se_cache) {
+		se_cache->Predecode();
+	}
+}
+
 void Game_System::OnSeInelukiReady(FileRequestResult* result, lcf::rpg::Sound se) {
 	auto item = se_request_ids.find(result->file);
 	if (item != se_request_ids.end()) {
@@ -21,7 +21,9 @@
 // Headers
 #include <string>
 #include <map>
+#include <vector>
 #include <lcf/rpg/animation.h>
+#include <lcf/rpg/eventcommand.h>
 #include <lcf/rpg/music.h>
 #include <lcf/rpg/sound.h>
 #include <lcf/rpg/system.h>
@@ -135,6 +137,23 @@ public:
 	 */
 	void SePlay(const lcf::rpg::Animation& animation);
 
+	/**
+	 * Decodes sound effects into the SE cache without playing them, so the
+	 * first play does not wait for the decoder.
+	 * Stops when the memory limit of the SE cache is reached.
+	 *
+	 * @param names sound names, duplicates are ignored
+	 */
+	void SePredecode(std::vector<std::string> names);
+
+	/**
+	 * Collects the sounds of all "Play Sound" commands with a constant name.
+	 *
+	 * @param commands event commands to scan
+	 * @param names receives the sound names
+	 */
+	static void CollectSeNames(const std::vector<lcf::rpg::EventCommand>& commands, std::vector<std::string>& names);
+
 	/** @return system graphic filename.  */
 	std::string_view GetSystemName();
 
@@ -443,6 +462,7 @@ private:
 	void OnBgmInelukiReady(FileRequestResult* result);
 	void OnSeReady(FileRequestResult* result, lcf::rpg::Sound se, bool stop_sounds);
 	void OnSeInelukiReady(FileRequestResult* result, lcf::rpg::Sound se);
+	void OnSePredecodeReady(FileRequestResult* result);
 	void OnChangeSystemGraphicReady(FileRequestResult* result);
 private:
 	lcf::rpg::SaveSystem data;
@@ -450,6 +470,7 @@ private:
 	FileRequestBinding music_request_id;
 	FileRequestBinding system_request_id;
 	std::map<std::string, FileRequestBinding> se_request_ids;
+	std::map<std::string, FileRequestBinding> se_predecode_request_ids;
 	Color bg_color = Color{ 0, 0, 0, 255 };
 	bool bgm_pending = false;
 	int loaded_frame_count = 0;
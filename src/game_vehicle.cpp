@@ -69,8 +69,7 @@ Game_Vehicle::Game_Vehicle(Type type)
 
 
 //	if (true) { // TODO - PIXELMOVE
-		real_x = (float)GetX();
-		real_y = (float)GetY();
+		SetRealPosition((float)GetX(), (float)GetY());
 //	} // END PIXELMOVE
 
 }
@@ -138,8 +137,7 @@ void Game_Vehicle::SyncWithRider(const Game_Character* rider) {
 	SetRemainingStep(rider->GetRemainingStep());
 
         if (true) { // TODO - PIXELMOVE
-		real_x = rider->real_x;
-		real_y = rider->real_y;
+		SetRealPosition(rider->real_x, rider->real_y);
         } // END - PIXELMOVE
 
 
@@ -33,6 +33,9 @@
 #include <lcf/reader_lcf.h>
 #include <lcf/reader_util.h>
 #include <lcf/writer_lcf.h>
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
 #include <vector>
 
 /*
@@ -177,431 +180,654 @@ struct ProcessAssignmentRet {
 	}
 };
 
-ProcessAssignmentRet ProcessAssignment(std::vector<int32_t>::iterator& it, std::vector<int32_t>::iterator end, const Game_BaseInterpreterContext& ip);
+namespace {
+	/** Instruction of a compiled expression, operands are taken from the stack */
+	enum class Code : uint8_t {
+		/** Pushes arg */
+		Push,
+		Var,
+		Switch,
+		VarIndirect,
+		SwitchIndirect,
+		Negate,
+		Not,
+		Flip,
+		Add,
+		Sub,
+		Mul,
+		Div,
+		Mod,
+		BitOr,
+		BitAnd,
+		BitXor,
+		BitShiftLeft,
+		BitShiftRight,
+		Equal,
+		GreaterEqual,
+		LessEqual,
+		Greater,
+		Less,
+		NotEqual,
+		Or,
+		And,
+		Ternary,
+		/** Inplace operation arg on the lvalue, operands are the lvalue id and the value */
+		Inplace,
+		/** Calls the function arg */
+		Function,
+		/** Replaces arg values with 0 */
+		Discard
+	};
+	// The binary operations are in the same order as in Op
+	static_assert(static_cast<int>(Code::And) - static_cast<int>(Code::Add) == static_cast<int>(Op::And) - static_cast<int>(Op::Add));
+
+	struct Instruction {
+		Code code;
+		/** Type of the lvalue of Code::Inplace */
+		Op lvalue;
+		int32_t arg;
+	};
 
-int Process(std::vector<int32_t>::iterator& it, std::vector<int32_t>::iterator end, const Game_BaseInterpreterContext& ip) {
-	int value = 0;
-	int imm = 0;
-	int imm2 = 0;
-	int imm3 = 0;
+	/** Expression compiled to a stack machine program */
+	struct Program {
+		/** Op codes the program was compiled from */
+		std::vector<int32_t> source;
+		std::vector<Instruction> code;
+		/** Maximum stack size while executing */
+		int max_depth = 0;
+	};
 
-	if (it == end) {
-		return 0;
-	}
+	struct FunctionInfo {
+		const char* name;
+		int args;
+	};
 
-	auto op = static_cast<Op>(*it);
-	++it;
+	/** Indexed by Fn */
+	constexpr FunctionInfo functions[] = {
+		{ "rnd", 2 },
+		{ "item", 2 },
+		{ "event", 2 },
+		{ "actor", 2 },
+		{ "member", 2 },
+		{ "enemy", 2 },
+		{ "misc", 1 },
+		{ "pow", 2 },
+		{ "sqrt", 2 },
+		{ "sin", 3 },
+		{ "cos", 3 },
+		{ "atan2", 3 },
+		{ "min", 2 },
+		{ "max", 2 },
+		{ "abs", 1 },
+		{ "clamp", 3 },
+		{ "muldiv", 3 },
+		{ "divmul", 3 },
+		{ "between", 3 }
+	};
+	static_assert(std::size(functions) == static_cast<size_t>(Fn::Between) + 1);
+
+	/**
+	 * Translates the byte stream of an expression into a Program.
+	 *
+	 * The parser consumes the bytes exactly like the former recursive
+	 * evaluator: malformed expressions produce the same values and all
+	 * validation warnings are reported once while compiling.
+	 */
+	class ExpressionCompiler {
+	public:
+		ExpressionCompiler(Span<const int32_t> op_codes, Program& prog) : prog(prog) {
+			for (auto& o : op_codes) {
+				auto uo = static_cast<uint32_t>(o);
+				ops.push_back(static_cast<int32_t>(uo & 0x000000FF));
+				ops.push_back(static_cast<int32_t>((uo & 0x0000FF00) >> 8));
+				ops.push_back(static_cast<int32_t>((uo & 0x00FF0000) >> 16));
+				ops.push_back(static_cast<int32_t>((uo & 0xFF000000) >> 24));
+			}
+		}
 
-	// When entering the switch it is on the first argument
-	switch (op) {
-		case Op::Null:
-			it++;
-			return 0;
-		case Op::U8:
-		case Op::UX8:
-			value = *it++;
-			return value;
-		case Op::U16:
-		case Op::UX16:
-			imm = *it++;
-			if (it == end) {
-				return 0;
+		void CompileSingle() {
+			Compile();
+		}
+
+		void CompileMultiple() {
+			if (ops.empty()) {
+				return;
 			}
-			imm2 = *it++;
-			value = (imm2 << 8) + imm;
-			return value;
-		case Op::S32:
-		case Op::SX32:
-			imm = *it++;
-			if (it == end) {
-				return 0;
+
+			while (true) {
+				Compile();
+
+				if (AtEnd() || static_cast<Op>(ops[pos]) == Op::Null) {
+					break;
+				}
 			}
-			imm2 = *it++;
-			if (it == end) {
-				return 0;
+		}
+
+	private:
+		bool AtEnd() const {
+			return pos >= ops.size();
+		}
+
+		int32_t Next() {
+			// Reads past the end are 0
+			return AtEnd() ? 0 : ops[pos++];
+		}
+
+		void Emit(Code code, int32_t arg = 0, Op lvalue = Op::Null) {
+			switch (code) {
+				case Code::Push:
+					++depth;
+					break;
+				case Code::Add:
+				case Code::Sub:
+				case Code::Mul:
+				case Code::Div:
+				case Code::Mod:
+				case Code::BitOr:
+				case Code::BitAnd:
+				case Code::BitXor:
+				case Code::BitShiftLeft:
+				case Code::BitShiftRight:
+				case Code::Equal:
+				case Code::GreaterEqual:
+				case Code::LessEqual:
+				case Code::Greater:
+				case Code::Less:
+				case Code::NotEqual:
+				case Code::Or:
+				case Code::And:
+				case Code::Inplace:
+					--depth;
+					break;
+				case Code::Ternary:
+					depth -= 2;
+					break;
+				case Code::Function:
+					depth -= functions[arg].args - 1;
+					break;
+				case Code::Discard:
+					depth -= arg - 1;
+					break;
+				default:
+					break;
 			}
-			imm3 = *it++;
-			if (it == end) {
-				return 0;
+			prog.max_depth = std::max(prog.max_depth, depth);
+			prog.code.push_back({ code, lvalue, arg });
+		}
+
+		void Compile() {
+			if (AtEnd()) {
+				Emit(Code::Push, 0);
+				return;
 			}
-			value = *it++;
-			value = (value << 24) + (imm3 << 16) + (imm2 << 8) + imm;
-			return value;
-		case Op::Var:
-			imm = Process(it, end, ip);
-			return Main_Data::game_variables->Get(imm);
-		case Op::Switch:
-			imm = Process(it, end, ip);
-			return Main_Data::game_switches->GetInt(imm);
-		case Op::VarIndirect:
-			imm = Process(it, end, ip);
-			return Main_Data::game_variables->GetIndirect(imm);
-		case Op::SwitchIndirect:
-			imm = Process(it, end, ip);
-			return Main_Data::game_switches->GetInt(Main_Data::game_variables->Get(imm));
-		case Op::Negate:
-			imm = Process(it, end, ip);
-			return -imm;
-		case Op::Not:
-			imm = Process(it, end, ip);
-			return !imm ? 0 : 1;
-		case Op::Flip:
-			imm = Process(it, end, ip);
-			return ~imm;
-		case Op::AssignInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(imm2);
-		}
-		case Op::AddInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(static_cast<int32_t>(Utils::Clamp<int64_t>(static_cast<int64_t>(ret.fetch()) + imm2, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max())));
-		}
-		case Op::SubInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(static_cast<int32_t>(Utils::Clamp<int64_t>(static_cast<int64_t>(ret.fetch()) - imm2, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max())));
-		}
-		case Op::MulInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(static_cast<int32_t>(Utils::Clamp<int64_t>(static_cast<int64_t>(ret.fetch()) * imm2, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max())));
-		}
-		case Op::DivInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			if (imm2 == 0) {
-				return ret.fetch();
+
+			auto op = static_cast<Op>(ops[pos++]);
+
+			// When entering the switch it is on the first argument
+			switch (op) {
+				case Op::Null:
+					Next();
+					Emit(Code::Push, 0);
+					return;
+				case Op::U8:
+				case Op::UX8:
+					Emit(Code::Push, Next());
+					return;
+				case Op::U16:
+				case Op::UX16: {
+					uint32_t imm = Next();
+					if (AtEnd()) {
+						Emit(Code::Push, 0);
+						return;
+					}
+					uint32_t imm2 = Next();
+					Emit(Code::Push, static_cast<int32_t>((imm2 << 8) + imm));
+					return;
+				}
+				case Op::S32:
+				case Op::SX32: {
+					uint32_t value = 0;
+					for (int i = 0; i < 3; ++i) {
+						value += static_cast<uint32_t>(Next()) << (i * 8);
+						if (AtEnd()) {
+							Emit(Code::Push, 0);
+							return;
+						}
+					}
+					value += static_cast<uint32_t>(Next()) << 24;
+					Emit(Code::Push, static_cast<int32_t>(value));
+					return;
+				}
+				case Op::Var:
+					Compile();
+					Emit(Code::Var);
+					return;
+				case Op::Switch:
+					Compile();
+					Emit(Code::Switch);
+					return;
+				case Op::VarIndirect:
+					Compile();
+					Emit(Code::VarIndirect);
+					return;
+				case Op::SwitchIndirect:
+					Compile();
+					Emit(Code::SwitchIndirect);
+					return;
+				case Op::Negate:
+					Compile();
+					Emit(Code::Negate);
+					return;
+				case Op::Not:
+					Compile();
+					Emit(Code::Not);
+					return;
+				case Op::Flip:
+					Compile();
+					Emit(Code::Flip);
+					return;
+				case Op::AssignInplace:
+				case Op::AddInplace:
+				case Op::SubInplace:
+				case Op::MulInplace:
+				case Op::DivInplace:
+				case Op::ModInplace:
+				case Op::BitOrInplace:
+				case Op::BitAndInplace:
+				case Op::BitXorInplace:
+				case Op::BitShiftLeftInplace:
+				case Op::BitShiftRightInplace: {
+					Op lvalue = CompileAssignment();
+					Compile();
+					Emit(Code::Inplace, static_cast<int32_t>(op), lvalue);
+					return;
+				}
+				case Op::Add:
+				case Op::Sub:
+				case Op::Mul:
+				case Op::Div:
+				case Op::Mod:
+				case Op::BitOr:
+				case Op::BitAnd:
+				case Op::BitXor:
+				case Op::BitShiftLeft:
+				case Op::BitShiftRight:
+				case Op::Equal:
+				case Op::GreaterEqual:
+				case Op::LessEqual:
+				case Op::Greater:
+				case Op::Less:
+				case Op::NotEqual:
+				case Op::Or:
+				case Op::And:
+					Compile();
+					Compile();
+					Emit(static_cast<Code>(static_cast<int>(Code::Add) + static_cast<int>(op) - static_cast<int>(Op::Add)));
+					return;
+				case Op::Ternary:
+					Compile();
+					Compile();
+					Compile();
+					Emit(Code::Ternary);
+					return;
+				case Op::Function:
+					CompileFunction();
+					return;
+				default:
+					Output::Warning("Maniac: Expression contains unsupported operation {}", static_cast<int>(op));
+					Emit(Code::Push, 0);
+					return;
 			}
-			return ret.assign(ret.fetch() / imm2);
 		}
-		case Op::ModInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			if (imm2 == 0) {
-				return ret.fetch();
-			}
-			return ret.assign(ret.fetch() % imm2);
-		}
-		case Op::BitOrInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(ret.fetch() | imm2);
-		}
-		case Op::BitAndInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(ret.fetch() & imm2);
-		}
-		case Op::BitXorInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(ret.fetch() ^ imm2);
-		}
-		case Op::BitShiftLeftInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(ret.fetch() << imm2);
-		}
-		case Op::BitShiftRightInplace: {
-			auto ret = ProcessAssignment(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return ret.assign(ret.fetch() >> imm2);
-		}
-		case Op::Add:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return static_cast<int32_t>(Utils::Clamp<int64_t>(static_cast<int64_t>(imm) + imm2, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
-		case Op::Sub:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return static_cast<int32_t>(Utils::Clamp<int64_t>(static_cast<int64_t>(imm) - imm2, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
-		case Op::Mul:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return static_cast<int32_t>(Utils::Clamp<int64_t>(static_cast<int64_t>(imm) * imm2, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
-		case Op::Div:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			if (imm2 == 0) {
-				return imm;
+
+		Op CompileAssignment() {
+			// Like Compile but it remembers the type (Variable or Switch) to allow assignments
+			if (AtEnd()) {
+				Emit(Code::Push, 0);
+				return Op::Null;
 			}
-			return imm / imm2;
-		case Op::Mod:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			if (imm2 == 0) {
-				return imm;
+
+			auto op = static_cast<Op>(ops[pos]);
+
+			switch (op) {
+				case Op::Var:
+				case Op::Switch:
+				case Op::VarIndirect:
+				case Op::SwitchIndirect:
+					++pos;
+					Compile();
+					return op;
+				default:
+					Compile();
+					return op;
 			}
-			return imm % imm2;
-		case Op::BitOr:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm | imm2;
-		case Op::BitAnd:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm & imm2;
-		case Op::BitXor:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm ^ imm2;
-		case Op::BitShiftLeft:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm << imm2;
-		case Op::BitShiftRight:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm >> imm2;
-		case Op::Equal:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm == imm2 ? 1 : 0;
-		case Op::GreaterEqual:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm >= imm2 ? 1 : 0;
-		case Op::LessEqual:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm <= imm2 ? 1 : 0;
-		case Op::Greater:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm > imm2 ? 1 : 0;
-		case Op::Less:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm < imm2 ? 1 : 0;
-		case Op::NotEqual:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return imm != imm2 ? 1 : 0;
-		case Op::Or:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return !!imm || !!imm2 ? 1 : 0;
-		case Op::And:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			return !!imm && !!imm2 ? 1 : 0;
-		case Op::Ternary:
-			imm = Process(it, end, ip);
-			imm2 = Process(it, end, ip);
-			imm3 = Process(it, end, ip);
-			return imm != 0 ? imm2 : imm3;
-		case Op::Function:
-			imm = *it++; // function
-			imm2 = *it++; // arguments
-
-			if ((imm2 & 0x80) != 0) {
+		}
+
+		void CompileFunction() {
+			int32_t fn = Next();
+			int32_t args = Next();
+
+			if ((args & 0x80) != 0) {
 				// Argument count is 4 bytes, that mode is not supported
 				Output::Warning("Maniac: Expression func long args unsupported");
-				return 0;
+				Emit(Code::Push, 0);
+				return;
 			}
 
-			switch (static_cast<Fn>(imm)) {
-				case Fn::Rand:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression rnd args {} != 2", imm2);
-						return 0;
-					}
-					imm3 = Process(it, end, ip);
-					return ControlVariables::Random(Process(it, end, ip), imm3);
-				case Fn::Item:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression item args {} != 2", imm2);
-						return 0;
-					}
-					imm3 = Process(it, end, ip);
-					return ControlVariables::Item(Process(it, end, ip), imm3);
-				case Fn::Event:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression event args {} != 2", imm2);
-						return 0;
-					}
-					imm3 = Process(it, end, ip);
-					return ControlVariables::Event(Process(it, end, ip), imm3, ip);
-				case Fn::Actor:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression actor args {} != 2", imm2);
-						return 0;
-					}
-					imm3 = Process(it, end, ip);
-					return ControlVariables::Actor(Process(it, end, ip), imm3);
-				case Fn::Party:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression member args {} != 2", imm2);
-						return 0;
-					}
-					imm3 = Process(it, end, ip);
-					return ControlVariables::Party(Process(it, end, ip), imm3);
-				case Fn::Enemy:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression enemy args {} != 2", imm2);
-						return 0;
-					}
-					imm3 = Process(it, end, ip);
-					return ControlVariables::Enemy(Process(it, end, ip), imm3);
-					break;
-				case Fn::Misc:
-					if (imm2 != 1) {
-						Output::Warning("Maniac: Expression misc args {} != 1", imm2);
-						return 0;
-					}
-					return ControlVariables::Other(Process(it, end, ip));
-				case Fn::Pow:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression pow args {} != 2", imm2);
-						return 0;
-					}
-					return ControlVariables::Pow(Process(it, end, ip), Process(it, end, ip));
-				case Fn::Sqrt:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression sqrt args {} != 2", imm2);
-						return 0;
-					}
-					return ControlVariables::Sqrt(Process(it, end, ip), Process(it, end, ip));
-				case Fn::Sin:
-					if (imm2 != 3) {
-						Output::Warning("Maniac: Expression sin args {} != 3", imm2);
-						return 0;
-					}
-					return ControlVariables::Sin(Process(it, end, ip), Process(it, end, ip), Process(it, end, ip));
-				case Fn::Cos:
-					if (imm2 != 3) {
-						Output::Warning("Maniac: Expression cos args {} != 3", imm2);
-						return 0;
-					}
-					return ControlVariables::Cos(Process(it, end, ip), Process(it, end, ip), Process(it, end, ip));
-				case Fn::Atan2:
-					if (imm2 != 3) {
-						Output::Warning("Maniac: Expression atan2 args {} != 3", imm2);
-						return 0;
-					}
-					return ControlVariables::Atan2(Process(it, end, ip), Process(it, end, ip), Process(it, end, ip));
-				case Fn::Min:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression min args {} != 2", imm2);
-						return 0;
-					}
-					return ControlVariables::Min(Process(it, end, ip), Process(it, end, ip));
-				case Fn::Max:
-					if (imm2 != 2) {
-						Output::Warning("Maniac: Expression max args {} != 2", imm2);
-						return 0;
-					}
-					return ControlVariables::Max(Process(it, end, ip), Process(it, end, ip));
-				case Fn::Abs:
-					if (imm2 != 1) {
-						Output::Warning("Maniac: Expression abs args {} != 1", imm2);
-						return 0;
-					}
-					return ControlVariables::Abs(Process(it, end, ip));
-				case Fn::Clamp:
-					if (imm2 != 3) {
-						Output::Warning("Maniac: Expression clamp args {} != 3", imm2);
-						return 0;
-					}
-					return ControlVariables::Clamp(Process(it, end, ip), Process(it, end, ip), Process(it, end, ip));
-				case Fn::Muldiv:
-					if (imm2 != 3) {
-						Output::Warning("Maniac: Expression muldiv args {} != 3", imm2);
-						return 0;
-					}
-					return ControlVariables::Muldiv(Process(it, end, ip), Process(it, end, ip), Process(it, end, ip));
-				case Fn::Divmul:
-					if (imm2 != 3) {
-						Output::Warning("Maniac: Expression divmul args {} != 3", imm2);
-						return 0;
-					}
-					return ControlVariables::Divmul(Process(it, end, ip), Process(it, end, ip), Process(it, end, ip));
-				case Fn::Between:
-					if (imm2 != 3) {
-						Output::Warning("Maniac: Expression between args {} != 3", imm2);
-						return 0;
-					}
-					return ControlVariables::Between(Process(it, end, ip), Process(it, end, ip), Process(it, end, ip));
-				default:
-					Output::Warning("Maniac: Expression Unknown Func {}", imm);
-					for (int i = 0; i < imm2; ++i) {
-						Process(it, end, ip);
-					}
-					return 0;
+			if (fn < 0 || fn >= static_cast<int>(std::size(functions))) {
+				Output::Warning("Maniac: Expression Unknown Func {}", fn);
+				for (int i = 0; i < args; ++i) {
+					Compile();
+				}
+				Emit(Code::Discard, args);
+				return;
 			}
-		default:
-			Output::Warning("Maniac: Expression contains unsupported operation {}", static_cast<int>(op));
-			return 0;
-	}
-}
 
-ProcessAssignmentRet ProcessAssignment(std::vector<int32_t>::iterator& it, std::vector<int32_t>::iterator end, const Game_BaseInterpreterContext& ip) {
-	// Like process but it remembers the type (Variable or Switch) without evaluating it to allow assignments
-	int imm = 0;
+			const auto& info = functions[fn];
+			if (args != info.args) {
+				// The arguments are not consumed and parsed as the following operations
+				Output::Warning("Maniac: Expression {} args {} != {}", info.name, args, info.args);
+				Emit(Code::Push, 0);
+				return;
+			}
 
-	if (it == end) {
-		return {Op::Null, 0};
-	}
+			for (int i = 0; i < args; ++i) {
+				Compile();
+			}
+			Emit(Code::Function, fn);
+		}
 
-	auto op = static_cast<Op>(*it);
-	++it;
+		std::vector<int32_t> ops;
+		size_t pos = 0;
+		int depth = 0;
+		Program& prog;
+	};
 
-	// When entering the switch it is on the first argument
-	switch (op) {
-		case Op::Var:
-		case Op::Switch:
-		case Op::VarIndirect:
-		case Op::SwitchIndirect:
-			imm = Process(it, end, ip);
-			return {op, imm};
-		default:
-			--it; // back on the op as op is fetched again by Process
-			imm = Process(it, end, ip);
-			return {op, imm};
+	int32_t SaturateCast(int64_t value) {
+		return static_cast<int32_t>(Utils::Clamp<int64_t>(value, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
 	}
-}
 
-int32_t ManiacPatch::ParseExpression(Span<const int32_t> op_codes, const Game_BaseInterpreterContext& interpreter) {
-	std::vector<int32_t> ops;
-	for (auto &o: op_codes) {
-		auto uo = static_cast<uint32_t>(o);
-		ops.push_back(static_cast<int32_t>(uo & 0x000000FF));
-		ops.push_back(static_cast<int32_t>((uo & 0x0000FF00) >> 8));
-		ops.push_back(static_cast<int32_t>((uo & 0x00FF0000) >> 16));
-		ops.push_back(static_cast<int32_t>((uo & 0xFF000000) >> 24));
+	int32_t Inplace(Op op, const ProcessAssignmentRet& ret, int32_t value) {
+		switch (op) {
+			case Op::AssignInplace:
+				return ret.assign(value);
+			case Op::AddInplace:
+				return ret.assign(SaturateCast(static_cast<int64_t>(ret.fetch()) + value));
+			case Op::SubInplace:
+				return ret.assign(SaturateCast(static_cast<int64_t>(ret.fetch()) - value));
+			case Op::MulInplace:
+				return ret.assign(SaturateCast(static_cast<int64_t>(ret.fetch()) * value));
+			case Op::DivInplace:
+				if (value == 0) {
+					return ret.fetch();
+				}
+				return ret.assign(ret.fetch() / value);
+			case Op::ModInplace:
+				if (value == 0) {
+					return ret.fetch();
+				}
+				return ret.assign(ret.fetch() % value);
+			case Op::BitOrInplace:
+				return ret.assign(ret.fetch() | value);
+			case Op::BitAndInplace:
+				return ret.assign(ret.fetch() & value);
+			case Op::BitXorInplace:
+				return ret.assign(ret.fetch() ^ value);
+			case Op::BitShiftLeftInplace:
+				return ret.assign(ret.fetch() << value);
+			case Op::BitShiftRightInplace:
+				return ret.assign(ret.fetch() >> value);
+			default:
+				return 0;
+		}
 	}
-	auto beg = ops.begin();
-	return Process(beg, ops.end(), interpreter);
-}
 
-std::vector<int32_t> ManiacPatch::ParseExpressions(Span<const int32_t> op_codes, const Game_BaseInterpreterContext& interpreter) {
-	std::vector<int32_t> ops;
-	for (auto& o : op_codes) {
-		auto uo = static_cast<uint32_t>(o);
-		ops.push_back(static_cast<int32_t>(uo & 0x000000FF));
-		ops.push_back(static_cast<int32_t>((uo & 0x0000FF00) >> 8));
-		ops.push_back(static_cast<int32_t>((uo & 0x00FF0000) >> 16));
-		ops.push_back(static_cast<int32_t>((uo & 0xFF000000) >> 24));
+	int32_t CallFunction(Fn fn, const int32_t* a, const Game_BaseInterpreterContext& ip) {
+		switch (fn) {
+			case Fn::Rand:
+				return ControlVariables::Random(a[1], a[0]);
+			case Fn::Item:
+				return ControlVariables::Item(a[1], a[0]);
+			case Fn::Event:
+				return ControlVariables::Event(a[1], a[0], ip);
+			case Fn::Actor:
+				return ControlVariables::Actor(a[1], a[0]);
+			case Fn::Party:
+				return ControlVariables::Party(a[1], a[0]);
+			case Fn::Enemy:
+				return ControlVariables::Enemy(a[1], a[0]);
+			case Fn::Misc:
+				return ControlVariables::Other(a[0]);
+			case Fn::Pow:
+				return ControlVariables::Pow(a[0], a[1]);
+			case Fn::Sqrt:
+				return ControlVariables::Sqrt(a[0], a[1]);
+			case Fn::Sin:
+				return ControlVariables::Sin(a[0], a[1], a[2]);
+			case Fn::Cos:
+				return ControlVariables::Cos(a[0], a[1], a[2]);
+			case Fn::Atan2:
+				return ControlVariables::Atan2(a[0], a[1], a[2]);
+			case Fn::Min:
+				return ControlVariables::Min(a[0], a[1]);
+			case Fn::Max:
+				return ControlVariables::Max(a[0], a[1]);
+			case Fn::Abs:
+				return ControlVariables::Abs(a[0]);
+			case Fn::Clamp:
+				return ControlVariables::Clamp(a[0], a[1], a[2]);
+			case Fn::Muldiv:
+				return ControlVariables::Muldiv(a[0], a[1], a[2]);
+			case Fn::Divmul:
+				return ControlVariables::Divmul(a[0], a[1], a[2]);
+			case Fn::Between:
+				return ControlVariables::Between(a[0], a[1], a[2]);
+		}
+		return 0;
 	}
 
-	if (ops.empty()) {
-		return {};
+	/**
+	 * Executes a compiled expression.
+	 *
+	 * @param prog program to execute
+	 * @param stack stack with space for prog.max_depth values
+	 * @param ip interpreter context
+	 * @return amount of values left on the stack, one per expression
+	 */
+	int Execute(const Program& prog, int32_t* stack, const Game_BaseInterpreterContext& ip) {
+		int32_t* sp = stack;
+
+		for (const auto& ins : prog.code) {
+			switch (ins.code) {
+				case Code::Push:
+					*sp++ = ins.arg;
+					break;
+				case Code::Var:
+					sp[-1] = Main_Data::game_variables->Get(sp[-1]);
+					break;
+				case Code::Switch:
+					sp[-1] = Main_Data::game_switches->GetInt(sp[-1]);
+					break;
+				case Code::VarIndirect:
+					sp[-1] = Main_Data::game_variables->GetIndirect(sp[-1]);
+					break;
+				case Code::SwitchIndirect:
+					sp[-1] = Main_Data::game_switches->GetInt(Main_Data::game_variables->Get(sp[-1]));
+					break;
+				case Code::Negate:
+					sp[-1] = -sp[-1];
+					break;
+				case Code::Not:
+					sp[-1] = !sp[-1] ? 0 : 1;
+					break;
+				case Code::Flip:
+					sp[-1] = ~sp[-1];
+					break;
+				case Code::Add:
+					--sp;
+					sp[-1] = SaturateCast(static_cast<int64_t>(sp[-1]) + sp[0]);
+					break;
+				case Code::Sub:
+					--sp;
+					sp[-1] = SaturateCast(static_cast<int64_t>(sp[-1]) - sp[0]);
+					break;
+				case Code::Mul:
+					--sp;
+					sp[-1] = SaturateCast(static_cast<int64_t>(sp[-1]) * sp[0]);
+					break;
+				case Code::Div:
+					--sp;
+					if (sp[0] != 0) {
+						sp[-1] /= sp[0];
+					}
+					break;
+				case Code::Mod:
+					--sp;
+					if (sp[0] != 0) {
+						sp[-1] %= sp[0];
+					}
+					break;
+				case Code::BitOr:
+					--sp;
+					sp[-1] |= sp[0];
+					break;
+				case Code::BitAnd:
+					--sp;
+					sp[-1] &= sp[0];
+					break;
+				case Code::BitXor:
+					--sp;
+					sp[-1] ^= sp[0];
+					break;
+				case Code::BitShiftLeft:
+					--sp;
+					sp[-1] <<= sp[0];
+					break;
+				case Code::BitShiftRight:
+					--sp;
+					sp[-1] >>= sp[0];
+					break;
+				case Code::Equal:
+					--sp;
+					sp[-1] = sp[-1] == sp[0] ? 1 : 0;
+					break;
+				case Code::GreaterEqual:
+					--sp;
+					sp[-1] = sp[-1] >= sp[0] ? 1 : 0;
+					break;
+				case Code::LessEqual:
+					--sp;
+					sp[-1] = sp[-1] <= sp[0] ? 1 : 0;
+					break;
+				case Code::Greater:
+					--sp;
+					sp[-1] = sp[-1] > sp[0] ? 1 : 0;
+					break;
+				case Code::Less:
+					--sp;
+					sp[-1] = sp[-1] < sp[0] ? 1 : 0;
+					break;
+				case Code::NotEqual:
+					--sp;
+					sp[-1] = sp[-1] != sp[0] ? 1 : 0;
+					break;
+				case Code::Or:
+					--sp;
+					sp[-1] = !!sp[-1] || !!sp[0] ? 1 : 0;
+					break;
+				case Code::And:
+					--sp;
+					sp[-1] = !!sp[-1] && !!sp[0] ? 1 : 0;
+					break;
+				case Code::Ternary:
+					sp -= 2;
+					sp[-1] = sp[-1] != 0 ? sp[0] : sp[1];
+					break;
+				case Code::Inplace:
+					--sp;
+					sp[-1] = Inplace(static_cast<Op>(ins.arg), { ins.lvalue, sp[-1] }, sp[0]);
+					break;
+				case Code::Function: {
+					int args = functions[ins.arg].args;
+					sp -= args;
+					*sp = CallFunction(static_cast<Fn>(ins.arg), sp, ip);
+					++sp;
+					break;
+				}
+				case Code::Discard:
+					sp -= ins.arg;
+					*sp++ = 0;
+					break;
+			}
+		}
+
+		return static_cast<int>(sp - stack);
 	}
 
-	auto it = ops.begin();
+	/** Compiled expressions by the address of their op codes, for single and multiple expressions */
+	std::unordered_map<const int32_t*, Program> expression_cache[2];
+	constexpr size_t expression_cache_limit = 4096;
 
-	std::vector<int32_t> results;
+	const Program& GetProgram(Span<const int32_t> op_codes, bool multiple) {
+		auto& cache = expression_cache[multiple ? 1 : 0];
+
+		auto it = cache.find(op_codes.data());
+		if (it != cache.end()) {
+			// The op codes are compared because the memory can be reused by another command
+			const auto& source = it->second.source;
+			if (source.size() == op_codes.size() && std::equal(source.begin(), source.end(), op_codes.begin())) {
+				return it->second;
+			}
+		} else if (cache.size() >= expression_cache_limit) {
+			cache.clear();
+		}
 
-	while (true) {
-		results.push_back(Process(it, ops.end(), interpreter));
+		auto& prog = cache[op_codes.data()];
+		prog = {};
+		prog.source.assign(op_codes.begin(), op_codes.end());
 
-		if (it == ops.end() || static_cast<Op>(*it) == Op::Null) {
-			break;
+		ExpressionCompiler compiler(op_codes, prog);
+		if (multiple) {
+			compiler.CompileMultiple();
+		} else {
+			compiler.CompileSingle();
 		}
+
+		return prog;
 	}
 
+	template <typename F>
+	void WithStack(const Program& prog, F&& f) {
+		std::array<int32_t, 64> stack;
+		if (prog.max_depth <= static_cast<int>(stack.size())) {
+			f(stack.data());
+		} else {
+			std::vector<int32_t> large_stack(prog.max_depth);
+			f(large_stack.data());
+		}
+	}
+}
+
+int32_t ManiacPatch::ParseExpression(Span<const int32_t> op_codes, const Game_BaseInterpreterContext& interpreter) {
+	const auto& prog = GetProgram(op_codes, false);
+
+	int32_t result = 0;
+	WithStack(prog, [&](int32_t* stack) {
+		if (Execute(prog, stack, interpreter) > 0) {
+			result = stack[0];
+		}
+	});
+	return result;
+}
+
+std::vector<int32_t> ManiacPatch::ParseExpressions(Span<const int32_t> op_codes, const Game_BaseInterpreterContext& interpreter) {
+	const auto& prog = GetProgram(op_codes, true);
+
+	std::vector<int32_t> results;
+	WithStack(prog, [&](int32_t* stack) {
+		int count = Execute(prog, stack, interpreter);
+		results.assign(stack, stack + count);
+	});
 	return results;
 }
 
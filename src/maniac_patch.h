@@ -28,7 +28,24 @@
 class Game_BaseInterpreterContext;
 
 namespace ManiacPatch {
+	/**
+	 * Evaluates an expression of an event command.
+	 * The expression is compiled on first use and cached by the address of
+	 * the op codes, so they should point into the event command.
+	 *
+	 * @param op_codes packed expression bytes
+	 * @param interpreter interpreter context
+	 * @return value of the expression
+	 */
 	int32_t ParseExpression(Span<const int32_t> op_codes, const Game_BaseInterpreterContext& interpreter);
+
+	/**
+	 * Evaluates a list of expressions, like ParseExpression.
+	 *
+	 * @param op_codes packed expression bytes
+	 * @param interpreter interpreter context
+	 * @return value of every expression
+	 */
 	std::vector<int32_t> ParseExpressions(Span<const int32_t> op_codes, const Game_BaseInterpreterContext& interpreter);
 
 	std::array<bool, 50> GetKeyRange();
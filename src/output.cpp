@@ -22,7 +22,9 @@
 #include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include <chrono>
 #include <fmt/color.h>
 #include <fmt/ostream.h>
@@ -103,6 +105,16 @@ namespace {
 
 	LogCallbackFn log_cb = LogCallback;
 	LogCallbackUserData log_cb_udata = nullptr;
+
+	// Messages of worker threads, written by the main thread
+	struct WorkerMessage {
+		LogLevel lvl;
+		std::string msg;
+		Color color;
+	};
+	thread_local bool is_worker_thread = false;
+	std::mutex worker_messages_mutex;
+	std::vector<WorkerMessage> worker_messages;
 }
 
 std::string Output::LogLevelToString(LogLevel lvl) {
@@ -136,6 +148,13 @@ void Output::SetLogCallback(LogCallbackFn fn, LogCallbackUserData userdata) {
 }
 
 static void WriteLog(LogLevel lvl, std::string const& msg, Color const& c = Color()) {
+	if (is_worker_thread) {
+		std::lock_guard<std::mutex> lock(worker_messages_mutex);
+		worker_messages.push_back({lvl, msg, c});
+		return;
+	}
+	Output::FlushWorkerMessages();
+
 // skip writing log file
 #ifndef EMSCRIPTEN
 	std::string prefix = Output::LogLevelToString(lvl) + ": ";
@@ -166,6 +185,25 @@ static void WriteLog(LogLevel lvl, std::string const& msg, Color const& c = Colo
 	}
 }
 
+void Output::SetWorkerThread() {
+	is_worker_thread = true;
+}
+
+void Output::FlushWorkerMessages() {
+	std::vector<WorkerMessage> messages;
+	{
+		std::lock_guard<std::mutex> lock(worker_messages_mutex);
+		if (worker_messages.empty()) {
+			return;
+		}
+		messages.swap(worker_messages);
+	}
+
+	for (auto& m : messages) {
+		WriteLog(m.lvl, m.msg, m.color);
+	}
+}
+
 static void HandleErrorOutput(const std::string& err) {
 	// Drawing directly on the screen because message_overlay is not visible
 	// when faded out
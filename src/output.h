@@ -119,6 +119,19 @@ namespace Output {
 	/** @return the Loglevel as string */
 	std::string LogLevelToString(LogLevel lvl);
 
+	/**
+	 * Marks the calling thread as a worker thread.
+	 * Messages of worker threads are queued and written by the main thread
+	 * with its next message or by FlushWorkerMessages.
+	 */
+	void SetWorkerThread();
+
+	/**
+	 * Writes the queued messages of worker threads.
+	 * Must be called by the main thread.
+	 */
+	void FlushWorkerMessages();
+
 	/**
 	 * Displays an info string with formatted string.
 	 *
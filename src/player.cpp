@@ -29,6 +29,7 @@
 #  include <emscripten.h>
 #endif
 
+#include "asset_prefetch.h"
 #include "async_handler.h"
 #include "audio.h"
 #include "cache.h"
@@ -354,6 +355,7 @@ void Player::Update(bool update_scene) {
 
 	Audio().Update();
 	Input::Update();
+	AsyncHandler::Update();
 
 	// Game events can query full screen status and change their behavior, so this needs to
 	// be a game key and not a system key.
@@ -420,6 +422,8 @@ void Player::Exit() {
 	auto ret = FileFinder::Root().OpenOutputStream("/tmp/message.png", std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
 	if (ret) Output::TakeScreenshot(ret);
 #endif
+	AssetPrefetch::Quit();
+	AsyncHandler::Quit();
 	Player::ResetGameObjects();
 	Font::Dispose();
 	Graphics::Quit();
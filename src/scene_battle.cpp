@@ -131,6 +131,15 @@ void Scene_Battle::Start() {
 
 	Game_Battle::Init(troop_id);
 
+	std::vector<std::string> se_names;
+	for (const auto& page : troop->pages) {
+		Game_System::CollectSeNames(page.event_commands, se_names);
+	}
+	for (int which = Game_System::SFX_Escape; which <= Game_System::SFX_UseItem; ++which) {
+		se_names.push_back(Main_Data::game_system->GetSystemSE(which).name);
+	}
+	Main_Data::game_system->SePredecode(std::move(se_names));
+
 	CreateUi();
 
 	InitEscapeChance();
@@ -36,6 +36,7 @@
 #include "audio.h"
 #include "input.h"
 #include "game_dynrpg.h"
+#include "asset_prefetch.h"
 
 using namespace std::chrono_literals;
 
@@ -87,6 +88,8 @@ void Scene_Map::Start() {
 	Main_Data::game_pictures->InitGraphics();
 	Game_Clock::ResetFrame(Game_Clock::now());
 
+	AssetPrefetch::PrefetchMap(Game_Map::GetMap(), Game_Map::GetMapId());
+
 	Start2(MapUpdateAsyncContext());
 }
 
@@ -239,6 +242,8 @@ void Scene_Map::PreUpdateForegroundEvents(MapUpdateAsyncContext& actx) {
 }
 
 void Scene_Map::vUpdate() {
+	AssetPrefetch::Update();
+
 	if (activate_inn) {
 		UpdateInn();
 		return;
@@ -318,6 +323,7 @@ void Scene_Map::FinishPendingTeleport(TeleportParams tp) {
 
 	if (Game_Map::GetMapId() != old_map_id) {
 		spriteset->Refresh();
+		AssetPrefetch::PrefetchMap(Game_Map::GetMap(), Game_Map::GetMapId());
 	}
 	FinishPendingTeleport2(MapUpdateAsyncContext(), tp);
 }
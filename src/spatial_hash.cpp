@@ -0,0 +1,112 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "spatial_hash.h"
+#include <algorithm>
+#include <cmath>
+
+void SpatialHash::Reset(int width, int height, float cell_size) {
+	this->width = std::max(width, 0);
+	this->height = std::max(height, 0);
+	inv_cell_size = 1.0f / cell_size;
+
+	cell_head.assign(this->width * this->height, -1);
+	item_cell.clear();
+	item_next.clear();
+	item_prev.clear();
+}
+
+int SpatialHash::CellX(float x) const {
+	float cx = std::floor(x * inv_cell_size);
+	if (!(cx >= 0.0f)) {
+		return 0;
+	}
+	return cx >= width ? width - 1 : static_cast<int>(cx);
+}
+
+int SpatialHash::CellY(float y) const {
+	float cy = std::floor(y * inv_cell_size);
+	if (!(cy >= 0.0f)) {
+		return 0;
+	}
+	return cy >= height ? height - 1 : static_cast<int>(cy);
+}
+
+void SpatialHash::Update(int item, float x, float y) {
+	if (item < 0 || cell_head.empty()) {
+		return;
+	}
+
+	if (item >= static_cast<int>(item_cell.size())) {
+		item_cell.resize(item + 1, -1);
+		item_next.resize(item + 1, -1);
+		item_prev.resize(item + 1, -1);
+	}
+
+	const int cell = CellY(y) * width + CellX(x);
+	if (item_cell[item] == cell) {
+		return;
+	}
+
+	Remove(item);
+
+	item_cell[item] = cell;
+	item_prev[item] = -1;
+	item_next[item] = cell_head[cell];
+	if (cell_head[cell] >= 0) {
+		item_prev[cell_head[cell]] = item;
+	}
+	cell_head[cell] = item;
+}
+
+void SpatialHash::Remove(int item) {
+	if (item < 0 || item >= static_cast<int>(item_cell.size()) || item_cell[item] < 0) {
+		return;
+	}
+
+	const int next = item_next[item];
+	const int prev = item_prev[item];
+	if (prev >= 0) {
+		item_next[prev] = next;
+	} else {
+		cell_head[item_cell[item]] = next;
+	}
+	if (next >= 0) {
+		item_prev[next] = prev;
+	}
+	item_cell[item] = -1;
+}
+
+void SpatialHash::Query(float x, float y, float radius, std::vector<int>& out) const {
+	if (cell_head.empty()) {
+		return;
+	}
+
+	const int x0 = CellX(x - radius);
+	const int x1 = CellX(x + radius);
+	const int y0 = CellY(y - radius);
+	const int y1 = CellY(y + radius);
+
+	for (int cy = y0; cy <= y1; ++cy) {
+		for (int cx = x0; cx <= x1; ++cx) {
+			for (int item = cell_head[cy * width + cx]; item >= 0; item = item_next[item]) {
+				out.push_back(item);
+			}
+		}
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_SPATIAL_HASH_H
+#define EP_SPATIAL_HASH_H
+
+// Headers
+#include <vector>
+
+/**
+ * Uniform grid of item indices, the broadphase of the pixel movement.
+ *
+ * Every item is stored in the cell of its position, positions outside of
+ * the grid are clamped to the border cells. Moving an item inside its
+ * cell is free, moving it to another cell relinks it in constant time.
+ */
+class SpatialHash {
+public:
+	/**
+	 * Removes all items and resizes the grid.
+	 *
+	 * @param width grid width in cells
+	 * @param height grid height in cells
+	 * @param cell_size cell size in position units
+	 */
+	void Reset(int width, int height, float cell_size = 1.0f);
+
+	/**
+	 * Inserts an item or moves it to a new position.
+	 * Ignored when the grid is empty.
+	 *
+	 * @param item item index, >= 0
+	 * @param x position x
+	 * @param y position y
+	 */
+	void Update(int item, float x, float y);
+
+	/**
+	 * @param item item index
+	 */
+	void Remove(int item);
+
+	/**
+	 * Appends all items whose cell overlaps the square of the given radius
+	 * around a position. Every item within the radius is found, items
+	 * further away can be returned too. The order is unspecified.
+	 *
+	 * @param x position x
+	 * @param y position y
+	 * @param radius search radius
+	 * @param out receives the items
+	 */
+	void Query(float x, float y, float radius, std::vector<int>& out) const;
+
+	int GetWidth() const;
+	int GetHeight() const;
+
+private:
+	int CellX(float x) const;
+	int CellY(float y) const;
+
+	int width = 0;
+	int height = 0;
+	float inv_cell_size = 1.0f;
+	/** first item of every cell, -1 when empty */
+	std::vector<int> cell_head;
+	/** cell of every item, -1 when not stored */
+	std::vector<int> item_cell;
+	std::vector<int> item_next;
+	std::vector<int> item_prev;
+};
+
+inline int SpatialHash::GetWidth() const {
+	return width;
+}
+
+inline int SpatialHash::GetHeight() const {
+	return height;
+}
+
+#endif
@@ -101,10 +101,18 @@ BitmapRef Sprite::Refresh(Rect& rect) {
 	bool effects_rect_changed = rect != bitmap_effects_src_rect;
 
 	if (no_effects || effects_changed || effects_rect_changed || bitmap_changed) {
+		if (effects_changed && !effects_rect_changed && !bitmap_changed && bitmap_effects) {
+			++effect_changes;
+		} else {
+			effect_changes = 0;
+		}
 		bitmap_effects.reset();
+	} else {
+		effect_changes = 0;
 	}
 
 	if (no_effects) {
+		bitmap_shading.reset();
 		return bitmap;
 	} else if (bitmap_effects) {
 		return bitmap_effects;
@@ -114,13 +122,44 @@ BitmapRef Sprite::Refresh(Rect& rect) {
 		current_flip_x = flipx_effect;
 		current_flip_y = flipy_effect;
 
-		bitmap_effects = Cache::SpriteEffect(bitmap, rect, flipx_effect, flipy_effect, current_tone, current_flash);
+		if (effect_changes >= 2) {
+			// Animated tone or flash, every frame would create a new cache entry
+			ShadeInPlace(rect);
+		} else {
+			bitmap_shading.reset();
+			bitmap_effects = Cache::SpriteEffect(bitmap, rect, flipx_effect, flipy_effect, current_tone, current_flash);
+		}
 		bitmap_effects_src_rect = rect;
 
 		return bitmap_effects;
 	}
 }
 
+void Sprite::ShadeInPlace(const Rect& rect) {
+	if (!bitmap_shading || bitmap_shading->GetWidth() != rect.width || bitmap_shading->GetHeight() != rect.height) {
+		bitmap_shading = Bitmap::Create(rect.width, rect.height, true);
+	}
+
+	Bitmap& dst = *bitmap_shading;
+	if (current_flip_x || current_flip_y) {
+		dst.Clear();
+		dst.FlipBlit(0, 0, *bitmap, rect, current_flip_x, current_flip_y, Opacity::Opaque());
+	} else {
+		// Replaces the previous frame including the alpha channel
+		dst.BlitFast(0, 0, *bitmap, rect, Opacity::Opaque());
+	}
+
+	// Same effects as Cache::SpriteEffect, applied to the copy
+	if (current_tone != Tone()) {
+		dst.ToneBlit(0, 0, dst, dst.GetRect(), current_tone, Opacity::Opaque());
+	}
+	if (current_flash != Color()) {
+		dst.BlendBlit(0, 0, dst, dst.GetRect(), current_flash, Opacity::Opaque());
+	}
+
+	bitmap_effects = bitmap_shading;
+}
+
 void Sprite::SetBitmap(BitmapRef const& nbitmap) {
 	bitmap = nbitmap;
 	if (!bitmap) {
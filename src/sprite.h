@@ -127,8 +127,12 @@ private:
 	Color flash_effect;
 
 	BitmapRef bitmap_effects;
+	/** Owned by the sprite and shaded in place while the effects are animated */
+	BitmapRef bitmap_shading;
 
 	Rect bitmap_effects_src_rect;
+	/** Consecutive effect changes of the same image */
+	int effect_changes = 0;
 
 	Tone current_tone;
 	Color current_flash;
@@ -142,6 +146,7 @@ private:
 	void BlitScreenIntern(Bitmap& dst, Bitmap const& draw_bitmap,
 							Rect const& src_rect) const;
 	BitmapRef Refresh(Rect& rect);
+	void ShadeInPlace(const Rect& rect);
 };
 
 inline int Sprite::GetWidth() const {
@@ -3,10 +3,12 @@
 #include "bitmap.h"
 #include <filefinder.h>
 #include <player.h>
+#include <algorithm>
 #include <cmath>
 #include <main_data.h>
 #include <game_variables.h>
 #include <map>
+#include <unordered_map>
 #include <iostream>
 #include <input.h>
 #include "game_map.h"
@@ -14,6 +16,7 @@
 #include <cache.h>
 #include "game_event.h"
 #include "scene_map.h"
+#include "string_view.h"
 
 int Spriteset_MapDoom::mapWidth() {
 	return mapW;
@@ -22,215 +25,249 @@ int Spriteset_MapDoom::mapHeight() {
 	return mapH;
 }
 
-float Spriteset_MapDoom::castRay(float rayAngle, int& ray, std::vector<DrawingDoom>& d, int x, int &mx, int &my) {
-
-	float rayPosX = player.x;
-	float rayPosY = player.y;
-
-	// Direction du rayon
-	float rayDirX = cos(rayAngle);
-	float rayDirY = sin(rayAngle);
-
-	int startX = (int)(rayPosX / TILE_SIZE);
-	int startY = (int)(rayPosY / TILE_SIZE);
-	int mapX = startX;
-	int mapY = startY;
-
-	float rayDistance = 0.0;
-	bool hit = false;
-
-	while (!hit) {
-		// Vérification si le rayon sort des limites de la carte
-		if (mapX < 0 || mapX >= mapWidth() || mapY < 0 || mapY >= mapHeight()) {
-			//rayDistance = -1;
-			break;  // Sortir de la boucle si on dépasse la carte
+void Spriteset_MapDoom::castRay(const DoomRaycaster& raycaster, const PlayerDoom& player, float rayAngle, int x, ColumnBand& band) {
+
+	auto& d = band.drawings;
+	auto& hits = band.hits;
+
+	hits.clear();
+	raycaster.Cast(player.x, player.y, rayAngle, hits);
+
+	for (const auto& h : hits) {
+		if (h.kind == DoomRaycaster::Hit::Kind_Upper) {
+			// One billboard per tile, placed on the column passing closest to the tile center
+			int tile = h.tile_y * raycaster.GetWidth() + h.tile_x;
+			auto it = band.billboards.find(tile);
+			if (it == band.billboards.end()) {
+				band.billboards.emplace(tile, static_cast<int>(d.size()));
+				d.push_back({ 6, x, h.distance + 8.0f, 0, 0, {h.tile_x, h.tile_y}, h.offset });
+			} else if (h.offset < d[it->second].offset) {
+				auto& billboard = d[it->second];
+				billboard.x = x;
+				billboard.distance = h.distance + 8.0f;
+				billboard.offset = h.offset;
+			}
+		} else if (h.kind == DoomRaycaster::Hit::Kind_Event) {
+			const auto& e = raycaster.GetWallEvents()[h.event];
+			int type = (e.type == DoomRaycaster::WallEvent::Type_Stretch) ? 5 : 3;
+			d.push_back({ type, x, h.distance - 0.1f, h.texture_x, e.id, {e.tile_sprite, 0} });
+			if (e.type != DoomRaycaster::WallEvent::Type_Door) {
+				// The tile behind a solid wall event is drawn as wall
+				d.push_back({ 0, x, h.distance, h.texture_x, 0, {h.tile_x, h.tile_y} });
+			}
+		} else {
+			d.push_back({ 0, x, h.distance, h.texture_x, 0, {h.tile_x, h.tile_y} });
 		}
+	}
+}
 
-		if ((int)rayPosX % TILE_SIZE == 8 && (int)rayPosY % TILE_SIZE == 8)
-		{
-			int t_id = tilemapUp->GetTileDoom(mapX, mapY, 1);
-			if (t_id > 146) {
-				DrawingDoom de = { 6, x, rayDistance + 8.0f, (int)rayPosX % TILE_SIZE, t_id, {mapX, mapY} };
-
-				auto b = std::find_if(d.begin(),
-					d.end(),
-					[&d1 = de]
-					(const DrawingDoom& d2) -> bool { return d2.type == 6 && (d1.position.x == d2.position.x && d1.position.y == d2.position.y); });
-
+void Spriteset_MapDoom::castColumns(const DoomRaycaster& raycaster, const PlayerDoom& player, int width,
+		WorkerPool* pool, std::vector<ColumnBand>& bands, std::vector<DrawingDoom>& out) {
 
-				if (b == d.end()) {
-					d.push_back(de);
-				}
+	const int num_bands = std::max(1, std::min(pool ? pool->GetThreadCount() : 1, width));
+	bands.resize(num_bands);
 
+	for (int i = 0; i < num_bands; i++) {
+		auto job = [&raycaster, &player, &band = bands[i], width, x0 = width * i / num_bands, x1 = width * (i + 1) / num_bands]() {
+			band.drawings.clear();
+			band.billboards.clear();
+			for (int x = x0; x < x1; x++) {
+				float rayAngle = player.angle + (x - width / 2) * (player.fov / width);
+				castRay(raycaster, player, rayAngle, x, band);
 			}
-
+		};
+		if (pool) {
+			pool->Push(job);
+		} else {
+			job();
 		}
+	}
+	if (pool) {
+		pool->Wait();
+	}
 
-		if ((int)rayPosX % TILE_SIZE == 0 || (int)rayPosY % TILE_SIZE == 0
-			|| (int)rayPosX % TILE_SIZE == 15 || (int)rayPosY % TILE_SIZE == 15)
-			for (auto e : events_wall) {
-				if (e.x == mapX && e.y == mapY) {
-
-					float distance = rayDistance;
-				/*	if (Main_Data::game_player->doomMoveType == 0)
-						distance *= cos(rayAngle - player.angle);*/
-					int rayD = (int)rayPosX % TILE_SIZE;
-					int tx = e.tileSprite;
-
-					if (rayD == 0 || rayD == TILE_SIZE - 1)
-						rayD = (int)rayPosY % TILE_SIZE;
-
-					DrawingDoom de;
-
-					int type = 3;
-					if (e.type == 2) {
-						type = 4;
-						// if (!((int)rayPosX % TILE_SIZE == 8 || (int)rayPosY % TILE_SIZE == 8)) {
-						if (!(((int)rayPosX % TILE_SIZE >= 6 && (int)rayPosX % TILE_SIZE <= 10) || (int)rayPosY % TILE_SIZE >= 6 && (int)rayPosY % TILE_SIZE <= 10)) {
-							continue;
-						}
-						de = { type, x, distance - 0.1f, rayD, e.id, {tx,0} };
-
-						auto b = std::find_if(d.begin(),
-							d.end(),
-							[&d1 = de]
-							(const DrawingDoom& d2) -> bool { return d2.type == 4 && d1.evID == d2.evID; });
-
+	// Billboards seen by several bands keep the closest column, the first one on ties
+	std::unordered_map<int, const DrawingDoom*> best;
+	for (const auto& band : bands) {
+		for (const auto& it : band.billboards) {
+			const DrawingDoom& d = band.drawings[it.second];
+			auto b = best.emplace(it.first, &d);
+			if (!b.second && d.offset < b.first->second->offset) {
+				b.first->second = &d;
+			}
+		}
+	}
 
-						if (b != d.end()) {
-							continue;
-						}
-						distance -= 1.0f;
-					} else if(e.type == 3) {
-						type = 5;
-					}
+	// Same order as casting all columns in one band
+	out.clear();
+	for (const auto& band : bands) {
+		for (const auto& d : band.drawings) {
+			if (d.type != 6) {
+				out.push_back(d);
+				continue;
+			}
+			auto b = best.find(d.position.y * raycaster.GetWidth() + d.position.x);
+			if (b != best.end() && b->second) {
+				out.push_back(*b->second);
+				b->second = nullptr;
+			}
+		}
+	}
+}
 
-					de = { type, x, distance - 0.1f, rayD, e.id, {tx,0} };
+void Spriteset_MapDoom::setRenderWorkers(int workers) {
+	render_pool = std::make_unique<WorkerPool>(std::max(workers, 0));
+}
 
-					d.push_back(de);
+int Spriteset_MapDoom::mapCell(int x, int y) const {
+	if (x < 0 || y < 0 || x >= mapW || y >= mapH)
+		return -1;
+	int cell = map[y * mapW + x];
+	return cell == map_cell_none ? -1 : cell;
+}
 
-					if (e.type == 0 || e.type == 3) {
-						hit = true;
-						/*if (map[mapY][mapX] != 1)
-							rayDistance = -1;*/
-					}
-				}
-			}
+int Spriteset_MapDoom::addAtlasTile(const Bitmap& texture) {
+	int cell = tile_atlas_cells++;
+	int rows = cell / tile_atlas_columns + 1;
+
+	// Grows by doubling the rows, the cells keep their position
+	if (!tile_atlas || tile_atlas->height() < rows * TILE_SIZE) {
+		if (tile_atlas)
+			rows = std::max(rows, 2 * tile_atlas->height() / TILE_SIZE);
+		BitmapRef atlas = Bitmap::Create(tile_atlas_columns * TILE_SIZE, rows * TILE_SIZE, true);
+		if (tile_atlas)
+			atlas->BlitFast(0, 0, *tile_atlas, tile_atlas->GetRect(), 255);
+		tile_atlas = atlas;
+	}
 
-		// Vérifier si le rayon touche un mur
-		if ((map[mapY][mapX] == 1 || map[mapY][mapX] == 2) && (mapX != startX || mapY != startY)) {
-			hit = true;
-		}
-		else if (hit == false) {
-			// Incrémenter la position du rayon
-			rayPosX += rayDirX;
-			rayPosY += rayDirY;
+	Rect rect = atlasRect(cell);
+	tile_atlas->BlitFast(rect.x, rect.y, texture, Rect(0, 0, TILE_SIZE, TILE_SIZE), 255);
+	return cell;
+}
 
-			mapX = (int)(rayPosX / TILE_SIZE);
-			mapY = (int)(rayPosY / TILE_SIZE);
+Rect Spriteset_MapDoom::atlasRect(int cell) const {
+	return Rect((cell % tile_atlas_columns) * TILE_SIZE, (cell / tile_atlas_columns) * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+}
 
-			// Calcul de la distance actuelle du rayon
-			rayDistance += sqrt(rayDirX * rayDirX + rayDirY * rayDirY);
+void Spriteset_MapDoom::buildTileAtlas() {
+	// As wide as the chipset, grows downwards when the map uses more tiles
+	int atlas_width = chipset ? chipset->width() : 480;
+	tile_atlas_columns = std::max(atlas_width / TILE_SIZE, 1);
+
+	floor_cells.assign(mapWidth() * mapHeight(), -1);
+
+	// Lower layer of every floor tile and upper layer of every billboard
+	Rect rect;
+	for (int y = 0; y < mapHeight(); y++) {
+		for (int x = 0; x < mapWidth(); x++) {
+			if (mapCell(x, y) != 1 && mapTexture(x, y, 0, rect))
+				floor_cells[y * mapWidth() + x] = tile_cells[0][tilemapDown->GetTileDoom(x, y, 0)];
+			if (raycaster.GetTile(x, y) & DoomRaycaster::Tile_Upper)
+				mapTexture(x, y, 1, rect);
 		}
 	}
+}
 
-	mx = mapX;
-	my = mapY;
-
-	ray = (int) rayPosX % TILE_SIZE;
-	if (ray == 0 || ray == TILE_SIZE - 1)
-		ray = (int)rayPosY % TILE_SIZE;
-
-	float distance = rayDistance;
-	return distance;  // Retourner la distance si un mur est touché
+size_t Spriteset_MapDoom::memoryUsage() const {
+	return map.capacity() + raycaster.GetMemoryUsage() + tileAtlasMemoryUsage()
+		+ (tile_cells[0].capacity() + tile_cells[1].capacity() + floor_cells.capacity()) * sizeof(int);
 }
 
-float Spriteset_MapDoom::renderTexturedFloor(float x1, float wallHeight, float rayAngle) {
-	//int start = Player::screen_height / 2 + wallHeight + 1;
-	int start = Player::screen_height / 2 + 1;
+size_t Spriteset_MapDoom::tileAtlasMemoryUsage() const {
+	return tile_atlas ? static_cast<size_t>(tile_atlas->pitch()) * tile_atlas->height() : 0;
+}
 
-	// Calcul des directions cosinus et sinus en fonction de l'angle du rayon
-	float directionCos = std::cos(rayAngle);
-	float directionSin = std::sin(rayAngle);
-	float playerAngle = player.angle;
+void Spriteset_MapDoom::logMemoryUsage() const {
+	Output::Debug("Doom map {}x{}: grid {} B, raycaster {} B, tile atlas {} tiles {} B, tile tables {} B, total {} B",
+		mapW, mapH, map.capacity(), raycaster.GetMemoryUsage(), tile_atlas_cells, tileAtlasMemoryUsage(),
+		(tile_cells[0].capacity() + tile_cells[1].capacity() + floor_cells.capacity()) * sizeof(int), memoryUsage());
+}
 
-	int lastMapX = -1;
-	int lastMapY = -1;
+void Spriteset_MapDoom::renderFloor() {
+	const int width = Player::screen_width;
+	const int height = Player::screen_height;
+	const int start = height / 2 + 1;
 
-	int y = 0;
-	float distance = 0;
-	float tilex, tiley;
-	int mapX;
-	int mapY;
-	BitmapRef texture;
+	if (!tile_atlas)
+		return;
 
-	const int inf = std::numeric_limits<int>::max();
+	// The floor follows the ray of each column, same projection as the walls
+	ray_cos.resize(width);
+	ray_sin.resize(width);
+	for (int x = 0; x < width; x++) {
+		float rayAngle = player.angle + (x - width / 2) * (player.fov / width);
+		ray_cos[x] = std::cos(rayAngle);
+		ray_sin[x] = std::sin(rayAngle);
+	}
 
-	//for (int y = start; y < Player::screen_height; y++) {
-	for (y = Player::screen_height; y >= start ; y--) {
-		// Créer et calculer la distance
-		distance = (Player::screen_height) / (2.0f * y - Player::screen_height);
-		if (distance < 0) {
-			distance = abs(distance);
-			//Output::Debug("NEG");
-		}
-		if (distance >= inf) {
-			//Output::Debug("inf - {}", distance);
-			distance = 120;
-			break;
-		}
-		//if (Main_Data::game_player->doomMoveType == 0)
-		//	distance = distance / cos(rayAngle - player.angle);
+	// A column ends at the first wall or the map border, seen from the bottom
+	floor_done.assign(width, 0);
 
-		// Calcul de la position en tiles
-		tilex = distance * directionCos;
-		tiley = distance * directionSin;
+	const float px = player.x / TILE_SIZE;
+	const float py = player.y / TILE_SIZE;
 
-		// Ajouter la position du joueur pour obtenir la position dans le monde
-		tilex += player.x / TILE_SIZE;
-		tiley += player.y / TILE_SIZE;
+	const bool direct = sprite->bpp() == 4 && tile_atlas->bpp() == 4;
+	auto* dst_pixels = reinterpret_cast<uint32_t*>(sprite->pixels());
+	const int dst_stride = sprite->pitch() / 4;
+	const auto* atlas_pixels = reinterpret_cast<const uint32_t*>(tile_atlas->pixels());
+	const int atlas_stride = tile_atlas->pitch() / 4;
 
-		// Obtenir la position du tile correspondant dans la carte
-		mapX = static_cast<int>(std::floor(tilex));
-		mapY = static_cast<int>(std::floor(tiley));
+	// Row height is constant for each row, the first row is below the screen
+	auto rows = [&](int x0, int x1) {
+		for (int y = height; y >= start; y--) {
+			float distance = static_cast<float>(height) / (2 * y - height);
+			uint32_t* dst_row = (direct && y < height) ? dst_pixels + y * dst_stride : nullptr;
 
-		// Vérifier si la position du tile est valide dans la carte
-		if (mapX < 0 || mapY < 0 || mapX >= mapWidth() || mapY >= mapHeight()) {
-			break;
-		}
+			for (int x = x0; x < x1; x++) {
+				if (floor_done[x])
+					continue;
 
-		if (map[mapY][mapX] != 1) {
+				float tilex = px + distance * ray_cos[x];
+				float tiley = py + distance * ray_sin[x];
 
-			if (lastMapX != mapX || lastMapY != mapY) {
-				texture = mapTexture(mapX, mapY);
-				lastTile = texture;
-				lastMapX = mapX;
-				lastMapY = mapY;
-			}
-			else {
-				texture = lastTile;
-			}
+				int mapX = static_cast<int>(std::floor(tilex));
+				int mapY = static_cast<int>(std::floor(tiley));
 
-			int texture_x = static_cast<int>(std::floor(tilex * TILE_SIZE)) % TILE_SIZE;
-			int texture_y = static_cast<int>(std::floor(tiley * TILE_SIZE)) % TILE_SIZE;
+				if (mapX < 0 || mapY < 0 || mapX >= mapW || mapY >= mapH) {
+					floor_done[x] = 1;
+					continue;
+				}
 
-			// Définir les coordonnées de la texture
+				int cell = floor_cells[mapY * mapW + mapX];
+				if (cell < 0) {
+					floor_done[x] = 1;
+					continue;
+				}
 
-			if (texture) {
-				Rect srcRect = { texture_x, texture_y, 1, 1 };
+				if (y >= height)
+					continue;
 
-				sprite->BlitFast(x1, y, *texture, srcRect, 255);
+				int texture_x = static_cast<int>(std::floor(tilex * TILE_SIZE)) % TILE_SIZE;
+				int texture_y = static_cast<int>(std::floor(tiley * TILE_SIZE)) % TILE_SIZE;
+				int atlas_x = (cell % tile_atlas_columns) * TILE_SIZE + texture_x;
+				int atlas_y = (cell / tile_atlas_columns) * TILE_SIZE + texture_y;
 
+				if (dst_row) {
+					dst_row[x] = atlas_pixels[atlas_y * atlas_stride + atlas_x];
+				} else {
+					sprite->BlitFast(x, y, *tile_atlas, Rect(atlas_x, atlas_y, 1, 1), 255);
+				}
 			}
-
-		}
-		else {
-			break;
 		}
+	};
 
+	// Columns are independent, every worker writes its own band of pixels
+	const int bands = (direct && render_pool) ? std::max(1, std::min(render_pool->GetThreadCount(), width)) : 1;
+	if (bands == 1) {
+		rows(0, width);
+		return;
 	}
-
-	return distance;
+	for (int i = 0; i < bands; i++) {
+		render_pool->Push([&rows, x0 = width * i / bands, x1 = width * (i + 1) / bands]() {
+			rows(x0, x1);
+		});
+	}
+	render_pool->Wait();
 }
 
 void Spriteset_MapDoom::DrawEvents(std::vector<DrawingDoom> &d, float FOV) {
@@ -295,44 +332,10 @@ void Spriteset_MapDoom::renderScene() {
 	float FOV = player.fov;
 	std::vector<DrawingDoom> drawings = {};
 
-	bool drawFloor = true;
-
-	for (int x = 0; x < Player::screen_width; x++) {
-		// Calculer l'angle du rayon
-		float rayAngle = player.angle + (x - Player::screen_width / 2) * (FOV / Player::screen_width);
-
-		int ray = 0;
-
-		int mx;
-		int my;
-		// Cast le rayon et obtenir la distance
-		float distance = castRay(rayAngle, ray, drawings, x, mx, my);
-
-		if (distance >= 0) {
-			if (drawFloor) {
-				float df = renderTexturedFloor(x, distance, rayAngle);
-				if (df > 3) {
-					//drawFloor = false;
-					//x++;
-					//renderTexturedFloor(x, distance, rayAngle);
-
-					//d = { 0, x, distance, ray, 0, {mx, my} };
-					//drawings.push_back(d);
-				}
-			}
-			else {
-				drawFloor = true;
-			}
-
-			DrawingDoom d = { 0, x, distance, ray, 0, {mx, my} };
-			drawings.push_back(d);
-
-			/*if (x == Player::screen_width / 2)
-				Output::Debug("D {}", distance);*/
-
-		}
+	renderFloor();
 
-	}
+	// Cast the rays, the walls they hit are added to the draw list
+	castColumns(raycaster, player, Player::screen_width, render_pool.get(), column_bands, drawings);
 
 	DrawEvents(drawings, FOV);
 
@@ -354,11 +357,8 @@ void Spriteset_MapDoom::renderScene() {
 		else if (d.type == 0 || d.type == 3 || d.type == 5) {
 			float distance = d.distance;
 
-			// Output::Debug(" {}", map[d.position.x][d.position.y]);
-			bool b = true;
-			if (d.position.y >= 0 && d.position.y < mapHeight() && d.position.x >= 0 && d.position.x < mapWidth())
-				if (map[d.position.y][d.position.x] == 2)
-					b = false;
+			// Output::Debug(" {}", mapCell(d.position.x, d.position.y));
+			bool b = mapCell(d.position.x, d.position.y) != 2;
 			if (distance > 0 && b) {
 				int lineHeight = static_cast<int>(TILE_SIZE * Player::screen_height * 1.1 / distance);
 				int drawStart = (Player::screen_height - lineHeight) / 2;
@@ -368,11 +368,12 @@ void Spriteset_MapDoom::renderScene() {
 
 				Rect r = Rect(d.x, drawStart, 1, drawEnd - drawStart);
 				BitmapRef texture;
+				Rect tile;
 				if (d.type == 3 || d.type == 5) {
 					texture = ((Scene_Map*)scene_map)->GetEventSprite(d.evID);
 				}
-				else
-					texture = mapTexture(d.position.x, d.position.y);
+				else if (mapTexture(d.position.x, d.position.y, 0, tile))
+					texture = tile_atlas;
 
 				if (texture) {
 					Rect srcRect;
@@ -409,7 +410,7 @@ void Spriteset_MapDoom::renderScene() {
 							srcRect = { 0,0,0,0 };*/
 					}
 					else
-						srcRect = { textureX, 0, 1, texture->height() };
+						srcRect = { tile.x + textureX, tile.y, 1, tile.height };
 
 					if (srcRect.width != 0 && srcRect.height != 0)
 						sprite->StretchBlit(r, *texture, srcRect, 255);
@@ -425,10 +426,16 @@ void Spriteset_MapDoom::renderScene() {
 			if (distance > 0) {
 
 				BitmapRef texture;
-				if (d.type == 6)
-					texture = mapTexture(d.position.x, d.position.y, 1);
-				else
+				Rect tile;
+				if (d.type == 6) {
+					if (mapTexture(d.position.x, d.position.y, 1, tile))
+						texture = tile_atlas;
+				}
+				else {
 					texture = ((Scene_Map*)scene_map)->GetEventSprite(d.evID);
+					if (texture)
+						tile = texture->GetRect();
+				}
 
 				if (texture) {
 
@@ -438,14 +445,14 @@ void Spriteset_MapDoom::renderScene() {
 					// int textureX = d.textureX;
 
 					float d5 = (float) lineHeight / Player::screen_height;
-					int zx = d5 * 6 * texture->width();
-					int zy = d5 * 6 * texture->height();
+					int zx = d5 * 6 * tile.width;
+					int zy = d5 * 6 * tile.height;
 
-					int DoomEventWidth = texture->width();
-					int DoomEventHeight = texture->height();
+					int DoomEventWidth = tile.width;
+					int DoomEventHeight = tile.height;
 
-					Rect srcRect = { 0, 0, texture->width(), texture->height()};
-					Rect srcRect2 = { 0, 0, texture->width(), texture->height() };
+					Rect srcRect = tile;
+					Rect srcRect2 = tile;
 
 					float sprCorrection = 1;
 					if (d.type == 6)
@@ -515,7 +522,7 @@ float Spriteset_MapDoom::castRay7() {
 			mapY = rayX / TILE_SIZE;
 			mapY = rayY / TILE_SIZE;
 			if (mapX >= 0 && mapX < mapWidth() && mapY >= 0 && mapY < mapHeight()) {
-				wall = (map[mapY][mapX] == 1);
+				wall = (mapCell(mapX, mapY) == 1);
 			}
 			else {
 				break;
@@ -641,11 +648,10 @@ void Spriteset_MapDoom::renderMode7() {
 					}
 				}
 
-				BitmapRef texture = mapTexture(mapX, mapY);
-
-				if (texture) {
-					Rect srcRect = {TILE_SIZE - 1 - mx, my, 1, 1 };
-					sprite->BlitFast(x, y, *texture, srcRect, 200);
+				Rect tile;
+				if (mx >= 0 && my >= 0 && mapTexture(mapX, mapY, 0, tile)) {
+					Rect srcRect = { tile.x + TILE_SIZE - 1 - mx, tile.y + my, 1, 1 };
+					sprite->BlitFast(x, y, *tile_atlas, srcRect, 200);
 				}
 
 
@@ -722,10 +728,11 @@ void Spriteset_MapDoom::renderMode7() {
 
 				Rect r = Rect(d.x, drawStart, 1, drawEnd - drawStart);
 				BitmapRef texture;
+				Rect tile;
 				if (d.type == 3)
 					texture = ((Scene_Map*)scene_map)->GetEventSprite(d.evID);
-				else
-					texture = mapTexture(d.position.x, d.position.y);
+				else if (mapTexture(d.position.x, d.position.y, 0, tile))
+					texture = tile_atlas;
 
 				if (texture) {
 					Rect srcRect;
@@ -734,7 +741,7 @@ void Spriteset_MapDoom::renderMode7() {
 						srcRect = { texture->width() - textureX - 5, 0, 1, texture->height() };
 					}
 					else
-						srcRect = { textureX, 0, 1, texture->height() };
+						srcRect = { tile.x + textureX, tile.y, 1, tile.height };
 
 					sprite->StretchBlit(r, *texture, srcRect, 255);
 				}
@@ -822,29 +829,31 @@ void Spriteset_MapDoom::renderMode7() {
 	castRay7();
 }
 
-BitmapRef Spriteset_MapDoom::mapTexture(int x, int y, int layer) {
-	if (x >= 0 && y >= 0 && x < mapWidth() && y < mapHeight()) {
-		//int id = ((Scene_Map*)scene_map)->GetTileID(x, y, 0);
-		int id = 0;
-		if (layer == 0)
-			id = tilemapDown->GetTileDoom(x, y, 0);
-		else
-			id = tilemapUp->GetTileDoom(x, y, 1);
-
-		auto mt = mapTexturesID;
-		if (layer != 0) {
-			mt = mapTexturesUpperID;
-		}
-
-		if (!mt[id]) {
-			mt[id] = ((Scene_Map*)scene_map)->GetTile(x, y, layer);
-			return mt[id];
-		}
-		return mt[id];
+bool Spriteset_MapDoom::mapTexture(int x, int y, int layer, Rect& rect) {
+	if (x < 0 || y < 0 || x >= mapWidth() || y >= mapHeight())
+		return false;
+
+	int id = 0;
+	if (layer == 0)
+		id = tilemapDown->GetTileDoom(x, y, 0);
+	else
+		id = tilemapUp->GetTileDoom(x, y, 1);
+	if (id < 0)
+		return false;
+
+	std::vector<int>& cells = tile_cells[layer == 0 ? 0 : 1];
+	if (id >= static_cast<int>(cells.size()))
+		cells.resize(id + 1, -1);
+
+	if (cells[id] < 0) {
+		BitmapRef texture = ((Scene_Map*)scene_map)->GetTile(x, y, layer);
+		if (!texture)
+			return false;
+		cells[id] = addAtlasTile(*texture);
 	}
 
-	BitmapRef b = Bitmap::Create(TILE_SIZE, TILE_SIZE, Color(0, 0, 0, 0));
-	return b;
+	rect = atlasRect(cells[id]);
+	return true;
 }
 
 void Spriteset_MapDoom::renderTexturedFloor() {
@@ -890,14 +899,14 @@ void Spriteset_MapDoom::renderTexturedFloor() {
 
 
 			Rect r = Rect(x, y, 1, 1);
-			BitmapRef texture = mapTexture(x2, y2);
+			Rect tile;
 			int mx = floor(x2);
 			int my = floor(y2);
 
-			if (texture) {
-				Rect srcRect = { mx, my, 1, 1 };
-				//sprite->StretchBlit(r, *texture, srcRect, 255);
-				sprite->BlitFast(x, y, *texture, srcRect, 255);
+			if (mapTexture(x2, y2, 0, tile)) {
+				Rect srcRect = { tile.x + mx, tile.y + my, 1, 1 };
+				//sprite->StretchBlit(r, *tile_atlas, srcRect, 255);
+				sprite->BlitFast(x, y, *tile_atlas, srcRect, 255);
 			}
 
 		}
@@ -925,9 +934,13 @@ Spriteset_MapDoom::Spriteset_MapDoom() {
 
 	auto m = Game_Map::GetPassagesDown();
 
-	for (int x = 0;x < mapWidth(); x++) {
-		for (int y = 0; y < mapHeight(); y++) {
-			map[y][x] = Game_Map::GetTerrainTag(x, y) - 1;
+	// Terrain tag minus one, tags without meaning for the renderer are clamped
+	map.assign(mapWidth() * mapHeight(), map_cell_none);
+	for (int y = 0; y < mapHeight(); y++) {
+		for (int x = 0; x < mapWidth(); x++) {
+			int tag = Game_Map::GetTerrainTag(x, y) - 1;
+			if (tag >= 0)
+				map[y * mapWidth() + x] = static_cast<uint8_t>(std::min(tag, map_cell_none - 1));
 		}
 	}
 
@@ -941,25 +954,43 @@ Spriteset_MapDoom::Spriteset_MapDoom() {
 	sprite = Bitmap::Create(Player::screen_width, Player::screen_height);
 	spriteUpper = Bitmap::Create(Player::screen_width, Player::screen_height);
 
+	raycaster.Resize(mapWidth(), mapHeight());
+	for (int y = 0; y < mapHeight(); y++) {
+		for (int x = 0; x < mapWidth(); x++) {
+			uint8_t flags = 0;
+			if (mapCell(x, y) == 1)
+				flags |= DoomRaycaster::Tile_Wall;
+			else if (mapCell(x, y) == 2)
+				flags |= DoomRaycaster::Tile_Hidden;
+			if (tilemapUp->GetTileDoom(x, y, 1) > 146)
+				flags |= DoomRaycaster::Tile_Upper;
+			raycaster.SetTile(x, y, flags);
+		}
+	}
+
 	for (int i = 0;i <= Game_Map::GetHighestEventId();i++) {
 		auto e = Game_Map::GetEvent(i);
 		if (e) {
 			if (e->GetName() == "[WALL]" || e->GetName() == "[WALL_D]" || e->GetName() == "[WALL_S]") {
-				int t = 0;
+				int t = DoomRaycaster::WallEvent::Type_Wall;
 				if (e->GetName() == "[WALL_D]")
-					t = 1;
+					t = DoomRaycaster::WallEvent::Type_Door;
 				if (e->GetName() == "[WALL_S]")
-					t = 3;
+					t = DoomRaycaster::WallEvent::Type_Stretch;
 
 				int tileSprite = 0;
 				if (e->HasTileSprite())
 					tileSprite = 1;
 
-				EventWall p = { e->GetX(), e->GetY(), e->GetId(), t, tileSprite };
-				events_wall.push_back(p);
+				raycaster.AddWallEvent({ e->GetX(), e->GetY(), e->GetId(), t, tileSprite });
 			}
 		}
 	}
+
+	buildTileAtlas();
+	logMemoryUsage();
+
+	setRenderWorkers(WorkerPool::GetDefaultThreadCount(4));
 }
 
 Spriteset_MapDoom::Spriteset_MapDoom(std::string n, int zoom, int dx, int dy, int rx, int ry, int rz) {
@@ -1068,7 +1099,7 @@ void Spriteset_MapDoom::Load_OBJ(std::string name) {
 	points3D = {};
 	connections3D = {};
 
-	surfaces = {};
+	triangles = {};
 
 	Output::Debug(".mtl");
 
@@ -1082,9 +1113,9 @@ void Spriteset_MapDoom::Load_OBJ(std::string name) {
 	for (std::string line; getline(ini_stream, line); )
 	{
 		// Output::Debug("{}", line);
-		if (line._Starts_with("newmtl ")) {
+		if (StartsWith(line, "newmtl ")) {
 			material_name = line.substr(7,line.length() - 7);
-		} else if (line._Starts_with("Kd ")) {
+		} else if (StartsWith(line, "Kd ")) {
 			std::vector<std::string> v = split(line, " ");
 			int r = std::stof(v[1]) * 255;
 			int g = std::stof(v[2]) * 255;
@@ -1106,7 +1137,7 @@ void Spriteset_MapDoom::Load_OBJ(std::string name) {
 	for (std::string line; getline(ini_stream, line); )
 	{
 		// Output::Debug("{}", line);
-		if (line._Starts_with("v ")) {
+		if (StartsWith(line, "v ")) {
 			std::vector<std::string> v = split(line, " ");
 			float x = std::stof(v[1]);
 			float y = std::stof(v[2]);
@@ -1117,7 +1148,7 @@ void Spriteset_MapDoom::Load_OBJ(std::string name) {
 			/*pointsNoMaterial.push_back(v3);*/
 		}
 		// Material
-		else if (line._Starts_with("usemtl ")) {
+		else if (StartsWith(line, "usemtl ")) {
 			material_name = line.substr(7, line.length() - 7);
 			Output::Debug("{}", material_name);
 			color = colors[material_name];
@@ -1132,59 +1163,27 @@ void Spriteset_MapDoom::Load_OBJ(std::string name) {
 
 		}
 		// Surface
-		else if (line._Starts_with("f ")) {
+		else if (StartsWith(line, "f ")) {
 			std::vector<std::string> v = split(line, " ");
-			std::vector<Point> s;
-			Point p;
-			p.color = color;
-			for (int i = 1; i < v.size(); i++) {
-				auto vc = v[i];
-				std::vector<std::string> f = split(vc, "/");
-
-				if (i == 1) {
-					p.y = std::stof(f[0]) - 1;
-				}
-				else if (i == v.size() - 1) {
-					p.x = p.y;
-					p.y = std::stof(f[0]) - 1;
-					s.push_back(p);
-					p.x = p.y;
-					p.y = s[0].x;
-					s.push_back(p);
-				}
-				else {
-					p.x = p.y;
-					p.y = std::stof(f[0]) - 1;
-					s.push_back(p);
-				}
-
+			std::vector<int> face;
+			for (size_t i = 1; i < v.size(); i++) {
+				if (v[i].empty() || v[i] == "\r")
+					continue;
+				std::vector<std::string> f = split(v[i], "/");
+				face.push_back(std::stoi(f[0]) - 1);
 			}
 
-			connection c;
-			int cc;
-			for (int i = 1; i < v.size(); i++) {
-				auto vc = v[i];
-				std::vector<std::string> f = split(vc, "/");
-				if (i == 1) {
-					c.a = std::stoi(f[0]) - 1;
-					cc = c.a;
-				}
-				else {
-					c.b = std::stoi(f[0]) - 1;
-					connections3D.push_back(c);
-					c.a = c.b;
-					if (i == v.size() - 1) {
-						c.b = cc;
-						connections3D.push_back(c);
-					}
-				}
+			// Faces are convex polygons, split into a triangle fan
+			for (size_t i = 2; i < face.size(); i++) {
+				triangles.push_back({ face[0], face[i - 1], face[i], color });
 			}
 
-			surfaces.push_back(s);
-
+			for (size_t i = 0; i < face.size(); i++) {
+				connections3D.push_back({ face[i], face[(i + 1) % face.size()] });
+			}
 		}
 		 // => Wireframe
-		/*else if (line._Starts_with("f ")) {
+		/*else if (StartsWith(line, "f ")) {
 			std::vector<std::string> v = split(line, " ");
 			connection c;
 			int cc;
@@ -1300,7 +1299,6 @@ void Spriteset_MapDoom::Update(bool first) {
 				sprite->Clear();
 				renderMode7();
 			}
-			points.clear();
 
 			timer++;
 
@@ -1431,13 +1429,12 @@ void Spriteset_MapDoom::Update(bool first) {
 					int ppx = px / TILE_SIZE;
 					int ppy = py / TILE_SIZE;
 
-					//Output::Debug(" {} {} {}", ppx, ppy, map[ppx][ppy]);
+					//Output::Debug(" {} {} {}", ppx, ppy, mapCell(ppx, ppy));
 
-					if (ppx < mapWidth() && ppy < mapHeight() && ppx >= 0 && ppy >= 0)
-						if (map[ppy][ppx] == 0) {
-							player.x = px;
-							player.y = py;
-						}
+					if (mapCell(ppx, ppy) == 0) {
+						player.x = px;
+						player.y = py;
+					}
 				}
 				if (Input::IsPressed(Input::LEFT)) {  // Tourner à gauche
 					player.angle -= angle;
@@ -1480,7 +1477,6 @@ void Spriteset_MapDoom::Update(bool first) {
 			sprite->Clear();
 			renderScene();
 		}
-		points.clear();
 
 
 		timer++;
@@ -1511,38 +1507,12 @@ void Spriteset_MapDoom::Update(bool first) {
 			p.x += centeroid.x;
 			p.y += centeroid.y;
 			p.z += centeroid.z;
-
-			//if (timer % refresh_rate == 1 || refresh_rate == 1)
-				//pixel(p.x, p.y, p.z, p.color);
 		}
 
-		if (timer % refresh_rate == 1 || refresh_rate == 1 || first) {
-
-			for (auto& c : connections3D) {
-				// line(points3D[c.a], points3D[c.b]);
-			}
-			for (auto s : surfaces) {
-
-				std::vector<Point> s2;
-				for (auto p : s) {
-					Point p2 = { points3D[p.x].x, points3D[p.x].y, points3D[p.x].z, points3D[p.x].upper, p.color };
-					s2.push_back(p2);
-
-					p2 = { points3D[p.y].x, points3D[p.y].y, points3D[p.y].z, points3D[p.y].upper, p.color };
-					s2.push_back(p2);
+		// Models are cheap to rasterize, they are drawn every frame
+		renderModel();
 
-					// Output::Debug(" {} {} {}", p2.color.red, p2.color.green , p2.color.blue);
-				}
-				sortPoints(s2);
-				drawPolygon(s2);
-
-			}
-
-			Show();
-
-		}
 		timer++;
-		points.clear();
 	}
 }
 
@@ -1555,125 +1525,6 @@ void Spriteset_MapDoom::normalizeAngle(double& angle) {
 }
 
 
-void Spriteset_MapDoom::pixel(float x, float y, float z, Color c) {
-
-	Point p = { x, y, z, false, c, true};
-	if (z < 0) {
-		p.upper = true;
-	}
-
-	points.emplace_back(p);
-}
-
-void Spriteset_MapDoom::line(Point p1, Point p2) {
-
-	float x1, y1, x2, y2, z1, z2;
-	x1 = p1.x;
-	y1 = p1.y;
-	x2 = p2.x;
-	y2 = p2.y;
-	z1 = p1.z;
-	z2 = p2.z;
-
-	float dx = x2 - x1;
-	float dy = y2 - y1;
-	float length = std::sqrt(dx * dx + dy * dy);
-	float angle = std::atan2(dy, dx);
-
-	//Output::Debug(". {}", length);
-
-	for (float i = 0; i < length; i++) {
-		float zz = z1 + std::tanf(angle) * i;
-
-		float f = i / length;
-		zz = lerp(z1, z2, f);
-
-		pixel(x1 + std::cosf(angle) * i, y1 + std::sin(angle) * i, zz, p1.color);
-		// Output::Debug("..");
-	}
-}
-
-// Fonction pour calculer le centroïde du polygone
-Spriteset_MapDoom::Point Spriteset_MapDoom::computeCentroid(const std::vector<Spriteset_MapDoom::Point>& points) {
-	int x_sum = 0, y_sum = 0;
-	for (const auto& p : points) {
-		x_sum += p.x;
-		y_sum += p.y;
-	}
-	Point p;
-	p.x = x_sum / static_cast<int>(points.size());
-	p.y = y_sum / static_cast<int>(points.size());
-	return p;
-}
-
-// Fonction pour trier les points en fonction de leur angle par rapport au centroïde
-void Spriteset_MapDoom::sortPoints(std::vector<Spriteset_MapDoom::Point>& points) {
-	Point centroid = computeCentroid(points);
-	std::sort(points.begin(), points.end(), [centroid](const Point& a, const Point& b) {
-		return std::atan2(a.y - centroid.y, a.x - centroid.x) < std::atan2(b.y - centroid.y, b.x - centroid.x);
-		});
-}
-
-void Spriteset_MapDoom::drawPolygon(std::vector<Spriteset_MapDoom::Point> vertices) {
-
-	if (vertices.size() < 3) return;  // Pas un polygone valide
-
-	Color color = Color(255, 255, 0, 255);
-
-	color = vertices[0].color;
-
-	int z = 0;
-	float z_sum = 0.0;
-
-	// Additionner toutes les valeurs de Z
-	for (const auto& point : vertices) {
-		z_sum += point.z;
-	}
-
-	// Calculer la moyenne
-	z = z_sum / vertices.size();
-
-	// Trouver les bornes verticales (y_min et y_max)
-	int y_min = vertices[0].y;
-	int y_max = vertices[0].y;
-	for (const auto& p : vertices) {
-		y_min = std::min(y_min, (int) p.y);
-		y_max = std::max(y_max, (int) p.y);
-	}
-
-	// Pour chaque ligne horizontale (scanline), déterminer les vertices d'intersection
-	for (int y = y_min; y <= y_max; ++y) {
-		std::vector<int> intersections;
-
-		// Trouver les vertices d'intersection entre la ligne de balayage et les arêtes du polygone
-		for (size_t i = 0; i < vertices.size(); ++i) {
-			Point p1 = vertices[i];
-			Point p2 = vertices[(i + 1) % vertices.size()];  // Cycle pour connecter le dernier point au premier
-
-			// Vérifier si l'arête coupe la ligne de balayage
-			if ((p1.y <= y && p2.y > y) || (p2.y <= y && p1.y > y)) {
-				// Calculer le point d'intersection en x par interpolation linéaire
-				int x = p1.x + (y - p1.y) * (p2.x - p1.x) / (p2.y - p1.y);
-				intersections.push_back(x);
-			}
-		}
-
-		// Trier les intersections pour dessiner les segments horizontaux
-		std::sort(intersections.begin(), intersections.end());
-
-		// Remplir les pixels entre chaque paire de vertices d'intersection
-		for (size_t i = 0; i + 1 < intersections.size(); i += 2) {
-			int x_start = intersections[i];
-			int x_end = intersections[i + 1];
-			// TODO Remplacer pr la fonction line ?
-			for (int x = x_start; x <= x_end; ++x) {
-				pixel(x, y, z, color);  // Dessiner les pixels dans l'intervalle
-			}
-		}
-	}
-}
-
-
 float Spriteset_MapDoom::lerp(float a, float b, float f)
 {
 	return a + f * (b - a);
@@ -1728,73 +1579,52 @@ void Spriteset_MapDoom::rotate(Point& point, float x, float y, float z) {
 	point.y = new_y;
 }
 
-
-bool Spriteset_MapDoom::comparePoints(const Point& p1, const Point& p2) {
-	return p1.z < p2.z;
-}
-
-void Spriteset_MapDoom::Show() {
-
-	//Output::Debug("Start render");
+void Spriteset_MapDoom::renderModel() {
 
 	sprite->Clear();
 	spriteUpper->Clear();
 
-	float zmin = 0;
-	float zmax = 0;
-	bool f = true;
-	for (const auto& p : points) {
-		//Output::Debug(" {}", p.z);
-		if (f) {
-			zmax = p.z;
-			f = false;
-		}
-		else {
-			zmin = std::max(zmin, p.z);
-			zmax = std::min(zmax, p.z);
-		}
-	}
-
-	std::sort(points.begin(), points.end(), std::greater<Point>());
-
-	bool pointsZB[999][999] = { false };
-
-	Rect r;
-	Color c = Color(255,0,0,255);
-	for (auto p : points) {
-
-		//Output::Debug("AZE");
-
-		int i = p.x + 999 / 2;
-		int j = p.y + 999 / 2;
-
-		if (p.exist && !pointsZB[i][j])
-		{
-
-			pointsZB[i][j] = true;
-
-			r = Rect(p.x + displayX + Player::screen_width / 2, Player::screen_height - (p.y + displayY + Player::screen_height / 2), 1, 1);
-
-			int mult = ((p.z - zmin) / (zmax - zmin)) * 100;
-
-			int red, green, blue;
-			red = p.color.red;
-			green = p.color.green;
-			blue = p.color.blue;
-
-			// Output::Debug(" {} {} {}", red, green, blue);
-
-			c = Color(red * mult / 100, green * mult / 100, blue * mult / 100, 255);
-
-			sprite->FillRect(r, c);
+	// The last point tracks the rotation and is not part of the model
+	const int vertices = static_cast<int>(points3D.size()) - 1;
+	if (triangles.empty() || vertices <= 0)
+		return;
 
-			if (p.upper) {
-				c = Color(255, 0, 0, 255);
-				spriteUpper->FillRect(r, c);
-			}
+	// Nearer vertices (smaller z) are brighter
+	float zmin = points3D[0].z;
+	float zmax = points3D[0].z;
+	for (int i = 1; i < vertices; i++) {
+		zmin = std::min(zmin, points3D[i].z);
+		zmax = std::max(zmax, points3D[i].z);
+	}
+	const float range = zmax - zmin;
+
+	auto shade = [&](const Color& c, float z) {
+		int mult = range > 0 ? static_cast<int>((zmax - z) / range * 100) : 100;
+		return Color(c.red * mult / 100, c.green * mult / 100, c.blue * mult / 100, 255);
+	};
+
+	const float originX = displayX + Player::screen_width / 2;
+	const float originY = Player::screen_height - (displayY + Player::screen_height / 2);
+
+	auto vertex = [&](int i, const Color& c) {
+		const Point& p = points3D[i];
+		return DoomRasterizer::Vertex{ originX + p.x, originY - p.y, p.z, c };
+	};
+
+	rasterizer.Begin(*sprite, spriteUpper.get());
+
+	for (const auto& t : triangles) {
+		if (t.a < 0 || t.b < 0 || t.c < 0 || t.a >= vertices || t.b >= vertices || t.c >= vertices)
+			continue;
+
+		if (modelShading == Shading_Gouraud) {
+			rasterizer.DrawTriangle(
+				vertex(t.a, shade(t.color, points3D[t.a].z)),
+				vertex(t.b, shade(t.color, points3D[t.b].z)),
+				vertex(t.c, shade(t.color, points3D[t.c].z)));
+		} else {
+			Color c = shade(t.color, (points3D[t.a].z + points3D[t.b].z + points3D[t.c].z) / 3);
+			rasterizer.DrawTriangle(vertex(t.a, c), vertex(t.b, c), vertex(t.c, c));
 		}
 	}
-
-
-	//Output::Debug("Rendered");
 }
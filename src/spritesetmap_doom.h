@@ -1,21 +1,36 @@
 #ifndef EP_SPRITESET_MAP_DOOM_H
 #define EP_SPRITESET_MAP_DOOM_H
 
-#include <SDL2/SDL.h>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include "bitmap.h"
 #include <tilemap.h>
 #include "async_handler.h"
+#include "doom_rasterizer.h"
+#include "doom_raycaster.h"
 #include "sprite.h"
 #include "scene.h"
+#include "worker_pool.h"
 
 class Spriteset_MapDoom {
 public:
 
 	bool doomMap = false;
-	int map[999][999];
 
-	int mapW, mapH = 0;
+	/** Cell value of tiles without terrain tag */
+	static constexpr int map_cell_none = 255;
+	/** Terrain tag minus one of every tile, row major, mapW * mapH */
+	std::vector<uint8_t> map;
+
+	int mapW = 0, mapH = 0;
+
+	/**
+	 * @param x tile x
+	 * @param y tile y
+	 * @return terrain tag minus one, -1 without tag or outside of the map
+	 */
+	int mapCell(int x, int y) const;
 
 	// Structure reprsentant le joueur
 	struct PlayerDoom {
@@ -35,7 +50,9 @@ public:
 		float distance; 
 		int textureX; 
 		int evID;
-		Point position;
+		::Point position;
+		/** Distance between ray and tile center of upper layer billboards */
+		float offset = 0;
 
 		bool operator > (const DrawingDoom& d) const
 		{
@@ -61,19 +78,100 @@ public:
 		}
 	};
 
-	struct EventWall {
-		int x, y, id, type, tileSprite;
+	/** Walls, wall events and upper layer tiles of the map */
+	DoomRaycaster raycaster;
+
+	/** Draw list of a band of screen columns */
+	struct ColumnBand {
+		std::vector<DrawingDoom> drawings;
+		/** index in drawings of the upper layer billboard of a tile */
+		std::unordered_map<int, int> billboards;
+		std::vector<DoomRaycaster::Hit> hits;
 	};
-	std::vector<EventWall> events_wall;
+	std::vector<ColumnBand> column_bands;
+
+	/** Renders the floor and casts the rays, nullptr renders on the main thread */
+	std::unique_ptr<WorkerPool> render_pool;
+
+	/**
+	 * Sets the amount of threads rendering the map.
+	 *
+	 * @param workers thread count, 0 renders on the main thread
+	 */
+	void setRenderWorkers(int workers);
 
 	float castRay7();
-	float castRay(float rayAngle, int &ray, std::vector<DrawingDoom> &d, int x, int &mx, int &my);
+	/**
+	 * Casts the ray of a screen column and appends the walls, wall events
+	 * and upper layer billboards it hits to the draw list of the band.
+	 *
+	 * @param raycaster map grid
+	 * @param player camera
+	 * @param rayAngle ray angle in radians
+	 * @param x screen column
+	 * @param band draw list of the column band
+	 */
+	static void castRay(const DoomRaycaster& raycaster, const PlayerDoom& player, float rayAngle, int x, ColumnBand& band);
+
+	/**
+	 * Casts the rays of all screen columns. The columns are split into one
+	 * band per worker and every band fills its own draw list. The lists are
+	 * merged in column order, the result does not depend on the worker count.
+	 *
+	 * @param raycaster map grid
+	 * @param player camera
+	 * @param width screen width in columns
+	 * @param pool workers, nullptr casts on the calling thread
+	 * @param bands scratch data of the bands, reused between frames
+	 * @param out receives the merged draw list
+	 */
+	static void castColumns(const DoomRaycaster& raycaster, const PlayerDoom& player, int width,
+		WorkerPool* pool, std::vector<ColumnBand>& bands, std::vector<DrawingDoom>& out);
 	void renderScene();
 	void renderMode7();
 
-	float renderTexturedFloor(float x, float distance, float angle);
+	/**
+	 * Draws the floor row by row into sprite, sampling tile_atlas.
+	 * Each column ends at the first wall seen from the bottom of the screen.
+	 */
+	void renderFloor();
+	/** Copies the floor tiles and upper layer billboards into tile_atlas */
+	void buildTileAtlas();
 	void renderTexturedFloor();
-	BitmapRef mapTexture(int x, int y, int layer = 0);
+
+	/**
+	 * Looks up the tile of a map position in tile_atlas, tiles missing
+	 * in the atlas are added.
+	 *
+	 * @param x tile x
+	 * @param y tile y
+	 * @param layer 0 lower layer, 1 upper layer
+	 * @param rect receives the atlas cell of the tile
+	 * @return Whether the position has a tile
+	 */
+	bool mapTexture(int x, int y, int layer, Rect& rect);
+
+	/**
+	 * Appends a tile to tile_atlas.
+	 *
+	 * @param texture TILE_SIZE tile
+	 * @return atlas cell of the tile
+	 */
+	int addAtlasTile(const Bitmap& texture);
+	Rect atlasRect(int cell) const;
+
+	/** Distinct tiles of both layers, chipset wide, TILE_SIZE cells */
+	BitmapRef tile_atlas;
+	int tile_atlas_columns = 1;
+	int tile_atlas_cells = 0;
+	/** Atlas cell of every tile ID of the lower and upper layer, -1 when not loaded */
+	std::vector<int> tile_cells[2];
+	/** Atlas cell of every map tile, -1 for walls */
+	std::vector<int> floor_cells;
+	/** Per frame scratch data of renderFloor */
+	std::vector<float> ray_cos;
+	std::vector<float> ray_sin;
+	std::vector<uint8_t> floor_done;
 
 	void DrawEvents(std::vector<DrawingDoom> &d, float FOV);
 
@@ -85,6 +183,12 @@ public:
 	int mapWidth();
 	int mapHeight();
 
+	/** @return bytes used by the map grid, the raycaster and the tile atlas */
+	size_t memoryUsage() const;
+	size_t tileAtlasMemoryUsage() const;
+	/** Logs the memory used for the current map */
+	void logMemoryUsage() const;
+
 	int displayX = 0;
 	int displayY = 0;
 	int rotationX = 0;
@@ -100,38 +204,44 @@ public:
 
 	void setRotation(int rx, int ry, int rz);
 	void getRotation(int varX, int varY, int varZ);
-	void Spriteset_MapDoom::normalizeAngle(double& angle);
+	void normalizeAngle(double& angle);
 
 	void Update(bool first);
 
 	BitmapRef sprite;
 	BitmapRef spriteUpper;
-	BitmapRef lastTile;
 
-	void pixel(float x, float y, float z, Color c);
-	void line(Point p1, Point p2);
 	void rotate(Point& point, float x = 1, float y = 1, float z = 1);
 
-	Spriteset_MapDoom::Point computeCentroid(const std::vector<Spriteset_MapDoom::Point>& points);
-	void sortPoints(std::vector<Spriteset_MapDoom::Point>& points);
-	void drawPolygon(std::vector<Point> vertices);
-	bool comparePoints(const Spriteset_MapDoom::Point& p1, const Spriteset_MapDoom::Point& p2);
-
 	float lerp(float a, float b, float f);
 
 	void Load_OBJ(std::string name);
 	std::vector<std::string> split(const std::string& s, const std::string& delimiter);
 
-	std::vector<Point> points;
 	std::vector <Point> points3D;
 	std::vector <connection> connections3D;
 
+	/** Model face, indices into points3D */
+	struct Triangle {
+		int a, b, c;
+		Color color;
+	};
+	std::vector<Triangle> triangles;
 
-	std::vector <std::vector<Point>> surfaces;
+	enum ModelShading {
+		/** One color per face from its average depth */
+		Shading_Flat,
+		/** Colors interpolated from the depth of every vertex */
+		Shading_Gouraud
+	};
+	ModelShading modelShading = Shading_Flat;
 
-	vec3 centeroid;
+	DoomRasterizer rasterizer;
+
+	/** Rasterizes the model into sprite, spriteUpper marks the parts with negative depth */
+	void renderModel();
 
-	void Show();
+	vec3 centeroid;
 
 
 	int refresh_index = 0;
@@ -145,8 +255,6 @@ public:
 	//std::unique_ptr<Scene_Map*> scene_map;
 	//std::unique_ptr<Scene_Map> scene_map;
 	//BitmapRef mapTextures[9999][999];
-	BitmapRef mapTexturesID[9999];
-	BitmapRef mapTexturesUpperID[9999];
 
 	float scaleX = 96;
 	float scaleY = scaleX;
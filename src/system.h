@@ -107,6 +107,11 @@
 #  define SUPPORT_KEYBOARD
 #endif
 
+// Images are decoded by worker threads on desktop platforms
+#if defined(HAVE_THREADS) && (defined(_WIN32) || defined(SYSTEM_DESKTOP_LINUX_BSD_MACOS))
+#  define SUPPORT_ASYNC_DECODE
+#endif
+
 #ifdef SUPPORT_JOYSTICK_AXIS
 #  define JOYSTICK_STICK_SENSIBILITY 0.6
 #  define JOYSTICK_TRIGGER_SENSIBILITY 0.2
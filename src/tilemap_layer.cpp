@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 #include "tilemap_layer.h"
@@ -203,15 +204,6 @@ TilemapLayer::TilemapLayer(int ilayer) :
 	// Its z-value should be between the z of the events in the upper layer and the hero
 	upper_layer(this, Priority_TilesetAbove + TileAbove + layer)
 {
-
-
-
-    // Buffer for dealing with transformations.
-	work_bitmap = Bitmap::Create(MODE7_CANVAS_HALFSIZE*2, MODE7_CANVAS_HALFSIZE*2);
-	work_bitmap2 = Bitmap::Create(MODE7_CANVAS_HALFSIZE*2, MODE7_CANVAS_HALFSIZE*2);
-
-
-
 }
 
 // This setup of having an always inlined DrawTile() which dispatches to DrawTileImpl()
@@ -229,15 +221,7 @@ void TilemapLayer::DrawTileImpl(Bitmap& dst, Bitmap& tileset, Bitmap& tone_tiles
 
 	auto rect = Rect{ col * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE };
 
-	auto* src = &tileset;
-
-	// Create tone changed tile
-	if (tone != Tone()) {
-		if (chipset_tone_tiles.insert(tone_hash).second) {
-			tone_tileset.ToneBlit(col * TILE_SIZE, row * TILE_SIZE, tileset, rect, tone, Opacity::Opaque());
-		}
-		src = &tone_tileset;
-	}
+	auto* src = &GetToneTile(tileset, tone_tileset, row, col, tone_hash);
 
 	bool use_fast_blit = fast_blit && allow_fast_blit;
 	if (op == ImageOpacity::Opaque || use_fast_blit) {
@@ -247,6 +231,19 @@ void TilemapLayer::DrawTileImpl(Bitmap& dst, Bitmap& tileset, Bitmap& tone_tiles
 	}
 }
 
+Bitmap& TilemapLayer::GetToneTile(Bitmap& tileset, Bitmap& tone_tileset, int row, int col, uint32_t tone_hash) {
+	if (tone == Tone()) {
+		return tileset;
+	}
+
+	// Create tone changed tile
+	if (chipset_tone_tiles.insert(tone_hash).second) {
+		auto rect = Rect{ col * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE };
+		tone_tileset.ToneBlit(col * TILE_SIZE, row * TILE_SIZE, tileset, rect, tone, Opacity::Opaque());
+	}
+	return tone_tileset;
+}
+
 static uint32_t MakeFTileHash(int id) {
 	return static_cast<uint32_t>(id);
 }
@@ -267,43 +264,37 @@ static uint32_t MakeAbTileHash(int id, int anim_step) {
 	return static_cast<uint32_t>((id + (anim_step << 12)) | (4 << 24));
 }
 
-void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_oy) {
-
-
-	// Get current Mode7 state.
-	const bool mode7 = Game_Map::GetIsMode7();
-	const int total_width = mode7 ? work_bitmap->GetWidth() : Player::screen_width;
-	const int total_height = mode7 ? work_bitmap->GetHeight() : Player::screen_height;
-	const int adjusted_render_ox = mode7 ? render_ox + ((total_width - Player::screen_width) / 2) : render_ox;
-	const int adjusted_render_oy = mode7 ? render_oy + ((total_height - Player::screen_height) / 2) : render_oy;
-	Bitmap& intermediateDst = mode7 ? *work_bitmap.get() : dst;
-	if (mode7) {
-		work_bitmap.get()->Clear();
-		work_bitmap2.get()->Clear();
+void TilemapLayer::GetAnimationSteps(int& step_c, int& step_ab) const {
+	// FIXME: When Game_Map singleton is made an object we can remove this null check
+	const auto frames = Main_Data::game_system ? static_cast<uint32_t>(Main_Data::game_system->GetFrameCounter()) : 0u;
+	step_c = (frames / 6) % 4;
+	step_ab = frames / animation_speed;
+	if (animation_type) {
+		step_ab %= 3;
+	} else {
+		step_ab %= 4;
+		if (step_ab == 3) {
+			step_ab = 1;
+		}
 	}
+}
 
-
+void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_oy) {
+	if (Game_Map::GetIsMode7()) {
+		DrawMode7(dst, z_order, render_ox, render_oy);
+		return;
+	}
 
 	// Get the number of tiles that can be displayed on window
-//	int tiles_x = (int)ceil(Player::screen_width / (float)TILE_SIZE);
-//	int tiles_y = (int)ceil(Player::screen_height / (float)TILE_SIZE);
-
-    int tiles_x = (int)ceil(total_width / (float)TILE_SIZE);
-	int tiles_y = (int)ceil(total_height / (float)TILE_SIZE);
-
+	int tiles_x = (int)ceil(Player::screen_width / (float)TILE_SIZE);
+	int tiles_y = (int)ceil(Player::screen_height / (float)TILE_SIZE);
 
 	// If ox or oy are not equal to the tile size draw the next tile too
 	// to prevent black (empty) tiles at the borders
-//	if ((ox - render_ox) % TILE_SIZE != 0) {
-     if ((ox - adjusted_render_ox) % TILE_SIZE != 0) {
-
+	if ((ox - render_ox) % TILE_SIZE != 0) {
 		++tiles_x;
 	}
-
-
-//	if ((oy - render_oy) % TILE_SIZE != 0) {
-    if ((ox - adjusted_render_ox) % TILE_SIZE != 0) {
-
+	if ((oy - render_oy) % TILE_SIZE != 0) {
 		++tiles_y;
 	}
 
@@ -319,32 +310,13 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 		return rem >= 0 ? rem : m + rem;
 	};
 
-	// FIXME: When Game_Map singleton is made an object we can remove this null check
-	const auto frames = Main_Data::game_system ? static_cast<uint32_t>(Main_Data::game_system->GetFrameCounter()) : 0u;
-	auto animation_step_c = (frames / 6) % 4;
-	auto animation_step_ab = frames / animation_speed;
-	if (animation_type) {
-		animation_step_ab %= 3;
-	} else {
-		animation_step_ab %= 4;
-		if (animation_step_ab == 3) {
-			animation_step_ab = 1;
-		}
-	}
-
-
-//	const int div_ox = div_rounding_down(ox - render_ox, TILE_SIZE);
-//	const int div_oy = div_rounding_down(oy - render_oy, TILE_SIZE);
-
-    const int div_ox = div_rounding_down(ox - adjusted_render_ox, TILE_SIZE);
-	const int div_oy = div_rounding_down(oy - adjusted_render_oy, TILE_SIZE);
-
+	int animation_step_c, animation_step_ab;
+	GetAnimationSteps(animation_step_c, animation_step_ab);
 
-//	const int mod_ox = mod(ox - render_ox, TILE_SIZE);
-//	const int mod_oy = mod(oy - render_oy, TILE_SIZE);
-
-	const int mod_ox = mod(ox - adjusted_render_ox, TILE_SIZE);
-	const int mod_oy = mod(oy - adjusted_render_oy, TILE_SIZE);
+	const int div_ox = div_rounding_down(ox - render_ox, TILE_SIZE);
+	const int div_oy = div_rounding_down(oy - render_oy, TILE_SIZE);
+	const int mod_ox = mod(ox - render_ox, TILE_SIZE);
+	const int mod_oy = mod(oy - render_oy, TILE_SIZE);
 
 
 	for (int y = 0; y < tiles_y; y++) {
@@ -394,8 +366,7 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 						}
 
 						auto tone_hash = MakeETileHash(id);
-//						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-					DrawTile(intermediateDst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
+						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
 
 					} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
 						// If Block C
@@ -405,8 +376,7 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 						int row = 4 + animation_step_c;
 
 						auto tone_hash = MakeCTileHash(tile.ID, animation_step_c);
-//						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-                        DrawTile(intermediateDst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
+						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
 					} else if (tile.ID < BLOCK_C) {
 						// If Blocks A1, A2, B
 
@@ -418,8 +388,7 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 
 						// Create tone changed tile
 						auto tone_hash = MakeAbTileHash(tile.ID,  animation_step_ab);
-//						DrawTile(dst, *autotiles_ab_screen, *autotiles_ab_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-                    DrawTile(intermediateDst, *autotiles_ab_screen, *autotiles_ab_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
+						DrawTile(dst, *autotiles_ab_screen, *autotiles_ab_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
 					} else {
 						// If blocks D1-D12
 
@@ -430,8 +399,7 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 						int row = pos.y;
 
 						auto tone_hash = MakeDTileHash(tile.ID);
-//						DrawTile(dst, *autotiles_d_screen, *autotiles_d_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-                        DrawTile(intermediateDst, *autotiles_d_screen, *autotiles_d_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
+						DrawTile(dst, *autotiles_d_screen, *autotiles_d_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
 
 					}
 				} else {
@@ -454,57 +422,279 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 						}
 
 						auto tone_hash = MakeFTileHash(id);
-//						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash);
-                        DrawTile(intermediateDst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, mode7);
+						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash);
 					}
 				}
 			}
 		}
 	}
+}
 
+namespace {
+	/** Scales a premultiplied pixel by opacity / 255 */
+	inline uint32_t ScalePixel(uint32_t pixel, uint32_t opacity) {
+		uint32_t rb = (pixel & 0x00FF00FF) * opacity + 0x00800080;
+		rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+		uint32_t ag = ((pixel >> 8) & 0x00FF00FF) * opacity + 0x00800080;
+		ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+		return rb | ag;
+	}
+}
 
-	if (mode7) {
-		// Get map properties.
-		float yaw = Game_Map::GetMode7Yaw();
-		int slant = Game_Map::GetMode7Slant();
-		int horizon = Game_Map::GetMode7Horizon();
-		int scaledHorizon = (horizon * (90 - slant)) / 90;
-		// Rotate.
-		double angle = (yaw * (2 * M_PI) / 360);
-		int rotationOX = MODE7_CANVAS_HALFSIZE-8;
-		int rotationOY = MODE7_CANVAS_HALFSIZE;
-		work_bitmap2.get()->RotateZoomOpacityBlit(rotationOX, rotationOY+4, rotationOX, rotationOY,
-			intermediateDst, intermediateDst.GetRect(), angle, 1, 1, Opacity::Opaque());
-		// Draw line by line.
-		const int scrW = Player::screen_width;
-		const int scrH = Player::screen_height;
-		const int half_scrW = scrW / 2;
-		const int half_scrH = scrH / 2;
-		int horscan = scaledHorizon * 2;
-		int baseline = half_scrH + Game_Map::GetMode7Baseline();
-		double scale = Game_Map::GetMode7Scale();
-		double distance, zoom;
-		double iConst = 1 + (slant / (baseline + scaledHorizon));
-		double distanceBase = slant * scale / (baseline + scaledHorizon);
-		double syBase = MODE7_CANVAS_HALFSIZE + distanceBase*2;
-		for (int ly = 0; ly < scrH; ly++) {
-			distance = (slant * scale) / (ly + scaledHorizon);
-			zoom = iConst - (distance / scale);
-			if (zoom > 0.001) {
-				int li = ly - horscan;
-				int opacity = zoom * zoom * 1024;
-				//
-				int sy = syBase - distance*2;
-				int scaledWidth = intermediateDst.GetWidth() * zoom * 2.0;
-				int displace = (scrW - scaledWidth) / 2;
-				Rect srcRect = Rect(0, sy, intermediateDst.GetWidth(), 1);
-				Rect dstRect = Rect(displace, ly, scaledWidth, 1);
-				dst.StretchBlit(dstRect, *work_bitmap2.get(), srcRect, Opacity(opacity), Bitmap::BlendMode::Normal);
+bool TilemapLayer::Mode7Key::operator==(const Mode7Key& other) const {
+	return view.yaw == other.view.yaw && view.slant == other.view.slant
+		&& view.horizon == other.view.horizon && view.baseline == other.view.baseline
+		&& view.scale == other.view.scale
+		&& ox == other.ox && oy == other.oy
+		&& render_ox == other.render_ox && render_oy == other.render_oy
+		&& screen_width == other.screen_width && screen_height == other.screen_height
+		&& animation_step_c == other.animation_step_c && animation_step_ab == other.animation_step_ab
+		&& tone == other.tone;
+}
+
+void TilemapLayer::DrawMode7(Bitmap& dst, uint8_t z_order, int render_ox, int render_oy) {
+	Mode7View view;
+	view.yaw = Game_Map::GetMode7Yaw();
+	view.slant = static_cast<int>(Game_Map::GetMode7Slant());
+	view.horizon = Game_Map::GetMode7Horizon();
+	view.baseline = Game_Map::GetMode7Baseline();
+	view.scale = Game_Map::GetMode7Scale();
+
+	Mode7Key key;
+	key.view = view;
+	key.ox = ox;
+	key.oy = oy;
+	key.render_ox = render_ox;
+	key.render_oy = render_oy;
+	key.screen_width = Player::screen_width;
+	key.screen_height = Player::screen_height;
+	GetAnimationSteps(key.animation_step_c, key.animation_step_ab);
+	key.tone = tone;
+
+	// Both sublayers of a frame share one projection
+	if (mode7_dirty || !(key == mode7_key)) {
+		ProjectMode7(view, render_ox, render_oy, Game_Map::LoopHorizontal(), Game_Map::LoopVertical());
+		mode7_key = key;
+		mode7_dirty = false;
+	}
+
+	auto& sublayer = mode7_sublayers[z_order >= TileAbove ? 1 : 0];
+	if (sublayer) {
+		dst.Blit(0, 0, *sublayer, sublayer->GetRect(), Opacity::Opaque());
+	}
+}
+
+TilemapLayer::Mode7Tile TilemapLayer::GetMode7Tile(int map_x, int map_y, int animation_step_c, int animation_step_ab) {
+	Mode7Tile result;
+
+	TileData& tile = GetDataCache(map_x, map_y);
+	Bitmap* tileset = nullptr;
+	Bitmap* tone_tileset = nullptr;
+	int row = 0;
+	int col = 0;
+	uint32_t tone_hash = 0;
+
+	if (layer == 0) {
+		if (tile.ID >= BLOCK_E && tile.ID < BLOCK_E + BLOCK_E_TILES) {
+			int id = substitutions[tile.ID - BLOCK_E];
+			if (id < 96) {
+				col = 12 + id % 6;
+				row = id / 6;
+			} else {
+				col = 18 + (id - 96) % 6;
+				row = (id - 96) / 6;
 			}
+			tileset = chipset.get();
+			tone_tileset = chipset_effect.get();
+			tone_hash = MakeETileHash(id);
+		} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
+			col = 3 + (tile.ID - BLOCK_C) / 50;
+			row = 4 + animation_step_c;
+			tileset = chipset.get();
+			tone_tileset = chipset_effect.get();
+			tone_hash = MakeCTileHash(tile.ID, animation_step_c);
+		} else if (tile.ID < BLOCK_C) {
+			TileXY pos = GetCachedAutotileAB(tile.ID, animation_step_ab);
+			col = pos.x;
+			row = pos.y;
+			tileset = autotiles_ab_screen.get();
+			tone_tileset = autotiles_ab_screen_effect.get();
+			tone_hash = MakeAbTileHash(tile.ID, animation_step_ab);
+		} else {
+			TileXY pos = GetCachedAutotileD(tile.ID);
+			col = pos.x;
+			row = pos.y;
+			tileset = autotiles_d_screen.get();
+			tone_tileset = autotiles_d_screen_effect.get();
+			tone_hash = MakeDTileHash(tile.ID);
+		}
+	} else if (tile.ID >= BLOCK_F && tile.ID < BLOCK_F + BLOCK_F_TILES) {
+		int id = substitutions[tile.ID - BLOCK_F];
+		if (id < 48) {
+			col = 18 + id % 6;
+			row = 8 + id / 6;
+		} else {
+			col = 24 + (id - 48) % 6;
+			row = (id - 48) / 6;
+		}
+		tileset = chipset.get();
+		tone_tileset = chipset_effect.get();
+		tone_hash = MakeFTileHash(id);
+	}
+
+	if (!tileset || !tone_tileset || tileset->GetTileOpacity(col, row) == ImageOpacity::Transparent) {
+		return result;
+	}
+
+	Bitmap& src = GetToneTile(*tileset, *tone_tileset, row, col, tone_hash);
+	result.bitmap = &src;
+	result.x = col * TILE_SIZE;
+	result.y = row * TILE_SIZE;
+	result.sublayer = tile.z >= TileAbove ? 1 : 0;
+	if (src.bpp() == 4 && src.pixels()) {
+		result.stride = src.pitch() / 4;
+		result.pixels = reinterpret_cast<const uint32_t*>(src.pixels()) + result.y * result.stride + result.x;
+	}
+	return result;
+}
+
+void TilemapLayer::ProjectMode7(const Mode7View& view, int render_ox, int render_oy, bool loop_h, bool loop_v) {
+	const int scrW = Player::screen_width;
+	const int scrH = Player::screen_height;
+
+	for (auto& sublayer : mode7_sublayers) {
+		if (!sublayer || sublayer->GetWidth() != scrW || sublayer->GetHeight() != scrH) {
+			sublayer = Bitmap::Create(scrW, scrH, true);
+		} else {
+			sublayer->Clear();
 		}
 	}
 
+	auto div_rounding_down = [](int n, int m) {
+		if (n >= 0) return n / m;
+		return (n - m + 1) / m;
+	};
+	auto mod = [](int n, int m) {
+		int rem = n % m;
+		return rem >= 0 ? rem : m + rem;
+	};
+
+	// The map is seen through a canvas centered on the screen. The canvas is
+	// rotated around its center and every screen line stretches one line of it.
+	const int canvas = MODE7_CANVAS_HALFSIZE * 2;
+	const int canvas_x = ox - render_ox - (canvas - scrW) / 2;
+	const int canvas_y = oy - render_oy - (canvas - scrH) / 2;
 
+	// Tiles under the canvas, resolved once per projection
+	const int first_tile_x = div_rounding_down(canvas_x, TILE_SIZE);
+	const int first_tile_y = div_rounding_down(canvas_y, TILE_SIZE);
+	const int shift_x = canvas_x - first_tile_x * TILE_SIZE;
+	const int shift_y = canvas_y - first_tile_y * TILE_SIZE;
+	const int tiles_x = (shift_x + canvas + TILE_SIZE - 1) / TILE_SIZE;
+	const int tiles_y = (shift_y + canvas + TILE_SIZE - 1) / TILE_SIZE;
+
+	int animation_step_c, animation_step_ab;
+	GetAnimationSteps(animation_step_c, animation_step_ab);
+
+	mode7_tiles.assign(tiles_x * tiles_y, Mode7Tile());
+	for (int y = 0; y < tiles_y; y++) {
+		for (int x = 0; x < tiles_x; x++) {
+			int map_x = first_tile_x + x;
+			int map_y = first_tile_y + y;
+			if (loop_h) map_x = mod(map_x, width);
+			if (loop_v) map_y = mod(map_y, height);
+
+			if (map_x < 0 || map_x >= width || map_y < 0 || map_y >= height) {
+				continue;
+			}
+			mode7_tiles[y * tiles_x + x] = GetMode7Tile(map_x, map_y, animation_step_c, animation_step_ab);
+		}
+	}
+
+	const int scaled_horizon = (view.horizon * (90 - view.slant)) / 90;
+	const int baseline = scrH / 2 + view.baseline;
+	if (baseline + scaled_horizon == 0) {
+		return;
+	}
+
+	const double angle = view.yaw * (2 * M_PI) / 360;
+	const double cos_a = std::cos(angle);
+	const double sin_a = std::sin(angle);
+	// Rotation pivot on the canvas, the rotated canvas is 4 pixels lower
+	const double pivot_x = MODE7_CANVAS_HALFSIZE - 8;
+	const double pivot_y = MODE7_CANVAS_HALFSIZE;
+	const double pivot_shift = 4;
+
+	const double i_const = 1 + (view.slant / (baseline + scaled_horizon));
+	const double distance_base = view.slant * view.scale / (baseline + scaled_horizon);
+	const double sy_base = MODE7_CANVAS_HALFSIZE + distance_base * 2;
+
+	uint32_t* rows[2] = {};
+	int strides[2] = {};
+	for (int i = 0; i < 2; i++) {
+		if (mode7_sublayers[i]->bpp() == 4) {
+			rows[i] = reinterpret_cast<uint32_t*>(mode7_sublayers[i]->pixels());
+			strides[i] = mode7_sublayers[i]->pitch() / 4;
+		}
+	}
+
+	for (int ly = 0; ly < scrH; ly++) {
+		if (ly + scaled_horizon == 0) {
+			continue;
+		}
+		double distance = (view.slant * view.scale) / (ly + scaled_horizon);
+		double zoom = i_const - (distance / view.scale);
+		if (!(zoom > 0.001)) {
+			continue;
+		}
+
+		const uint32_t opacity = std::min(static_cast<int>(zoom * zoom * 1024), 255);
+		const int sy = sy_base - distance * 2;
+		const int scaled_width = canvas * zoom * 2.0;
+		if (opacity == 0 || sy < 0 || sy >= canvas || scaled_width <= 0) {
+			continue;
+		}
+
+		const int displace = (scrW - scaled_width) / 2;
+		const int x0 = std::max(displace, 0);
+		const int x1 = std::min(displace + scaled_width, scrW);
+
+		// Affine map of this line from the column u on the rotated canvas
+		// to the unrotated canvas, u is sampled at pixel centers
+		const double zoom_x = static_cast<double>(canvas) / scaled_width;
+		const double dy = sy + 0.5 - pivot_y - pivot_shift;
+		const double line_x = cos_a * (0.5 - pivot_x) + sin_a * dy + pivot_x;
+		const double line_y = -sin_a * (0.5 - pivot_x) + cos_a * dy + pivot_y;
+
+		for (int x = x0; x < x1; x++) {
+			const int u = static_cast<int>(zoom_x * (x - displace + 0.5));
+			const double cx = line_x + cos_a * u;
+			const double cy = line_y - sin_a * u;
+			if (cx < 0 || cy < 0 || cx >= canvas || cy >= canvas) {
+				continue;
+			}
+
+			const int px = static_cast<int>(cx) + shift_x;
+			const int py = static_cast<int>(cy) + shift_y;
+			const Mode7Tile& tile = mode7_tiles[(py / TILE_SIZE) * tiles_x + px / TILE_SIZE];
+			if (!tile.bitmap) {
+				continue;
+			}
+
+			const int tx = px % TILE_SIZE;
+			const int ty = py % TILE_SIZE;
+			uint32_t* row = rows[tile.sublayer];
+			if (tile.pixels && row) {
+				uint32_t pixel = tile.pixels[ty * tile.stride + tx];
+				if (pixel != 0) {
+					row[ly * strides[tile.sublayer] + x] = opacity == 255 ? pixel : ScalePixel(pixel, opacity);
+				}
+			} else {
+				mode7_sublayers[tile.sublayer]->Blit(x, ly, *tile.bitmap,
+					Rect(tile.x + tx, tile.y + ty, 1, 1), Opacity(opacity));
+			}
+		}
+	}
 }
 
 TilemapLayer::TileXY TilemapLayer::GetCachedAutotileAB(short ID, short animID) {
@@ -557,6 +747,7 @@ void TilemapLayer::CreateTileCacheAt(int x, int y, int tile_id) {
 		}
 	}
 	GetDataCache(x, y) = tile;
+	mode7_dirty = true;
 }
 
 void TilemapLayer::RecreateTileDataAt(int x, int y, int tile_id) {
@@ -766,6 +957,7 @@ BitmapRef TilemapLayer::GenerateAutotiles(int count, const std::unordered_map<ui
 
 void TilemapLayer::SetChipset(BitmapRef const& nchipset) {
 	chipset = nchipset;
+	mode7_dirty = true;
 	chipset_effect = Bitmap::Create(chipset->width(), chipset->height());
 	chipset_tone_tiles.clear();
 
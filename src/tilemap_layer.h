@@ -99,6 +99,28 @@ public:
 
 	void SetTone(Tone tone);
 
+	/** Camera of the Mode7 projection, see Game_Map::GetMode7Yaw() and friends */
+	struct Mode7View {
+		float yaw = 0;
+		int slant = 0;
+		int horizon = 0;
+		int baseline = 0;
+		double scale = 1;
+	};
+
+	/**
+	 * Projects both sublayers with Mode7 into screen sized buffers.
+	 * Every screen pixel samples its map tile directly, the canvas position
+	 * advances by one affine step per pixel along each scanline.
+	 *
+	 * @param view camera
+	 * @param render_ox render offset x
+	 * @param render_oy render offset y
+	 * @param loop_h whether the map loops horizontally
+	 * @param loop_v whether the map loops vertically
+	 */
+	void ProjectMode7(const Mode7View& view, int render_ox, int render_oy, bool loop_h, bool loop_v);
+
 	BitmapRef DrawTileDoom(int x, int y, bool allow_fast_blit = true);
 	int GetTileDoom(int map_x, int map_y, int layer);
 
@@ -107,8 +129,6 @@ public:
 private:
 	BitmapRef chipset;
 	BitmapRef chipset_effect;
-	BitmapRef work_bitmap;
-	BitmapRef work_bitmap2;
 	std::unordered_set<uint32_t> chipset_tone_tiles;
 	std::vector<short> map_data;
 	std::vector<uint8_t> passable;
@@ -129,6 +149,9 @@ private:
 	void GenerateAutotileD(short ID);
 	void DrawTile(Bitmap& dst, Bitmap& tile, Bitmap& tone_tile, int x, int y, int row, int col, uint32_t tone_hash, bool allow_fast_blit = true);
 	void DrawTileImpl(Bitmap& dst, Bitmap& tile, Bitmap& tone_tile, int x, int y, int row, int col, uint32_t tone_hash, ImageOpacity op, bool allow_fast_blit);
+	Bitmap& GetToneTile(Bitmap& tileset, Bitmap& tone_tileset, int row, int col, uint32_t tone_hash);
+	void GetAnimationSteps(int& step_c, int& step_ab) const;
+	void DrawMode7(Bitmap& dst, uint8_t z_order, int render_ox, int render_oy);
 	void RecalculateAutotile(int x, int y, int tile_id);
 
 	static const int TILES_PER_ROW = 64;
@@ -173,6 +196,44 @@ private:
 
 	Tone tone;
 
+	/** Source of a tile sampled by the Mode7 projection */
+	struct Mode7Tile {
+		/** Tileset holding the tile, nullptr when nothing is drawn */
+		Bitmap* bitmap = nullptr;
+		int x = 0;
+		int y = 0;
+		/** Top left pixel of the tile, nullptr when not 32 bit */
+		const uint32_t* pixels = nullptr;
+		int stride = 0;
+		/** 0 lower sublayer, 1 upper sublayer */
+		uint8_t sublayer = 0;
+	};
+
+	/** State of the last projection, both sublayers of a frame reuse it */
+	struct Mode7Key {
+		Mode7View view;
+		int ox = 0;
+		int oy = 0;
+		int render_ox = 0;
+		int render_oy = 0;
+		int screen_width = 0;
+		int screen_height = 0;
+		int animation_step_c = 0;
+		int animation_step_ab = 0;
+		Tone tone;
+
+		bool operator==(const Mode7Key& other) const;
+	};
+
+	Mode7Tile GetMode7Tile(int map_x, int map_y, int animation_step_c, int animation_step_ab);
+
+	/** Tiles under the Mode7 canvas, row major */
+	std::vector<Mode7Tile> mode7_tiles;
+	BitmapRef mode7_sublayers[2];
+	Mode7Key mode7_key;
+	/** Tiles or tilesets changed since the last projection */
+	bool mode7_dirty = true;
+
 	bool IsInMapBounds(int x, int y) const;
 };
 
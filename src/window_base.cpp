@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include "window_base.h"
@@ -120,32 +121,32 @@ void Window_Base::DrawActorFace(const Game_Actor& actor, int cx, int cy) {
 }
 
 void Window_Base::DrawActorName(const Game_Battler& actor, int cx, int cy) const {
-	contents->TextDraw(cx, cy, Font::ColorDefault, actor.GetName());
+	DrawTextField(cx, cy, Font::ColorDefault, actor.GetName());
 }
 
 void Window_Base::DrawActorTitle(const Game_Actor& actor, int cx, int cy) const {
-	contents->TextDraw(cx, cy, Font::ColorDefault, actor.GetTitle());
+	DrawTextField(cx, cy, Font::ColorDefault, actor.GetTitle());
 }
 
 void Window_Base::DrawActorClass(const Game_Actor& actor, int cx, int cy) const {
-	contents->TextDraw(cx, cy, Font::ColorDefault, actor.GetClassName());
+	DrawTextField(cx, cy, Font::ColorDefault, actor.GetClassName());
 }
 
 void Window_Base::DrawActorLevel(const Game_Actor& actor, int cx, int cy) const {
 	// Draw LV-String
-	contents->TextDraw(cx, cy, 1, lcf::Data::terms.lvl_short);
+	DrawTextField(cx, cy, 1, lcf::Data::terms.lvl_short);
 
 	// Draw Level of the Actor
-	contents->TextDraw(cx + (lcf::Data::system.easyrpg_max_level >= 100 ? 30 : 24), cy, Font::ColorDefault, std::to_string(actor.GetLevel()), Text::AlignRight);
+	DrawTextField(cx + (lcf::Data::system.easyrpg_max_level >= 100 ? 30 : 24), cy, Font::ColorDefault, std::to_string(actor.GetLevel()), Text::AlignRight);
 }
 
 void Window_Base::DrawActorState(const Game_Battler& actor, int cx, int cy) const {
 	// Unit has Normal state if no state is set
 	const lcf::rpg::State* state = actor.GetSignificantState();
 	if (!state) {
-		contents->TextDraw(cx, cy, Font::ColorDefault, lcf::Data::terms.normal_status);
+		DrawTextField(cx, cy, Font::ColorDefault, lcf::Data::terms.normal_status);
 	} else {
-		contents->TextDraw(cx, cy, state->color, state->name);
+		DrawTextField(cx, cy, state->color, state->name);
 	}
 }
 
@@ -154,7 +155,7 @@ void Window_Base::DrawActorExp(const Game_Actor& actor, int cx, int cy) const {
 	int width = 7;
 	if (actor.MaxExpValue() < 1000000) {
 		width = 6;
-		contents->TextDraw(cx, cy, 1, lcf::Data::terms.exp_short);
+		DrawTextField(cx, cy, 1, lcf::Data::terms.exp_short);
 	}
 
 	// Current Exp of the Actor
@@ -167,53 +168,53 @@ void Window_Base::DrawActorExp(const Game_Actor& actor, int cx, int cy) const {
 
 	// Exp for Level up
 	ss << std::setfill(' ') << std::setw(width) << actor.GetNextExpString();
-	contents->TextDraw(cx + (width == 6 ? 12 : 0), cy, Font::ColorDefault, ss.str(), Text::AlignLeft);
+	DrawTextField(cx + (width == 6 ? 12 : 0), cy, Font::ColorDefault, ss.str(), Text::AlignLeft);
 }
 
 void Window_Base::DrawActorHp(const Game_Battler& actor, int cx, int cy, int digits, bool draw_max) const {
 	// Draw HP-String
-	contents->TextDraw(cx, cy, 1, lcf::Data::terms.hp_short);
+	DrawTextField(cx, cy, 1, lcf::Data::terms.hp_short);
 
 	// Draw Current HP of the Actor
 	cx += 12;
 	// Color: 0 okay, 4 critical, 5 dead
 	int color = GetValueFontColor(actor.GetHp(), actor.GetMaxHp(), true);
 	auto dx = digits * 6;
-	contents->TextDraw(cx + dx, cy, color, std::to_string(actor.GetHp()), Text::AlignRight);
+	DrawTextField(cx + dx, cy, color, std::to_string(actor.GetHp()), Text::AlignRight);
 
 	if (!draw_max)
 		return;
 
 	// Draw the /
 	cx += dx;
-	contents->TextDraw(cx, cy, Font::ColorDefault, "/");
+	DrawTextField(cx, cy, Font::ColorDefault, "/");
 
 	// Draw Max Hp
 	cx += 6;
-	contents->TextDraw(cx + dx, cy, Font::ColorDefault, std::to_string(actor.GetMaxHp()), Text::AlignRight);
+	DrawTextField(cx + dx, cy, Font::ColorDefault, std::to_string(actor.GetMaxHp()), Text::AlignRight);
 }
 
 void Window_Base::DrawActorSp(const Game_Battler& actor, int cx, int cy, int digits, bool draw_max) const {
 	// Draw SP-String
-	contents->TextDraw(cx, cy, 1, lcf::Data::terms.sp_short);
+	DrawTextField(cx, cy, 1, lcf::Data::terms.sp_short);
 
 	// Draw Current SP of the Actor
 	cx += 12;
 	// Color: 0 okay, 4 critical/empty
 	int color = GetValueFontColor(actor.GetSp(), actor.GetMaxSp(), false);
 	auto dx = digits * 6;
-	contents->TextDraw(cx + dx, cy, color, std::to_string(actor.GetSp()), Text::AlignRight);
+	DrawTextField(cx + dx, cy, color, std::to_string(actor.GetSp()), Text::AlignRight);
 
 	if (!draw_max)
 		return;
 
 	// Draw the /
 	cx += dx;
-	contents->TextDraw(cx, cy, Font::ColorDefault, "/");
+	DrawTextField(cx, cy, Font::ColorDefault, "/");
 
 	// Draw Max Sp
 	cx += 6;
-	contents->TextDraw(cx + dx, cy, Font::ColorDefault, std::to_string(actor.GetMaxSp()), Text::AlignRight);
+	DrawTextField(cx + dx, cy, Font::ColorDefault, std::to_string(actor.GetMaxSp()), Text::AlignRight);
 }
 
 void Window_Base::DrawActorParameter(const Game_Battler& actor, int cx, int cy, int type) const {
@@ -242,10 +243,10 @@ void Window_Base::DrawActorParameter(const Game_Battler& actor, int cx, int cy,
 	}
 
 	// Draw Term
-	contents->TextDraw(cx, cy, 1, name);
+	DrawTextField(cx, cy, 1, name);
 
 	// Draw Value
-	contents->TextDraw(cx + 78, cy, Font::ColorDefault, std::to_string(value), Text::AlignRight);
+	DrawTextField(cx + 78, cy, Font::ColorDefault, std::to_string(value), Text::AlignRight);
 }
 
 void Window_Base::DrawEquipmentType(const Game_Actor& actor, int cx, int cy, int type) const {
@@ -275,19 +276,19 @@ void Window_Base::DrawEquipmentType(const Game_Actor& actor, int cx, int cy, int
 		return;
 	}
 
-	contents->TextDraw(cx, cy, 1, name);
+	DrawTextField(cx, cy, 1, name);
 }
 
 void Window_Base::DrawItemName(const lcf::rpg::Item& item, int cx, int cy, bool enabled) const {
 	int color = enabled ? Font::ColorDefault : Font::ColorDisabled;
 
-	contents->TextDraw(cx, cy, color, item.name);
+	DrawTextField(cx, cy, color, item.name);
 }
 
 void Window_Base::DrawSkillName(const lcf::rpg::Skill& skill, int cx, int cy, bool enabled) const {
 	int color = enabled ? Font::ColorDefault : Font::ColorDisabled;
 
-	contents->TextDraw(cx, cy, color, skill.name);
+	DrawTextField(cx, cy, color, skill.name);
 }
 
 void Window_Base::DrawCurrencyValue(int money, int cx, int cy) const {
@@ -297,9 +298,9 @@ void Window_Base::DrawCurrencyValue(int money, int cx, int cy) const {
 	gold << money;
 
 	Rect gold_text_size = Text::GetSize(*Font::Default(), lcf::Data::terms.gold);
-	contents->TextDraw(cx, cy, 1, lcf::Data::terms.gold, Text::AlignRight);
+	DrawTextField(cx, cy, 1, lcf::Data::terms.gold, Text::AlignRight);
 
-	contents->TextDraw(cx - gold_text_size.width, cy, Font::ColorDefault, gold.str(), Text::AlignRight);
+	DrawTextField(cx - gold_text_size.width, cy, Font::ColorDefault, gold.str(), Text::AlignRight);
 }
 
 void Window_Base::DrawGauge(const Game_Battler& actor, int cx, int cy, int alpha) const {
@@ -335,11 +336,11 @@ void Window_Base::DrawGauge(const Game_Battler& actor, int cx, int cy, int alpha
 }
 
 void Window_Base::DrawActorHpValue(const Game_Battler& actor, int cx, int cy) const {
-	contents->TextDraw(cx, cy, GetValueFontColor(actor.GetHp(), actor.GetMaxHp(), true), std::to_string(actor.GetHp()), Text::AlignRight);
+	DrawTextField(cx, cy, GetValueFontColor(actor.GetHp(), actor.GetMaxHp(), true), std::to_string(actor.GetHp()), Text::AlignRight);
 }
 
 void Window_Base::DrawActorSpValue(const Game_Battler& actor, int cx, int cy) const {
-	contents->TextDraw(cx, cy, GetValueFontColor(actor.GetSp(), actor.GetMaxSp(), false), std::to_string(actor.GetSp()), Text::AlignRight);
+	DrawTextField(cx, cy, GetValueFontColor(actor.GetSp(), actor.GetMaxSp(), false), std::to_string(actor.GetSp()), Text::AlignRight);
 }
 
 int Window_Base::GetValueFontColor(int have, int max, bool can_knockout) const {
@@ -347,3 +348,197 @@ int Window_Base::GetValueFontColor(int have, int max, bool can_knockout) const {
 	if (max > 0 && (have <= max / 4)) return Font::ColorCritical;
 	return Font::ColorDefault;
 }
+
+namespace {
+	/**
+	 * Splits rect into the parts that are not in keep.
+	 *
+	 * @param rect rect to split
+	 * @param keep area to leave out
+	 * @param parts receives up to 4 parts, some can be empty
+	 */
+	void SplitRectExcept(Rect rect, Rect keep, std::array<Rect, 4>& parts) {
+		keep.Adjust(rect);
+		if (keep.IsEmpty()) {
+			parts = {{ rect, {}, {}, {} }};
+			return;
+		}
+
+		parts = {{
+			{ rect.x, rect.y, rect.width, keep.y - rect.y },
+			{ rect.x, keep.y + keep.height, rect.width, rect.y + rect.height - keep.y - keep.height },
+			{ rect.x, keep.y, keep.x - rect.x, keep.height },
+			{ keep.x + keep.width, keep.y, rect.x + rect.width - keep.x - keep.width, keep.height }
+		}};
+	}
+}
+
+void Window_Base::DrawTextField(int cx, int cy, int color, std::string_view text, Text::Alignment align) const {
+	if (!retain_text_fields) {
+		contents->TextDraw(cx, cy, color, text, align);
+		return;
+	}
+
+	ValidateTextFields();
+
+	auto font = contents->GetFont();
+	if (!font) {
+		font = Font::Default();
+	}
+	// The text colors are taken from the system graphic
+	auto system = Cache::SystemOrBlack();
+	auto system_id = system->GetId();
+
+	const TextFieldKey key(cx, cy, align);
+	auto& field = text_fields[key];
+	field.drawn = true;
+
+	if (field.font == font && field.color == color && field.text == text && field.system_id == system_id) {
+		if (!field.cleared.IsEmpty()) {
+			// Parts of the text are missing, drawing them again is enough
+			RedrawTextField(key, field, field.cleared);
+			field.cleared = {};
+		}
+		return;
+	}
+
+	if (field.font) {
+		ClearTextField(field);
+	}
+
+	// Same area as used by Text::Draw
+	Rect rect;
+	if (!text.empty()) {
+		rect = Text::GetSize(*font, text);
+		rect.x = cx;
+		if (align == Text::AlignCenter) {
+			rect.x -= rect.width / 2;
+		} else if (align == Text::AlignRight) {
+			rect.x -= rect.width;
+		}
+		rect.y = cy;
+		rect.width += 1;
+		rect.height += 1;
+	}
+
+	field.text = ToString(text);
+	field.font = font;
+	field.color = color;
+	field.system_id = ToString(system_id);
+	field.rect = rect;
+	field.cleared = {};
+
+	contents->TextDraw(cx, cy, color, text, align);
+}
+
+void Window_Base::BeginTextFields() {
+	ValidateTextFields();
+
+	for (auto& field : text_fields) {
+		field.second.drawn = false;
+	}
+}
+
+void Window_Base::EndTextFields() {
+	std::vector<TextField> unused;
+	for (auto it = text_fields.begin(); it != text_fields.end();) {
+		if (!it->second.drawn) {
+			unused.push_back(std::move(it->second));
+			it = text_fields.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (const auto& field : unused) {
+		ClearTextField(field);
+	}
+}
+
+void Window_Base::InvalidateTextFields(Rect rect) {
+	for (auto& entry : text_fields) {
+		auto& field = entry.second;
+
+		Rect cleared = rect;
+		cleared.Adjust(field.rect);
+		if (cleared.IsEmpty()) {
+			continue;
+		}
+
+		if (!field.cleared.IsEmpty()) {
+			// Only one area is tracked, use the bounding box
+			int x2 = std::max(cleared.x + cleared.width, field.cleared.x + field.cleared.width);
+			int y2 = std::max(cleared.y + cleared.height, field.cleared.y + field.cleared.height);
+			cleared.x = std::min(cleared.x, field.cleared.x);
+			cleared.y = std::min(cleared.y, field.cleared.y);
+			cleared.width = x2 - cleared.x;
+			cleared.height = y2 - cleared.y;
+		}
+		field.cleared = cleared;
+	}
+}
+
+void Window_Base::ClearTextFields() {
+	text_fields.clear();
+	text_fields_contents = contents;
+}
+
+void Window_Base::ValidateTextFields() const {
+	if (text_fields_contents.lock() != contents) {
+		// New contents, the old fields are not visible anymore
+		text_fields.clear();
+		text_fields_contents = contents;
+	}
+}
+
+void Window_Base::ClearTextField(const TextField& field) const {
+	if (field.rect.IsEmpty()) {
+		return;
+	}
+
+	// The area cleared by InvalidateTextFields can contain new drawings
+	std::array<Rect, 4> parts;
+	SplitRectExcept(field.rect, field.cleared, parts);
+	for (const auto& part : parts) {
+		if (!part.IsEmpty()) {
+			contents->ClearRect(part);
+		}
+	}
+
+	// Neighbouring texts can overlap with the cleared area (e.g. shadows)
+	for (const auto& entry : text_fields) {
+		const auto& other = entry.second;
+		if (&other == &field || other.rect.IsOutOfBounds(field.rect)) {
+			continue;
+		}
+
+		for (const auto& part : parts) {
+			RedrawTextField(entry.first, other, part);
+		}
+	}
+}
+
+void Window_Base::RedrawTextField(const TextFieldKey& key, const TextField& field, Rect area) const {
+	area.Adjust(field.rect);
+	if (area.IsEmpty()) {
+		return;
+	}
+
+	auto& text = text_field_scratch;
+	if (!text || text->width() < field.rect.width || text->height() < field.rect.height) {
+		int width = std::max(field.rect.width, text ? text->width() : 0);
+		int height = std::max(field.rect.height, text ? text->height() : 0);
+		text = Bitmap::Create(width, height, true);
+	} else {
+		text->ClearRect(Rect(0, 0, field.rect.width, field.rect.height));
+	}
+
+	// Only the missing pixels are drawn, blending the rest of the text a
+	// second time would darken anti-aliased edges
+	text->SetFont(field.font);
+	text->TextDraw(std::get<0>(key) - field.rect.x, std::get<1>(key) - field.rect.y, field.color, field.text,
+		static_cast<Text::Alignment>(std::get<2>(key)));
+
+	Rect src_rect(area.x - field.rect.x, area.y - field.rect.y, area.width, area.height);
+	contents->Blit(area.x, area.y, *text, src_rect, Opacity::Opaque());
+}
@@ -20,7 +20,9 @@
 
 // Headers
 #include <array>
+#include <memory>
 #include <string>
+#include <tuple>
 #include "window.h"
 #include "game_actor.h"
 #include "main_data.h"
@@ -73,6 +75,20 @@ public:
 	int GetValueFontColor(int have, int max, bool can_knockout) const;
 	/** @} */
 
+	/**
+	 * Draws a text into the contents.
+	 * When text fields are retained the text is only drawn when it differs
+	 * from the last text drawn at the same position and only the area of the
+	 * old text is cleared.
+	 *
+	 * @param cx x position, the right border for AlignRight
+	 * @param cy y position
+	 * @param color system color
+	 * @param text text to draw
+	 * @param align text alignment
+	 */
+	void DrawTextField(int cx, int cy, int color, std::string_view text, Text::Alignment align = Text::AlignLeft) const;
+
 	/**
 	 * Cancels async loading of faces.
 	 * Used to prevent rendering faces that are loaded too slow on the wrong page.
@@ -86,13 +102,64 @@ public:
 protected:
 	void OnFaceReady(FileRequestResult* result, int face_index, int cx, int cy, bool flip);
 
+	/**
+	 * Starts a redraw of all text fields.
+	 * Fields that are not drawn again until EndTextFields are cleared.
+	 */
+	void BeginTextFields();
+
+	/** Clears the text fields that were not drawn since BeginTextFields. */
+	void EndTextFields();
+
+	/**
+	 * Marks the text fields in an area of the contents that was cleared
+	 * outside of DrawTextField to be drawn again.
+	 *
+	 * @param rect cleared area
+	 */
+	void InvalidateTextFields(Rect rect);
+
+	/** Forgets all text fields, used after the contents were cleared. */
+	void ClearTextFields();
+
 	std::vector<FileRequestBinding> face_request_ids;
 
+	/** Whether DrawTextField skips texts that did not change */
+	bool retain_text_fields = false;
+
 	int current_frame = 0;
 	int total_frames = 0;
 	std::array<int, 2> old_position;
 	std::array<int, 2> new_position;
 
+private:
+	struct TextField {
+		std::string text;
+		FontRef font;
+		int color = 0;
+		/** System graphic providing the text colors */
+		std::string system_id;
+		/** Area of the text, including the shadow */
+		Rect rect;
+		/** Area of the text that was cleared by InvalidateTextFields */
+		Rect cleared;
+		/** Drawn since BeginTextFields */
+		bool drawn = false;
+	};
+
+	/** Key of a text field: x, y and alignment */
+	using TextFieldKey = std::tuple<int, int, int>;
+
+	void ValidateTextFields() const;
+	void ClearTextField(const TextField& field) const;
+	/** Draws the part of a text field inside area again */
+	void RedrawTextField(const TextFieldKey& key, const TextField& field, Rect area) const;
+
+	mutable std::map<TextFieldKey, TextField> text_fields;
+	/** Contents the text fields were drawn into */
+	mutable std::weak_ptr<Bitmap> text_fields_contents;
+	/** Scratch bitmap of RedrawTextField, only grows */
+	mutable BitmapRef text_field_scratch;
 };
 
 #endif
@@ -58,11 +58,26 @@ Window_BattleStatus::Window_BattleStatus(int ix, int iy, int iwidth, int iheight
 		SetOpacity(0);
 	}
 
+	// Refresh is called on every HP, SP and state change
+	retain_text_fields = true;
+
 	Refresh();
 }
 
 void Window_BattleStatus::Refresh() {
-	contents->Clear();
+	if (!enemy && lcf::Data::battlecommands.battle_type == lcf::rpg::BattleCommands::BattleType_gauge) {
+		// Faces are not retained
+		contents->Clear();
+		ClearTextFields();
+	} else if (Feature::HasRpg2k3BattleSystem() && lcf::Data::battlecommands.battle_type != lcf::rpg::BattleCommands::BattleType_alternative) {
+		// RefreshGauge draws the ATB gauge over the old one
+		Rect gauge_rect(156, 0, 16 + 25 + 16, contents->GetHeight());
+		contents->ClearRect(gauge_rect);
+		InvalidateTextFields(gauge_rect);
+	}
+
+	// Only texts that changed are cleared and drawn again
+	BeginTextFields();
 
 	if (enemy) {
 		item_max = Main_Data::game_enemyparty->GetBattlerCount();
@@ -108,16 +123,20 @@ void Window_BattleStatus::Refresh() {
 	}
 
 	RefreshGauge();
+
+	EndTextFields();
 }
 
 void Window_BattleStatus::RefreshGauge() {
 	if (Feature::HasRpg2k3BattleSystem()) {
 		if (lcf::Data::battlecommands.battle_type == lcf::rpg::BattleCommands::BattleType_alternative) {
+			Rect gauge_rect(192, 0, 45, 64);
 			if (lcf::Data::battlecommands.window_size == lcf::rpg::BattleCommands::WindowSize_small) {
-				contents->ClearRect(Rect(192, 0, 45, 58));
-			} else {
-				contents->ClearRect(Rect(192, 0, 45, 64));
+				gauge_rect.height = 58;
 			}
+			contents->ClearRect(gauge_rect);
+			// HP and SP are drawn over the gauge
+			InvalidateTextFields(gauge_rect);
 		}
 
 		for (int i = 0; i < item_max; ++i) {
@@ -0,0 +1,126 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "worker_pool.h"
+
+#ifdef HAVE_THREADS
+
+WorkerPool::WorkerPool(int num_threads) {
+	for (int i = 0; i < num_threads; ++i) {
+		threads.emplace_back(&WorkerPool::ThreadFunction, this);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done_cv.wait(lock, [this] { return jobs.empty() && running == 0; });
+		stop = true;
+	}
+	job_cv.notify_all();
+
+	for (auto& thread: threads) {
+		thread.join();
+	}
+}
+
+void WorkerPool::Push(Job job) {
+	if (threads.empty()) {
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	job_cv.notify_one();
+}
+
+void WorkerPool::Wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	done_cv.wait(lock, [this] { return jobs.empty() && running == 0; });
+}
+
+bool WorkerPool::IsBusy() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return !jobs.empty() || running > 0;
+}
+
+int WorkerPool::GetThreadCount() const {
+	return static_cast<int>(threads.size());
+}
+
+int WorkerPool::GetDefaultThreadCount(int max_threads) {
+	int hw = static_cast<int>(std::thread::hardware_concurrency());
+	return std::max(0, std::min(hw - 1, max_threads));
+}
+
+void WorkerPool::ThreadFunction() {
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			job_cv.wait(lock, [this] { return stop || !jobs.empty(); });
+			if (stop && jobs.empty()) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+			++running;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--running;
+		}
+		done_cv.notify_all();
+	}
+}
+
+#else
+
+WorkerPool::WorkerPool(int) {
+}
+
+WorkerPool::~WorkerPool() {
+}
+
+void WorkerPool::Push(Job job) {
+	job();
+}
+
+void WorkerPool::Wait() {
+}
+
+bool WorkerPool::IsBusy() const {
+	return false;
+}
+
+int WorkerPool::GetThreadCount() const {
+	return 0;
+}
+
+int WorkerPool::GetDefaultThreadCount(int) {
+	return 0;
+}
+
+#endif
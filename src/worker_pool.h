@@ -0,0 +1,96 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_WORKER_POOL_H
+#define EP_WORKER_POOL_H
+
+// Headers
+#include <functional>
+#include <deque>
+#include <vector>
+
+#ifdef HAVE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+/**
+ * Fixed size pool of worker threads executing queued jobs.
+ *
+ * On platforms without thread support (HAVE_THREADS undefined) or when
+ * created with 0 threads every job is executed immediately inside Push.
+ * Code using the pool therefore behaves identical everywhere, only the
+ * point in time where the work happens differs.
+ */
+class WorkerPool {
+public:
+	using Job = std::function<void()>;
+
+	/**
+	 * Creates the pool and starts the worker threads.
+	 *
+	 * @param num_threads amount of worker threads, 0 runs jobs inline
+	 */
+	explicit WorkerPool(int num_threads);
+
+	/** Waits for all pending jobs and stops the workers */
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/**
+	 * Queues a job for execution on a worker thread.
+	 *
+	 * @param job function to execute
+	 */
+	void Push(Job job);
+
+	/** Blocks until every queued job has finished */
+	void Wait();
+
+	/** @return whether jobs are queued or running */
+	bool IsBusy() const;
+
+	/** @return amount of worker threads */
+	int GetThreadCount() const;
+
+	/**
+	 * Suggested worker count for background work on this machine.
+	 * One hardware thread is left for the main loop.
+	 *
+	 * @param max_threads upper limit
+	 * @return worker count, 0 when threads are not supported
+	 */
+	static int GetDefaultThreadCount(int max_threads);
+
+private:
+#ifdef HAVE_THREADS
+	void ThreadFunction();
+
+	std::vector<std::thread> threads;
+	std::deque<Job> jobs;
+	mutable std::mutex mutex;
+	std::condition_variable job_cv;
+	std::condition_variable done_cv;
+	int running = 0;
+	bool stop = false;
+#endif
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include <lcf/data.h>
+#include <lcf/rpg/map.h>
+#include "asset_prefetch.h"
+#include "doctest.h"
+
+namespace {
+lcf::rpg::EventCommand MakeCommand(lcf::rpg::EventCommand::Code code, const std::string& string, std::vector<int32_t> params = {}) {
+	lcf::rpg::EventCommand com;
+	com.code = static_cast<int32_t>(code);
+	com.string = lcf::DBString(string);
+	com.parameters = lcf::DBArray<int32_t>(params.begin(), params.end());
+	return com;
+}
+
+lcf::rpg::Map MakeMap() {
+	using Cmd = lcf::rpg::EventCommand::Code;
+
+	lcf::rpg::Map map;
+	map.chipset_id = 1;
+	map.parallax_flag = true;
+	map.parallax_name = "Sky";
+
+	lcf::rpg::EventPage page;
+	page.character_name = "Hero";
+	page.event_commands.push_back(MakeCommand(Cmd::ShowPicture, "Pic", { 1, 0, 0, 0, 0, 100, 0, 1 }));
+	// Not transparent
+	page.event_commands.push_back(MakeCommand(Cmd::ShowPicture, "Opaque", { 1, 0, 0, 0, 0, 100, 0, 0 }));
+	page.event_commands.push_back(MakeCommand(Cmd::ChangeFaceGraphic, "Face", { 0, 0, 0 }));
+	page.event_commands.push_back(MakeCommand(Cmd::PlaySound, "Bell", { 100, 100, 50 }));
+	page.event_commands.push_back(MakeCommand(Cmd::PlayBGM, "Theme", { 0, 100, 100, 50 }));
+	page.event_commands.push_back(MakeCommand(Cmd::Teleport, "", { 5, 1, 1 }));
+
+	lcf::rpg::EventPage page2;
+	page2.character_name = "Hero";
+	page2.event_commands.push_back(MakeCommand(Cmd::PlaySound, "Bell", { 100, 100, 50 }));
+	page2.event_commands.push_back(MakeCommand(Cmd::Teleport, "", { 3, 1, 1 }));
+	page2.event_commands.push_back(MakeCommand(Cmd::Teleport, "", { 5, 2, 2 }));
+
+	lcf::rpg::Event ev;
+	ev.pages = { page, page2 };
+	map.events.push_back(ev);
+
+	return map;
+}
+}
+
+TEST_SUITE_BEGIN("AssetPrefetch");
+
+TEST_CASE("Collect") {
+	lcf::rpg::Chipset chipset;
+	chipset.ID = 1;
+	chipset.chipset_name = "World";
+	lcf::Data::chipsets = { chipset };
+
+	auto assets = AssetPrefetch::Collect(MakeMap());
+
+	using Image = std::pair<std::string, std::string>;
+	REQUIRE_EQ(assets.images.size(), 3);
+	// Chipset and panorama are needed first
+	CHECK_EQ(assets.images[0], Image("ChipSet", "World"));
+	CHECK_EQ(assets.images[1], Image("Panorama", "Sky"));
+	CHECK_EQ(assets.images[2], Image("CharSet", "Hero"));
+
+	REQUIRE_EQ(assets.event_images.size(), 2);
+	CHECK_EQ(assets.event_images[0], Image("FaceSet", "Face"));
+	CHECK_EQ(assets.event_images[1], Image("Picture", "Pic"));
+
+	CHECK_EQ(assets.sounds, std::vector<std::string>{ "Bell" });
+	CHECK_EQ(assets.music, std::vector<std::string>{ "Theme" });
+	CHECK_EQ(assets.maps, std::vector<int>{ 3, 5 });
+
+	lcf::Data::chipsets.clear();
+}
+
+TEST_CASE("CollectEmpty") {
+	auto assets = AssetPrefetch::Collect(lcf::rpg::Map());
+
+	CHECK(assets.images.empty());
+	CHECK(assets.event_images.empty());
+	CHECK(assets.sounds.empty());
+	CHECK(assets.music.empty());
+	CHECK(assets.maps.empty());
+}
+
+TEST_SUITE_END();
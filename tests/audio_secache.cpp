@@ -0,0 +1,199 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include "audio_secache.h"
+#include "doctest.h"
+
+#ifdef WANT_DRWAV
+
+namespace {
+// Mono 8 bit PCM WAV file
+std::vector<uint8_t> MakeWav(int samples) {
+	auto u32 = [](std::vector<uint8_t>& v, uint32_t x) {
+		for (int i = 0; i < 4; ++i) {
+			v.push_back((x >> (i * 8)) & 0xFF);
+		}
+	};
+	auto u16 = [](std::vector<uint8_t>& v, uint16_t x) {
+		v.push_back(x & 0xFF);
+		v.push_back(x >> 8);
+	};
+
+	std::vector<uint8_t> v;
+	v.insert(v.end(), { 'R', 'I', 'F', 'F' });
+	u32(v, 36 + samples);
+	v.insert(v.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+	u32(v, 16);
+	u16(v, 1);
+	u16(v, 1);
+	u32(v, 22050);
+	u32(v, 22050);
+	u16(v, 1);
+	u16(v, 8);
+	v.insert(v.end(), { 'd', 'a', 't', 'a' });
+	u32(v, samples);
+	for (int i = 0; i < samples; ++i) {
+		v.push_back(static_cast<uint8_t>(128 + (i % 64)));
+	}
+	return v;
+}
+
+std::unique_ptr<AudioSeCache> CreateSe(const std::string& name, int samples = 1000) {
+	auto se = AudioSeCache::GetCachedSe(name);
+	if (se) {
+		return se;
+	}
+	Filesystem_Stream::InputStream stream(new Filesystem_Stream::InputMemoryStreamBuf(MakeWav(samples)), name);
+	return AudioSeCache::Create(std::move(stream), name);
+}
+
+// Decodes and caches an SE like a play does
+void Play(const std::string& name) {
+	auto se = CreateSe(name);
+	REQUIRE(se);
+	se->CreateSeDecoder();
+}
+
+size_t SampleSize() {
+	AudioSeCache::Clear();
+	AudioSeCache::SetCacheLimit(1024 * 1024);
+	Play("probe");
+	auto size = AudioSeCache::GetStats().size;
+	AudioSeCache::Clear();
+	return size;
+}
+}
+
+TEST_SUITE_BEGIN("AudioSeCache");
+
+TEST_CASE("HitsAndMisses") {
+	AudioSeCache::Clear();
+	AudioSeCache::SetCacheLimit(1024 * 1024);
+
+	Play("a");
+	Play("a");
+	Play("b");
+
+	auto stats = AudioSeCache::GetStats();
+	CHECK_EQ(stats.hits, 1);
+	CHECK_EQ(stats.misses, 2);
+	CHECK_EQ(stats.evictions, 0);
+	CHECK_EQ(stats.entries, 2);
+
+	CHECK(AudioSeCache::IsCached("a"));
+	CHECK(!AudioSeCache::IsCached("c"));
+	CHECK_EQ(AudioSeCache::GetStats().hits, 1);
+}
+
+TEST_CASE("EvictsLeastRecentlyUsed") {
+	const size_t size = SampleSize();
+	REQUIRE(size > 0);
+	AudioSeCache::SetCacheLimit(size * 3);
+
+	Play("a");
+	Play("b");
+	Play("c");
+	// "a" becomes the most recently used sample
+	Play("a");
+	Play("d");
+
+	CHECK(AudioSeCache::IsCached("a"));
+	CHECK(!AudioSeCache::IsCached("b"));
+	CHECK(AudioSeCache::IsCached("c"));
+	CHECK(AudioSeCache::IsCached("d"));
+
+	auto stats = AudioSeCache::GetStats();
+	CHECK_EQ(stats.evictions, 1);
+	CHECK_EQ(stats.size, size * 3);
+}
+
+TEST_CASE("KeepsPlayingSamples") {
+	const size_t size = SampleSize();
+	AudioSeCache::SetCacheLimit(size);
+
+	auto playing = CreateSe("a");
+	auto dec = playing->CreateSeDecoder();
+	playing.reset();
+	Play("b");
+
+	// Only "b" is not in use anymore
+	AudioSeCache::SetCacheLimit(size);
+	CHECK(AudioSeCache::IsCached("a"));
+	CHECK(!AudioSeCache::IsCached("b"));
+
+	AudioSeCache::SetCacheLimit(0);
+	CHECK(AudioSeCache::IsCached("a"));
+	CHECK_EQ(AudioSeCache::GetStats().entries, 1);
+
+	dec.reset();
+	AudioSeCache::SetCacheLimit(0);
+	CHECK_EQ(AudioSeCache::GetStats().entries, 0);
+}
+
+TEST_CASE("PredecodeStopsAtLimit") {
+	const size_t size = SampleSize();
+	AudioSeCache::SetCacheLimit(size * 3);
+
+	Play("a");
+	CHECK(CreateSe("b")->Predecode());
+	CHECK(CreateSe("c")->Predecode());
+	// Limit reached, nothing is evicted
+	CHECK(!CreateSe("d")->Predecode());
+
+	auto stats = AudioSeCache::GetStats();
+	CHECK_EQ(stats.predecoded, 2);
+	CHECK_EQ(stats.evictions, 0);
+	CHECK(AudioSeCache::IsCached("a"));
+	CHECK(!AudioSeCache::IsCached("d"));
+
+	// Predecoded samples are freed before played samples
+	Play("e");
+	CHECK(AudioSeCache::IsCached("a"));
+	CHECK(AudioSeCache::IsCached("e"));
+	CHECK_EQ(AudioSeCache::GetStats().evictions, 1);
+	CHECK_EQ(AudioSeCache::GetStats().size, size * 3);
+}
+
+TEST_CASE("CountsPredecodeHits") {
+	AudioSeCache::Clear();
+	AudioSeCache::SetCacheLimit(1024 * 1024);
+
+	CHECK(CreateSe("a")->Predecode());
+	CHECK(CreateSe("b")->Predecode());
+	Play("a");
+	Play("a");
+
+	auto stats = AudioSeCache::GetStats();
+	CHECK_EQ(stats.predecoded, 2);
+	CHECK_EQ(stats.predecode_hits, 1);
+	CHECK_EQ(stats.hits, 2);
+}
+
+TEST_CASE("SameNameTwice") {
+	const size_t size = SampleSize();
+	AudioSeCache::SetCacheLimit(size * 4);
+
+	// Both are created before the sample is cached
+	auto first = CreateSe("a");
+	auto second = CreateSe("a");
+	CHECK(first->Predecode());
+	auto dec = second->CreateSeDecoder();
+	CHECK(first->Predecode());
+
+	auto stats = AudioSeCache::GetStats();
+	CHECK_EQ(stats.entries, 1);
+	CHECK_EQ(stats.size, size);
+	CHECK_EQ(first->GetSeData(), second->GetSeData());
+
+	// Nothing is left behind once evicted
+	first.reset();
+	second.reset();
+	dec.reset();
+	AudioSeCache::SetCacheLimit(0);
+	CHECK_EQ(AudioSeCache::GetStats().entries, 0);
+	CHECK_EQ(AudioSeCache::GetStats().size, 0);
+}
+
+TEST_SUITE_END();
+
+#endif
@@ -1,5 +1,6 @@
 #include <lcf/data.h>
 #include "doctest.h"
+#include "dynrpg_chunk.h"
 #include "game_dynrpg.h"
 #include "game_variables.h"
 #include "test_mock_actor.h"
@@ -147,6 +148,92 @@ TEST_CASE("Arg parse") {
 	CHECK(i == 0);
 }
 
+TEST_CASE("Arg parse integers") {
+	const MockActor m; // disable log
+
+	std::vector<std::string> args = {"12", "-7", "+5", "3"};
+	bool okay = false;
+
+	int i, i2, i3;
+	float f;
+
+	std::tie(i, i2, i3, f) = DynRpg::ParseArgs<int, int, int, float>("func", args, &okay);
+	CHECK(okay);
+	CHECK(i == 12);
+	CHECK(i2 == -7);
+	CHECK(i3 == 5);
+	CHECK(f == 3.0f);
+}
+
+TEST_CASE("Parse cached") {
+	const MockActor m;
+
+	std::vector<int32_t> vars = {4, 2};
+	Main_Data::game_variables->SetData(vars);
+	Main_Data::game_variables->SetWarning(0);
+
+	auto cmd = DynRpg::ParseCommandCached(R"(@FunC Abc, V2, "V1", VV2, 42)");
+	CHECK(cmd.function_name == "func");
+	REQUIRE(cmd.args.size() == 5);
+	CHECK(cmd.args[0] == "abc");
+	CHECK(cmd.args[2] == "V1");
+	CHECK(cmd.args[4] == "42");
+
+	REQUIRE(cmd.references.size() == 2);
+	CHECK(cmd.references[0].first == 1);
+	CHECK(cmd.references[1].first == 3);
+
+	std::vector<std::string> args;
+	std::vector<DynRpg::Number> numbers;
+	DynRpg::ResolveArgs(cmd, args, numbers);
+	REQUIRE(args.size() == 5);
+	REQUIRE(numbers.size() == 5);
+	CHECK(args[1] == "2");
+	CHECK(args[3] == "2");
+	CHECK(numbers[1].int_value == 2);
+
+	// References follow the variables
+	Main_Data::game_variables->Set(2, 1);
+	DynRpg::ResolveArgs(cmd, args, numbers);
+	CHECK(args[1] == "1");
+	CHECK(args[3] == "4");
+	CHECK(numbers[1].int_value == 1);
+	CHECK(numbers[3].int_value == 4);
+}
+
+TEST_CASE("Parse cached numbers") {
+	const MockActor m; // disable log
+
+	auto cmd = DynRpg::ParseCommandCached(R"(@FunC 12, -1.5, 1.5a, abc, "7")");
+	REQUIRE(cmd.numbers.size() == 5);
+	CHECK(cmd.numbers[0].is_int);
+	CHECK(cmd.numbers[0].int_value == 12);
+	CHECK(cmd.numbers[0].float_value == 12.0f);
+	CHECK(!cmd.numbers[1].is_int);
+	CHECK(cmd.numbers[1].is_float);
+	CHECK(cmd.numbers[1].float_value == -1.5f);
+	CHECK(!cmd.numbers[2].is_float);
+	CHECK(!cmd.numbers[3].is_float);
+	CHECK(cmd.numbers[4].int_value == 7);
+
+	bool okay = false;
+	int i, i2;
+	float f;
+	std::string s;
+	std::tie(i, f, s, i2) = DynRpg::ParseArgs<int, float, std::string, int>("func",
+		DynRpg::ArgList(cmd.args, cmd.numbers), &okay);
+	CHECK(okay);
+	CHECK(i == 12);
+	CHECK(f == -1.5f);
+	CHECK(s == "1.5a");
+	CHECK(i2 == 0);
+
+	// Without converted numbers the text is parsed as before
+	std::tie(f) = DynRpg::ParseArgs<float>("func", DynRpg::ArgList(cmd.args).subspan(2), &okay);
+	CHECK(okay);
+	CHECK(f == 1.5f);
+}
+
 TEST_CASE("easyrpg dynrpg invoke") {
 	Game_DynRpg dyn;
 	const MockActor m;
@@ -186,6 +273,62 @@ TEST_CASE("easyrpg dynrpg invoke") {
 	dyn.Invoke("@unknownfunc 1, 2, 3");
 }
 
+TEST_CASE("dynrpg invoke cached command") {
+	Game_DynRpg dyn;
+	const MockActor m;
+
+	Player::game_config.patch_dynrpg.Set(true);
+
+	std::vector<int32_t> vars = {0, 3};
+	Main_Data::game_variables->SetData(vars);
+	Main_Data::game_variables->SetWarning(0);
+
+	CHECK(dyn.GetFunctionId("easyrpg_add") >= 0);
+	CHECK(dyn.GetFunctionId("unknownfunc") == -1);
+
+	dyn.Invoke("@easyrpg_add 1, V2, 1");
+	CHECK(Main_Data::game_variables->Get(1) == 4);
+
+	// Same comment again, the variable is read on every call
+	Main_Data::game_variables->Set(2, 10);
+	dyn.Invoke("@easyrpg_add 1, V2, 1");
+	CHECK(Main_Data::game_variables->Get(1) == 11);
+}
+
+TEST_CASE("dynrpg invoke falls through") {
+	Game_DynRpg dyn;
+	const MockActor m;
+
+	Player::game_config.patch_dynrpg.Set(true);
+
+	std::vector<int> calls;
+	dyn.RegisterFunction("test_func", [&](dyn_arg_list, bool&, Game_Interpreter*) {
+		calls.push_back(1);
+		return false;
+	});
+	dyn.RegisterFunction("test_func", [&](dyn_arg_list args, bool&, Game_Interpreter*) {
+		calls.push_back(2);
+		return std::get<0>(DynRpg::ParseArgs<int>("test_func", args)) == 1;
+	});
+	dyn.RegisterFunction("test_func", [&](dyn_arg_list, bool&, Game_Interpreter*) {
+		calls.push_back(3);
+		return true;
+	});
+
+	// The first handler declines, the second handles the call
+	dyn.Invoke("@test_func 1");
+	CHECK(calls == std::vector<int>{1, 2});
+
+	calls.clear();
+	dyn.Invoke("@test_func 2");
+	CHECK(calls == std::vector<int>{1, 2, 3});
+
+	// Calls through @call fall through as well
+	calls.clear();
+	dyn.Invoke("@call test_func, 1");
+	CHECK(calls == std::vector<int>{1, 2});
+}
+
 TEST_CASE("Incompatible changes") {
 	const MockActor m; // disable log
 
@@ -207,4 +350,58 @@ TEST_CASE("Incompatible changes") {
 	CHECK(args[0] == "4");
 }
 
+TEST_CASE("Save chunk") {
+	DynRpg::ChunkWriter w(3);
+	w.WriteBool(true);
+	w.WriteU8(200);
+	w.WriteU16(60000);
+	w.WriteI32(-123456);
+	w.WriteU64(0x0123456789ABCDEFull);
+	w.WriteFloat(1.5f);
+	w.WriteDouble(-0.1);
+	w.WriteString("Hello, \n World");
+	// Header, values and the length prefixed string
+	CHECK(w.GetSize() == 6 + 28 + 4 + 14);
+	auto data = w.Finish();
+
+	REQUIRE(DynRpg::ChunkReader::IsBinaryChunk(data));
+	DynRpg::ChunkReader r(data);
+	CHECK(r.GetVersion() == 3);
+	CHECK(r.ReadBool());
+	CHECK(r.ReadU8() == 200);
+	CHECK(r.ReadU16() == 60000);
+	CHECK(r.ReadI32() == -123456);
+	CHECK(r.ReadU64() == 0x0123456789ABCDEFull);
+	CHECK(r.ReadFloat() == 1.5f);
+	CHECK(r.ReadDouble() == -0.1);
+	CHECK(r.ReadString() == "Hello, \n World");
+	CHECK(r.IsOk());
+	CHECK(r.AtEnd());
+
+	// Reading past the end fails without touching memory
+	CHECK(r.ReadU32() == 0);
+	CHECK(!r.IsOk());
+}
+
+TEST_CASE("Save chunk legacy") {
+	std::string json = R"({"a":{"filename":""}})";
+	std::string text = "0,0,Hello,0,255,0,1,id";
+
+	CHECK(!DynRpg::ChunkReader::IsBinaryChunk(std::vector<uint8_t>(json.begin(), json.end())));
+	CHECK(!DynRpg::ChunkReader::IsBinaryChunk(std::vector<uint8_t>(text.begin(), text.end())));
+	CHECK(!DynRpg::ChunkReader::IsBinaryChunk({}));
+
+	// Truncated string length
+	DynRpg::ChunkWriter w(1);
+	w.WriteU32(1000);
+	auto data = w.Finish();
+	DynRpg::ChunkReader r(data);
+	CHECK(r.ReadString().empty());
+	CHECK(!r.IsOk());
+
+	DynRpg::ChunkReader r2(data);
+	CHECK(r2.ReadU32() == 1000);
+	CHECK(!r2.CanHold(1000, 1));
+}
+
 TEST_SUITE_END();
@@ -0,0 +1,107 @@
+#include "dynrpg_particle_integrator.h"
+#include "doctest.h"
+#include <cmath>
+#include <vector>
+
+using ParticleIntegrator::Kernel;
+using ParticleIntegrator::Params;
+
+namespace {
+struct Particles {
+	std::vector<float> x, y, s, dx, dy;
+
+	explicit Particles(int n) : x(n), y(n), s(n), dx(n), dy(n) {
+		for (int i = 0; i < n; ++i) {
+			x[i] = (i * 37) % 320;
+			y[i] = (i * 91) % 240;
+			s[i] = 1.0f + (i % 5);
+			dx[i] = ((i % 7) - 3) * 0.25f;
+			dy[i] = ((i % 11) - 5) * 0.125f;
+		}
+	}
+
+	void Step(Kernel kernel, const Params& p) {
+		ParticleIntegrator::Integrate(kernel, p, x.data(), y.data(), s.data(), dx.data(), dy.data(), x.size());
+	}
+};
+
+void RequireClose(const std::vector<float>& a, const std::vector<float>& b) {
+	REQUIRE_EQ(a.size(), b.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+		INFO("index ", i);
+		REQUIRE(std::fabs(a[i] - b[i]) <= 1e-3f * std::max(1.0f, std::fabs(a[i])));
+	}
+}
+
+Params MakeParams() {
+	Params p;
+	p.ax0 = 160.0f;
+	p.ay0 = 120.0f;
+	p.afc = 5.0f / 600.0f;
+	p.gx = 0.0f;
+	p.gy = 1.0f / 600.0f;
+	p.ds = -0.05f;
+	return p;
+}
+
+void TestKernel(Kernel kernel) {
+	if (!ParticleIntegrator::IsSupported(kernel)) {
+		return;
+	}
+
+	INFO(ParticleIntegrator::GetKernelName(kernel));
+
+	// Odd count to exercise the scalar tail of the vector loops
+	constexpr int n = 1003;
+	Particles ref(n);
+	Particles vec(n);
+	auto p = MakeParams();
+
+	for (int step = 0; step < 60; ++step) {
+		ref.Step(Kernel::Scalar, p);
+		vec.Step(kernel, p);
+	}
+
+	RequireClose(ref.x, vec.x);
+	RequireClose(ref.y, vec.y);
+	RequireClose(ref.s, vec.s);
+	RequireClose(ref.dx, vec.dx);
+	RequireClose(ref.dy, vec.dy);
+}
+}
+
+TEST_SUITE_BEGIN("ParticleIntegrator");
+
+TEST_CASE("ScalarAlwaysSupported") {
+	REQUIRE(ParticleIntegrator::IsSupported(Kernel::Scalar));
+	REQUIRE(ParticleIntegrator::IsSupported(ParticleIntegrator::GetKernel()));
+}
+
+TEST_CASE("ScalarStep") {
+	Params p;
+	p.gx = 1.0f;
+	p.ds = 0.5f;
+
+	float x = 1.0f, y = 2.0f, s = 1.0f, dx = 3.0f, dy = 4.0f;
+	ParticleIntegrator::Integrate(Kernel::Scalar, p, &x, &y, &s, &dx, &dy, 1);
+
+	REQUIRE_EQ(x, 4.0f);
+	REQUIRE_EQ(y, 6.0f);
+	REQUIRE_EQ(s, 1.5f);
+	REQUIRE_EQ(dx, 4.0f);
+	REQUIRE_EQ(dy, 4.0f);
+}
+
+TEST_CASE("SSE2") {
+	TestKernel(Kernel::SSE2);
+}
+
+TEST_CASE("AVX2") {
+	TestKernel(Kernel::AVX2);
+}
+
+TEST_CASE("NEON") {
+	TestKernel(Kernel::NEON);
+}
+
+TEST_SUITE_END();
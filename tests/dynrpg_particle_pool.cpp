@@ -0,0 +1,219 @@
+#include "dynrpg_particle_pool.h"
+#include "doctest.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+using Handle = ParticlePool::Handle;
+
+std::string Tag(int i) {
+	return "stream" + std::to_string(i);
+}
+
+// Every handle is in exactly one phase and the order list is consistent
+void RequireConsistent(const ParticlePool& pool) {
+	REQUIRE(pool.GetStartingCount() <= pool.GetRunningCount());
+	REQUIRE(pool.GetRunningCount() <= pool.GetActiveCount());
+	REQUIRE(pool.GetActiveCount() <= pool.GetCapacity());
+
+	std::set<Handle> seen;
+	for (int i = 0; i < pool.GetCapacity(); ++i) {
+		Handle h = pool.GetActive(i);
+		REQUIRE(h < static_cast<Handle>(pool.GetCapacity()));
+		REQUIRE(seen.insert(h).second);
+	}
+}
+}
+
+TEST_SUITE_BEGIN("ParticlePool");
+
+TEST_CASE("Aligned") {
+	ParticlePool pool(37);
+	pool.Reserve(40);
+
+	for (int i = 0; i < pool.GetCapacity(); ++i) {
+		Handle h = pool.GetActive(i);
+		for (float* p: { pool.X(h), pool.Y(h), pool.S(h), pool.DX(h), pool.DY(h) }) {
+			REQUIRE_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0);
+			REQUIRE_EQ(p[0], 0.0f);
+			REQUIRE_EQ(p[36], 0.0f);
+		}
+	}
+}
+
+TEST_CASE("StartStop") {
+	ParticlePool pool(4);
+
+	Handle a = pool.Start("a");
+	Handle b = pool.Start("b");
+	REQUIRE_NE(a, ParticlePool::null_handle);
+	REQUIRE_NE(b, ParticlePool::null_handle);
+	REQUIRE_NE(a, b);
+	REQUIRE_EQ(pool.Start("a"), ParticlePool::null_handle);
+	REQUIRE_EQ(pool.Find("a"), a);
+	REQUIRE_EQ(pool.GetStartingCount(), 2);
+
+	pool.StartToStream(0);
+	REQUIRE_EQ(pool.GetStartingCount(), 1);
+	REQUIRE_EQ(pool.GetRunningCount(), 2);
+
+	REQUIRE_EQ(pool.Stop("a"), a);
+	REQUIRE_EQ(pool.Stop("a"), ParticlePool::null_handle);
+	REQUIRE_EQ(pool.Find("a"), ParticlePool::null_handle);
+	REQUIRE_EQ(pool.GetRunningCount(), 1);
+	REQUIRE_EQ(pool.GetActiveCount(), 2);
+	REQUIRE_EQ(pool.GetActive(1), a);
+	RequireConsistent(pool);
+
+	pool.Release(1);
+	REQUIRE_EQ(pool.GetActiveCount(), 1);
+	REQUIRE_EQ(pool.GetActive(0), b);
+
+	// The tag can be reused once stopped
+	REQUIRE_NE(pool.Start("a"), ParticlePool::null_handle);
+	RequireConsistent(pool);
+}
+
+TEST_CASE("StopStarting") {
+	ParticlePool pool(4);
+	Handle a = pool.Start("a");
+	Handle b = pool.Start("b");
+	Handle c = pool.Start("c");
+	pool.StartToStream(0);
+
+	REQUIRE_EQ(pool.Stop("b"), b);
+	REQUIRE_EQ(pool.GetStartingCount(), 1);
+	REQUIRE_EQ(pool.GetRunningCount(), 2);
+	REQUIRE_EQ(pool.GetActive(2), b);
+	REQUIRE_EQ(pool.GetActive(0), c);
+	REQUIRE_EQ(pool.GetActive(1), a);
+	REQUIRE_EQ(pool.Find("a"), a);
+	REQUIRE_EQ(pool.Find("c"), c);
+	RequireConsistent(pool);
+}
+
+TEST_CASE("StableHandles") {
+	ParticlePool pool(100);
+	Handle h = pool.Start("first");
+	float* x = pool.X(h);
+	x[99] = 42.0f;
+	pool.GetEmitter(h).x = 7;
+
+	for (int i = 0; i < 1000; ++i) {
+		pool.Start(Tag(i));
+	}
+
+	REQUIRE_EQ(pool.X(h), x);
+	REQUIRE_EQ(x[99], 42.0f);
+	REQUIRE_EQ(pool.GetEmitter(h).x, 7);
+	REQUIRE_EQ(pool.Find("first"), h);
+}
+
+TEST_CASE("ResizeKeepsEmitters") {
+	ParticlePool pool(10);
+	Handle h = pool.Start("a");
+	pool.GetEmitter(h).y = 5;
+
+	pool.SetParticlesPerSlot(500);
+	REQUIRE_EQ(pool.GetParticlesPerSlot(), 500);
+	REQUIRE_EQ(pool.Find("a"), h);
+	REQUIRE_EQ(pool.GetEmitter(h).y, 5);
+	REQUIRE_EQ(pool.S(h)[499], 0.0f);
+	RequireConsistent(pool);
+}
+
+TEST_CASE("ShrinkTimeout") {
+	// Stream with 30 blocks of 10 particles
+	int fade = 30;
+	ParticlePool pool(10 * fade);
+
+	Handle streaming = pool.Start("streaming");
+	Handle stopping = pool.Start("stopping");
+	pool.StartToStream(0);
+	pool.StartToStream(0);
+	pool.GetEmitter(streaming).itr = 25;
+	pool.GetEmitter(stopping).itr = 20;
+	pool.GetEmitter(stopping).end_cnt = 27;
+	REQUIRE_EQ(pool.Stop("stopping"), stopping);
+
+	fade = 10;
+	pool.SetParticlesPerSlot(10 * fade);
+	pool.RestartEmitters(fade);
+
+	// Block indices used by Stream::Update stay inside the ring
+	const auto& e1 = pool.GetEmitter(streaming);
+	REQUIRE_EQ(e1.itr, 0);
+	int z = fade - e1.itr - 1;
+	REQUIRE(z >= 0);
+	REQUIRE(z < fade);
+
+	const auto& e2 = pool.GetEmitter(stopping);
+	REQUIRE_EQ(e2.itr, 0);
+	REQUIRE_EQ(e2.end_cnt, fade - 1);
+	REQUIRE(fade - e2.end_cnt > 0);
+
+	// Shorter remaining steps are kept
+	pool.GetEmitter(stopping).end_cnt = 3;
+	pool.RestartEmitters(fade);
+	REQUIRE_EQ(pool.GetEmitter(stopping).end_cnt, 3);
+	RequireConsistent(pool);
+}
+
+TEST_CASE("Stress") {
+	constexpr int num = 10000;
+	ParticlePool pool(30);
+
+	std::vector<Handle> handles;
+	for (int i = 0; i < num; ++i) {
+		Handle h = pool.Start(Tag(i));
+		REQUIRE_NE(h, ParticlePool::null_handle);
+		pool.GetEmitter(h).x = i;
+		handles.push_back(h);
+	}
+	REQUIRE_EQ(pool.GetActiveCount(), num);
+	RequireConsistent(pool);
+
+	const int capacity = pool.GetCapacity();
+	const int chunks = pool.GetChunkCount();
+
+	for (int round = 0; round < 3; ++round) {
+		// Stop every second stream and release it like the simulation does
+		for (int i = round % 2; i < num; i += 2) {
+			REQUIRE_EQ(pool.Stop(Tag(i)), handles[i]);
+		}
+		for (int i = pool.GetRunningCount(); i < pool.GetActiveCount(); ++i) {
+			pool.Release(i--);
+		}
+		REQUIRE_EQ(pool.GetActiveCount(), num / 2);
+		RequireConsistent(pool);
+
+		// Restart them, freed slots are reused without growing
+		for (int i = round % 2; i < num; i += 2) {
+			handles[i] = pool.Start(Tag(i));
+			REQUIRE_NE(handles[i], ParticlePool::null_handle);
+			pool.GetEmitter(handles[i]).x = i;
+		}
+		REQUIRE_EQ(pool.GetActiveCount(), num);
+		REQUIRE_EQ(pool.GetCapacity(), capacity);
+		REQUIRE_EQ(pool.GetChunkCount(), chunks);
+		RequireConsistent(pool);
+	}
+
+	for (int i = 0; i < num; ++i) {
+		REQUIRE_EQ(pool.Find(Tag(i)), handles[i]);
+		REQUIRE_EQ(pool.GetEmitter(handles[i]).x, i);
+	}
+
+	pool.StopAll();
+	REQUIRE_EQ(pool.GetRunningCount(), 0);
+	REQUIRE_EQ(pool.GetActiveCount(), num);
+	REQUIRE_EQ(pool.Find(Tag(0)), ParticlePool::null_handle);
+
+	pool.Clear();
+	REQUIRE_EQ(pool.GetActiveCount(), 0);
+	REQUIRE_EQ(pool.GetCapacity(), capacity);
+}
+
+TEST_SUITE_END();
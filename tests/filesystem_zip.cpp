@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <vector>
 #include "filesystem.h"
 #include "filefinder.h"
 #include "main_data.h"
@@ -60,6 +62,53 @@ TEST_CASE("File reading") {
 	CHECK(line_out == "lo");
 }
 
+TEST_CASE("File reading: Deflate") {
+	auto fs = FileFinder::Root().Create(ZIP_PATH);
+	auto is = fs.OpenInputStream("1kb");
+	REQUIRE(is);
+	CHECK(is.GetSize() == 1024);
+
+	std::vector<char> data(2048, 1);
+	is.read(data.data(), data.size());
+	CHECK(is.gcount() == 1024);
+	CHECK(std::all_of(data.begin(), data.begin() + 1024, [](char c) { return c == 0; }));
+
+	is.clear();
+	is.seekg(-24, std::ios_base::end);
+	CHECK(is.tellg() == 1000);
+	is.read(data.data(), 100);
+	CHECK(is.gcount() == 24);
+
+	// Seeking backwards restarts decompression
+	is.clear();
+	is.seekg(10, std::ios_base::beg);
+	CHECK(is.get() == 0);
+	CHECK(is.tellg() == 11);
+}
+
+TEST_CASE("File reading: Independent streams") {
+	auto fs = FileFinder::Root().Create(ZIP_PATH);
+	auto is1 = fs.OpenInputStream("text");
+	auto is2 = fs.OpenInputStream("text");
+	auto is3 = fs.OpenInputStream("1kb");
+	REQUIRE(is1);
+	REQUIRE(is2);
+	REQUIRE(is3);
+
+	is2.seekg(6);
+	std::string line_out;
+	CHECK(Utils::ReadLine(is1, line_out));
+	CHECK(line_out == "hello");
+	CHECK(is3.get() == 0);
+	CHECK(Utils::ReadLine(is2, line_out));
+	CHECK(line_out == "World");
+	CHECK(Utils::ReadLine(is1, line_out));
+	CHECK(line_out == "World");
+	CHECK(Utils::ReadLine(is2, line_out));
+	CHECK(line_out == "123");
+	CHECK(is3.tellg() == 1);
+}
+
 TEST_CASE("File IO error") {
 	auto fs = FileFinder::Root().Create(ZIP_PATH);
 	CHECK(!fs.OpenInputStream("game"));
@@ -3,6 +3,7 @@
 #include "cache.h"
 #include "bitmap.h"
 #include "font.h"
+#include <algorithm>
 #include <iostream>
 #include "doctest.h"
 
@@ -105,4 +106,29 @@ TEST_CASE("FontGlyphCharEx") {
 	}
 }
 
+TEST_CASE("FontGlyphCache") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto font = Font::Default();
+	auto system = Cache::SysBlack();
+	auto first = Bitmap::Create(width, height);
+	auto second = Bitmap::Create(width, height);
+
+	// The second pass renders from the glyph cache
+	for (auto* surface : { first.get(), second.get() }) {
+		int x = 0;
+		for (char32_t ch : std::u32string(U"Xぽ下X")) {
+			x += font->Render(*surface, x, 0, *system, 0, ch).x;
+		}
+	}
+
+	REQUIRE_EQ(first->pitch(), second->pitch());
+	CHECK(std::equal(
+		reinterpret_cast<const uint8_t*>(first->pixels()),
+		reinterpret_cast<const uint8_t*>(first->pixels()) + first->pitch() * height,
+		reinterpret_cast<const uint8_t*>(second->pixels())));
+
+	// Cached glyphs must not share their bitmap
+	CHECK_NE(font->vRender(U'X').bitmap, font->vRender(U'Y').bitmap);
+}
+
 TEST_SUITE_END();
@@ -0,0 +1,104 @@
+#include <random>
+#include <vector>
+#include "doctest.h"
+#include "game_map.h"
+#include "mock_game.h"
+
+TEST_SUITE_BEGIN("Game_Map");
+
+namespace {
+constexpr int map_w = 40;
+constexpr int map_h = 30;
+
+lcf::rpg::Event MakeEvent(int id, int x, int y) {
+	lcf::rpg::Event ev;
+	ev.ID = id;
+	ev.x = x;
+	ev.y = y;
+	ev.pages.push_back({});
+	ev.pages.back().ID = 1;
+	ev.pages.back().move_type = lcf::rpg::EventPage::MoveType_stationary;
+	ev.pages.back().character_pattern = 1;
+	if (id % 3 == 0) {
+		ev.pages.back().layer = lcf::rpg::EventPage::Layers_below;
+	}
+	return ev;
+}
+
+std::vector<int> LinearIndicesAt(int x, int y) {
+	std::vector<int> out;
+	auto& events = Game_Map::GetEvents();
+	for (int i = 0; i < static_cast<int>(events.size()); ++i) {
+		if (events[i].IsInPosition(x, y)) {
+			out.push_back(i);
+		}
+	}
+	return out;
+}
+
+std::vector<int> IndexedIndicesAt(int x, int y) {
+	std::vector<int> out;
+	auto& events = Game_Map::GetEvents();
+	for (int idx = Game_Map::GetFirstEventIndexAt(x, y); idx >= 0; idx = Game_Map::GetNextEventIndexAt(idx)) {
+		if (events[idx].IsInPosition(x, y)) {
+			out.push_back(idx);
+		}
+	}
+	return out;
+}
+
+void CompareWithLinearScan() {
+	auto& events = Game_Map::GetEvents();
+	for (int y = -1; y <= map_h; ++y) {
+		for (int x = -1; x <= map_w; ++x) {
+			CAPTURE(x);
+			CAPTURE(y);
+			auto linear = LinearIndicesAt(x, y);
+			REQUIRE_EQ(IndexedIndicesAt(x, y), linear);
+
+			Game_Event* last = linear.empty() ? nullptr : &events[linear.back()];
+			REQUIRE_EQ(Game_Map::GetEventAt(x, y, false), last);
+			REQUIRE_EQ(Game_Map::CheckEvent(x, y), linear.empty() ? 0 : events[linear.front()].GetId());
+		}
+	}
+}
+}
+
+TEST_CASE("EventIndexMatchesLinearScan") {
+	const MockGame mg(MockMap::ePass40x30);
+
+	std::mt19937 rng(77);
+	std::uniform_int_distribution<int> pos_x(-2, map_w + 1);
+	std::uniform_int_distribution<int> pos_y(-2, map_h + 1);
+
+	auto map = MakeMockMap(MockMap::ePass40x30);
+	map->events.clear();
+	for (int id = 1; id <= 200; ++id) {
+		map->events.push_back(MakeEvent(id, pos_x(rng) % map_w, pos_y(rng) % map_h));
+	}
+	Game_Map::Setup(std::move(map));
+
+	CompareWithLinearScan();
+
+	for (int round = 0; round < 10; ++round) {
+		auto& events = Game_Map::GetEvents();
+		std::uniform_int_distribution<int> pick(0, static_cast<int>(events.size()) - 1);
+
+		// Move events, some of them outside of the map
+		for (int i = 0; i < 60; ++i) {
+			auto& ev = events[pick(rng)];
+			ev.SetX(pos_x(rng));
+			ev.SetY(pos_y(rng));
+		}
+
+		// Clone new events and replace existing ones
+		int src_id = events[pick(rng)].GetId();
+		REQUIRE(Game_Map::CloneMapEvent(Game_Map::GetMapId(), src_id, pos_x(rng) % map_w, 3, 0, ""));
+		int target_id = events[pick(rng)].GetId();
+		REQUIRE(Game_Map::CloneMapEvent(Game_Map::GetMapId(), src_id, 5, pos_y(rng) % map_h, target_id, ""));
+
+		CompareWithLinearScan();
+	}
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,387 @@
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+#include "game_interpreter.h"
+#include "game_interpreter_control_variables.h"
+#include "game_map.h"
+#include "maniac_patch.h"
+#include "rand.h"
+#include "test_mock_actor.h"
+#include "doctest.h"
+
+namespace {
+using Bytes = std::vector<int32_t>;
+
+enum Op {
+	U8 = 1,
+	S32 = 3,
+	Var = 8,
+	Switch = 9,
+	VarIndirect = 13,
+	Array = 19,
+	Negate = 24,
+	Not,
+	Flip,
+	AssignInplace = 34,
+	AddInplace,
+	DivInplace = 38,
+	Add = 48,
+	Sub,
+	Mul,
+	Div,
+	Mod,
+	BitOr,
+	BitAnd,
+	BitXor,
+	BitShiftLeft,
+	BitShiftRight,
+	Equal,
+	GreaterEqual,
+	LessEqual,
+	Greater,
+	Less,
+	NotEqual,
+	Or,
+	And,
+	Ternary = 72,
+	Function = 78
+};
+
+constexpr int num_functions = 19;
+constexpr int function_args[num_functions] = { 2, 2, 2, 2, 2, 2, 1, 2, 2, 3, 3, 3, 2, 2, 1, 3, 3, 3, 3 };
+
+Bytes Const(int32_t v) {
+	auto u = static_cast<uint32_t>(v);
+	return { S32, int32_t(u & 0xFF), int32_t((u >> 8) & 0xFF), int32_t((u >> 16) & 0xFF), int32_t(u >> 24) };
+}
+
+Bytes Cat(std::initializer_list<Bytes> parts) {
+	Bytes r;
+	for (auto& p : parts) {
+		r.insert(r.end(), p.begin(), p.end());
+	}
+	return r;
+}
+
+Bytes Call(int fn, std::initializer_list<Bytes> args) {
+	return Cat({ Bytes{ Function, fn, static_cast<int32_t>(args.size()) }, Cat(args) });
+}
+
+// Packs the bytes into op codes like the event command parameters
+std::vector<int32_t> Pack(const Bytes& bytes) {
+	std::vector<int32_t> ops((bytes.size() + 3) / 4);
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		ops[i / 4] = static_cast<int32_t>(static_cast<uint32_t>(ops[i / 4]) | (static_cast<uint32_t>(bytes[i]) << ((i % 4) * 8)));
+	}
+	return ops;
+}
+
+// Subset of the recursive evaluator used before expressions were compiled
+struct Legacy {
+	const Game_BaseInterpreterContext& ip;
+	Bytes::const_iterator it;
+	Bytes::const_iterator end;
+
+	int32_t Next() {
+		return it == end ? 0 : *it++;
+	}
+
+	int32_t Saturate(int64_t v) {
+		return static_cast<int32_t>(Utils::Clamp<int64_t>(v, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
+	}
+
+	int32_t Process() {
+		if (it == end) {
+			return 0;
+		}
+
+		int op = *it++;
+		int32_t a, b, c;
+
+		switch (op) {
+			case U8:
+				return Next();
+			case S32: {
+				uint32_t v = 0;
+				for (int i = 0; i < 3; ++i) {
+					v += static_cast<uint32_t>(Next()) << (i * 8);
+					if (it == end) {
+						return 0;
+					}
+				}
+				v += static_cast<uint32_t>(Next()) << 24;
+				return static_cast<int32_t>(v);
+			}
+			case Var:
+				return Main_Data::game_variables->Get(Process());
+			case Switch:
+				return Main_Data::game_switches->GetInt(Process());
+			case VarIndirect:
+				return Main_Data::game_variables->GetIndirect(Process());
+			case Negate:
+				return -Process();
+			case Not:
+				return !Process() ? 0 : 1;
+			case Flip:
+				return ~Process();
+			case AssignInplace:
+			case AddInplace:
+			case DivInplace: {
+				// Only variables as lvalue
+				++it;
+				int id = Process();
+				b = Process();
+				int cur = Main_Data::game_variables->Get(id);
+				if (op == AssignInplace) {
+					return Main_Data::game_variables->Set(id, b);
+				} else if (op == AddInplace) {
+					return Main_Data::game_variables->Set(id, Saturate(static_cast<int64_t>(cur) + b));
+				}
+				return b == 0 ? cur : Main_Data::game_variables->Set(id, cur / b);
+			}
+			case Ternary:
+				a = Process();
+				b = Process();
+				c = Process();
+				return a != 0 ? b : c;
+			case Function:
+				return ProcessFunction();
+			default:
+				break;
+		}
+
+		if (op >= Add && op <= And) {
+			a = Process();
+			b = Process();
+			switch (op) {
+				case Add: return Saturate(static_cast<int64_t>(a) + b);
+				case Sub: return Saturate(static_cast<int64_t>(a) - b);
+				case Mul: return Saturate(static_cast<int64_t>(a) * b);
+				case Div: return b == 0 ? a : a / b;
+				case Mod: return b == 0 ? a : a % b;
+				case BitOr: return a | b;
+				case BitAnd: return a & b;
+				case BitXor: return a ^ b;
+				case BitShiftLeft: return a << b;
+				case BitShiftRight: return a >> b;
+				case Equal: return a == b;
+				case GreaterEqual: return a >= b;
+				case LessEqual: return a <= b;
+				case Greater: return a > b;
+				case Less: return a < b;
+				case NotEqual: return a != b;
+				case Or: return !!a || !!b;
+				case And: return !!a && !!b;
+			}
+		}
+
+		return 0;
+	}
+
+	int32_t ProcessFunction() {
+		int fn = Next();
+		int args = Next();
+
+		if (fn >= num_functions) {
+			for (int i = 0; i < args; ++i) {
+				Process();
+			}
+			return 0;
+		}
+		if (args != function_args[fn]) {
+			return 0;
+		}
+
+		int32_t a[3] = {};
+		for (int i = 0; i < args; ++i) {
+			a[i] = Process();
+		}
+
+		switch (fn) {
+			case 0: return ControlVariables::Random(a[1], a[0]);
+			case 1: return ControlVariables::Item(a[1], a[0]);
+			case 2: return ControlVariables::Event(a[1], a[0], ip);
+			case 3: return ControlVariables::Actor(a[1], a[0]);
+			case 4: return ControlVariables::Party(a[1], a[0]);
+			case 5: return ControlVariables::Enemy(a[1], a[0]);
+			case 6: return ControlVariables::Other(a[0]);
+			case 7: return ControlVariables::Pow(a[0], a[1]);
+			case 8: return ControlVariables::Sqrt(a[0], a[1]);
+			case 9: return ControlVariables::Sin(a[0], a[1], a[2]);
+			case 10: return ControlVariables::Cos(a[0], a[1], a[2]);
+			case 11: return ControlVariables::Atan2(a[0], a[1], a[2]);
+			case 12: return ControlVariables::Min(a[0], a[1]);
+			case 13: return ControlVariables::Max(a[0], a[1]);
+			case 14: return ControlVariables::Abs(a[0]);
+			case 15: return ControlVariables::Clamp(a[0], a[1], a[2]);
+			case 16: return ControlVariables::Muldiv(a[0], a[1], a[2]);
+			case 17: return ControlVariables::Divmul(a[0], a[1], a[2]);
+			case 18: return ControlVariables::Between(a[0], a[1], a[2]);
+		}
+		return 0;
+	}
+};
+
+int32_t LegacyParse(const Bytes& bytes, const Game_BaseInterpreterContext& ip) {
+	Legacy l{ ip, bytes.begin(), bytes.end() };
+	return l.Process();
+}
+
+void CheckSame(const Bytes& bytes, const Game_BaseInterpreterContext& ip) {
+	auto ops = Pack(bytes);
+	// The packed op codes are padded with 0
+	Bytes padded = bytes;
+	padded.resize(ops.size() * 4);
+
+	Rand::SeedRandomNumberGenerator(1234);
+	int32_t expected = LegacyParse(padded, ip);
+	Rand::SeedRandomNumberGenerator(1234);
+	CHECK_EQ(ManiacPatch::ParseExpression(ops, ip), expected);
+	// Cached program
+	Rand::SeedRandomNumberGenerator(1234);
+	CHECK_EQ(ManiacPatch::ParseExpression(ops, ip), expected);
+}
+
+struct ManiacFixture {
+	MockBattle mb;
+	Game_Interpreter ip;
+
+	ManiacFixture() {
+		Output::SetLogLevel(LogLevel::Error);
+
+		Main_Data::game_variables->Set(1, 7);
+		Main_Data::game_variables->Set(2, 1);
+		Main_Data::game_variables->Set(3, -40);
+		Main_Data::game_switches->Set(4, true);
+		Main_Data::game_party->AddItem(5, 12);
+		Main_Data::game_party->GainGold(321);
+		Main_Data::game_player->SetX(3);
+		Main_Data::game_player->SetY(9);
+
+		Game_Map::Init();
+	}
+
+	~ManiacFixture() {
+		Game_Map::Quit();
+	}
+};
+}
+
+TEST_SUITE_BEGIN("ManiacPatch");
+
+TEST_CASE_FIXTURE(ManiacFixture, "Functions") {
+	const Bytes v1 = Cat({ Bytes{ Var }, Const(1) });
+
+	// Every function with a constant, a variable and a nested call
+	const std::vector<Bytes> args[num_functions] = {
+		{ Const(1), Const(100) },
+		{ Const(5), Const(0) },
+		{ Const(Game_Character::CharPlayer), Const(1) },
+		{ Const(1), Const(0) },
+		{ Const(0), Const(0) },
+		{ Const(0), Const(0) },
+		{ Const(0) },
+		{ Const(3), Const(4) },
+		{ Const(1000), Const(10) },
+		{ Const(45), Const(1), Const(1000) },
+		{ Const(45), Const(1), Const(1000) },
+		{ Const(-10), v1, Const(100) },
+		{ v1, Const(-2) },
+		{ v1, Const(-2) },
+		{ Const(-123) },
+		{ Const(50), Const(0), v1 },
+		{ Const(100), v1, Const(3) },
+		{ Const(100), v1, Const(3) },
+		{ v1, Const(0), Const(10) }
+	};
+
+	for (int fn = 0; fn < num_functions; ++fn) {
+		CAPTURE(fn);
+		Bytes call = { Function, fn, function_args[fn] };
+		for (auto& a : args[fn]) {
+			call.insert(call.end(), a.begin(), a.end());
+		}
+		CheckSame(call, ip);
+		CheckSame(Cat({ Bytes{ Add }, call, Const(1) }), ip);
+	}
+
+	CheckSame(Call(12, { Call(13, { v1, Const(9) }), Call(14, { Const(-5) }) }), ip);
+}
+
+TEST_CASE_FIXTURE(ManiacFixture, "Operators") {
+	const int32_t values[] = { 0, 1, -1, 7, -40, 1 << 20, std::numeric_limits<int32_t>::max() };
+
+	for (int op = Add; op <= And; ++op) {
+		for (int32_t a : values) {
+			for (int32_t b : values) {
+				if ((op == BitShiftLeft || op == BitShiftRight) && (b < 0 || b > 30)) {
+					continue;
+				}
+				CAPTURE(op);
+				CAPTURE(a);
+				CAPTURE(b);
+				CheckSame(Cat({ Bytes{ op }, Const(a), Const(b) }), ip);
+			}
+		}
+	}
+
+	for (int op : { Negate, Not, Flip }) {
+		CheckSame(Cat({ Bytes{ op }, Const(-40) }), ip);
+	}
+
+	CheckSame(Cat({ Bytes{ Ternary }, Bytes{ Switch }, Const(4), Const(2), Const(3) }), ip);
+	CheckSame(Cat({ Bytes{ VarIndirect }, Const(2) }), ip);
+	CheckSame(Bytes{ U8, 200 }, ip);
+}
+
+TEST_CASE_FIXTURE(ManiacFixture, "MalformedExpressions") {
+	// Wrong argument count, the arguments are parsed as the next operations
+	CheckSame(Cat({ Bytes{ Add }, Bytes{ Function, 7, 1 }, Const(2), Const(3) }), ip);
+	// Unknown function, arguments are evaluated and discarded
+	CheckSame(Cat({ Bytes{ Add }, Bytes{ Function, 60, 2 }, Const(2), Const(3), Const(4) }), ip);
+	// Truncated constant
+	CheckSame(Bytes{ Add, U8, 5, U8, 6, S32, 1, 2 }, ip);
+	// Unsupported operation
+	CheckSame(Cat({ Bytes{ Add, Array }, Const(4) }), ip);
+	// Empty
+	CHECK_EQ(ManiacPatch::ParseExpression({}, ip), 0);
+}
+
+TEST_CASE_FIXTURE(ManiacFixture, "Inplace") {
+	Player::game_config.patch_easyrpg.Set(false);
+
+	for (int op : { AssignInplace, AddInplace, DivInplace }) {
+		CAPTURE(op);
+		auto bytes = Cat({ Bytes{ op, Var }, Const(1), Bytes{ Mul }, Const(3), Bytes{ Var }, Const(1) });
+		auto ops = Pack(bytes);
+		bytes.resize(ops.size() * 4);
+
+		Main_Data::game_variables->Set(1, 7);
+		int32_t expected = LegacyParse(bytes, ip);
+		int32_t expected_var = Main_Data::game_variables->Get(1);
+
+		Main_Data::game_variables->Set(1, 7);
+		CHECK_EQ(ManiacPatch::ParseExpression(ops, ip), expected);
+		CHECK_EQ(Main_Data::game_variables->Get(1), expected_var);
+	}
+}
+
+TEST_CASE_FIXTURE(ManiacFixture, "MultipleExpressions") {
+	auto ops = Pack(Cat({ Const(5), Bytes{ Var }, Const(1), Call(7, { Const(2), Const(10) }) }));
+
+	CHECK_EQ(ManiacPatch::ParseExpressions(ops, ip), std::vector<int32_t>{ 5, 7, 1024 });
+	CHECK(ManiacPatch::ParseExpressions({}, ip).empty());
+}
+
+TEST_CASE_FIXTURE(ManiacFixture, "CacheDetectsChangedOpCodes") {
+	auto ops = Pack(Cat({ Bytes{ Add }, Const(1), Const(2) }));
+	CHECK_EQ(ManiacPatch::ParseExpression(ops, ip), 3);
+
+	// Same memory, different expression
+	auto changed = Pack(Cat({ Bytes{ Sub }, Const(1), Const(2) }));
+	REQUIRE_EQ(changed.size(), ops.size());
+	std::copy(changed.begin(), changed.end(), ops.begin());
+	CHECK_EQ(ManiacPatch::ParseExpression(ops, ip), -1);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "spatial_hash.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("SpatialHash");
+
+namespace {
+struct Point {
+	float x;
+	float y;
+};
+
+std::vector<int> Sorted(std::vector<int> v) {
+	std::sort(v.begin(), v.end());
+	return v;
+}
+
+std::vector<int> BruteForce(const std::vector<Point>& points, float x, float y, float radius) {
+	std::vector<int> out;
+	for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+		if (std::hypot(points[i].x - x, points[i].y - y) <= radius) {
+			out.push_back(i);
+		}
+	}
+	return out;
+}
+}
+
+TEST_CASE("Empty") {
+	SpatialHash grid;
+	std::vector<int> out;
+
+	grid.Update(0, 1.0f, 1.0f);
+	grid.Query(1.0f, 1.0f, 5.0f, out);
+	REQUIRE(out.empty());
+
+	grid.Reset(10, 10);
+	grid.Query(1.0f, 1.0f, 5.0f, out);
+	REQUIRE(out.empty());
+}
+
+TEST_CASE("UpdateRemove") {
+	SpatialHash grid;
+	grid.Reset(20, 20);
+
+	grid.Update(0, 2.5f, 2.5f);
+	grid.Update(1, 2.2f, 2.7f);
+	grid.Update(2, 15.0f, 15.0f);
+
+	std::vector<int> out;
+	grid.Query(2.5f, 2.5f, 1.0f, out);
+	REQUIRE_EQ(Sorted(out), std::vector<int>{ 0, 1 });
+
+	grid.Update(1, 14.0f, 15.0f);
+	out.clear();
+	grid.Query(2.5f, 2.5f, 1.0f, out);
+	REQUIRE_EQ(out, std::vector<int>{ 0 });
+
+	out.clear();
+	grid.Query(15.0f, 15.0f, 1.0f, out);
+	REQUIRE_EQ(Sorted(out), std::vector<int>{ 1, 2 });
+
+	grid.Remove(2);
+	grid.Remove(2);
+	out.clear();
+	grid.Query(15.0f, 15.0f, 1.0f, out);
+	REQUIRE_EQ(out, std::vector<int>{ 1 });
+}
+
+TEST_CASE("OutsideIsClamped") {
+	SpatialHash grid;
+	grid.Reset(8, 8);
+
+	grid.Update(0, -3.0f, -3.0f);
+	grid.Update(1, 12.0f, 4.0f);
+
+	std::vector<int> out;
+	grid.Query(-3.0f, -3.0f, 0.5f, out);
+	REQUIRE_EQ(out, std::vector<int>{ 0 });
+
+	out.clear();
+	grid.Query(12.0f, 4.0f, 0.5f, out);
+	REQUIRE_EQ(out, std::vector<int>{ 1 });
+}
+
+TEST_CASE("QueryMatchesBruteForce") {
+	constexpr int size = 40;
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(-2.0f, size + 2.0f);
+	std::uniform_real_distribution<float> step(-1.5f, 1.5f);
+	std::uniform_real_distribution<float> radius(0.0f, 3.0f);
+
+	for (float cell_size : { 1.0f, 2.0f, 0.5f }) {
+		SpatialHash grid;
+		grid.Reset(static_cast<int>(size / cell_size), static_cast<int>(size / cell_size), cell_size);
+
+		std::vector<Point> points(300);
+		for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+			points[i] = { pos(rng), pos(rng) };
+			grid.Update(i, points[i].x, points[i].y);
+		}
+
+		for (int frame = 0; frame < 50; ++frame) {
+			for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+				points[i].x += step(rng);
+				points[i].y += step(rng);
+				grid.Update(i, points[i].x, points[i].y);
+			}
+
+			for (int q = 0; q < 20; ++q) {
+				float x = pos(rng);
+				float y = pos(rng);
+				float r = radius(rng);
+
+				std::vector<int> found;
+				grid.Query(x, y, r, found);
+				found = Sorted(found);
+				REQUIRE(std::adjacent_find(found.begin(), found.end()) == found.end());
+
+				for (int i : BruteForce(points, x, y, r)) {
+					REQUIRE(std::binary_search(found.begin(), found.end(), i));
+				}
+			}
+		}
+	}
+}
+
+TEST_SUITE_END();
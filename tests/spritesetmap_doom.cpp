@@ -0,0 +1,125 @@
+#include "doctest.h"
+#include "spritesetmap_doom.h"
+#include "worker_pool.h"
+
+TEST_SUITE_BEGIN("Doom");
+
+namespace {
+using DrawingDoom = Spriteset_MapDoom::DrawingDoom;
+using PlayerDoom = Spriteset_MapDoom::PlayerDoom;
+
+// Room with border walls, pillars, upper layer tiles and wall events
+DoomRaycaster MakeMap() {
+	DoomRaycaster raycaster;
+	raycaster.Resize(40, 40);
+	for (int y = 0; y < 40; ++y) {
+		for (int x = 0; x < 40; ++x) {
+			bool wall = x == 0 || y == 0 || x == 39 || y == 39 || (x % 7 == 3 && y % 5 == 2);
+			uint8_t flags = wall ? DoomRaycaster::Tile_Wall : 0;
+			if ((x * y) % 11 == 4) {
+				flags |= DoomRaycaster::Tile_Upper;
+			}
+			raycaster.SetTile(x, y, flags);
+		}
+	}
+
+	int id = 1;
+	for (int y = 4; y < 39; y += 9) {
+		for (int x = 6; x < 39; x += 8) {
+			int type = (id % 3 == 0) ? DoomRaycaster::WallEvent::Type_Wall : DoomRaycaster::WallEvent::Type_Door;
+			raycaster.AddWallEvent({ x, y, id++, type, 0 });
+		}
+	}
+	return raycaster;
+}
+
+bool Equal(const DrawingDoom& l, const DrawingDoom& r) {
+	return l.type == r.type && l.x == r.x && l.distance == r.distance && l.textureX == r.textureX
+		&& l.evID == r.evID && l.position == r.position;
+}
+}
+
+TEST_CASE("Raycaster wall hit") {
+	DoomRaycaster raycaster;
+	raycaster.Resize(10, 10);
+	raycaster.SetTile(9, 5, DoomRaycaster::Tile_Wall);
+	raycaster.SetTile(5, 0, DoomRaycaster::Tile_Hidden);
+
+	std::vector<DoomRaycaster::Hit> hits;
+	CHECK(raycaster.Cast(5.5f * TILE_SIZE, 5.5f * TILE_SIZE, 0.0f, hits));
+	REQUIRE(hits.size() == 1);
+	CHECK(hits[0].kind == DoomRaycaster::Hit::Kind_Wall);
+	CHECK(hits[0].distance == doctest::Approx(3.5f * TILE_SIZE));
+	CHECK(hits[0].texture_x == TILE_SIZE / 2);
+	CHECK(hits[0].tile_x == 9);
+	CHECK(hits[0].tile_y == 5);
+
+	hits.clear();
+	CHECK(raycaster.Cast(5.5f * TILE_SIZE, 5.5f * TILE_SIZE, static_cast<float>(-M_PI / 2), hits));
+	REQUIRE(hits.size() == 1);
+	CHECK(hits[0].tile_y == 0);
+
+	hits.clear();
+	CHECK(!raycaster.Cast(5.5f * TILE_SIZE, 5.5f * TILE_SIZE, static_cast<float>(M_PI), hits));
+	CHECK(hits.empty());
+}
+
+TEST_CASE("Raycaster wall events") {
+	DoomRaycaster raycaster;
+	raycaster.Resize(10, 10);
+	raycaster.SetTile(9, 5, DoomRaycaster::Tile_Wall);
+	raycaster.AddWallEvent({ 6, 5, 1, DoomRaycaster::WallEvent::Type_Door, 0 });
+	raycaster.AddWallEvent({ 7, 5, 2, DoomRaycaster::WallEvent::Type_Wall, 0 });
+	raycaster.AddWallEvent({ 20, 5, 3, DoomRaycaster::WallEvent::Type_Wall, 0 });
+	CHECK(raycaster.GetWallEvents().size() == 2);
+
+	std::vector<DoomRaycaster::Hit> hits;
+	CHECK(raycaster.Cast(5.5f * TILE_SIZE, 5.5f * TILE_SIZE, 0.0f, hits));
+	REQUIRE(hits.size() == 2);
+	CHECK(hits[0].kind == DoomRaycaster::Hit::Kind_Event);
+	CHECK(raycaster.GetWallEvents()[hits[0].event].id == 1);
+	CHECK(hits[0].distance == doctest::Approx(0.5f * TILE_SIZE));
+	CHECK(hits[1].kind == DoomRaycaster::Hit::Kind_Event);
+	CHECK(raycaster.GetWallEvents()[hits[1].event].id == 2);
+	CHECK(hits[1].distance == doctest::Approx(1.5f * TILE_SIZE));
+}
+
+TEST_CASE("Raycaster memory follows the map size") {
+	DoomRaycaster raycaster;
+	raycaster.Resize(20, 15);
+	size_t small = raycaster.GetMemoryUsage();
+	CHECK(small >= 20 * 15 * (sizeof(uint8_t) + sizeof(int)));
+
+	raycaster.Resize(1200, 1000);
+	CHECK(raycaster.GetWidth() == 1200);
+	raycaster.SetTile(1100, 999, DoomRaycaster::Tile_Wall);
+	CHECK(raycaster.GetTile(1100, 999) == DoomRaycaster::Tile_Wall);
+	CHECK(raycaster.GetMemoryUsage() > small);
+}
+
+TEST_CASE("Column bands match single threaded casting") {
+	auto raycaster = MakeMap();
+
+	for (float angle = 0.0f; angle < 6.3f; angle += 0.7f) {
+		PlayerDoom player = { 20 * TILE_SIZE + 8, 20 * TILE_SIZE + 3, angle, 1.9f, 110 };
+
+		std::vector<Spriteset_MapDoom::ColumnBand> ref_bands;
+		std::vector<DrawingDoom> ref;
+		Spriteset_MapDoom::castColumns(raycaster, player, 320, nullptr, ref_bands, ref);
+		REQUIRE(!ref.empty());
+
+		for (int workers: { 0, 1, 3, 4 }) {
+			WorkerPool pool(workers);
+			std::vector<Spriteset_MapDoom::ColumnBand> bands;
+			std::vector<DrawingDoom> out;
+			Spriteset_MapDoom::castColumns(raycaster, player, 320, &pool, bands, out);
+
+			REQUIRE(out.size() == ref.size());
+			for (size_t i = 0; i < out.size(); ++i) {
+				CHECK(Equal(out[i], ref[i]));
+			}
+		}
+	}
+}
+
+TEST_SUITE_END();